@@ -3,8 +3,33 @@
 #include <time.h>
 #include <string.h>
 #include <math.h>
+#include <dirent.h>
 #include "pbimganalysis.h"
 
+// Return true if the files 'path' and 'pathRef' have the same content
+// byte for byte, else false
+bool UnitTestFileIsEqual(const char* const path, 
+  const char* const pathRef) {
+  FILE* fp = fopen(path, "r");
+  FILE* fpRef = fopen(pathRef, "r");
+  if (fp == NULL || fpRef == NULL) {
+    if (fp != NULL)
+      fclose(fp);
+    if (fpRef != NULL)
+      fclose(fpRef);
+    return false;
+  }
+  int c = 0;
+  int cRef = 0;
+  do {
+    c = fgetc(fp);
+    cRef = fgetc(fpRef);
+  } while (c == cRef && c != EOF);
+  fclose(fp);
+  fclose(fpRef);
+  return (c == cRef);
+}
+
 void UnitTestImgKMeansClusters() {
   srandom(1);
   for (int size = 0; size < 2; ++size) {
@@ -22,6 +47,20 @@ void UnitTestImgKMeansClusters() {
         PBErrCatch(PBImgAnalysisErr);
       }
       fclose(fd);
+      // The streamed encoding must be identical to the one of the 
+      // JSONNode
+      fd = fopen("./imgkmeanscluster-ref.txt", "w");
+      JSONNode* json = IKMCEncodeAsJSON(&clusters);
+      JSONSave(json, fd, false);
+      JSONFree(&json);
+      fclose(fd);
+      if (!UnitTestFileIsEqual("./imgkmeanscluster.txt", 
+        "./imgkmeanscluster-ref.txt")) {
+        PBImgAnalysisErr->_type = PBErrTypeUnitTestFailed;
+        sprintf(PBImgAnalysisErr->_msg, "IKMCEncodeAsJSONStream NOK");
+        PBErrCatch(PBImgAnalysisErr);
+      }
+      remove("./imgkmeanscluster-ref.txt");
       fd = fopen("./imgkmeanscluster.txt", "r");
       if (!IKMCLoad(&clusters, fd)) {
         PBImgAnalysisErr->_type = PBErrTypeUnitTestFailed;
@@ -34,7 +73,53 @@ void UnitTestImgKMeansClusters() {
       printf("%s size K=%d cell=%d:\n", 
         fileName, K, IKMCGetSizeCell(&clusters));
       IKMCPrintln(&clusters, stdout);
+      unsigned short* labels = IKMCGetLabelMap(&clusters);
+      VecShort2D dim = GBGetDim(img);
+      VecShort2D pos = VecShortCreateStatic2D();
+      do {
+        int id = labels[VecGet(&pos, 1) * VecGet(&dim, 0) + 
+          VecGet(&pos, 0)];
+        if (id < 0 || id >= K || id != IKMCGetId(&clusters, &pos)) {
+          PBImgAnalysisErr->_type = PBErrTypeUnitTestFailed;
+          sprintf(PBImgAnalysisErr->_msg, "IKMCGetLabelMap NOK");
+          PBErrCatch(PBImgAnalysisErr);
+        }
+        // The id is the same as the one given by the KMeansClusters
+        VecFloat* input = IKMCGetInputOverCell(&clusters, &pos);
+        if (id != KMeansClustersGetId(IKMCKMeansClusters(&clusters), 
+          input)) {
+          PBImgAnalysisErr->_type = PBErrTypeUnitTestFailed;
+          sprintf(PBImgAnalysisErr->_msg, "IKMCGetId NOK");
+          PBErrCatch(PBImgAnalysisErr);
+        }
+        VecFree(&input);
+      } while (VecStep(&pos, &dim));
+      IKMCSetNbThread(&clusters, 3);
+      if (IKMCGetNbThread(&clusters) != 3) {
+        PBImgAnalysisErr->_type = PBErrTypeUnitTestFailed;
+        sprintf(PBImgAnalysisErr->_msg, "IKMCSetNbThread NOK");
+        PBErrCatch(PBImgAnalysisErr);
+      }
+      unsigned short* labelsThread = IKMCGetLabelMap(&clusters);
+      if (memcmp(labels, labelsThread, sizeof(unsigned short) * 
+        VecGet(&dim, 0) * VecGet(&dim, 1)) != 0) {
+        PBImgAnalysisErr->_type = PBErrTypeUnitTestFailed;
+        sprintf(PBImgAnalysisErr->_msg, "IKMCGetLabelMap NOK");
+        PBErrCatch(PBImgAnalysisErr);
+      }
+      free(labelsThread);
       IKMCCluster(&clusters);
+      do {
+        int id = labels[VecGet(&pos, 1) * VecGet(&dim, 0) + 
+          VecGet(&pos, 0)];
+        if (memcmp(GBFinalPixel(img, &pos), 
+          IKMCGetPixelCluster(&clusters, id), sizeof(GBPixel)) != 0) {
+          PBImgAnalysisErr->_type = PBErrTypeUnitTestFailed;
+          sprintf(PBImgAnalysisErr->_msg, "IKMCCluster NOK");
+          PBErrCatch(PBImgAnalysisErr);
+        }
+      } while (VecStep(&pos, &dim));
+      free(labels);
       char fileNameOut[50] = {'\0'};
       sprintf(fileNameOut, 
         "./ImgKMeansClustersTest/imgkmeanscluster%02d-%02d.tga", K, size);
@@ -47,6 +132,252 @@ void UnitTestImgKMeansClusters() {
   printf("UnitTestImgKMeansClusters OK\n");
 }
 
+void UnitTestImgKMeansClustersAccelerated() {
+  char* fileName = "./ImgKMeansClustersTest/imgkmeanscluster.tga";
+  GenBrush* img = GBCreateFromFile(fileName);
+  VecShort2D dim = GBGetDim(img);
+  long area = (long)VecGet(&dim, 0) * (long)VecGet(&dim, 1);
+  KMeansClustersSeed seeds[3] = {KMeansClustersSeed_Random, 
+    KMeansClustersSeed_Forgy, KMeansClustersSeed_PlusPlus};
+  for (int iSeed = 0; iSeed < 3; ++iSeed) {
+    int K = 3;
+    // Search with the Lloyd k-means as a reference
+    ImgKMeansClusters lloyd = ImgKMeansClustersCreateStatic(
+      img, seeds[iSeed], 1);
+    if (IKMCGetSearchMode(&lloyd) != IKMCSearchMode_KMeansClusters) {
+      PBImgAnalysisErr->_type = PBErrTypeUnitTestFailed;
+      sprintf(PBImgAnalysisErr->_msg, 
+        "ImgKMeansClustersCreateStatic NOK");
+      PBErrCatch(PBImgAnalysisErr);
+    }
+    IKMCSetSearchMode(&lloyd, IKMCSearchMode_Lloyd);
+    if (IKMCGetSearchMode(&lloyd) != IKMCSearchMode_Lloyd) {
+      PBImgAnalysisErr->_type = PBErrTypeUnitTestFailed;
+      sprintf(PBImgAnalysisErr->_msg, "IKMCSetSearchMode NOK");
+      PBErrCatch(PBImgAnalysisErr);
+    }
+    srandom(iSeed);
+    IKMCSearch(&lloyd, K);
+    // Search with the Hamerly k-means from the same initial centers,
+    // over several threads
+    ImgKMeansClusters clusters = ImgKMeansClustersCreateStatic(
+      img, seeds[iSeed], 1);
+    IKMCSetSearchMode(&clusters, IKMCSearchMode_Hamerly);
+    IKMCSetNbThread(&clusters, 3);
+    srandom(iSeed);
+    IKMCSearch(&clusters, K);
+    if (IKMCGetK(&clusters) != K) {
+      PBImgAnalysisErr->_type = PBErrTypeUnitTestFailed;
+      sprintf(PBImgAnalysisErr->_msg, "IKMCSearch NOK");
+      PBErrCatch(PBImgAnalysisErr);
+    }
+    // The bounds give the same centers and assignments as the Lloyd
+    // k-means with less distances computed
+    for (int id = K; id--;) {
+      const VecFloat* a = 
+        KMeansClustersCenter(IKMCKMeansClusters(&lloyd), id);
+      const VecFloat* b = 
+        KMeansClustersCenter(IKMCKMeansClusters(&clusters), id);
+      if (VecGetDim(a) != VecGetDim(b) || memcmp(a->_val, b->_val, 
+        sizeof(float) * VecGetDim(a)) != 0) {
+        PBImgAnalysisErr->_type = PBErrTypeUnitTestFailed;
+        sprintf(PBImgAnalysisErr->_msg, "IKMCSearch NOK");
+        PBErrCatch(PBImgAnalysisErr);
+      }
+    }
+    unsigned short* labels = IKMCGetLabelMap(&clusters);
+    unsigned short* labelsLloyd = IKMCGetLabelMap(&lloyd);
+    if (memcmp(labels, labelsLloyd, 
+      sizeof(unsigned short) * area) != 0) {
+      PBImgAnalysisErr->_type = PBErrTypeUnitTestFailed;
+      sprintf(PBImgAnalysisErr->_msg, "IKMCSearch NOK");
+      PBErrCatch(PBImgAnalysisErr);
+    }
+    if (IKMCGetNbDist(&clusters) <= 0 ||
+      IKMCGetNbDist(&clusters) >= IKMCGetNbDist(&lloyd)) {
+      PBImgAnalysisErr->_type = PBErrTypeUnitTestFailed;
+      sprintf(PBImgAnalysisErr->_msg, "IKMCGetNbDist NOK (%ld<%ld)",
+        IKMCGetNbDist(&clusters), IKMCGetNbDist(&lloyd));
+      PBErrCatch(PBImgAnalysisErr);
+    }
+    printf("Hamerly computed %ld distances instead of %ld\n", 
+      IKMCGetNbDist(&clusters), IKMCGetNbDist(&lloyd));
+    free(labelsLloyd);
+    ImgKMeansClustersFreeStatic(&lloyd);
+    // At convergence each center is the average of the inputs 
+    // nearest to it
+    VecFloat* sums[3];
+    int count[3] = {0, 0, 0};
+    for (int id = K; id--;)
+      sums[id] = VecFloatCreate(
+        VecGetDim(KMeansClustersCenter(IKMCKMeansClusters(&clusters), 0)));
+    VecShort2D pos = VecShortCreateStatic2D();
+    do {
+      int id = labels[VecGet(&pos, 1) * VecGet(&dim, 0) + 
+        VecGet(&pos, 0)];
+      VecFloat* input = IKMCGetInputOverCell(&clusters, &pos);
+      VecOp(sums[id], 1.0, input, 1.0);
+      ++(count[id]);
+      VecFree(&input);
+    } while (VecStep(&pos, &dim));
+    for (int id = K; id--;) {
+      if (count[id] > 0) {
+        VecScale(sums[id], 1.0 / (float)(count[id]));
+        if (VecDist(sums[id], KMeansClustersCenter(
+          IKMCKMeansClusters(&clusters), id)) > 0.01) {
+          PBImgAnalysisErr->_type = PBErrTypeUnitTestFailed;
+          sprintf(PBImgAnalysisErr->_msg, "IKMCSearch NOK");
+          PBErrCatch(PBImgAnalysisErr);
+        }
+      }
+      VecFree(sums + id);
+    }
+    free(labels);
+    ImgKMeansClustersFreeStatic(&clusters);
+  }
+  GBFree(&img);
+  printf("UnitTestImgKMeansClustersAccelerated OK\n");
+}
+
+// Return the sum over the pixels of the image of the ImgKMeansClusters
+// 'that' of the squared distance of their input over cell to the 
+// center of their cluster
+double UnitTestImgKMeansClustersSSE(const ImgKMeansClusters* const that) {
+  unsigned short* labels = IKMCGetLabelMap(that);
+  VecShort2D dim = GBGetDim(IKMCImg(that));
+  double sse = 0.0;
+  VecShort2D pos = VecShortCreateStatic2D();
+  do {
+    int id = labels[VecGet(&pos, 1) * VecGet(&dim, 0) + 
+      VecGet(&pos, 0)];
+    VecFloat* input = IKMCGetInputOverCell(that, &pos);
+    float d = VecDist(input, 
+      KMeansClustersCenter(IKMCKMeansClusters(that), id));
+    sse += d * d;
+    VecFree(&input);
+  } while (VecStep(&pos, &dim));
+  free(labels);
+  return sse;
+}
+
+void UnitTestImgKMeansClustersMiniBatch() {
+  srandom(1);
+  char* fileName = "./ImgKMeansClustersTest/imgkmeanscluster.tga";
+  GenBrush* img = GBCreateFromFile(fileName);
+  int K = 3;
+  // Get the within-cluster sum of squares of the full search as a 
+  // reference
+  ImgKMeansClusters full = ImgKMeansClustersCreateStatic(
+    img, KMeansClustersSeed_PlusPlus, 1);
+  IKMCSearch(&full, K);
+  double sseFull = UnitTestImgKMeansClustersSSE(&full);
+  ImgKMeansClustersFreeStatic(&full);
+  ImgKMeansClusters clusters = ImgKMeansClustersCreateStatic(
+    img, KMeansClustersSeed_PlusPlus, 1);
+  if (IKMCGetSizeBatch(&clusters) != 0) {
+    PBImgAnalysisErr->_type = PBErrTypeUnitTestFailed;
+    sprintf(PBImgAnalysisErr->_msg, "ImgKMeansClustersCreateStatic NOK");
+    PBErrCatch(PBImgAnalysisErr);
+  }
+  IKMCSetSizeBatch(&clusters, 100);
+  if (IKMCGetSizeBatch(&clusters) != 100) {
+    PBImgAnalysisErr->_type = PBErrTypeUnitTestFailed;
+    sprintf(PBImgAnalysisErr->_msg, "IKMCSetSizeBatch NOK");
+    PBErrCatch(PBImgAnalysisErr);
+  }
+  IKMCSearch(&clusters, K);
+  if (IKMCGetK(&clusters) != K) {
+    PBImgAnalysisErr->_type = PBErrTypeUnitTestFailed;
+    sprintf(PBImgAnalysisErr->_msg, "IKMCSearch NOK");
+    PBErrCatch(PBImgAnalysisErr);
+  }
+  for (int id = K; id--;) {
+    const VecFloat* center = 
+      KMeansClustersCenter(IKMCKMeansClusters(&clusters), id);
+    if (VecGetDim(center) != 36) {
+      PBImgAnalysisErr->_type = PBErrTypeUnitTestFailed;
+      sprintf(PBImgAnalysisErr->_msg, "IKMCSearch NOK");
+      PBErrCatch(PBImgAnalysisErr);
+    }
+    for (int i = VecGetDim(center); i--;) {
+      if (VecGet(center, i) < 0.0 || VecGet(center, i) > 255.0) {
+        PBImgAnalysisErr->_type = PBErrTypeUnitTestFailed;
+        sprintf(PBImgAnalysisErr->_msg, "IKMCSearch NOK");
+        PBErrCatch(PBImgAnalysisErr);
+      }
+    }
+  }
+  // The mini-batch search is nearly as good as the full search
+  double sse = UnitTestImgKMeansClustersSSE(&clusters);
+  printf("Within-cluster sum of squares: mini-batch %f full %f\n", 
+    sse, sseFull);
+  if (sse > sseFull * 1.2) {
+    PBImgAnalysisErr->_type = PBErrTypeUnitTestFailed;
+    sprintf(PBImgAnalysisErr->_msg, "IKMCSearch NOK (%f<=%f)", 
+      sse, sseFull * 1.2);
+    PBErrCatch(PBImgAnalysisErr);
+  }
+  IKMCCluster(&clusters);
+  GBSetFileName(img, 
+    "./ImgKMeansClustersTest/imgkmeansclusterminibatch.tga");
+  GBRender(img);
+  ImgKMeansClustersFreeStatic(&clusters);
+  GBFree(&img);
+  printf("UnitTestImgKMeansClustersMiniBatch OK\n");
+}
+
+void UnitTestImgKMeansClustersCell() {
+  // Number of pixels in the cell for each size
+  int nbPixel[3] = {1, 9, 21};
+  for (int size = 0; size < 3; ++size) {
+    IKMCCell cell = IKMCCellCreateStatic(size);
+    if (cell._nbPixel != nbPixel[size]) {
+      PBImgAnalysisErr->_type = PBErrTypeUnitTestFailed;
+      sprintf(PBImgAnalysisErr->_msg, "IKMCCellCreateStatic NOK");
+      PBErrCatch(PBImgAnalysisErr);
+    }
+    for (int iPix = cell._nbPixel; iPix--;) {
+      short x = cell._offsets[2 * iPix];
+      short y = cell._offsets[2 * iPix + 1];
+      if (abs(x) > size || abs(y) > size) {
+        PBImgAnalysisErr->_type = PBErrTypeUnitTestFailed;
+        sprintf(PBImgAnalysisErr->_msg, "IKMCCellCreateStatic NOK");
+        PBErrCatch(PBImgAnalysisErr);
+      }
+    }
+    IKMCCellFreeStatic(&cell);
+    if (cell._offsets != NULL) {
+      PBImgAnalysisErr->_type = PBErrTypeUnitTestFailed;
+      sprintf(PBImgAnalysisErr->_msg, "IKMCCellFreeStatic NOK");
+      PBErrCatch(PBImgAnalysisErr);
+    }
+  }
+  // The cell of the ImgKMeansClusters follows its size
+  GenBrush* img = 
+    GBCreateFromFile("./ImgKMeansClustersTest/imgkmeanscluster.tga");
+  ImgKMeansClusters clusters = ImgKMeansClustersCreateStatic(
+    img, KMeansClustersSeed_Forgy, 0);
+  for (int size = 0; size < 3; ++size) {
+    IKMCSetSizeCell(&clusters, size);
+    if (clusters._cell._nbPixel != nbPixel[size]) {
+      PBImgAnalysisErr->_type = PBErrTypeUnitTestFailed;
+      sprintf(PBImgAnalysisErr->_msg, "IKMCSetSizeCell NOK");
+      PBErrCatch(PBImgAnalysisErr);
+    }
+    VecShort2D pos = VecShortCreateStatic2D();
+    VecFloat* input = IKMCGetInputOverCell(&clusters, &pos);
+    if (VecGetDim(input) != 4 * nbPixel[size]) {
+      PBImgAnalysisErr->_type = PBErrTypeUnitTestFailed;
+      sprintf(PBImgAnalysisErr->_msg, "IKMCGetInputOverCell NOK");
+      PBErrCatch(PBImgAnalysisErr);
+    }
+    VecFree(&input);
+  }
+  ImgKMeansClustersFreeStatic(&clusters);
+  GBFree(&img);
+  printf("UnitTestImgKMeansClustersCell OK\n");
+}
+
 void UnitTestIntersectionOverUnion() {
   char* fileNameA = "./iou1.tga";
   GenBrush* imgA = GBCreateFromFile(fileNameA);
@@ -71,6 +402,58 @@ void UnitTestIntersectionOverUnion() {
   printf("UnitTestIntersectionOverUnion OK\n");
 }
 
+void UnitTestIntersectionOverUnionBitMask() {
+  char* fileNameA = "./iou1.tga";
+  GenBrush* imgA = GBCreateFromFile(fileNameA);
+  char* fileNameB = "./iou2.tga";
+  GenBrush* imgB = GBCreateFromFile(fileNameB);
+  GBPixel rgba = GBColorBlack;
+  ImgBitMask* maskA = ImgBitMaskCreateFromGenBrush(imgA, &rgba);
+  ImgBitMask* maskB = ImgBitMaskCreateFromGenBrush(imgB, &rgba);
+  VecShort2D dim = GBGetDim(imgA);
+  VecShort2D pos = VecShortCreateStatic2D();
+  long nbSet = 0;
+  do {
+    bool isSame = GBPixelIsSame(GBFinalPixel(imgA, &pos), &rgba);
+    if (IBMGet(maskA, VecGet(&pos, 0), VecGet(&pos, 1)) != isSame) {
+      PBImgAnalysisErr->_type = PBErrTypeUnitTestFailed;
+      sprintf(PBImgAnalysisErr->_msg, 
+        "ImgBitMaskCreateFromGenBrush failed");
+      PBErrCatch(PBImgAnalysisErr);
+    }
+    nbSet += isSame;
+  } while (VecStep(&pos, &dim));
+  if (IBMGetNbSet(maskA) != nbSet) {
+    PBImgAnalysisErr->_type = PBErrTypeUnitTestFailed;
+    sprintf(PBImgAnalysisErr->_msg, "IBMGetNbSet failed");
+    PBErrCatch(PBImgAnalysisErr);
+  }
+  float iou = IntersectionOverUnionBitMask(maskA, maskB);
+  if (!ISEQUALF(iou, 6.0 / 10.0)) {
+    PBImgAnalysisErr->_type = PBErrTypeUnitTestFailed;
+    sprintf(PBImgAnalysisErr->_msg, 
+      "IntersectionOverUnionBitMask failed");
+    PBErrCatch(PBImgAnalysisErr);
+  }
+  ImgBitMaskFree(&maskA);
+  ImgBitMaskFree(&maskB);
+  rgba = GBColorRed;
+  maskA = ImgBitMaskCreateFromGenBrush(imgA, &rgba);
+  maskB = ImgBitMaskCreateFromGenBrush(imgB, &rgba);
+  iou = IntersectionOverUnionBitMask(maskA, maskB);
+  if (!ISEQUALF(iou, 1.0)) {
+    PBImgAnalysisErr->_type = PBErrTypeUnitTestFailed;
+    sprintf(PBImgAnalysisErr->_msg, 
+      "IntersectionOverUnionBitMask failed");
+    PBErrCatch(PBImgAnalysisErr);
+  }
+  ImgBitMaskFree(&maskA);
+  ImgBitMaskFree(&maskB);
+  GBFree(&imgA);
+  GBFree(&imgB);
+  printf("UnitTestIntersectionOverUnionBitMask OK\n");
+}
+
 void UnitTestGBSimilarityCoefficient() {
   char* fileNameA = "./iou1.tga";
   GenBrush* imgA = GBCreateFromFile(fileNameA);
@@ -93,6 +476,145 @@ void UnitTestGBSimilarityCoefficient() {
   printf("UnitTestIntersectionOverUnion OK\n");
 }
 
+void UnitTestImgSegmentorPlane() {
+  char* fileName = "ISPredict-in.tga";
+  GenBrush* img = GBCreateFromFile(fileName);
+  ImgSegmentorPlane* plane = ImgSegmentorPlaneCreateFromGenBrush(img);
+  VecShort2D dim = GBGetDim(img);
+  if (!VecIsEqual(ISPDim(plane), &dim) || 
+    ISPGetNbChannel(plane) != 3 ||
+    ((size_t)ISPVal(plane) % IS_PLANEALIGN) != 0) {
+    PBImgAnalysisErr->_type = PBErrTypeUnitTestFailed;
+    sprintf(PBImgAnalysisErr->_msg, 
+      "ImgSegmentorPlaneCreateFromGenBrush failed");
+    PBErrCatch(PBImgAnalysisErr);
+  }
+  VecShort2D pos = VecShortCreateStatic2D();
+  do {
+    GBPixel pix = GBGetFinalPixel(img, &pos);
+    long iPos = GBPosIndex(&pos, &dim);
+    for (int iRGB = 3; iRGB--;) {
+      if (!ISEQUALF(ISPVal(plane)[iPos * 3 + iRGB], 
+        (float)(pix._rgba[iRGB]) / 255.0)) {
+        PBImgAnalysisErr->_type = PBErrTypeUnitTestFailed;
+        sprintf(PBImgAnalysisErr->_msg, 
+          "ImgSegmentorPlaneCreateFromGenBrush failed");
+        PBErrCatch(PBImgAnalysisErr);
+      }
+    }
+  } while (VecStep(&pos, &dim));
+  ImgSegmentorPlane* clone = ImgSegmentorPlaneClone(plane);
+  if (memcmp(ISPVal(clone), ISPVal(plane), 
+    sizeof(float) * ISPGetArea(plane) * 3) != 0) {
+    PBImgAnalysisErr->_type = PBErrTypeUnitTestFailed;
+    sprintf(PBImgAnalysisErr->_msg, "ImgSegmentorPlaneClone failed");
+    PBErrCatch(PBImgAnalysisErr);
+  }
+  ImgSegmentorPlane* borrow = plane;
+  ImgSegmentorPlaneRelease(&borrow, plane);
+  if (borrow != NULL || ISPGetNbChannel(plane) != 3) {
+    PBImgAnalysisErr->_type = PBErrTypeUnitTestFailed;
+    sprintf(PBImgAnalysisErr->_msg, "ImgSegmentorPlaneRelease failed");
+    PBErrCatch(PBImgAnalysisErr);
+  }
+  ImgSegmentorPlaneRelease(&clone, plane);
+  if (clone != NULL) {
+    PBImgAnalysisErr->_type = PBErrTypeUnitTestFailed;
+    sprintf(PBImgAnalysisErr->_msg, "ImgSegmentorPlaneRelease failed");
+    PBErrCatch(PBImgAnalysisErr);
+  }
+  ImgSegmentorPlaneFree(&plane);
+  if (plane != NULL) {
+    PBImgAnalysisErr->_type = PBErrTypeUnitTestFailed;
+    sprintf(PBImgAnalysisErr->_msg, "ImgSegmentorPlaneFree failed");
+    PBErrCatch(PBImgAnalysisErr);
+  }
+  GBFree(&img);
+  printf("UnitTestImgSegmentorPlane OK\n");
+}
+
+void UnitTestImgSegmentorPredCache() {
+  VecShort2D dim = VecShortCreateStatic2D();
+  VecSet(&dim, 0, 10);
+  VecSet(&dim, 1, 10);
+  ImgSegmentorPlane* pred = ImgSegmentorPlaneCreate(&dim, 2);
+  for (long i = ISPGetArea(pred) * 2; i--;)
+    ISPVal(pred)[i] = (float)i;
+  unsigned char params[2][4] = {{1, 2, 3, 4}, {1, 2, 3, 5}};
+  size_t sizeEntry = sizeof(ImgSegmentorPredCacheEntry) + 
+    sizeof(params[0]) + sizeof(ImgSegmentorPlane) + 
+    sizeof(float) * ISPGetArea(pred) * 2;
+  ImgSegmentorPredCache* cache = 
+    ImgSegmentorPredCacheCreate(sizeEntry * 2);
+  ImgSegmentorPredCacheKey key = {._paramHash = 1, 
+    ._params = params[0], ._sizeParams = sizeof(params[0]), 
+    ._iCrit = 0, ._iSample = 0, ._dim = dim};
+  // The cache takes ownership of the prediction and returns it pinned
+  ImgSegmentorPlane* predA = ImgSegmentorPlaneClone(pred);
+  ImgSegmentorPredCacheEntry* entryA = ISPCAdd(cache, &key, predA);
+  if (entryA == NULL || entryA->_pred != predA || 
+    entryA->_nbPin != 1 || ISPCAdd(cache, &key, pred) != NULL) {
+    PBImgAnalysisErr->_type = PBErrTypeUnitTestFailed;
+    sprintf(PBImgAnalysisErr->_msg, "ISPCAdd failed");
+    PBErrCatch(PBImgAnalysisErr);
+  }
+  ISPCUnpin(cache, entryA);
+  ImgSegmentorPredCacheKey keyB = key;
+  keyB._paramHash = 2;
+  ImgSegmentorPredCacheEntry* entryB = 
+    ISPCAdd(cache, &keyB, ImgSegmentorPlaneClone(pred));
+  ISPCUnpin(cache, entryB);
+  // The whole key is compared: same hash with other parameters or 
+  // other dimensions doesn't match
+  ImgSegmentorPredCacheKey keyOther = key;
+  keyOther._params = params[1];
+  ImgSegmentorPredCacheEntry* missParams = ISPCGet(cache, &keyOther);
+  keyOther = key;
+  VecSet(&(keyOther._dim), 0, 11);
+  ImgSegmentorPredCacheEntry* missDim = ISPCGet(cache, &keyOther);
+  keyOther = key;
+  keyOther._iCrit = 1;
+  ImgSegmentorPredCacheEntry* missCrit = ISPCGet(cache, &keyOther);
+  ImgSegmentorPredCacheEntry* hit = ISPCGet(cache, &key);
+  if (hit != entryA || hit->_pred != predA || 
+    memcmp(ISPVal(hit->_pred), ISPVal(pred), 
+    sizeof(float) * ISPGetArea(pred) * 2) != 0 || 
+    missParams != NULL || missDim != NULL || missCrit != NULL || 
+    ISPCGetSize(cache) != sizeEntry * 2) {
+    PBImgAnalysisErr->_type = PBErrTypeUnitTestFailed;
+    sprintf(PBImgAnalysisErr->_msg, "ISPCGet failed");
+    PBErrCatch(PBImgAnalysisErr);
+  }
+  ISPCUnpin(cache, hit);
+  // The entry B is the least recently used and is evicted
+  ImgSegmentorPredCacheKey keyC = key;
+  keyC._paramHash = 3;
+  ImgSegmentorPredCacheEntry* entryC = 
+    ISPCAdd(cache, &keyC, ImgSegmentorPlaneClone(pred));
+  ImgSegmentorPredCacheEntry* evicted = ISPCGet(cache, &keyB);
+  hit = ISPCGet(cache, &key);
+  if (entryC == NULL || evicted != NULL || hit != entryA || 
+    ISPCGetSize(cache) != sizeEntry * 2) {
+    PBImgAnalysisErr->_type = PBErrTypeUnitTestFailed;
+    sprintf(PBImgAnalysisErr->_msg, "ISPCAdd failed");
+    PBErrCatch(PBImgAnalysisErr);
+  }
+  // All the entries are pinned, they are not evicted and the new
+  // prediction stays owned by the caller
+  if (ISPCAdd(cache, &keyB, pred) != NULL || 
+    ISPCGet(cache, &keyC) != entryC) {
+    PBImgAnalysisErr->_type = PBErrTypeUnitTestFailed;
+    sprintf(PBImgAnalysisErr->_msg, "ISPCAdd failed");
+    PBErrCatch(PBImgAnalysisErr);
+  }
+  ISPCUnpin(cache, entryC);
+  ISPCUnpin(cache, entryC);
+  ISPCUnpin(cache, hit);
+  ImgSegmentorPredCacheFree(&cache);
+  ImgSegmentorPlaneFree(&pred);
+  printf("UnitTestImgSegmentorPredCache OK\n");
+}
+
 void UnitTestImgSegmentorRGB() {
   int nbClass = 2;
   ImgSegmentorCriterionRGB* criterion = 
@@ -104,18 +626,94 @@ void UnitTestImgSegmentorRGB() {
     PBErrCatch(PBImgAnalysisErr);
   }
   int imgArea = 4;
-  VecFloat* input = VecFloatCreate(imgArea * 3);
   VecShort2D dim = VecShortCreateStatic2D();
   VecSet(&dim, 0, 2);
   VecSet(&dim, 1, 2);
-  VecFloat* output = ISCRGBPredict(criterion, input, &dim, -1);
-  if (VecGetDim(output) != imgArea * nbClass) {
+  ImgSegmentorPlane* input = ImgSegmentorPlaneCreate(&dim, 3);
+  ImgSegmentorPlane* output = ISCRGBPredict(criterion, input, -1, NULL);
+  if (ISPGetArea(output) != imgArea || 
+    ISPGetNbChannel(output) != nbClass) {
     PBImgAnalysisErr->_type = PBErrTypeUnitTestFailed;
     sprintf(PBImgAnalysisErr->_msg, "ISCRGBPredict failed");
     PBErrCatch(PBImgAnalysisErr);
   }
-  VecFree(&input);
-  VecFree(&output);
+  // The lookup table is not used by default
+  if (ISCRGBIsCompiled(criterion) || 
+    ISCRGBGetLUTSize(criterion) != ISCRGB_LUTSIZEDEFAULT) {
+    PBImgAnalysisErr->_type = PBErrTypeUnitTestFailed;
+    sprintf(PBImgAnalysisErr->_msg, "ImgSegmentorCriterionRGB failed");
+    PBErrCatch(PBImgAnalysisErr);
+  }
+  ISCRGBCompile(criterion);
+  if (ISCRGBIsCompiled(criterion)) {
+    PBImgAnalysisErr->_type = PBErrTypeUnitTestFailed;
+    sprintf(PBImgAnalysisErr->_msg, "ISCRGBCompile failed");
+    PBErrCatch(PBImgAnalysisErr);
+  }
+  // The lookup table is exact on the samples of its grid
+  int lutSize = 64;
+  ISCRGBSetLUTSize(criterion, lutSize);
+  float* val = ISPVal(input);
+  for (long i = imgArea * 3; i--;)
+    val[i] = (float)((int)(rnd() * (lutSize - 1))) / 
+      (float)(lutSize - 1);
+  ImgSegmentorPlaneFree(&output);
+  output = ISCRGBPredict(criterion, input, -1, NULL);
+  ISCRGBCompile(criterion);
+  ImgSegmentorPlane* outputLUT = ISCRGBPredict(criterion, input, -1, NULL);
+  if (!ISCRGBIsCompiled(criterion)) {
+    PBImgAnalysisErr->_type = PBErrTypeUnitTestFailed;
+    sprintf(PBImgAnalysisErr->_msg, "ISCRGBCompile failed");
+    PBErrCatch(PBImgAnalysisErr);
+  }
+  for (long i = imgArea * nbClass; i--;) {
+    if (fabs(ISPVal(output)[i] - ISPVal(outputLUT)[i]) > 0.0001) {
+      PBImgAnalysisErr->_type = PBErrTypeUnitTestFailed;
+      sprintf(PBImgAnalysisErr->_msg, "ISCRGBCompile failed");
+      PBErrCatch(PBImgAnalysisErr);
+    }
+  }
+  ImgSegmentorPlaneFree(&outputLUT);
+  // Measure the error of the lookup table at colors off its grid, it
+  // decreases with the size of the table
+  VecSet(&dim, 0, 100);
+  VecSet(&dim, 1, 100);
+  ImgSegmentorPlane* offGrid = ImgSegmentorPlaneCreate(&dim, 3);
+  for (long i = ISPGetArea(offGrid) * 3; i--;)
+    ISPVal(offGrid)[i] = rnd();
+  ISCRGBSetLUTSize(criterion, 0);
+  ImgSegmentorPlane* exact = ISCRGBPredict(criterion, offGrid, -1, NULL);
+  int lutSizes[2] = {8, 64};
+  float maxErr[2] = {0.0, 0.0};
+  for (int iSize = 0; iSize < 2; ++iSize) {
+    ISCRGBSetLUTSize(criterion, lutSizes[iSize]);
+    ISCRGBCompile(criterion);
+    outputLUT = ISCRGBPredict(criterion, offGrid, -1, NULL);
+    for (long i = ISPGetArea(offGrid) * nbClass; i--;) {
+      float err = fabs(ISPVal(exact)[i] - ISPVal(outputLUT)[i]);
+      if (err > maxErr[iSize])
+        maxErr[iSize] = err;
+    }
+    printf("Max error of the lookup table of size %d: %f\n", 
+      lutSizes[iSize], maxErr[iSize]);
+    ImgSegmentorPlaneFree(&outputLUT);
+  }
+  if (maxErr[1] > maxErr[0] || maxErr[1] > 0.05) {
+    PBImgAnalysisErr->_type = PBErrTypeUnitTestFailed;
+    sprintf(PBImgAnalysisErr->_msg, "ISCRGBCompile failed");
+    PBErrCatch(PBImgAnalysisErr);
+  }
+  ImgSegmentorPlaneFree(&exact);
+  ImgSegmentorPlaneFree(&offGrid);
+  ISCRGBSetLUTSize(criterion, 0);
+  ISCRGBCompile(criterion);
+  if (ISCRGBIsCompiled(criterion)) {
+    PBImgAnalysisErr->_type = PBErrTypeUnitTestFailed;
+    sprintf(PBImgAnalysisErr->_msg, "ISCRGBSetLUTSize failed");
+    PBErrCatch(PBImgAnalysisErr);
+  }
+  ImgSegmentorPlaneFree(&input);
+  ImgSegmentorPlaneFree(&output);
   ImgSegmentorCriterionRGBFree(&criterion);
   printf("UnitTestImgSegmentorRGB OK\n");
 }
@@ -211,6 +809,28 @@ void UnitTestImgSegmentorAddCriterionGetSet() {
     sprintf(PBImgAnalysisErr->_msg, "ISSetSizePool failed");
     PBErrCatch(PBImgAnalysisErr);
   }
+  if (ISGetNbThread(&segmentor) != 1) {
+    PBImgAnalysisErr->_type = PBErrTypeUnitTestFailed;
+    sprintf(PBImgAnalysisErr->_msg, "ISGetNbThread failed");
+    PBErrCatch(PBImgAnalysisErr);
+  }
+  ISSetNbThread(&segmentor, 4);
+  if (ISGetNbThread(&segmentor) != 4) {
+    PBImgAnalysisErr->_type = PBErrTypeUnitTestFailed;
+    sprintf(PBImgAnalysisErr->_msg, "ISSetNbThread failed");
+    PBErrCatch(PBImgAnalysisErr);
+  }
+  if (ISGetPredCacheBudget(&segmentor) != IS_PREDCACHEBUDGETDEFAULT) {
+    PBImgAnalysisErr->_type = PBErrTypeUnitTestFailed;
+    sprintf(PBImgAnalysisErr->_msg, "ISGetPredCacheBudget failed");
+    PBErrCatch(PBImgAnalysisErr);
+  }
+  ISSetPredCacheBudget(&segmentor, 1024);
+  if (ISGetPredCacheBudget(&segmentor) != 1024) {
+    PBImgAnalysisErr->_type = PBErrTypeUnitTestFailed;
+    sprintf(PBImgAnalysisErr->_msg, "ISSetPredCacheBudget failed");
+    PBErrCatch(PBImgAnalysisErr);
+  }
   if (ISGetNbElite(&segmentor) != GENALG_NBELITES) {
     PBImgAnalysisErr->_type = PBErrTypeUnitTestFailed;
     sprintf(PBImgAnalysisErr->_msg, "ISGetNbElite failed");
@@ -259,6 +879,199 @@ void UnitTestImgSegmentorAddCriterionGetSet() {
   printf("UnitTestImgSegmentorAddCriterionGetSet OK\n");
 }
 
+void UnitTestImgSegmentorSaveStream() {
+  int nbClass = 2;
+  ImgSegmentor segmentor = ImgSegmentorCreateStatic(nbClass);
+  ImgSegmentorCriterionRGB2HSV* criterionHSV = 
+    ISAddCriterionRGB2HSV(&segmentor, NULL);
+  ISAddCriterionRGB(&segmentor, criterionHSV);
+  ISAddCriterionTex(&segmentor, NULL, 1, 2);
+  // Add a criterion Dust to encode a VecLong
+  ImgSegmentorCriterionDust* dust = 
+    ImgSegmentorCriterionDustCreate(nbClass);
+  VecSet(dust->_size, 0, 3);
+  GenTreeAppendData(&(segmentor._criteria), dust);
+  // The streamed encoding must be identical to the one of the JSONNode
+  char* fileName = "unitTestImgSegmentorSaveStream.json";
+  char* fileNameRef = "unitTestImgSegmentorSaveStreamRef.json";
+  FILE* stream = fopen(fileName, "w");
+  if (!ISSave(&segmentor, stream, false)) {
+    PBImgAnalysisErr->_type = PBErrTypeUnitTestFailed;
+    sprintf(PBImgAnalysisErr->_msg, "ISSave failed");
+    PBErrCatch(PBImgAnalysisErr);
+  }
+  fclose(stream);
+  stream = fopen(fileNameRef, "w");
+  JSONNode* json = ISEncodeAsJSON(&segmentor);
+  JSONSave(json, stream, false);
+  JSONFree(&json);
+  fclose(stream);
+  if (!UnitTestFileIsEqual(fileName, fileNameRef)) {
+    PBImgAnalysisErr->_type = PBErrTypeUnitTestFailed;
+    sprintf(PBImgAnalysisErr->_msg, "ISEncodeAsJSONStream failed");
+    PBErrCatch(PBImgAnalysisErr);
+  }
+  // The compact form must be loadable
+  stream = fopen(fileName, "w");
+  if (!ISSave(&segmentor, stream, true)) {
+    PBImgAnalysisErr->_type = PBErrTypeUnitTestFailed;
+    sprintf(PBImgAnalysisErr->_msg, "ISSave failed");
+    PBErrCatch(PBImgAnalysisErr);
+  }
+  fclose(stream);
+  stream = fopen(fileName, "r");
+  ImgSegmentor load = ImgSegmentorCreateStatic(1);
+  if (!ISLoad(&load, stream) || 
+    ISGetNbCriterion(&load) != ISGetNbCriterion(&segmentor)) {
+    PBImgAnalysisErr->_type = PBErrTypeUnitTestFailed;
+    sprintf(PBImgAnalysisErr->_msg, "ISLoad failed");
+    PBErrCatch(PBImgAnalysisErr);
+  }
+  fclose(stream);
+  remove(fileName);
+  remove(fileNameRef);
+  ImgSegmentorFreeStatic(&load);
+  ImgSegmentorFreeStatic(&segmentor);
+  printf("UnitTestImgSegmentorSaveStream OK\n");
+}
+
+void UnitTestImgSegmentorSaveLoadBinary() {
+  int nbClass = 2;
+  ImgSegmentor segmentor = ImgSegmentorCreateStatic(nbClass);
+  ImgSegmentorCriterionRGB* rgb = ISAddCriterionRGB(&segmentor, NULL);
+  ImgSegmentorCriterionRGB2HSV* criterionHSV = 
+    ISAddCriterionRGB2HSV(&segmentor, NULL);
+  ISAddCriterionRGB(&segmentor, criterionHSV);
+  ISAddCriterionTex(&segmentor, NULL, 1, 2);
+  ISCRGBSetLUTSize(rgb, 64);
+  ISCSetIsFrozen(criterionHSV, true);
+  ISCompile(&segmentor);
+  char* fileName = "unitTestImgSegmentorSaveLoad.bin";
+  FILE* stream = fopen(fileName, "wb");
+  if (!ISSaveBinary(&segmentor, stream)) {
+    PBImgAnalysisErr->_type = PBErrTypeUnitTestFailed;
+    sprintf(PBImgAnalysisErr->_msg, "ISSaveBinary failed");
+    PBErrCatch(PBImgAnalysisErr);
+  }
+  fclose(stream);
+  stream = fopen(fileName, "rb");
+  ImgSegmentor load = ImgSegmentorCreateStatic(1);
+  if (!ISLoadBinary(&load, stream)) {
+    PBImgAnalysisErr->_type = PBErrTypeUnitTestFailed;
+    sprintf(PBImgAnalysisErr->_msg, "ISLoadBinary failed");
+    PBErrCatch(PBImgAnalysisErr);
+  }
+  fclose(stream);
+  const ImgSegmentorCriterionRGB* criterionRGB = (ImgSegmentorCriterionRGB*)
+    GenTreeData((GenTree*)GSetGet(&(load._criteria._subtrees), 0));
+  if (load._nbClass != segmentor._nbClass ||
+    load._nbEpoch != segmentor._nbEpoch ||
+    load._sizePool != segmentor._sizePool ||
+    load._nbElite != segmentor._nbElite ||
+    ISGetNbCriterion(&load) != ISGetNbCriterion(&segmentor) ||
+    load._binMap == NULL || !(criterionRGB->_flagLUTBorrowed)) {
+    PBImgAnalysisErr->_type = PBErrTypeUnitTestFailed;
+    sprintf(PBImgAnalysisErr->_msg, "ISLoadBinary failed");
+    PBErrCatch(PBImgAnalysisErr);
+  }
+  // The frozen flag of the criteria must be restored
+  const ImgSegmentorCriterion* criterionLoad = GenTreeData(
+    (GenTree*)GSetGet(&(load._criteria._subtrees), 1));
+  if (criterionLoad->_type != ISCType_RGB2HSV || 
+    !ISCIsFrozen(criterionLoad) || ISCIsFrozen(criterionRGB)) {
+    PBImgAnalysisErr->_type = PBErrTypeUnitTestFailed;
+    sprintf(PBImgAnalysisErr->_msg, "ISLoadBinary failed");
+    PBErrCatch(PBImgAnalysisErr);
+  }
+  // The loaded ImgSegmentor must predict the same scores
+  GenBrush* img = GBCreateFromFile("ISPredict-in.tga");
+  float* scores = ISPredictScores(&segmentor, img, NULL);
+  float* scoresLoad = ISPredictScores(&load, img, NULL);
+  VecShort2D dim = GBGetDim(img);
+  if (memcmp(scores, scoresLoad, sizeof(float) * nbClass * 
+    VecGet(&dim, 0) * VecGet(&dim, 1)) != 0) {
+    PBImgAnalysisErr->_type = PBErrTypeUnitTestFailed;
+    sprintf(PBImgAnalysisErr->_msg, "ISLoadBinary failed");
+    PBErrCatch(PBImgAnalysisErr);
+  }
+  free(scores);
+  // A corrupted file is rejected and leaves the loaded ImgSegmentor
+  // untouched: misaligned offset, number of values overflowing the 
+  // size of the file, number of classes different from the one of 
+  // the ImgSegmentor, rank and size of the Tex criterion out of range
+  stream = fopen(fileName, "rb");
+  fseek(stream, 0, SEEK_END);
+  long sizeFile = ftell(stream);
+  fseek(stream, 0, SEEK_SET);
+  char* buffer = PBErrMalloc(PBImgAnalysisErr, sizeFile);
+  if (fread(buffer, 1, sizeFile, stream) != (size_t)sizeFile) {
+    PBImgAnalysisErr->_type = PBErrTypeUnitTestFailed;
+    sprintf(PBImgAnalysisErr->_msg, "ISLoadBinary failed");
+    PBErrCatch(PBImgAnalysisErr);
+  }
+  fclose(stream);
+  ISBinNode* nodes = (ISBinNode*)(buffer + sizeof(ISBinHeader));
+  ISBinNode* nodeRGB = nodes + 1;
+  ISBinNode* nodeTex = NULL;
+  for (long iNode = 0; iNode < ((ISBinHeader*)buffer)->_nbNode; ++iNode)
+    if (nodes[iNode]._type == ISCType_Tex)
+      nodeTex = nodes + iNode;
+  char* fileNameCorrupted = "unitTestImgSegmentorSaveLoadCorrupted.bin";
+  for (int iCorruption = 0; iCorruption < 5; ++iCorruption) {
+    ISBinNode node = *nodeRGB;
+    ISBinNode nodeT = *nodeTex;
+    if (iCorruption == 0)
+      nodeRGB->_offLUT += sizeof(float);
+    else if (iCorruption == 1)
+      nodeRGB->_nbLUT = INT64_MAX / 2;
+    else if (iCorruption == 2)
+      nodeRGB->_nbClass = nbClass + 1;
+    else if (iCorruption == 3)
+      nodeTex->_param[0] = ISCTEX_RANKMAX + 1;
+    else
+      nodeTex->_param[1] = INT32_MAX;
+    stream = fopen(fileNameCorrupted, "wb");
+    fwrite(buffer, 1, sizeFile, stream);
+    fclose(stream);
+    *nodeRGB = node;
+    *nodeTex = nodeT;
+    stream = fopen(fileNameCorrupted, "rb");
+    if (ISLoadBinary(&load, stream) || 
+      ISGetNbCriterion(&load) != ISGetNbCriterion(&segmentor) ||
+      load._binMap == NULL) {
+      PBImgAnalysisErr->_type = PBErrTypeUnitTestFailed;
+      sprintf(PBImgAnalysisErr->_msg, "ISLoadBinary failed");
+      PBErrCatch(PBImgAnalysisErr);
+    }
+    fclose(stream);
+  }
+  remove(fileNameCorrupted);
+  free(buffer);
+  scores = ISPredictScores(&load, img, NULL);
+  if (memcmp(scores, scoresLoad, sizeof(float) * nbClass * 
+    VecGet(&dim, 0) * VecGet(&dim, 1)) != 0) {
+    PBImgAnalysisErr->_type = PBErrTypeUnitTestFailed;
+    sprintf(PBImgAnalysisErr->_msg, "ISLoadBinary failed");
+    PBErrCatch(PBImgAnalysisErr);
+  }
+  free(scores);
+  free(scoresLoad);
+  GBFree(&img);
+  // A JSON file is not a valid binary file
+  stream = fopen("unitTestImgSegmentorSaveLoad.json", "rb");
+  if (stream != NULL) {
+    if (ISLoadBinary(&load, stream)) {
+      PBImgAnalysisErr->_type = PBErrTypeUnitTestFailed;
+      sprintf(PBImgAnalysisErr->_msg, "ISLoadBinary failed");
+      PBErrCatch(PBImgAnalysisErr);
+    }
+    fclose(stream);
+  }
+  ImgSegmentorFreeStatic(&load);
+  ImgSegmentorFreeStatic(&segmentor);
+  printf("UnitTestImgSegmentorSaveLoadBinary OK\n");
+}
+
 void UnitTestImgSegmentorSaveLoad() {
   int nbClass = 2;
   ImgSegmentor segmentor = ImgSegmentorCreateStatic(nbClass);
@@ -371,6 +1184,1049 @@ void UnitTestImgSegmentorPredict() {
   printf("UnitTestImgSegmentorPredict OK\n");
 }
 
+void UnitTestImgSegmentorPredictWithContext() {
+  int nbClass = 2;
+  ImgSegmentor segmentor = ImgSegmentorCreateStatic(nbClass);
+  ImgSegmentorCriterionRGB2HSV* criterionHSV = 
+    ISAddCriterionRGB2HSV(&segmentor, NULL);
+  (void)ISAddCriterionRGB(&segmentor, criterionHSV);
+  char* fileNameIn = "ISPredict-in.tga";
+  GenBrush* img = GBCreateFromFile(fileNameIn);
+  GenBrush** res = ISPredict(&segmentor, img);
+  ImgSegmentorContext* ctx = ImgSegmentorContextCreate(&segmentor);
+  GenBrush** resCtx = ISPredictWithContext(&segmentor, img, ctx);
+  if (resCtx == NULL || ISCtxIsError(ctx)) {
+    PBImgAnalysisErr->_type = PBErrTypeUnitTestFailed;
+    sprintf(PBImgAnalysisErr->_msg, "ISPredictWithContext failed");
+    PBErrCatch(PBImgAnalysisErr);
+  }
+  VecShort2D dim = GBGetDim(img);
+  for (int iClass = nbClass; iClass--;) {
+    VecShort2D pos = VecShortCreateStatic2D();
+    do {
+      GBPixel pix = GBGetFinalPixel(res[iClass], &pos);
+      GBPixel pixCtx = GBGetFinalPixel(resCtx[iClass], &pos);
+      if (memcmp(pix._rgba, pixCtx._rgba, 4) != 0) {
+        PBImgAnalysisErr->_type = PBErrTypeUnitTestFailed;
+        sprintf(PBImgAnalysisErr->_msg, "ISPredictWithContext failed");
+        PBErrCatch(PBImgAnalysisErr);
+      }
+    } while (VecStep(&pos, &dim));
+    GBFree(res + iClass);
+    GBFree(resCtx + iClass);
+  }
+  free(res);
+  free(resCtx);
+  volatile bool flagStop = true;
+  ISCtxSetFlagStop(ctx, &flagStop);
+  resCtx = ISPredictWithContext(&segmentor, img, ctx);
+  if (resCtx != NULL || !ISCtxIsError(ctx)) {
+    PBImgAnalysisErr->_type = PBErrTypeUnitTestFailed;
+    sprintf(PBImgAnalysisErr->_msg, "ISCtxSetFlagStop failed");
+    PBErrCatch(PBImgAnalysisErr);
+  }
+  // A context created before the criteria are modified is outdated
+  ISCtxSetFlagStop(ctx, NULL);
+  ISCompile(&segmentor);
+  resCtx = ISPredictWithContext(&segmentor, img, ctx);
+  if (resCtx != NULL || !ISCtxIsError(ctx)) {
+    PBImgAnalysisErr->_type = PBErrTypeUnitTestFailed;
+    sprintf(PBImgAnalysisErr->_msg, "ISPredictWithContext failed");
+    PBErrCatch(PBImgAnalysisErr);
+  }
+  ImgSegmentorContextFree(&ctx);
+  ctx = ImgSegmentorContextCreate(&segmentor);
+  resCtx = ISPredictWithContext(&segmentor, img, ctx);
+  if (resCtx == NULL || ISCtxIsError(ctx)) {
+    PBImgAnalysisErr->_type = PBErrTypeUnitTestFailed;
+    sprintf(PBImgAnalysisErr->_msg, "ISPredictWithContext failed");
+    PBErrCatch(PBImgAnalysisErr);
+  }
+  for (int iClass = nbClass; iClass--;)
+    GBFree(resCtx + iClass);
+  free(resCtx);
+  ImgSegmentorContextFree(&ctx);
+  ImgSegmentorFreeStatic(&segmentor);
+  GBFree(&img);
+  printf("UnitTestImgSegmentorPredictWithContext OK\n");
+}
+
+void UnitTestImgSegmentorPredictBatch() {
+  int nbClass = 2;
+  ImgSegmentor segmentor = ImgSegmentorCreateStatic(nbClass);
+  (void)ISAddCriterionRGB(&segmentor, NULL);
+  char* fileNameIn = "ISPredict-in.tga";
+  int nbImg = 3;
+  GenBrush* imgs[3];
+  for (int iImg = nbImg; iImg--;)
+    imgs[iImg] = GBCreateFromFile(fileNameIn);
+  GenBrush** res = ISPredict(&segmentor, imgs[0]);
+  int nbThread = 2;
+  GenBrush*** resBatch = ISPredictBatch(&segmentor, 
+    (const GenBrush* const*)imgs, nbImg, nbThread);
+  VecShort2D dim = GBGetDim(imgs[0]);
+  for (int iImg = nbImg; iImg--;) {
+    if (resBatch[iImg] == NULL) {
+      PBImgAnalysisErr->_type = PBErrTypeUnitTestFailed;
+      sprintf(PBImgAnalysisErr->_msg, "ISPredictBatch failed");
+      PBErrCatch(PBImgAnalysisErr);
+    }
+    for (int iClass = nbClass; iClass--;) {
+      VecShort2D pos = VecShortCreateStatic2D();
+      do {
+        GBPixel pix = GBGetFinalPixel(res[iClass], &pos);
+        GBPixel pixBatch = GBGetFinalPixel(resBatch[iImg][iClass], &pos);
+        if (memcmp(pix._rgba, pixBatch._rgba, 4) != 0) {
+          PBImgAnalysisErr->_type = PBErrTypeUnitTestFailed;
+          sprintf(PBImgAnalysisErr->_msg, "ISPredictBatch failed");
+          PBErrCatch(PBImgAnalysisErr);
+        }
+      } while (VecStep(&pos, &dim));
+      GBFree(resBatch[iImg] + iClass);
+    }
+    free(resBatch[iImg]);
+    GBFree(imgs + iImg);
+  }
+  free(resBatch);
+  for (int iClass = nbClass; iClass--;)
+    GBFree(res + iClass);
+  free(res);
+  ImgSegmentorFreeStatic(&segmentor);
+  printf("UnitTestImgSegmentorPredictBatch OK\n");
+}
+
+void UnitTestImgSegmentorPredictScores() {
+  int nbClass = 2;
+  ImgSegmentor segmentor = ImgSegmentorCreateStatic(nbClass);
+  (void)ISAddCriterionRGB(&segmentor, NULL);
+  char* fileNameIn = "ISPredict-in.tga";
+  GenBrush* img = GBCreateFromFile(fileNameIn);
+  GenBrush** res = ISPredict(&segmentor, img);
+  float* scores = ISPredictScores(&segmentor, img, NULL);
+  unsigned char* scoresUInt8 = 
+    ISPredictScoresUInt8(&segmentor, img, NULL);
+  if (scores == NULL || scoresUInt8 == NULL) {
+    PBImgAnalysisErr->_type = PBErrTypeUnitTestFailed;
+    sprintf(PBImgAnalysisErr->_msg, "ISPredictScores failed");
+    PBErrCatch(PBImgAnalysisErr);
+  }
+  VecShort2D dim = GBGetDim(img);
+  long area = VecGet(&dim, 0) * VecGet(&dim, 1);
+  for (int iClass = nbClass; iClass--;) {
+    VecShort2D pos = VecShortCreateStatic2D();
+    do {
+      long iPos = iClass * area + GBPosIndex(&pos, &dim);
+      GBPixel pix = GBGetFinalPixel(res[iClass], &pos);
+      if (scores[iPos] < -1.0 || scores[iPos] > 1.0 ||
+        pix._rgba[GBPixelRed] != scoresUInt8[iPos] ||
+        ISScoreToGrey(&segmentor, scores[iPos]) != scoresUInt8[iPos]) {
+        PBImgAnalysisErr->_type = PBErrTypeUnitTestFailed;
+        sprintf(PBImgAnalysisErr->_msg, "ISPredictScores failed");
+        PBErrCatch(PBImgAnalysisErr);
+      }
+    } while (VecStep(&pos, &dim));
+    GBFree(res + iClass);
+  }
+  free(res);
+  free(scores);
+  free(scoresUInt8);
+  GBFree(&img);
+  ImgSegmentorFreeStatic(&segmentor);
+  printf("UnitTestImgSegmentorPredictScores OK\n");
+}
+
+void UnitTestImgSegmentorEvaluateSample() {
+  int nbClass = 2;
+  ImgSegmentor segmentor = ImgSegmentorCreateStatic(nbClass);
+  (void)ISAddCriterionRGB(&segmentor, NULL);
+  GDSGenBrushPair sample;
+  sample._img = GBCreateFromFile("ISPredict-in.tga");
+  char fileNameMask[50];
+  for (int iClass = nbClass; iClass--;) {
+    sprintf(fileNameMask, "ISPredict-out%02d.tga", iClass);
+    sample._mask[iClass] = GBCreateFromFile(fileNameMask);
+  }
+  GenBrush** pred = ISPredict(&segmentor, sample._img);
+  const GBPixel rgbaMask = GBColorBlack; 
+  float check = 0.0;
+  for (int iClass = nbClass; iClass--;)
+    check += IntersectionOverUnion(sample._mask[iClass], pred[iClass], 
+      &rgbaMask);
+  check /= (float)nbClass;
+  float value = ISEvaluateSample(&segmentor, &sample, -1, nbClass);
+  if (fabs(value - check) > PBMATH_EPSILON) {
+    PBImgAnalysisErr->_type = PBErrTypeUnitTestFailed;
+    sprintf(PBImgAnalysisErr->_msg, "ISEvaluateSample failed");
+    PBErrCatch(PBImgAnalysisErr);
+  }
+  for (int iClass = nbClass; iClass--;) {
+    GBFree(pred + iClass);
+    GBFree(sample._mask + iClass);
+  }
+  free(pred);
+  GBFree(&(sample._img));
+  ImgSegmentorFreeStatic(&segmentor);
+  printf("UnitTestImgSegmentorEvaluateSample OK\n");
+}
+
+void UnitTestImgSegmentorTexReuse() {
+  int nbClass = 2;
+  int rank = 1;
+  int size = 2;
+  ImgSegmentorCriterionTex* crit = 
+    ImgSegmentorCriterionTexCreate(nbClass, rank, size);
+  char* fileName = "ISPredict-in.tga";
+  GenBrush* img = GBCreateFromFile(fileName);
+  ImgSegmentorPlane* input = ImgSegmentorPlaneCreateFromGenBrush(img);
+  ImgSegmentorPlane* pred = ISCTexPredict(crit, input, -1, NULL);
+  ISCSetIsReusedInput(crit, true);
+  for (int iPass = 2; iPass--;) {
+    ImgSegmentorPlane* predReuse = ISCTexPredict(crit, input, 0, NULL);
+    ImgSegmentorReuseEntry* entry = GSetGet(ISCReusedInput(crit), 0);
+    ImgSegmentorCriterionTexReuse* reuse = entry->_data;
+    if (!(reuse->_flagComplete) || memcmp(ISPVal(pred), 
+      ISPVal(predReuse), 
+      sizeof(float) * ISPGetArea(pred) * nbClass) != 0) {
+      PBImgAnalysisErr->_type = PBErrTypeUnitTestFailed;
+      sprintf(PBImgAnalysisErr->_msg, "ISCTexPredict failed");
+      PBErrCatch(PBImgAnalysisErr);
+    }
+    ImgSegmentorPlaneFree(&predReuse);
+  }
+  ImgSegmentorPlaneFree(&pred);
+  ImgSegmentorPlaneFree(&input);
+  GBFree(&img);
+  ImgSegmentorCriterionTexFree(&crit);
+  printf("UnitTestImgSegmentorTexReuse OK\n");
+}
+
+void UnitTestImgSegmentorTexSAT() {
+  srandom(1);
+  int nbClass = 2;
+  int rank = 1;
+  // Random input big enough for the biggest fragments (9x9)
+  VecShort2D dim = VecShortCreateStatic2D();
+  VecSet(&dim, 0, 20);
+  VecSet(&dim, 1, 19);
+  ImgSegmentorPlane* input = ImgSegmentorPlaneCreate(&dim, 3);
+  float* val = ISPVal(input);
+  for (long i = ISPGetArea(input) * 3; i--;)
+    val[i] = rnd();
+  double* sat = ISCTexCreateSAT(input);
+  for (int size = 1; size <= 3; ++size) {
+    ImgSegmentorCriterionTex* crit = 
+      ImgSegmentorCriterionTexCreate(nbClass, rank, size);
+    VecFloat* in = VecFloatCreate(ISCTexGetNbInput(crit));
+    int sizeFragMax = powi(3, size - 1);
+    // Loop on the positions where the fragments fit in the image, 
+    // including the limits sizeFragMax - 1 and dim - sizeFragMax
+    VecShort2D pos = VecShortCreateStatic2D();
+    do {
+      if (VecGet(&pos, 0) < sizeFragMax - 1 || 
+        VecGet(&pos, 0) > VecGet(&dim, 0) - sizeFragMax ||
+        VecGet(&pos, 1) < sizeFragMax - 1 || 
+        VecGet(&pos, 1) > VecGet(&dim, 1) - sizeFragMax)
+        continue;
+      int iInput = VecGet(&pos, 1) * VecGet(&dim, 0) + VecGet(&pos, 0);
+      ISCTexGetNNInput(crit, input, sat, iInput, NULL, &pos, in);
+      // Compare with the brute force averages over the fragments
+      bool flagOk = true;
+      for (int i = 3; i--;)
+        if (VecGet(in, i) != val[iInput * 3 + i])
+          flagOk = false;
+      for (int iSize = 1; iSize < size; ++iSize) {
+        int sizeFrag = powi(3, iSize);
+        int half = (sizeFrag - 1) / 2;
+        int relPos[3] = {sizeFrag - 1, half, 0};
+        for (int iFrag = 9; iFrag--;) {
+          int x0 = VecGet(&pos, 0) - relPos[iFrag / 3];
+          int y0 = VecGet(&pos, 1) - relPos[iFrag % 3];
+          for (int i = 3; i--;) {
+            double sum = 0.0;
+            for (int y = y0; y < y0 + sizeFrag; ++y)
+              for (int x = x0; x < x0 + sizeFrag; ++x)
+                sum += val[(y * VecGet(&dim, 0) + x) * 3 + i];
+            float avg = sum / (double)(sizeFrag * sizeFrag);
+            if (fabs(VecGet(in, 3 * (1 + (iSize - 1) * 9 + iFrag) + i) 
+              - avg) > 1e-5)
+              flagOk = false;
+          }
+        }
+      }
+      if (!flagOk) {
+        PBImgAnalysisErr->_type = PBErrTypeUnitTestFailed;
+        sprintf(PBImgAnalysisErr->_msg, 
+          "ISCTexGetNNInput failed (size %d, pos %d,%d)", size, 
+          VecGet(&pos, 0), VecGet(&pos, 1));
+        PBErrCatch(PBImgAnalysisErr);
+      }
+    } while (VecStep(&pos, &dim));
+    VecFree(&in);
+    ImgSegmentorCriterionTexFree(&crit);
+  }
+  free(sat);
+  ImgSegmentorPlaneFree(&input);
+  printf("UnitTestImgSegmentorTexSAT OK\n");
+}
+
+void UnitTestImgSegmentorFeatureCache() {
+  int nbClass = 2;
+  int rank = 1;
+  int size = 2;
+  ImgSegmentorCriterionTex* crit = 
+    ImgSegmentorCriterionTexCreate(nbClass, rank, size);
+  char* fileName = "ISPredict-in.tga";
+  GenBrush* img = GBCreateFromFile(fileName);
+  ImgSegmentorPlane* input = ImgSegmentorPlaneCreateFromGenBrush(img);
+  ImgSegmentorPlane* pred = ISCTexPredict(crit, input, -1, NULL);
+  ISCSetIsReusedInput(crit, true);
+  char* dir = "./UnitTestImgSegmentorTrain";
+  crit->_criterion._featureCachePath = dir;
+  uint64_t key = ISCTexGetFeatureCacheKey(crit, input, 0);
+  char* path = ISFeatureCacheGetFilePath(dir, key);
+  remove(path);
+  // The first pass computes and saves the features, the second maps 
+  // them from the file
+  for (int iPass = 0; iPass < 2; ++iPass) {
+    ImgSegmentorPlane* predReuse = ISCTexPredict(crit, input, 0, NULL);
+    ImgSegmentorReuseEntry* entry = GSetGet(ISCReusedInput(crit), 0);
+    ImgSegmentorCriterionTexReuse* reuse = entry->_data;
+    FILE* fp = fopen(path, "rb");
+    if (fp == NULL || (iPass == 0) != (reuse->_map == NULL) ||
+      memcmp(ISPVal(pred), ISPVal(predReuse), 
+      sizeof(float) * ISPGetArea(pred) * nbClass) != 0) {
+      PBImgAnalysisErr->_type = PBErrTypeUnitTestFailed;
+      sprintf(PBImgAnalysisErr->_msg, "ISCTexReuseSave failed");
+      PBErrCatch(PBImgAnalysisErr);
+    }
+    fclose(fp);
+    ImgSegmentorPlaneFree(&predReuse);
+    ImgSegmentorCriterionFlushReusedData((ImgSegmentorCriterion*)crit);
+  }
+  // A different input doesn't match the file
+  VecShort2D dim = VecShortCreateStatic2D();
+  VecSet(&dim, 0, 2);
+  VecSet(&dim, 1, 2);
+  if (ImgSegmentorCriterionTexReuseCreateFromFile(crit, &dim, dir, key) 
+    != NULL || ISCTexGetFeatureCacheKey(crit, input, 1) == key) {
+    PBImgAnalysisErr->_type = PBErrTypeUnitTestFailed;
+    sprintf(PBImgAnalysisErr->_msg, 
+      "ImgSegmentorCriterionTexReuseCreateFromFile failed");
+    PBErrCatch(PBImgAnalysisErr);
+  }
+  remove(path);
+  free(path);
+  crit->_criterion._featureCachePath = NULL;
+  ImgSegmentor segmentor = ImgSegmentorCreateStatic(nbClass);
+  ISSetFeatureCachePath(&segmentor, dir);
+  if (strcmp(ISGetFeatureCachePath(&segmentor), dir) != 0) {
+    PBImgAnalysisErr->_type = PBErrTypeUnitTestFailed;
+    sprintf(PBImgAnalysisErr->_msg, "ISSetFeatureCachePath failed");
+    PBErrCatch(PBImgAnalysisErr);
+  }
+  ISSetFeatureCachePath(&segmentor, NULL);
+  if (ISGetFeatureCachePath(&segmentor) != NULL) {
+    PBImgAnalysisErr->_type = PBErrTypeUnitTestFailed;
+    sprintf(PBImgAnalysisErr->_msg, "ISSetFeatureCachePath failed");
+    PBErrCatch(PBImgAnalysisErr);
+  }
+  ImgSegmentorFreeStatic(&segmentor);
+  ImgSegmentorPlaneFree(&pred);
+  ImgSegmentorPlaneFree(&input);
+  GBFree(&img);
+  ImgSegmentorCriterionTexFree(&crit);
+  printf("UnitTestImgSegmentorFeatureCache OK\n");
+}
+
+void UnitTestImgSegmentorCheckpointWriter() {
+  ImgSegmentor segmentor = ImgSegmentorCreateStatic(2);
+  ISSetCheckpointKeepBest(&segmentor, 1);
+  ISSetCheckpointKeepLast(&segmentor, 1);
+  if (ISGetCheckpointKeepBest(&segmentor) != 1 || 
+    ISGetCheckpointKeepLast(&segmentor) != 1) {
+    PBImgAnalysisErr->_type = PBErrTypeUnitTestFailed;
+    sprintf(PBImgAnalysisErr->_msg, "ISSetCheckpointKeepBest failed");
+    PBErrCatch(PBImgAnalysisErr);
+  }
+  ISCheckpointWriter* writer = ISCheckpointWriterCreate(
+    ISGetCheckpointKeepBest(&segmentor), 
+    ISGetCheckpointKeepLast(&segmentor));
+  char* path[3] = {"unitTestCheckpoint0.json", 
+    "unitTestCheckpoint1.json", "unitTestCheckpoint2.json"};
+  float value[3] = {0.3, 0.5, 0.4};
+  for (int i = 0; i < 3; ++i) {
+    char* data = strdup(path[i]);
+    ISCWAdd(writer, path[i], value[i], data, strlen(data));
+  }
+  ISCheckpointWriterFree(&writer);
+  // Only the best and the last checkpoints must be kept
+  for (int i = 0; i < 3; ++i) {
+    FILE* fp = fopen(path[i], "r");
+    char buffer[100] = {'\0'};
+    if ((fp != NULL) != (i > 0) || (fp != NULL && 
+      (fgets(buffer, 100, fp) == NULL || strcmp(buffer, path[i]) != 0))) {
+      PBImgAnalysisErr->_type = PBErrTypeUnitTestFailed;
+      sprintf(PBImgAnalysisErr->_msg, "ISCheckpointWriter failed");
+      PBErrCatch(PBImgAnalysisErr);
+    }
+    if (fp != NULL)
+      fclose(fp);
+    remove(path[i]);
+  }
+  if (writer != NULL) {
+    PBImgAnalysisErr->_type = PBErrTypeUnitTestFailed;
+    sprintf(PBImgAnalysisErr->_msg, "ISCheckpointWriterFree failed");
+    PBErrCatch(PBImgAnalysisErr);
+  }
+  ImgSegmentorFreeStatic(&segmentor);
+  printf("UnitTestImgSegmentorCheckpointWriter OK\n");
+}
+
+// Return the number of checkpoint files in the current directory and
+// copy in 'best' the name of the one with the best value if 'best' is
+// not null, remove them if 'flagRemove' is true
+int UnitTestCheckpoints(char* const best, const bool flagRemove) {
+  int nb = 0;
+  float bestValue = -1.0;
+  DIR* dir = opendir(".");
+  struct dirent* entry = NULL;
+  while (dir != NULL && (entry = readdir(dir)) != NULL) {
+    char* suffix = strstr(entry->d_name, "_" IS_CHECKPOINTFILENAME);
+    if (suffix == NULL || strcmp(suffix + 1, IS_CHECKPOINTFILENAME) != 0)
+      continue;
+    ++nb;
+    long epoch = 0;
+    float value = 0.0;
+    if (best != NULL && 
+      sscanf(entry->d_name, "%ld_%f_", &epoch, &value) == 2 &&
+      value > bestValue) {
+      bestValue = value;
+      strcpy(best, entry->d_name);
+    }
+    if (flagRemove)
+      remove(entry->d_name);
+  }
+  if (dir != NULL)
+    closedir(dir);
+  return nb;
+}
+
+// Copy in 'best' the name of the checkpoint file in the current 
+// directory with the best validation value, the most recent one for 
+// equal values, and in 'last' the name of the most recent one
+// Return the number of checkpoint files
+int UnitTestCheckpointsEval(char* const best, char* const last) {
+  int nb = 0;
+  float bestEval = -1.0;
+  float bestTrain = -1.0;
+  float lastTrain = -1.0;
+  DIR* dir = opendir(".");
+  struct dirent* entry = NULL;
+  while (dir != NULL && (entry = readdir(dir)) != NULL) {
+    char* suffix = strstr(entry->d_name, "_" IS_CHECKPOINTFILENAME);
+    long epoch = 0;
+    float train = 0.0;
+    float eval = 0.0;
+    if (suffix == NULL || 
+      strcmp(suffix + 1, IS_CHECKPOINTFILENAME) != 0 ||
+      sscanf(entry->d_name, "%ld_%f_%f_", &epoch, &train, &eval) != 3)
+      continue;
+    ++nb;
+    // The training value increases at each checkpoint
+    if (eval > bestEval || (eval == bestEval && train > bestTrain)) {
+      bestEval = eval;
+      bestTrain = train;
+      strcpy(best, entry->d_name);
+    }
+    if (train > lastTrain) {
+      lastTrain = train;
+      strcpy(last, entry->d_name);
+    }
+  }
+  if (dir != NULL)
+    closedir(dir);
+  return nb;
+}
+
+void UnitTestImgSegmentorTrainCheckpointEval() {
+  // Train the same model from the same seed keeping all the 
+  // checkpoints, then only the best one, then only the last one
+  // The best one is ranked by the validation value and may differ from
+  // the last one
+  int nbClass = 2;
+  char* cfgFilePath = PBFSJoinPath(
+    ".", "UnitTestImgSegmentorTrain", "dataset.json");
+  GDataSetGenBrushPair dataSet = 
+    GDataSetGenBrushPairCreateStaticFromFile(cfgFilePath);
+  srandom(6);
+  VecShort2D cat = VecShortCreateStatic2D();
+  VecSet(&cat, 0, 7);
+  VecSet(&cat, 1, 3);
+  GDSSplit(&dataSet, (VecShort*)&cat);
+  char best[256] = {'\0'};
+  char last[256] = {'\0'};
+  int keepBest[3] = {0, 1, 0};
+  int keepLast[3] = {0, 0, 1};
+  for (int iRun = 0; iRun < 3; ++iRun) {
+    UnitTestCheckpoints(NULL, true);
+    srandom(7);
+    ImgSegmentor segmentor = ImgSegmentorCreateStatic(nbClass);
+    ImgSegmentorCriterionRGB* crit = ISAddCriterionRGB(&segmentor, NULL);
+    ISAddCriterionRGB(&segmentor, crit);
+    ISSetCheckpointKeepBest(&segmentor, keepBest[iRun]);
+    ISSetCheckpointKeepLast(&segmentor, keepLast[iRun]);
+    ISSetSizePool(&segmentor, 16);
+    ISSetNbElite(&segmentor, 5);
+    ISSetSizeMaxPool(&segmentor, 16);
+    ISSetSizeMinPool(&segmentor, 16);
+    ISSetNbEpoch(&segmentor, 5);
+    ISSetTargetBestValue(&segmentor, 1.0);
+    ISTrain(&segmentor, &dataSet);
+    ImgSegmentorFreeStatic(&segmentor);
+    char bestRun[256] = {'\0'};
+    char lastRun[256] = {'\0'};
+    int nb = UnitTestCheckpointsEval(bestRun, lastRun);
+    if (iRun == 0) {
+      // All the checkpoints are kept, memorize the expected ones
+      if (nb < 1) {
+        PBImgAnalysisErr->_type = PBErrTypeUnitTestFailed;
+        sprintf(PBImgAnalysisErr->_msg, "ISTrain failed (checkpoints)");
+        PBErrCatch(PBImgAnalysisErr);
+      }
+      strcpy(best, bestRun);
+      strcpy(last, lastRun);
+    } else if (nb != 1 || 
+      strcmp(bestRun, (iRun == 1 ? best : last)) != 0) {
+      PBImgAnalysisErr->_type = PBErrTypeUnitTestFailed;
+      sprintf(PBImgAnalysisErr->_msg, "ISTrain failed (retention %d)", 
+        iRun);
+      PBErrCatch(PBImgAnalysisErr);
+    }
+  }
+  UnitTestCheckpoints(NULL, true);
+  free(cfgFilePath);
+  GDataSetGenBrushPairFreeStatic(&dataSet);
+  printf("UnitTestImgSegmentorTrainCheckpointEval OK\n");
+}
+
+void UnitTestImgSegmentorTrainCheckpoint() {
+  srandom(2);
+  // Remove the checkpoints of previous trainings
+  char best[256] = {'\0'};
+  UnitTestCheckpoints(NULL, true);
+  // Train a model with only RGB criteria, hence without int parameters
+  int nbClass = 2;
+  ImgSegmentor segmentor = ImgSegmentorCreateStatic(nbClass);
+  ImgSegmentorCriterionRGB* crit = ISAddCriterionRGB(&segmentor, NULL);
+  ISAddCriterionRGB(&segmentor, crit);
+  ISSetCheckpointKeepBest(&segmentor, 1);
+  ISSetCheckpointKeepLast(&segmentor, 1);
+  char* cfgFilePath = PBFSJoinPath(
+    ".", "UnitTestImgSegmentorTrain", "dataset.json");
+  GDataSetGenBrushPair dataSet = 
+    GDataSetGenBrushPairCreateStaticFromFile(cfgFilePath);
+  ISSetSizePool(&segmentor, 16);
+  ISSetNbElite(&segmentor, 5);
+  ISSetSizeMaxPool(&segmentor, 16);
+  ISSetSizeMinPool(&segmentor, 16);
+  ISSetNbEpoch(&segmentor, 3);
+  ISSetTargetBestValue(&segmentor, 0.99);
+  ISTrain(&segmentor, &dataSet);
+  // The retention policy must have kept at most the best and last 
+  // checkpoints, and the trained parameters must be the ones of the 
+  // best checkpoint
+  int nbCheckpoint = UnitTestCheckpoints(best, false);
+  if (nbCheckpoint < 1 || nbCheckpoint > 2) {
+    PBImgAnalysisErr->_type = PBErrTypeUnitTestFailed;
+    sprintf(PBImgAnalysisErr->_msg, "ISTrain failed (retention)");
+    PBErrCatch(PBImgAnalysisErr);
+  }
+  FILE* fp = fopen(best, "r");
+  ImgSegmentor load = ImgSegmentorCreateStatic(nbClass);
+  if (fp == NULL || !ISLoad(&load, fp)) {
+    PBImgAnalysisErr->_type = PBErrTypeUnitTestFailed;
+    sprintf(PBImgAnalysisErr->_msg, "ISTrain failed (checkpoint)");
+    PBErrCatch(PBImgAnalysisErr);
+  }
+  if (fp != NULL)
+    fclose(fp);
+  long nbParam = ISCRGBGetNbParamFloat(crit) * 2;
+  VecLong* adnI = VecLongCreate(1);
+  VecFloat* adnF = VecFloatCreate(nbParam);
+  VecFloat* adnFLoad = VecFloatCreate(nbParam);
+  ISGetAdn(&segmentor, adnI, adnF);
+  ISGetAdn(&load, adnI, adnFLoad);
+  if (!VecIsEqual(adnF, adnFLoad)) {
+    PBImgAnalysisErr->_type = PBErrTypeUnitTestFailed;
+    sprintf(PBImgAnalysisErr->_msg, "ISTrain failed (best)");
+    PBErrCatch(PBImgAnalysisErr);
+  }
+  // Remove the checkpoints
+  UnitTestCheckpoints(NULL, true);
+  VecFree(&adnI);
+  VecFree(&adnF);
+  VecFree(&adnFLoad);
+  free(cfgFilePath);
+  GDataSetGenBrushPairFreeStatic(&dataSet);
+  ImgSegmentorFreeStatic(&load);
+  ImgSegmentorFreeStatic(&segmentor);
+  printf("UnitTestImgSegmentorTrainCheckpoint OK\n");
+}
+
+void UnitTestImgSegmentorTrainThreads() {
+  // Train the same model from the same seed with one and several 
+  // threads, the trained parameters must be the same
+  int nbClass = 2;
+  char* cfgFilePath = PBFSJoinPath(
+    ".", "UnitTestImgSegmentorTrain", "dataset.json");
+  GDataSetGenBrushPair dataSet = 
+    GDataSetGenBrushPairCreateStaticFromFile(cfgFilePath);
+  VecFloat* adnF[2] = {NULL, NULL};
+  VecLong* adnI = VecLongCreate(1);
+  int nbThread[2] = {1, 3};
+  for (int iRun = 0; iRun < 2; ++iRun) {
+    srandom(3);
+    ImgSegmentor segmentor = ImgSegmentorCreateStatic(nbClass);
+    ImgSegmentorCriterionRGB* crit = ISAddCriterionRGB(&segmentor, NULL);
+    ISAddCriterionRGB(&segmentor, crit);
+    ISSetSizePool(&segmentor, 16);
+    ISSetNbElite(&segmentor, 5);
+    ISSetSizeMaxPool(&segmentor, 16);
+    ISSetSizeMinPool(&segmentor, 16);
+    ISSetNbEpoch(&segmentor, 3);
+    ISSetTargetBestValue(&segmentor, 0.99);
+    ISSetNbThread(&segmentor, nbThread[iRun]);
+    ISTrain(&segmentor, &dataSet);
+    adnF[iRun] = VecFloatCreate(ISCRGBGetNbParamFloat(crit) * 2);
+    ISGetAdn(&segmentor, adnI, adnF[iRun]);
+    ImgSegmentorFreeStatic(&segmentor);
+  }
+  if (!VecIsEqual(adnF[0], adnF[1])) {
+    PBImgAnalysisErr->_type = PBErrTypeUnitTestFailed;
+    sprintf(PBImgAnalysisErr->_msg, "ISTrain failed (threads)");
+    PBErrCatch(PBImgAnalysisErr);
+  }
+  // Remove the checkpoints
+  UnitTestCheckpoints(NULL, true);
+  VecFree(adnF);
+  VecFree(adnF + 1);
+  VecFree(&adnI);
+  free(cfgFilePath);
+  GDataSetGenBrushPairFreeStatic(&dataSet);
+  printf("UnitTestImgSegmentorTrainThreads OK\n");
+}
+
+void UnitTestImgSegmentorFrozen() {
+  int nbClass = 2;
+  ImgSegmentor segmentor = ImgSegmentorCreateStatic(nbClass);
+  ImgSegmentorCriterionRGB2HSV* critHSV = 
+    ISAddCriterionRGB2HSV(&segmentor, NULL);
+  ImgSegmentorCriterionRGB* critFrozen = 
+    ISAddCriterionRGB(&segmentor, critHSV);
+  ImgSegmentorCriterionRGB* crit = ISAddCriterionRGB(&segmentor, NULL);
+  ISCSetIsFrozen(critHSV, true);
+  ISCSetIsFrozen(critFrozen, true);
+  if (!ISCIsFrozen(critFrozen) || ISCIsFrozen(crit) ||
+    ISCGetNbTrainedParamFloat((ImgSegmentorCriterion*)critFrozen) != 0 ||
+    ISCGetNbTrainedParamFloat((ImgSegmentorCriterion*)crit) != 
+      ISCRGBGetNbParamFloat(crit)) {
+    PBImgAnalysisErr->_type = PBErrTypeUnitTestFailed;
+    sprintf(PBImgAnalysisErr->_msg, "ISCSetIsFrozen failed");
+    PBErrCatch(PBImgAnalysisErr);
+  }
+  // The adn only contains the parameters of the unfrozen criterion
+  VecFloat* bases = VecFloatCreate(ISCRGBGetNbParamFloat(crit));
+  VecFloat* basesFrozen = VecClone(NNBases(ISCRGBNeuraNet(critFrozen)));
+  for (long i = VecGetDim(bases); i--;)
+    VecSet(bases, i, 0.1);
+  ISSetParams(&segmentor, NULL, bases);
+  if (!VecIsEqual(NNBases(ISCRGBNeuraNet(crit)), bases) ||
+    !VecIsEqual(NNBases(ISCRGBNeuraNet(critFrozen)), basesFrozen)) {
+    PBImgAnalysisErr->_type = PBErrTypeUnitTestFailed;
+    sprintf(PBImgAnalysisErr->_msg, "ISSetParams failed");
+    PBErrCatch(PBImgAnalysisErr);
+  }
+  // The predictions of the frozen criteria are reused during training
+  GDSGenBrushPair sample;
+  sample._img = GBCreateFromFile("ISPredict-in.tga");
+  char fileNameMask[50];
+  for (int iClass = nbClass; iClass--;) {
+    sprintf(fileNameMask, "ISPredict-out%02d.tga", iClass);
+    sample._mask[iClass] = GBCreateFromFile(fileNameMask);
+  }
+  float check = ISEvaluateSample(&segmentor, &sample, -1, nbClass);
+  segmentor._flagTraining = true;
+  segmentor._reuseCache = ImgSegmentorReuseCacheCreate(0);
+  critHSV->_criterion._reuseCache = segmentor._reuseCache;
+  critFrozen->_criterion._reuseCache = segmentor._reuseCache;
+  crit->_criterion._reuseCache = segmentor._reuseCache;
+  for (int iPass = 2; iPass--;) {
+    float value = ISEvaluateSample(&segmentor, &sample, 0, nbClass);
+    const GSet* frozenPred = &(critFrozen->_criterion._frozenPred);
+    if (fabs(value - check) > PBMATH_EPSILON || 
+      GSetNbElem(frozenPred) != 1 ||
+      ((ImgSegmentorReuseEntry*)GSetGet(frozenPred, 0))->_data == NULL ||
+      GSetNbElem(&(critHSV->_criterion._frozenPred)) != 1 ||
+      GSetNbElem(&(crit->_criterion._frozenPred)) != 0) {
+      PBImgAnalysisErr->_type = PBErrTypeUnitTestFailed;
+      sprintf(PBImgAnalysisErr->_msg, "ISEvaluateSample failed");
+      PBErrCatch(PBImgAnalysisErr);
+    }
+  }
+  segmentor._flagTraining = false;
+  // The flag is saved with the criterion
+  char* fileName = "unitTestImgSegmentorFrozen.json";
+  FILE* stream = fopen(fileName, "w");
+  if (!ISSave(&segmentor, stream, false)) {
+    PBImgAnalysisErr->_type = PBErrTypeUnitTestFailed;
+    sprintf(PBImgAnalysisErr->_msg, "ISSave failed");
+    PBErrCatch(PBImgAnalysisErr);
+  }
+  fclose(stream);
+  ImgSegmentor load = ImgSegmentorCreateStatic(nbClass);
+  stream = fopen(fileName, "r");
+  if (!ISLoad(&load, stream)) {
+    PBImgAnalysisErr->_type = PBErrTypeUnitTestFailed;
+    sprintf(PBImgAnalysisErr->_msg, "ISLoad failed");
+    PBErrCatch(PBImgAnalysisErr);
+  }
+  fclose(stream);
+  remove(fileName);
+  const ImgSegmentorCriterion* critLoaded = 
+    GenTreeData((GenTree*)GSetGet(&(load._criteria._subtrees), 0));
+  if (!ISCIsFrozen(critLoaded)) {
+    PBImgAnalysisErr->_type = PBErrTypeUnitTestFailed;
+    sprintf(PBImgAnalysisErr->_msg, "ISLoad failed");
+    PBErrCatch(PBImgAnalysisErr);
+  }
+  ImgSegmentorFreeStatic(&load);
+  for (int iClass = nbClass; iClass--;)
+    GBFree(sample._mask + iClass);
+  GBFree(&(sample._img));
+  VecFree(&bases);
+  VecFree(&basesFrozen);
+  ImgSegmentorFreeStatic(&segmentor);
+  printf("UnitTestImgSegmentorFrozen OK\n");
+}
+
+void UnitTestImgSegmentorWarmStart() {
+  srandom(2);
+  ImgSegmentor segmentor = ImgSegmentorCreateStatic(2);
+  if (ISGetFlagWarmStart(&segmentor)) {
+    PBImgAnalysisErr->_type = PBErrTypeUnitTestFailed;
+    sprintf(PBImgAnalysisErr->_msg, "ISGetFlagWarmStart failed");
+    PBErrCatch(PBImgAnalysisErr);
+  }
+  ISSetFlagWarmStart(&segmentor, true);
+  if (!ISGetFlagWarmStart(&segmentor)) {
+    PBImgAnalysisErr->_type = PBErrTypeUnitTestFailed;
+    sprintf(PBImgAnalysisErr->_msg, "ISSetFlagWarmStart failed");
+    PBErrCatch(PBImgAnalysisErr);
+  }
+  ImgSegmentorCriterionRGB* crit = ISAddCriterionRGB(&segmentor, NULL);
+  long nbParam = ISCRGBGetNbParamFloat(crit);
+  VecFloat* bases = VecFloatCreate(nbParam);
+  for (long i = nbParam; i--;)
+    VecSet(bases, i, 0.5 - (float)i / (float)nbParam);
+  NNSetBases((NeuraNet*)ISCRGBNeuraNet(crit), bases);
+  // The current parameters must be the bases of the NeuraNet
+  VecLong* adnI = VecLongCreate(1);
+  VecFloat* adnF = VecFloatCreate(nbParam);
+  ISGetAdn(&segmentor, adnI, adnF);
+  if (!VecIsEqual(adnF, bases)) {
+    PBImgAnalysisErr->_type = PBErrTypeUnitTestFailed;
+    sprintf(PBImgAnalysisErr->_msg, "ISGetAdn failed");
+    PBErrCatch(PBImgAnalysisErr);
+  }
+  // The elites must be the current parameters, the other entities 
+  // mutations of them within the bounds
+  GenAlg* ga = GenAlgCreate(GENALG_NBENTITIES, GENALG_NBELITES, 
+    nbParam, 0);
+  ISCRGBSetBoundsAdnFloat(crit, ga, 0);
+  GAInit(ga);
+  ISTrainWarmStart(&segmentor, ga, 0, nbParam);
+  for (int iEnt = 0; iEnt < GAGetNbAdns(ga); ++iEnt) {
+    const VecFloat* adnEnt = GAAdnAdnF(GAAdn(ga, iEnt));
+    for (long i = nbParam; i--;) {
+      float delta = fabs(VecGet(adnEnt, i) - VecGet(bases, i));
+      if ((iEnt < GAGetNbElites(ga) && delta > PBMATH_EPSILON) ||
+        delta > 2.0 * IS_WARMSTARTMUTATION + PBMATH_EPSILON ||
+        fabs(VecGet(adnEnt, i)) > 1.0) {
+        PBImgAnalysisErr->_type = PBErrTypeUnitTestFailed;
+        sprintf(PBImgAnalysisErr->_msg, "ISTrainWarmStart failed");
+        PBErrCatch(PBImgAnalysisErr);
+      }
+    }
+  }
+  GenAlgFree(&ga);
+  VecFree(&adnI);
+  VecFree(&adnF);
+  VecFree(&bases);
+  ImgSegmentorFreeStatic(&segmentor);
+  printf("UnitTestImgSegmentorWarmStart OK\n");
+}
+
+void UnitTestImgSegmentorTrainState() {
+  srandom(2);
+  ImgSegmentor segmentor = ImgSegmentorCreateStatic(2);
+  char* path = "unitTestTrainState.bin";
+  ISSetTrainStatePath(&segmentor, path);
+  if (strcmp(ISGetTrainStatePath(&segmentor), path) != 0) {
+    PBImgAnalysisErr->_type = PBErrTypeUnitTestFailed;
+    sprintf(PBImgAnalysisErr->_msg, "ISSetTrainStatePath failed");
+    PBErrCatch(PBImgAnalysisErr);
+  }
+  GenAlg* ga = GenAlgCreate(GENALG_NBENTITIES, GENALG_NBELITES, 2, 1);
+  GAInit(ga);
+  VecFloat* bestAdnF = VecFloatCreate(2);
+  VecSet(bestAdnF, 0, 0.25);
+  VecSet(bestAdnF, 1, 0.5);
+  uint64_t rngSeed = 12345;
+  if (!ISTrainSaveState(&segmentor, ga, 0.75, bestAdnF, NULL, 1, 2, 
+    rngSeed)) {
+    PBImgAnalysisErr->_type = PBErrTypeUnitTestFailed;
+    sprintf(PBImgAnalysisErr->_msg, "ISTrainSaveState failed");
+    PBErrCatch(PBImgAnalysisErr);
+  }
+  ISTrainState state;
+  FILE* fp = fopen(path, "r");
+  if (ISTrainLoadState(&state, fp, 2, 1)) {
+    PBImgAnalysisErr->_type = PBErrTypeUnitTestFailed;
+    sprintf(PBImgAnalysisErr->_msg, "ISTrainLoadState failed (1)");
+    PBErrCatch(PBImgAnalysisErr);
+  }
+  rewind(fp);
+  if (!ISTrainLoadState(&state, fp, 1, 2) || 
+    state._bestValue != 0.75 || state._bestAdnI != NULL ||
+    !VecIsEqual(state._bestAdnF, bestAdnF) ||
+    GAGetNbAdns(state._ga) != GAGetNbAdns(ga) ||
+    GAGetCurEpoch(state._ga) != GAGetCurEpoch(ga) ||
+    state._rngSeed != rngSeed) {
+    PBImgAnalysisErr->_type = PBErrTypeUnitTestFailed;
+    sprintf(PBImgAnalysisErr->_msg, "ISTrainLoadState failed (2)");
+    PBErrCatch(PBImgAnalysisErr);
+  }
+  fclose(fp);
+  remove(path);
+  ISTrainStateFreeStatic(&state);
+  VecFree(&bestAdnF);
+  GenAlgFree(&ga);
+  ImgSegmentorFreeStatic(&segmentor);
+  printf("UnitTestImgSegmentorTrainState OK\n");
+}
+
+void UnitTestImgSegmentorTrainResume() {
+  int nbClass = 2;
+  char* path = "unitTestTrainResume.bin";
+  char* cfgFilePath = PBFSJoinPath(
+    ".", "UnitTestImgSegmentorTrain", "dataset.json");
+  GDataSetGenBrushPair dataSet = 
+    GDataSetGenBrushPairCreateStaticFromFile(cfgFilePath);
+  VecLong* adnI = VecLongCreate(1);
+  // Resume sequentially and in parallel, where the elites of the 
+  // resumed GenAlg are not new and give a threshold to the first 
+  // evaluation
+  int nbThread[2] = {1, 3};
+  for (int iThread = 0; iThread < 2; ++iThread) {
+    // Run 0 trains 4 epochs uninterrupted, run 1 trains 2 epochs 
+    // and run 2 resumes it for the 2 remaining epochs
+    VecFloat* adnF[3] = {NULL, NULL, NULL};
+    for (int iRun = 0; iRun < 3; ++iRun) {
+      ImgSegmentor segmentor = ImgSegmentorCreateStatic(nbClass);
+      ImgSegmentorCriterionRGB* crit = 
+        ISAddCriterionRGB(&segmentor, NULL);
+      ISAddCriterionRGB(&segmentor, crit);
+      ISCSetIsReusedInput(crit, true);
+      ISSetSizePool(&segmentor, 16);
+      ISSetNbElite(&segmentor, 5);
+      ISSetSizeMaxPool(&segmentor, 16);
+      ISSetSizeMinPool(&segmentor, 16);
+      ISSetNbEpoch(&segmentor, (iRun == 1 ? 2 : 4));
+      ISSetTargetBestValue(&segmentor, 1.0);
+      ISSetTrainStatePath(&segmentor, path);
+      ISSetNbThread(&segmentor, nbThread[iThread]);
+      if (iRun < 2) {
+        // Apart from the draw of the seed, the random generator of 
+        // the caller must be left untouched by the training
+        srandom(4);
+        (void)random();
+        long rndVal = random();
+        srandom(4);
+        ISTrain(&segmentor, &dataSet);
+        if (random() != rndVal) {
+          PBImgAnalysisErr->_type = PBErrTypeUnitTestFailed;
+          sprintf(PBImgAnalysisErr->_msg, "ISTrain failed (random)");
+          PBErrCatch(PBImgAnalysisErr);
+        }
+      } else {
+        FILE* fp = fopen(path, "r");
+        if (fp == NULL || !ISTrainResume(&segmentor, &dataSet, fp)) {
+          PBImgAnalysisErr->_type = PBErrTypeUnitTestFailed;
+          sprintf(PBImgAnalysisErr->_msg, "ISTrainResume failed");
+          PBErrCatch(PBImgAnalysisErr);
+        }
+        if (fp != NULL)
+          fclose(fp);
+      }
+      adnF[iRun] = VecFloatCreate(ISCRGBGetNbParamFloat(crit) * 2);
+      ISGetAdn(&segmentor, adnI, adnF[iRun]);
+      ImgSegmentorFreeStatic(&segmentor);
+    }
+    // The resumed training must end with the same parameters as the 
+    // uninterrupted one
+    if (!VecIsEqual(adnF[0], adnF[2])) {
+      PBImgAnalysisErr->_type = PBErrTypeUnitTestFailed;
+      sprintf(PBImgAnalysisErr->_msg, 
+        "ISTrainResume failed (resume, %d threads)", nbThread[iThread]);
+      PBErrCatch(PBImgAnalysisErr);
+    }
+    for (int iRun = 3; iRun--;)
+      VecFree(adnF + iRun);
+  }
+  // Remove the training state and the checkpoints
+  remove(path);
+  UnitTestCheckpoints(NULL, true);
+  VecFree(&adnI);
+  free(cfgFilePath);
+  GDataSetGenBrushPairFreeStatic(&dataSet);
+  printf("UnitTestImgSegmentorTrainResume OK\n");
+}
+
+void UnitTestImgSegmentorReuseCache() {
+  ImgSegmentorReuseCache* cache = ImgSegmentorReuseCacheCreate(0);
+  if (cache->_budget != 0 || cache->_mostRecent != NULL ||
+    cache->_leastRecent != NULL || cache->_flagReadOnly) {
+    PBImgAnalysisErr->_type = PBErrTypeUnitTestFailed;
+    sprintf(PBImgAnalysisErr->_msg, 
+      "ImgSegmentorReuseCacheCreate failed");
+    PBErrCatch(PBImgAnalysisErr);
+  }
+  cache->_budget = 250;
+  GSet set = GSetCreateStatic();
+  VecShort2D dim = VecShortCreateStatic2D();
+  VecSet(&dim, 0, 2);
+  VecSet(&dim, 1, 2);
+  // Add 3 planes of 100 bytes in a budget of 250 bytes
+  for (long iSample = 0; iSample < 3; ++iSample) {
+    ImgSegmentorReuseEntry* entry = ISRCGetEntry(cache, &set, iSample);
+    if (ISRCGetData(cache, entry) != NULL) {
+      PBImgAnalysisErr->_type = PBErrTypeUnitTestFailed;
+      sprintf(PBImgAnalysisErr->_msg, "ISRCGetData failed");
+      PBErrCatch(PBImgAnalysisErr);
+    }
+    ImgSegmentorPlane* plane = ImgSegmentorPlaneCreate(&dim, 1);
+    if (iSample == 2)
+      ISRCGetData(cache, ISRCGetEntry(cache, &set, 0));
+    if (!ISRCAdd(cache, entry, plane, ISReuseType_Plane, 100)) {
+      PBImgAnalysisErr->_type = PBErrTypeUnitTestFailed;
+      sprintf(PBImgAnalysisErr->_msg, "ISRCAdd failed");
+      PBErrCatch(PBImgAnalysisErr);
+    }
+  }
+  // The least recently used data, sample 1, must have been evicted
+  ImgSegmentorReuseStats stats = ISRCGetStats(cache);
+  if (GSetNbElem(&set) != 3 || stats._nbHit != 1 || 
+    stats._nbMiss != 3 || stats._nbEviction != 1 || 
+    stats._size != 200 ||
+    ((ImgSegmentorReuseEntry*)GSetGet(&set, 0))->_data == NULL ||
+    ((ImgSegmentorReuseEntry*)GSetGet(&set, 1))->_data != NULL ||
+    ((ImgSegmentorReuseEntry*)GSetGet(&set, 2))->_data == NULL) {
+    PBImgAnalysisErr->_type = PBErrTypeUnitTestFailed;
+    sprintf(PBImgAnalysisErr->_msg, "ISRCAdd failed");
+    PBErrCatch(PBImgAnalysisErr);
+  }
+  // Pinned data can't be evicted
+  ISRCPin(cache, GSetGet(&set, 0));
+  ISRCPin(cache, GSetGet(&set, 2));
+  ImgSegmentorPlane* plane = ImgSegmentorPlaneCreate(&dim, 1);
+  if (ISRCAdd(cache, GSetGet(&set, 1), plane, ISReuseType_Plane, 100)) {
+    PBImgAnalysisErr->_type = PBErrTypeUnitTestFailed;
+    sprintf(PBImgAnalysisErr->_msg, "ISRCAdd failed");
+    PBErrCatch(PBImgAnalysisErr);
+  }
+  ISRCUnpin(cache, GSetGet(&set, 0));
+  ISRCUnpin(cache, GSetGet(&set, 2));
+  // Data can't be added when read only
+  ISRCSetReadOnly(cache, true);
+  if (ISRCGetEntry(cache, &set, 3) != NULL ||
+    ISRCAdd(cache, GSetGet(&set, 1), plane, ISReuseType_Plane, 100)) {
+    PBImgAnalysisErr->_type = PBErrTypeUnitTestFailed;
+    sprintf(PBImgAnalysisErr->_msg, "ISRCSetReadOnly failed");
+    PBErrCatch(PBImgAnalysisErr);
+  }
+  ISRCSetReadOnly(cache, false);
+  ImgSegmentorPlaneFree(&plane);
+  while (GSetNbElem(&set) > 0) {
+    ImgSegmentorReuseEntry* entry = GSetPop(&set);
+    ISRCEntryFree(cache, &entry);
+  }
+  if (ISRCGetStats(cache)._size != 0 || cache->_mostRecent != NULL) {
+    PBImgAnalysisErr->_type = PBErrTypeUnitTestFailed;
+    sprintf(PBImgAnalysisErr->_msg, "ISRCEntryFree failed");
+    PBErrCatch(PBImgAnalysisErr);
+  }
+  ImgSegmentorReuseCacheFree(&cache);
+  if (cache != NULL) {
+    PBImgAnalysisErr->_type = PBErrTypeUnitTestFailed;
+    sprintf(PBImgAnalysisErr->_msg, "ImgSegmentorReuseCacheFree failed");
+    PBErrCatch(PBImgAnalysisErr);
+  }
+  // Budget of the ImgSegmentor
+  ImgSegmentor segmentor = ImgSegmentorCreateStatic(2);
+  if (ISGetReuseBudget(&segmentor) != 0 || 
+    ISGetReuseStats(&segmentor)._nbHit != 0) {
+    PBImgAnalysisErr->_type = PBErrTypeUnitTestFailed;
+    sprintf(PBImgAnalysisErr->_msg, "ISGetReuseBudget failed");
+    PBErrCatch(PBImgAnalysisErr);
+  }
+  ISSetReuseBudget(&segmentor, 1024);
+  if (ISGetReuseBudget(&segmentor) != 1024) {
+    PBImgAnalysisErr->_type = PBErrTypeUnitTestFailed;
+    sprintf(PBImgAnalysisErr->_msg, "ISSetReuseBudget failed");
+    PBErrCatch(PBImgAnalysisErr);
+  }
+  ImgSegmentorFreeStatic(&segmentor);
+  // Train with a budget holding all the reused inputs (250x250 RGB 
+  // planes of 750kB for 10 samples), then with a budget holding only 
+  // one of them
+  char* cfgFilePath = PBFSJoinPath(
+    ".", "UnitTestImgSegmentorTrain", "dataset.json");
+  GDataSetGenBrushPair dataSet = 
+    GDataSetGenBrushPairCreateStaticFromFile(cfgFilePath);
+  size_t budget[2] = {16000000, 1000000};
+  for (int iRun = 0; iRun < 2; ++iRun) {
+    srandom(5);
+    segmentor = ImgSegmentorCreateStatic(2);
+    ImgSegmentorCriterionRGB* crit = ISAddCriterionRGB(&segmentor, NULL);
+    ISCSetIsReusedInput(crit, true);
+    ISSetSizePool(&segmentor, 16);
+    ISSetNbElite(&segmentor, 5);
+    ISSetSizeMaxPool(&segmentor, 16);
+    ISSetSizeMinPool(&segmentor, 16);
+    ISSetNbEpoch(&segmentor, 2);
+    ISSetTargetBestValue(&segmentor, 1.0);
+    ISSetReuseBudget(&segmentor, budget[iRun]);
+    ISTrain(&segmentor, &dataSet);
+    // The inputs are computed once and then reused if they fit in the 
+    // budget, else they are evicted
+    stats = ISGetReuseStats(&segmentor);
+    if (stats._nbMiss == 0 || stats._size == 0 || 
+      stats._size > budget[iRun] ||
+      (iRun == 0 && (stats._nbHit == 0 || stats._nbEviction != 0)) ||
+      (iRun == 1 && stats._nbEviction == 0)) {
+      PBImgAnalysisErr->_type = PBErrTypeUnitTestFailed;
+      sprintf(PBImgAnalysisErr->_msg, "ISGetReuseStats failed (%d)", 
+        iRun);
+      PBErrCatch(PBImgAnalysisErr);
+    }
+    ImgSegmentorFreeStatic(&segmentor);
+  }
+  UnitTestCheckpoints(NULL, true);
+  free(cfgFilePath);
+  GDataSetGenBrushPairFreeStatic(&dataSet);
+  printf("UnitTestImgSegmentorReuseCache OK\n");
+}
+
 void UnitTestImgSegmentorTrain01() {
   srandom(2);
   int nbClass = 2;
@@ -635,7 +2491,25 @@ void UnitTestImgSegmentor() {
   UnitTestImgSegmentorCreateFree();
   UnitTestImgSegmentorAddCriterionGetSet();
   UnitTestImgSegmentorSaveLoad();
+  UnitTestImgSegmentorSaveLoadBinary();
+  UnitTestImgSegmentorSaveStream();
   UnitTestImgSegmentorPredict();
+  UnitTestImgSegmentorPredictWithContext();
+  UnitTestImgSegmentorPredictBatch();
+  UnitTestImgSegmentorPredictScores();
+  UnitTestImgSegmentorEvaluateSample();
+  UnitTestImgSegmentorTexReuse();
+  UnitTestImgSegmentorTexSAT();
+  UnitTestImgSegmentorReuseCache();
+  UnitTestImgSegmentorCheckpointWriter();
+  UnitTestImgSegmentorTrainCheckpoint();
+  UnitTestImgSegmentorTrainCheckpointEval();
+  UnitTestImgSegmentorTrainThreads();
+  UnitTestImgSegmentorTrainState();
+  UnitTestImgSegmentorTrainResume();
+  UnitTestImgSegmentorWarmStart();
+  UnitTestImgSegmentorFrozen();
+  UnitTestImgSegmentorFeatureCache();
   UnitTestImgSegmentorTrain01();
   UnitTestImgSegmentorTrain02();
   UnitTestImgSegmentorTrain03();
@@ -645,8 +2519,14 @@ void UnitTestImgSegmentor() {
 
 void UnitTestAll() {
   UnitTestImgKMeansClusters();
+  UnitTestImgKMeansClustersCell();
+  UnitTestImgKMeansClustersAccelerated();
+  UnitTestImgKMeansClustersMiniBatch();
   UnitTestIntersectionOverUnion();
+  UnitTestIntersectionOverUnionBitMask();
   UnitTestGBSimilarityCoefficient();
+  UnitTestImgSegmentorPlane();
+  UnitTestImgSegmentorPredCache();
   UnitTestImgSegmentorRGB();
   UnitTestImgSegmentor();
 }
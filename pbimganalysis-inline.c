@@ -74,6 +74,159 @@ void IKMCSetSizeCell(ImgKMeansClusters* const that, const int size) {
   }
 #endif
   that->_size = size;
+  // Update the pixels of the cell
+  IKMCCellFreeStatic(&(that->_cell));
+  that->_cell = IKMCCellCreateStatic(size);
+}
+
+// Return the nb of threads used by the ImgKMeansClusters 'that'
+#if BUILDMODE != 0
+static inline
+#endif 
+int IKMCGetNbThread(const ImgKMeansClusters* const that) {
+#if BUILDMODE == 0
+  if (that == NULL) {
+    PBImgAnalysisErr->_type = PBErrTypeNullPointer;
+    sprintf(PBImgAnalysisErr->_msg, "'that' is null");
+    PBErrCatch(PBImgAnalysisErr);
+  }
+#endif
+  return that->_nbThread;
+}
+
+// Set the nb of threads used by the ImgKMeansClusters 'that' to 'nb'
+#if BUILDMODE != 0
+static inline
+#endif 
+void IKMCSetNbThread(ImgKMeansClusters* const that, const int nb) {
+#if BUILDMODE == 0
+  if (that == NULL) {
+    PBImgAnalysisErr->_type = PBErrTypeNullPointer;
+    sprintf(PBImgAnalysisErr->_msg, "'that' is null");
+    PBErrCatch(PBImgAnalysisErr);
+  }
+  if (nb < 1) {
+    PBImgAnalysisErr->_type = PBErrTypeInvalidArg;
+    sprintf(PBImgAnalysisErr->_msg, "'nb' is invalid (%d>0)", nb);
+    PBErrCatch(PBImgAnalysisErr);
+  }
+#endif
+  that->_nbThread = nb;
+}
+
+// Return the algorithm used by the search of the ImgKMeansClusters 
+// 'that'
+#if BUILDMODE != 0
+static inline
+#endif 
+IKMCSearchMode IKMCGetSearchMode(const ImgKMeansClusters* const that) {
+#if BUILDMODE == 0
+  if (that == NULL) {
+    PBImgAnalysisErr->_type = PBErrTypeNullPointer;
+    sprintf(PBImgAnalysisErr->_msg, "'that' is null");
+    PBErrCatch(PBImgAnalysisErr);
+  }
+#endif
+  return that->_searchMode;
+}
+
+// Set the algorithm used by the search of the ImgKMeansClusters 
+// 'that' to 'mode'
+#if BUILDMODE != 0
+static inline
+#endif 
+void IKMCSetSearchMode(ImgKMeansClusters* const that, 
+  const IKMCSearchMode mode) {
+#if BUILDMODE == 0
+  if (that == NULL) {
+    PBImgAnalysisErr->_type = PBErrTypeNullPointer;
+    sprintf(PBImgAnalysisErr->_msg, "'that' is null");
+    PBErrCatch(PBImgAnalysisErr);
+  }
+#endif
+  that->_searchMode = mode;
+}
+
+// Return the number of distances to centers computed by the last 
+// search of the ImgKMeansClusters 'that'
+#if BUILDMODE != 0
+static inline
+#endif 
+long IKMCGetNbDist(const ImgKMeansClusters* const that) {
+#if BUILDMODE == 0
+  if (that == NULL) {
+    PBImgAnalysisErr->_type = PBErrTypeNullPointer;
+    sprintf(PBImgAnalysisErr->_msg, "'that' is null");
+    PBErrCatch(PBImgAnalysisErr);
+  }
+#endif
+  return that->_nbDist;
+}
+
+// Return the number of pixels per batch of the mini-batch search of 
+// the ImgKMeansClusters 'that'
+#if BUILDMODE != 0
+static inline
+#endif 
+int IKMCGetSizeBatch(const ImgKMeansClusters* const that) {
+#if BUILDMODE == 0
+  if (that == NULL) {
+    PBImgAnalysisErr->_type = PBErrTypeNullPointer;
+    sprintf(PBImgAnalysisErr->_msg, "'that' is null");
+    PBErrCatch(PBImgAnalysisErr);
+  }
+#endif
+  return that->_sizeBatch;
+}
+
+// Set the number of pixels per batch of the mini-batch search of 
+// the ImgKMeansClusters 'that' to 'size'
+// If 'size' is 0 the search uses all the pixels of the image at once
+#if BUILDMODE != 0
+static inline
+#endif 
+void IKMCSetSizeBatch(ImgKMeansClusters* const that, const int size) {
+#if BUILDMODE == 0
+  if (that == NULL) {
+    PBImgAnalysisErr->_type = PBErrTypeNullPointer;
+    sprintf(PBImgAnalysisErr->_msg, "'that' is null");
+    PBErrCatch(PBImgAnalysisErr);
+  }
+  if (size < 0) {
+    PBImgAnalysisErr->_type = PBErrTypeInvalidArg;
+    sprintf(PBImgAnalysisErr->_msg, "'size' is invalid (%d>=0)", size);
+    PBErrCatch(PBImgAnalysisErr);
+  }
+#endif
+  that->_sizeBatch = size;
+}
+
+// Get the average pixel of the 'id'-th cluster of the 
+// ImgKMeansClusters 'that'
+#if BUILDMODE != 0
+static inline
+#endif 
+const GBPixel* IKMCGetPixelCluster(const ImgKMeansClusters* const that, 
+  const int id) {
+#if BUILDMODE == 0
+  if (that == NULL) {
+    PBImgAnalysisErr->_type = PBErrTypeNullPointer;
+    sprintf(PBImgAnalysisErr->_msg, "'that' is null");
+    PBErrCatch(PBImgAnalysisErr);
+  }
+  if (that->_lut == NULL) {
+    PBImgAnalysisErr->_type = PBErrTypeInvalidArg;
+    sprintf(PBImgAnalysisErr->_msg, "'that' has not been searched");
+    PBErrCatch(PBImgAnalysisErr);
+  }
+  if (id < 0 || id >= IKMCGetK(that)) {
+    PBImgAnalysisErr->_type = PBErrTypeInvalidArg;
+    sprintf(PBImgAnalysisErr->_msg, "'id' is invalid (0<=%d<%d)", 
+      id, IKMCGetK(that));
+    PBErrCatch(PBImgAnalysisErr);
+  }
+#endif
+  return that->_lut + id;
 }
 
 // Get the size of the cells of the ImgKMeansClusters 'that'
@@ -106,6 +259,158 @@ int IKMCGetK(const ImgKMeansClusters* const that) {
   return KMeansClustersGetK(&(that->_kmeansClusters));
 }
 
+// Return true if the last prediction with the context 'that' failed
+#if BUILDMODE != 0
+static inline
+#endif
+bool ISCtxIsError(const ImgSegmentorContext* const that) {
+#if BUILDMODE == 0
+  if (that == NULL) {
+    PBImgAnalysisErr->_type = PBErrTypeNullPointer;
+    sprintf(PBImgAnalysisErr->_msg, "'that' is null");
+    PBErrCatch(PBImgAnalysisErr);
+  }
+#endif
+  return that->_flagError;
+}
+
+// Return the message of the error of the last prediction with the 
+// context 'that'
+#if BUILDMODE != 0
+static inline
+#endif
+const char* ISCtxErrMsg(const ImgSegmentorContext* const that) {
+#if BUILDMODE == 0
+  if (that == NULL) {
+    PBImgAnalysisErr->_type = PBErrTypeNullPointer;
+    sprintf(PBImgAnalysisErr->_msg, "'that' is null");
+    PBErrCatch(PBImgAnalysisErr);
+  }
+#endif
+  return that->_errMsg;
+}
+
+// Return the dimensions of the ImgSegmentorPlane 'that'
+#if BUILDMODE != 0
+static inline
+#endif
+const VecShort2D* ISPDim(const ImgSegmentorPlane* const that) {
+#if BUILDMODE == 0
+  if (that == NULL) {
+    PBImgAnalysisErr->_type = PBErrTypeNullPointer;
+    sprintf(PBImgAnalysisErr->_msg, "'that' is null");
+    PBErrCatch(PBImgAnalysisErr);
+  }
+#endif
+  return &(that->_dim);
+}
+
+// Return the number of pixels of the ImgSegmentorPlane 'that'
+#if BUILDMODE != 0
+static inline
+#endif
+long ISPGetArea(const ImgSegmentorPlane* const that) {
+#if BUILDMODE == 0
+  if (that == NULL) {
+    PBImgAnalysisErr->_type = PBErrTypeNullPointer;
+    sprintf(PBImgAnalysisErr->_msg, "'that' is null");
+    PBErrCatch(PBImgAnalysisErr);
+  }
+#endif
+  return (long)VecGet(&(that->_dim), 0) * (long)VecGet(&(that->_dim), 1);
+}
+
+// Return the number of values per pixel of the ImgSegmentorPlane 'that'
+#if BUILDMODE != 0
+static inline
+#endif
+int ISPGetNbChannel(const ImgSegmentorPlane* const that) {
+#if BUILDMODE == 0
+  if (that == NULL) {
+    PBImgAnalysisErr->_type = PBErrTypeNullPointer;
+    sprintf(PBImgAnalysisErr->_msg, "'that' is null");
+    PBErrCatch(PBImgAnalysisErr);
+  }
+#endif
+  return that->_nbChannel;
+}
+
+// Return the values of the ImgSegmentorPlane 'that'
+#if BUILDMODE != 0
+static inline
+#endif
+float* ISPVal(const ImgSegmentorPlane* const that) {
+#if BUILDMODE == 0
+  if (that == NULL) {
+    PBImgAnalysisErr->_type = PBErrTypeNullPointer;
+    sprintf(PBImgAnalysisErr->_msg, "'that' is null");
+    PBErrCatch(PBImgAnalysisErr);
+  }
+#endif
+  return that->_val;
+}
+
+// Return the dimensions of the ImgBitMask 'that'
+#if BUILDMODE != 0
+static inline
+#endif
+const VecShort2D* IBMDim(const ImgBitMask* const that) {
+#if BUILDMODE == 0
+  if (that == NULL) {
+    PBImgAnalysisErr->_type = PBErrTypeNullPointer;
+    sprintf(PBImgAnalysisErr->_msg, "'that' is null");
+    PBErrCatch(PBImgAnalysisErr);
+  }
+#endif
+  return &(that->_dim);
+}
+
+// Return the bit of the ImgBitMask 'that' at position ('x', 'y')
+#if BUILDMODE != 0
+static inline
+#endif
+bool IBMGet(const ImgBitMask* const that, const long x, const long y) {
+#if BUILDMODE == 0
+  if (that == NULL) {
+    PBImgAnalysisErr->_type = PBErrTypeNullPointer;
+    sprintf(PBImgAnalysisErr->_msg, "'that' is null");
+    PBErrCatch(PBImgAnalysisErr);
+  }
+  if (x < 0 || x >= VecGet(&(that->_dim), 0) || 
+    y < 0 || y >= VecGet(&(that->_dim), 1)) {
+    PBImgAnalysisErr->_type = PBErrTypeInvalidArg;
+    sprintf(PBImgAnalysisErr->_msg, "position is invalid (%ld,%ld)",
+      x, y);
+    PBErrCatch(PBImgAnalysisErr);
+  }
+#endif
+  return (that->_words[y * that->_nbWordPerRow + x / IBM_WORDSIZE] >> 
+    (x % IBM_WORDSIZE)) & 1;
+}
+
+// Set to 1 the bit of the ImgBitMask 'that' at position ('x', 'y')
+#if BUILDMODE != 0
+static inline
+#endif
+void IBMSet(ImgBitMask* const that, const long x, const long y) {
+#if BUILDMODE == 0
+  if (that == NULL) {
+    PBImgAnalysisErr->_type = PBErrTypeNullPointer;
+    sprintf(PBImgAnalysisErr->_msg, "'that' is null");
+    PBErrCatch(PBImgAnalysisErr);
+  }
+  if (x < 0 || x >= VecGet(&(that->_dim), 0) || 
+    y < 0 || y >= VecGet(&(that->_dim), 1)) {
+    PBImgAnalysisErr->_type = PBErrTypeInvalidArg;
+    sprintf(PBImgAnalysisErr->_msg, "position is invalid (%ld,%ld)",
+      x, y);
+    PBErrCatch(PBImgAnalysisErr);
+  }
+#endif
+  that->_words[y * that->_nbWordPerRow + x / IBM_WORDSIZE] |= 
+    (uint64_t)1 << (x % IBM_WORDSIZE);
+}
+
 // Return the nb of criterion of the ImgSegmentor 'that'
 #if BUILDMODE != 0
 static inline
@@ -397,6 +702,257 @@ void ISSetSizePool(ImgSegmentor* const that, int nb) {
   that->_sizePool = nb;
 }
 
+// Return the nb of threads used to evaluate the entities during the 
+// training of the ImgSegmentor 'that'
+#if BUILDMODE != 0
+static inline
+#endif
+int ISGetNbThread(const ImgSegmentor* const that) {
+#if BUILDMODE == 0
+  if (that == NULL) {
+    PBImgAnalysisErr->_type = PBErrTypeNullPointer;
+    sprintf(PBImgAnalysisErr->_msg, "'that' is null");
+    PBErrCatch(PBImgAnalysisErr);
+  }
+#endif
+  return that->_nbThread;
+}
+
+// Set the nb of threads used to evaluate the entities during the 
+// training of the ImgSegmentor 'that' to 'nb'
+#if BUILDMODE != 0
+static inline
+#endif
+void ISSetNbThread(ImgSegmentor* const that, const int nb) {
+#if BUILDMODE == 0
+  if (that == NULL) {
+    PBImgAnalysisErr->_type = PBErrTypeNullPointer;
+    sprintf(PBImgAnalysisErr->_msg, "'that' is null");
+    PBErrCatch(PBImgAnalysisErr);
+  }
+  if (nb < 1) {
+    PBImgAnalysisErr->_type = PBErrTypeInvalidArg;
+    sprintf(PBImgAnalysisErr->_msg, "'nb' is invalid (%d>0)", nb);
+    PBErrCatch(PBImgAnalysisErr);
+  }
+#endif
+  that->_nbThread = nb;
+}
+
+// Return the memory budget in bytes of the cache of predictions of 
+// the criteria during the training of the ImgSegmentor 'that'
+#if BUILDMODE != 0
+static inline
+#endif
+size_t ISGetPredCacheBudget(const ImgSegmentor* const that) {
+#if BUILDMODE == 0
+  if (that == NULL) {
+    PBImgAnalysisErr->_type = PBErrTypeNullPointer;
+    sprintf(PBImgAnalysisErr->_msg, "'that' is null");
+    PBErrCatch(PBImgAnalysisErr);
+  }
+#endif
+  return that->_predCacheBudget;
+}
+
+// Set the memory budget in bytes of the cache of predictions of the 
+// criteria during the training of the ImgSegmentor 'that' to 'budget'
+// 0 disables the cache
+#if BUILDMODE != 0
+static inline
+#endif
+void ISSetPredCacheBudget(ImgSegmentor* const that, 
+  const size_t budget) {
+#if BUILDMODE == 0
+  if (that == NULL) {
+    PBImgAnalysisErr->_type = PBErrTypeNullPointer;
+    sprintf(PBImgAnalysisErr->_msg, "'that' is null");
+    PBErrCatch(PBImgAnalysisErr);
+  }
+#endif
+  that->_predCacheBudget = budget;
+}
+
+// Return the memory budget in bytes of the data reused during the 
+// training of the ImgSegmentor 'that', 0 means no limit
+#if BUILDMODE != 0
+static inline
+#endif
+size_t ISGetReuseBudget(const ImgSegmentor* const that) {
+#if BUILDMODE == 0
+  if (that == NULL) {
+    PBImgAnalysisErr->_type = PBErrTypeNullPointer;
+    sprintf(PBImgAnalysisErr->_msg, "'that' is null");
+    PBErrCatch(PBImgAnalysisErr);
+  }
+#endif
+  return that->_reuseBudget;
+}
+
+// Set the memory budget in bytes of the data reused during the 
+// training of the ImgSegmentor 'that' to 'budget', 0 means no limit
+#if BUILDMODE != 0
+static inline
+#endif
+void ISSetReuseBudget(ImgSegmentor* const that, const size_t budget) {
+#if BUILDMODE == 0
+  if (that == NULL) {
+    PBImgAnalysisErr->_type = PBErrTypeNullPointer;
+    sprintf(PBImgAnalysisErr->_msg, "'that' is null");
+    PBErrCatch(PBImgAnalysisErr);
+  }
+#endif
+  that->_reuseBudget = budget;
+}
+
+// Return the number of best checkpoints kept on disk during the 
+// training of the ImgSegmentor 'that', 0 means no limit
+#if BUILDMODE != 0
+static inline
+#endif
+int ISGetCheckpointKeepBest(const ImgSegmentor* const that) {
+#if BUILDMODE == 0
+  if (that == NULL) {
+    PBImgAnalysisErr->_type = PBErrTypeNullPointer;
+    sprintf(PBImgAnalysisErr->_msg, "'that' is null");
+    PBErrCatch(PBImgAnalysisErr);
+  }
+#endif
+  return that->_checkpointKeepBest;
+}
+
+// Return the number of last checkpoints kept on disk during the 
+// training of the ImgSegmentor 'that', 0 means no limit
+#if BUILDMODE != 0
+static inline
+#endif
+int ISGetCheckpointKeepLast(const ImgSegmentor* const that) {
+#if BUILDMODE == 0
+  if (that == NULL) {
+    PBImgAnalysisErr->_type = PBErrTypeNullPointer;
+    sprintf(PBImgAnalysisErr->_msg, "'that' is null");
+    PBErrCatch(PBImgAnalysisErr);
+  }
+#endif
+  return that->_checkpointKeepLast;
+}
+
+// Set the number of best checkpoints kept on disk during the 
+// training of the ImgSegmentor 'that' to 'nb', 0 means no limit
+// The checkpoints are ranked by their value on the validation 
+// category of the dataset if any. Else they are ranked by their value 
+// on the training category, which increases at each checkpoint, then 
+// the best checkpoints are the last ones
+#if BUILDMODE != 0
+static inline
+#endif
+void ISSetCheckpointKeepBest(ImgSegmentor* const that, const int nb) {
+#if BUILDMODE == 0
+  if (that == NULL) {
+    PBImgAnalysisErr->_type = PBErrTypeNullPointer;
+    sprintf(PBImgAnalysisErr->_msg, "'that' is null");
+    PBErrCatch(PBImgAnalysisErr);
+  }
+  if (nb < 0) {
+    PBImgAnalysisErr->_type = PBErrTypeInvalidArg;
+    sprintf(PBImgAnalysisErr->_msg, "'nb' is invalid (%d>=0)", nb);
+    PBErrCatch(PBImgAnalysisErr);
+  }
+#endif
+  that->_checkpointKeepBest = nb;
+}
+
+// Set the number of last checkpoints kept on disk during the 
+// training of the ImgSegmentor 'that' to 'nb', 0 means no limit
+#if BUILDMODE != 0
+static inline
+#endif
+void ISSetCheckpointKeepLast(ImgSegmentor* const that, const int nb) {
+#if BUILDMODE == 0
+  if (that == NULL) {
+    PBImgAnalysisErr->_type = PBErrTypeNullPointer;
+    sprintf(PBImgAnalysisErr->_msg, "'that' is null");
+    PBErrCatch(PBImgAnalysisErr);
+  }
+  if (nb < 0) {
+    PBImgAnalysisErr->_type = PBErrTypeInvalidArg;
+    sprintf(PBImgAnalysisErr->_msg, "'nb' is invalid (%d>=0)", nb);
+    PBErrCatch(PBImgAnalysisErr);
+  }
+#endif
+  that->_checkpointKeepLast = nb;
+}
+
+// Return the path of the directory of the persistent feature cache of 
+// the ImgSegmentor 'that', NULL if not used
+#if BUILDMODE != 0
+static inline
+#endif
+const char* ISGetFeatureCachePath(const ImgSegmentor* const that) {
+#if BUILDMODE == 0
+  if (that == NULL) {
+    PBImgAnalysisErr->_type = PBErrTypeNullPointer;
+    sprintf(PBImgAnalysisErr->_msg, "'that' is null");
+    PBErrCatch(PBImgAnalysisErr);
+  }
+#endif
+  return that->_featureCachePath;
+}
+
+// Set the path of the directory of the persistent feature cache of 
+// the ImgSegmentor 'that' to 'path', NULL to not use it
+#if BUILDMODE != 0
+static inline
+#endif
+void ISSetFeatureCachePath(ImgSegmentor* const that, 
+  const char* const path) {
+#if BUILDMODE == 0
+  if (that == NULL) {
+    PBImgAnalysisErr->_type = PBErrTypeNullPointer;
+    sprintf(PBImgAnalysisErr->_msg, "'that' is null");
+    PBErrCatch(PBImgAnalysisErr);
+  }
+#endif
+  if (that->_featureCachePath != NULL)
+    free(that->_featureCachePath);
+  that->_featureCachePath = (path != NULL ? strdup(path) : NULL);
+}
+
+// Return the path of the file of the training state of the 
+// ImgSegmentor 'that', NULL if not used
+#if BUILDMODE != 0
+static inline
+#endif
+const char* ISGetTrainStatePath(const ImgSegmentor* const that) {
+#if BUILDMODE == 0
+  if (that == NULL) {
+    PBImgAnalysisErr->_type = PBErrTypeNullPointer;
+    sprintf(PBImgAnalysisErr->_msg, "'that' is null");
+    PBErrCatch(PBImgAnalysisErr);
+  }
+#endif
+  return that->_trainStatePath;
+}
+
+// Set the path of the file of the training state of the ImgSegmentor 
+// 'that' to 'path', NULL to not use it
+#if BUILDMODE != 0
+static inline
+#endif
+void ISSetTrainStatePath(ImgSegmentor* const that, 
+  const char* const path) {
+#if BUILDMODE == 0
+  if (that == NULL) {
+    PBImgAnalysisErr->_type = PBErrTypeNullPointer;
+    sprintf(PBImgAnalysisErr->_msg, "'that' is null");
+    PBErrCatch(PBImgAnalysisErr);
+  }
+#endif
+  if (that->_trainStatePath != NULL)
+    free(that->_trainStatePath);
+  that->_trainStatePath = (path != NULL ? strdup(path) : NULL);
+}
+
 // Return the nb of elites for training the ImgSegmentor 'that'
 #if BUILDMODE != 0
 static inline
@@ -473,6 +1029,38 @@ bool ISGetFlagTextOMeter(const ImgSegmentor* const that) {
   return that->_flagTextOMeter;
 }
 
+// Return the flag for the warm start of the training of the 
+// ImgSegmentor 'that'
+#if BUILDMODE != 0
+static inline
+#endif
+bool ISGetFlagWarmStart(const ImgSegmentor* const that) {
+#if BUILDMODE == 0
+  if (that == NULL) {
+    PBImgAnalysisErr->_type = PBErrTypeNullPointer;
+    sprintf(PBImgAnalysisErr->_msg, "'that' is null");
+    PBErrCatch(PBImgAnalysisErr);
+  }
+#endif
+  return that->_flagWarmStart;
+}
+
+// Set the flag for the warm start of the training of the 
+// ImgSegmentor 'that' to 'flag'
+#if BUILDMODE != 0
+static inline
+#endif
+void ISSetFlagWarmStart(ImgSegmentor* const that, const bool flag) {
+#if BUILDMODE == 0
+  if (that == NULL) {
+    PBImgAnalysisErr->_type = PBErrTypeNullPointer;
+    sprintf(PBImgAnalysisErr->_msg, "'that' is null");
+    PBErrCatch(PBImgAnalysisErr);
+  }
+#endif
+  that->_flagWarmStart = flag;
+}
+
 // Return the max nb of adns of the ImgSegmentor 'that'
 #if BUILDMODE != 0
 static inline
@@ -629,6 +1217,38 @@ const NeuraNet* ISCRGBNeuraNet(
   return that->_nn;
 }
 
+// Return the number of samples per color channel of the lookup table 
+// of the ImgSegmentorCriterionRGB 'that'
+#if BUILDMODE != 0
+static inline
+#endif
+int ISCRGBGetLUTSize(const ImgSegmentorCriterionRGB* const that) {
+#if BUILDMODE == 0
+  if (that == NULL) {
+    PBImgAnalysisErr->_type = PBErrTypeNullPointer;
+    sprintf(PBImgAnalysisErr->_msg, "'that' is null");
+    PBErrCatch(PBImgAnalysisErr);
+  }
+#endif
+  return that->_lutSize;
+}
+
+// Return true if the ImgSegmentorCriterionRGB 'that' has a compiled
+// lookup table, else false
+#if BUILDMODE != 0
+static inline
+#endif
+bool ISCRGBIsCompiled(const ImgSegmentorCriterionRGB* const that) {
+#if BUILDMODE == 0
+  if (that == NULL) {
+    PBImgAnalysisErr->_type = PBErrTypeNullPointer;
+    sprintf(PBImgAnalysisErr->_msg, "'that' is null");
+    PBErrCatch(PBImgAnalysisErr);
+  }
+#endif
+  return (that->_lut != NULL);
+}
+
 // ---- ImgSegmentorCriterion
 
 // Return the nb of class of the ImgSegmentorCriterion 'that'
@@ -679,6 +1299,40 @@ void _ISCSetIsReusedInput(ImgSegmentorCriterion* const that,
   that->_flagReusedInput = flag;
 }
 
+// Return true if the parameters of the ImgSegmentorCriterion 'that' 
+// are excluded from the training, else false
+#if BUILDMODE != 0
+static inline
+#endif
+bool _ISCIsFrozen(const ImgSegmentorCriterion* const that) {
+#if BUILDMODE == 0
+  if (that == NULL) {
+    PBImgAnalysisErr->_type = PBErrTypeNullPointer;
+    sprintf(PBImgAnalysisErr->_msg, "'that' is null");
+    PBErrCatch(PBImgAnalysisErr);
+  }
+#endif
+  return that->_flagFrozen;
+}
+
+// Set the flag memorizing if the parameters of the 
+// ImgSegmentorCriterion 'that' are excluded from the training to 
+// 'flag'
+#if BUILDMODE != 0
+static inline
+#endif
+void _ISCSetIsFrozen(ImgSegmentorCriterion* const that, 
+  const bool flag) {
+#if BUILDMODE == 0
+  if (that == NULL) {
+    PBImgAnalysisErr->_type = PBErrTypeNullPointer;
+    sprintf(PBImgAnalysisErr->_msg, "'that' is null");
+    PBErrCatch(PBImgAnalysisErr);
+  }
+#endif
+  that->_flagFrozen = flag;
+}
+
 // Return the reused input of the ImgSegmentorCriterion 'that'
 #if BUILDMODE != 0
 static inline
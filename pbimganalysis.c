@@ -14,16 +14,86 @@
 // ================= Global variable ==================
 
 // Variable to handle the signal Ctrl-C during training
-static volatile bool PBIA_CtrlC = false;
+static atomic_bool PBIA_CtrlC = false;
+
+// Last generation given to the criteria of an ImgSegmentor
+static atomic_ulong PBIA_Generation = 0;
 
 // ================ Functions declaration ====================
 
-// Get the input values for the pixel at position 'pos' according to
-// the cell size of the ImgKMeansClusters 'that'
-// The return is a VecFloat made of the sizeCell^2 pixels' value 
-// around pos ordered by (((r*256+g)*256+b)*256+a) 
-VecFloat* IKMCGetInputOverCell(const ImgKMeansClusters* const that, 
-  const VecShort2D* const pos);
+// Set the 4*'cell'->_nbPixel values of 'input' to the input values 
+// for the pixel at position 'pos' over the cell 'cell' of the 
+// ImgKMeansClusters 'that', 'keys' is a buffer of 'cell'->_nbPixel 
+// values
+void IKMCGetInputOverCellInto(const ImgKMeansClusters* const that,
+  const IKMCCell* const cell, const VecShort2D* const pos,
+  uint32_t* const keys, float* const input);
+
+// Update the average pixel of each cluster and the packed centers of
+// the ImgKMeansClusters 'that' from the current centers of its 
+// KMeansClusters
+void IKMCUpdateClusters(ImgKMeansClusters* const that);
+
+// Return the index of the center of the ImgKMeansClusters 'that' 
+// nearest to the input over cell 'input'
+int IKMCNearestCenter(const ImgKMeansClusters* const that, 
+  const float* const input);
+
+// Main function of the threads of IKMCRunWorkers
+void* IKMCWorkerMain(void* arg);
+
+// Task computing the inputs over cells and the ids of the pixels in 
+// the rows of the image processed by the worker 'worker'
+void IKMCPixelTaskRun(IKMCWorker* const worker);
+
+// Return the euclidean distance between the 'dim' values 'a' and 'b'
+float IKMCDist(const float* const a, const float* const b, 
+  const int dim);
+
+// Set the 'K' packed 'centers' to the initial centers of the search
+// of the ImgKMeansClusters 'that' over the 'nbInput' packed 'inputs' 
+// of dimension 'dim', according to the seed of its KMeansClusters
+void IKMCSeedCenters(const ImgKMeansClusters* const that, 
+  const float* const inputs, const long nbInput, const int dim, 
+  const int K, float* const centers);
+
+// Search the 'K' clusters of the ImgKMeansClusters 'that' over the 
+// 'nbInput' packed 'inputs' of dimension 'dim' with the Lloyd k-means,
+// accelerated with distance bounds (Hamerly) if 'flagBounds' is true,
+// and set the centers of its KMeansClusters to the result
+void IKMCSearchLloyd(ImgKMeansClusters* const that, 
+  const float* const inputs, const long nbInput, const int dim, 
+  const int K, const bool flagBounds);
+
+// Task assigning the inputs processed by the worker 'worker' to their
+// nearest center
+void IKMCAssignTaskRun(IKMCWorker* const worker);
+
+// Set the centers of the KMeansClusters of the ImgKMeansClusters 
+// 'that' to the 'K' packed 'centers' of dimension 'dim'
+void IKMCSetCenters(ImgKMeansClusters* const that, 
+  const float* const centers, const int K, const int dim);
+
+// Set the 'sizeBatch' packed 'inputs' over the cell 'cell' to the 
+// inputs of random pixels of random tiles of the image of the 
+// ImgKMeansClusters 'that', 'keys' is a buffer of 'cell'->_nbPixel 
+// values
+void IKMCSampleBatch(const ImgKMeansClusters* const that, 
+  const IKMCCell* const cell, uint32_t* const keys, float* const inputs, 
+  const int sizeBatch);
+
+// Search the 'K' clusters of the ImgKMeansClusters 'that' with the 
+// mini-batch k-means over random tiles of its image and set the 
+// centers of its KMeansClusters to the result
+void IKMCSearchMiniBatch(ImgKMeansClusters* const that, 
+  const IKMCCell* const cell, const int K);
+
+// Apply the task 'task' with the argument 'arg' to the 'nbItem' 
+// items of the ImgKMeansClusters 'that', splitting the items over its
+// threads
+// Return the number of distances to centers computed by the task
+long IKMCRunWorkers(const ImgKMeansClusters* const that, 
+  const long nbItem, void (*task)(IKMCWorker* const), void* const arg);
 
 // ================ Functions implementation ====================
 
@@ -50,6 +120,14 @@ ImgKMeansClusters ImgKMeansClustersCreateStatic(
   that._img = img;
   that._kmeansClusters = KMeansClustersCreateStatic(seed);
   that._size = size;
+  that._cell = IKMCCellCreateStatic(size);
+  that._lut = NULL;
+  that._centers = NULL;
+  that._dimCenter = 0;
+  that._nbThread = 1;
+  that._searchMode = IKMCSearchMode_KMeansClusters;
+  that._nbDist = 0;
+  that._sizeBatch = 0;
   // Return the new ImgKMeansClusters
   return that;
 }
@@ -67,10 +145,65 @@ void ImgKMeansClustersFreeStatic(ImgKMeansClusters* const that) {
   that->_img = NULL;
   // Free the memory used by the KMeansClusters
   KMeansClustersFreeStatic((KMeansClusters*)IKMCKMeansClusters(that));
+  // Free the memory used by the average pixels of the clusters
+  free(that->_lut);
+  that->_lut = NULL;
+  free(that->_centers);
+  that->_centers = NULL;
+  that->_dimCenter = 0;
+  // Free the memory used by the cell
+  IKMCCellFreeStatic(&(that->_cell));
+}
+
+// Create the IKMCCell of the pixels at a distance rounded to less or 
+// equal than 'size' from the center of a cell
+IKMCCell IKMCCellCreateStatic(const int size) {
+#if BUILDMODE == 0
+  if (size < 0) {
+    PBImgAnalysisErr->_type = PBErrTypeInvalidArg;
+    sprintf(PBImgAnalysisErr->_msg, "'size' is invalid (%d>=0)", size);
+    PBErrCatch(PBImgAnalysisErr);
+  }
+#endif
+  // Declare the new IKMCCell
+  IKMCCell that;
+  int width = 2 * size + 1;
+  that._offsets = PBErrMalloc(PBImgAnalysisErr, 
+    sizeof(short) * 2 * width * width);
+  that._nbPixel = 0;
+  // Loop over the square around the center and keep the pixels 
+  // inside the radius
+  for (int x = -size; x <= size; ++x) {
+    for (int y = -size; y <= size; ++y) {
+      if ((int)round(sqrt((float)(x * x + y * y))) <= size) {
+        that._offsets[2 * that._nbPixel] = x;
+        that._offsets[2 * that._nbPixel + 1] = y;
+        ++(that._nbPixel);
+      }
+    }
+  }
+  // Return the new IKMCCell
+  return that;
+}
+
+// Free the memory used by the IKMCCell 'that'
+void IKMCCellFreeStatic(IKMCCell* const that) {
+  if (that == NULL)
+    return;
+  free(that->_offsets);
+  that->_offsets = NULL;
+  that->_nbPixel = 0;
 }
 
 // Search for the 'K' clusters in the image of the
 // ImgKMeansClusters 'that'
+// If the size of batch is not 0 the search is a mini-batch k-means 
+// over random tiles of the image, else it's the one of the search 
+// mode
+// The inputs over cell of all the pixels are computed in one array of
+// packed values for the searches of the ImgKMeansClusters, and 
+// directly in one VecFloat per pixel for the search of 
+// KMeansClusters which needs a GSet of VecFloat
 void IKMCSearch(ImgKMeansClusters* const that, const int K) {
 #if BUILDMODE == 0
   if (that == NULL) {
@@ -84,26 +217,613 @@ void IKMCSearch(ImgKMeansClusters* const that, const int K) {
     PBErrCatch(PBImgAnalysisErr);
   }
 #endif
-  // Create a set to memorize the input over cells
-  GSetVecFloat inputOverCells = GSetVecFloatCreateStatic();
+  // If the search is by mini-batch
+  if (IKMCGetSizeBatch(that) > 0) {
+    IKMCSearchMiniBatch(that, &(that->_cell), K);
+    IKMCUpdateClusters(that);
+    return;
+  }
   // Get the dimension of the image
   VecShort2D dim = GBGetDim(IKMCImg(that));
-  // Loop on pixels
-  VecShort2D pos = VecShortCreateStatic2D();
-  do {
-    // Get the KMeansClusters input over the cell
-    VecFloat* inputOverCell = IKMCGetInputOverCell(that, &pos);
-    // Add it to the inputs for the search
-    GSetAppend(&inputOverCells, inputOverCell);
-  } while (VecStep(&pos, &dim));
+  long area = (long)VecGet(&dim, 0) * (long)VecGet(&dim, 1);
+  int dimInput = 4 * that->_cell._nbPixel;
   // Search the clusters
-  KMeansClustersSearch((KMeansClusters*)IKMCKMeansClusters(that),
-    &inputOverCells, K);
-  // Free the memory used by the input
-  while (GSetNbElem(&inputOverCells) > 0) {
-    VecFloat* v = GSetPop(&inputOverCells);
-    VecFree(&v);
+  if (IKMCGetSearchMode(that) != IKMCSearchMode_KMeansClusters) {
+    // Compute the input over cells in one packed array
+    float* inputs = PBErrMalloc(PBImgAnalysisErr, 
+      sizeof(float) * dimInput * area);
+    IKMCPixelTask task = {._inputs = inputs, ._vecInputs = NULL, 
+      ._labels = NULL};
+    IKMCRunWorkers(that, VecGet(&dim, 1), IKMCPixelTaskRun, &task);
+    IKMCSearchLloyd(that, inputs, area, dimInput, K, 
+      IKMCGetSearchMode(that) == IKMCSearchMode_Hamerly);
+    free(inputs);
+  } else {
+    that->_nbDist = 0;
+    // Create a set of the input over cells for the search and compute
+    // them directly in its VecFloat, the search of KMeansClusters 
+    // can't use a packed array
+    GSetVecFloat inputOverCells = GSetVecFloatCreateStatic();
+    VecFloat** vecInputs = PBErrMalloc(PBImgAnalysisErr, 
+      sizeof(VecFloat*) * area);
+    for (long iPix = 0; iPix < area; ++iPix) {
+      vecInputs[iPix] = VecFloatCreate(dimInput);
+      GSetAppend(&inputOverCells, vecInputs[iPix]);
+    }
+    IKMCPixelTask task = {._inputs = NULL, ._vecInputs = vecInputs, 
+      ._labels = NULL};
+    IKMCRunWorkers(that, VecGet(&dim, 1), IKMCPixelTaskRun, &task);
+    free(vecInputs);
+    KMeansClustersSearch((KMeansClusters*)IKMCKMeansClusters(that),
+      &inputOverCells, K);
+    while (GSetNbElem(&inputOverCells) > 0) {
+      VecFloat* input = GSetPop(&inputOverCells);
+      VecFree(&input);
+    }
+  }
+  // Update the average pixels of the clusters
+  IKMCUpdateClusters(that);
+}
+
+// Return the euclidean distance between the 'dim' values 'a' and 'b'
+float IKMCDist(const float* const a, const float* const b, 
+  const int dim) {
+  float dist = 0.0;
+  for (int i = 0; i < dim; ++i) {
+    float d = a[i] - b[i];
+    dist += d * d;
+  }
+  return sqrt(dist);
+}
+
+// Set the 'K' packed 'centers' to the initial centers of the search
+// of the ImgKMeansClusters 'that' over the 'nbInput' packed 'inputs' 
+// of dimension 'dim', according to the seed of its KMeansClusters
+void IKMCSeedCenters(const ImgKMeansClusters* const that, 
+  const float* const inputs, const long nbInput, const int dim, 
+  const int K, float* const centers) {
+  switch (IKMCKMeansClusters(that)->_seed) {
+    case KMeansClustersSeed_Random: {
+      // Random partition, the centers are the average of the inputs 
+      // randomly assigned to them
+      long* count = PBErrMalloc(PBImgAnalysisErr, sizeof(long) * K);
+      memset(count, 0, sizeof(long) * K);
+      memset(centers, 0, sizeof(float) * K * dim);
+      for (long iInput = 0; iInput < nbInput; ++iInput) {
+        const float* input = inputs + dim * iInput;
+        int id = (int)(random() % K);
+        for (int i = 0; i < dim; ++i)
+          centers[id * dim + i] += input[i];
+        ++(count[id]);
+      }
+      for (int id = 0; id < K; ++id)
+        for (int i = 0; i < dim && count[id] > 0; ++i)
+          centers[id * dim + i] /= (float)(count[id]);
+      free(count);
+      break;
+    }
+    case KMeansClustersSeed_PlusPlus: {
+      // The first center is a random input, the following ones are
+      // inputs chosen with a probability proportional to their 
+      // squared distance to the nearest already chosen center
+      float* dist = PBErrMalloc(PBImgAnalysisErr, sizeof(float) * nbInput);
+      long iInput = random() % nbInput;
+      memcpy(centers, inputs + dim * iInput, sizeof(float) * dim);
+      for (int id = 1; id < K; ++id) {
+        double sum = 0.0;
+        for (iInput = 0; iInput < nbInput; ++iInput) {
+          const float* input = inputs + dim * iInput;
+          float d = IKMCDist(input, centers + (id - 1) * dim, dim);
+          if (id == 1 || d * d < dist[iInput])
+            dist[iInput] = d * d;
+          sum += dist[iInput];
+        }
+        double r = rnd() * sum;
+        for (iInput = 0; iInput < nbInput - 1 && r >= dist[iInput]; 
+          ++iInput)
+          r -= dist[iInput];
+        memcpy(centers + id * dim, inputs + dim * iInput, 
+          sizeof(float) * dim);
+      }
+      free(dist);
+      break;
+    }
+    default: {
+      // Forgy, the centers are distinct random inputs
+      long* chosen = PBErrMalloc(PBImgAnalysisErr, sizeof(long) * K);
+      for (int id = 0; id < K; ++id) {
+        bool flagChosen = true;
+        while (flagChosen) {
+          chosen[id] = random() % nbInput;
+          flagChosen = false;
+          for (int jd = 0; jd < id && nbInput >= K; ++jd)
+            if (chosen[jd] == chosen[id])
+              flagChosen = true;
+        }
+        memcpy(centers + id * dim, inputs + dim * chosen[id], 
+          sizeof(float) * dim);
+      }
+      free(chosen);
+      break;
+    }
+  }
+}
+
+// Search the 'K' clusters of the ImgKMeansClusters 'that' over the 
+// 'nbInput' packed 'inputs' of dimension 'dim' with the Lloyd k-means,
+// accelerated with distance bounds (Hamerly) if 'flagBounds' is true,
+// and set the centers of its KMeansClusters to the result
+// With the bounds, each input keeps an upper bound of the distance to
+// its center and a lower bound of the distance to the other centers, 
+// the distances are recomputed only when these bounds can't prove the
+// assignment. The assignment is split over the threads, the sums of
+// the clusters are updated in the order of the inputs so the result 
+// doesn't depend on the number of threads nor on the bounds.
+// The initial centers are chosen by IKMCSeedCenters, which follows 
+// the seed of the KMeansClusters but not its use of the random 
+// generator, so the result differs from the one of KMeansClustersSearch
+void IKMCSearchLloyd(ImgKMeansClusters* const that, 
+  const float* const inputs, const long nbInput, const int dim, 
+  const int K, const bool flagBounds) {
+  // Allocate memory
+  float* centers = PBErrMalloc(PBImgAnalysisErr, sizeof(float) * K * dim);
+  double* sums = PBErrMalloc(PBImgAnalysisErr, sizeof(double) * K * dim);
+  long* count = PBErrMalloc(PBImgAnalysisErr, sizeof(long) * K);
+  float* moved = PBErrMalloc(PBImgAnalysisErr, sizeof(float) * K);
+  int* assign = PBErrMalloc(PBImgAnalysisErr, sizeof(int) * nbInput);
+  int* next = PBErrMalloc(PBImgAnalysisErr, sizeof(int) * nbInput);
+  float* halfDist = NULL;
+  float* upper = NULL;
+  float* lower = NULL;
+  if (flagBounds) {
+    halfDist = PBErrMalloc(PBImgAnalysisErr, sizeof(float) * K);
+    upper = PBErrMalloc(PBImgAnalysisErr, sizeof(float) * nbInput);
+    lower = PBErrMalloc(PBImgAnalysisErr, sizeof(float) * nbInput);
+  }
+  memset(sums, 0, sizeof(double) * K * dim);
+  memset(count, 0, sizeof(long) * K);
+  memset(assign, 0, sizeof(int) * nbInput);
+  // Get the initial centers
+  IKMCSeedCenters(that, inputs, nbInput, dim, K, centers);
+  // Declare the task of the assignment
+  IKMCAssignTask task = {._inputs = inputs, ._dim = dim, ._K = K, 
+    ._centers = centers, ._assign = assign, ._next = next, 
+    ._upper = upper, ._lower = lower, ._halfDist = halfDist, 
+    ._flagFirst = true};
+  // Loop until the assignment doesn't change
+  long nbDist = 0;
+  long nbChanged = 1;
+  for (int iter = 0; iter < IKMC_MAXITER && nbChanged > 0; ++iter) {
+    // Get the half distance of each center to its nearest other center
+    if (flagBounds) {
+      for (int id = 0; id < K; ++id)
+        halfDist[id] = -1.0;
+      for (int id = 0; id < K; ++id) {
+        for (int jd = id + 1; jd < K; ++jd) {
+          float d = 0.5 * IKMCDist(centers + id * dim, 
+            centers + jd * dim, dim);
+          if (halfDist[id] < 0.0 || d < halfDist[id])
+            halfDist[id] = d;
+          if (halfDist[jd] < 0.0 || d < halfDist[jd])
+            halfDist[jd] = d;
+        }
+      }
+      nbDist += K * (K - 1) / 2;
+    }
+    // Assign the inputs to their nearest center
+    nbDist += IKMCRunWorkers(that, nbInput, IKMCAssignTaskRun, &task);
+    // Update the assignment and the sums of the clusters
+    nbChanged = 0;
+    for (long iInput = 0; iInput < nbInput; ++iInput) {
+      int prev = assign[iInput];
+      int id = next[iInput];
+      if (task._flagFirst || id != prev) {
+        const float* input = inputs + dim * iInput;
+        if (!task._flagFirst) {
+          for (int i = 0; i < dim; ++i)
+            sums[prev * dim + i] -= input[i];
+          --(count[prev]);
+        }
+        for (int i = 0; i < dim; ++i)
+          sums[id * dim + i] += input[i];
+        ++(count[id]);
+        assign[iInput] = id;
+        ++nbChanged;
+      }
+    }
+    task._flagFirst = false;
+    if (nbChanged == 0)
+      break;
+    // Move the centers to the average of their inputs, empty clusters
+    // keep their center
+    float maxMoved = 0.0;
+    float secondMoved = 0.0;
+    int idMaxMoved = 0;
+    for (int id = 0; id < K; ++id) {
+      moved[id] = 0.0;
+      if (count[id] > 0) {
+        float* center = centers + id * dim;
+        float d = 0.0;
+        for (int i = 0; i < dim; ++i) {
+          float v = sums[id * dim + i] / (double)(count[id]);
+          d += (v - center[i]) * (v - center[i]);
+          center[i] = v;
+        }
+        moved[id] = sqrt(d);
+      }
+      if (moved[id] > maxMoved) {
+        secondMoved = maxMoved;
+        maxMoved = moved[id];
+        idMaxMoved = id;
+      } else if (moved[id] > secondMoved) {
+        secondMoved = moved[id];
+      }
+    }
+    // Update the bounds according to the centers' moves
+    if (flagBounds) {
+      for (long iInput = 0; iInput < nbInput; ++iInput) {
+        upper[iInput] += moved[assign[iInput]];
+        lower[iInput] -= 
+          (assign[iInput] == idMaxMoved ? secondMoved : maxMoved);
+      }
+    }
+  }
+  that->_nbDist = nbDist;
+  // Replace the centers of the KMeansClusters with the result
+  IKMCSetCenters(that, centers, K, dim);
+  // Free memory
+  free(centers);
+  free(sums);
+  free(count);
+  free(moved);
+  free(assign);
+  free(next);
+  free(halfDist);
+  free(upper);
+  free(lower);
+}
+
+// Task assigning the inputs processed by the worker 'worker' to their
+// nearest center
+// Without bounds (Lloyd) all the distances are computed, else 
+// (Hamerly) they are computed only if the bounds, reduced by a margin
+// for the rounding errors, can't prove the current center is the 
+// nearest one. The nearest center is the first one with the lowest 
+// distance in both cases.
+void IKMCAssignTaskRun(IKMCWorker* const worker) {
+  IKMCAssignTask* task = worker->_arg;
+  int dim = task->_dim;
+  int K = task->_K;
+  // Loop on the inputs of the worker
+  for (long iInput = worker->_first; iInput < worker->_end; ++iInput) {
+    const float* input = task->_inputs + dim * iInput;
+    if (task->_upper != NULL && !task->_flagFirst) {
+      // If the bounds prove the current center is the nearest one 
+      // there is nothing to do
+      int prev = task->_assign[iInput];
+      task->_next[iInput] = prev;
+      float bound = (task->_halfDist[prev] > task->_lower[iInput] ? 
+        task->_halfDist[prev] : task->_lower[iInput]);
+      bound *= 1.0 - IKMC_BOUNDMARGIN;
+      if (task->_upper[iInput] < bound)
+        continue;
+      // Tighten the upper bound and check again
+      task->_upper[iInput] = 
+        IKMCDist(input, task->_centers + prev * dim, dim);
+      ++(worker->_nbDist);
+      if (task->_upper[iInput] < bound)
+        continue;
+    }
+    // Search the nearest and second nearest centers
+    int id = 0;
+    float first = -1.0;
+    float second = -1.0;
+    for (int jd = 0; jd < K; ++jd) {
+      float d = IKMCDist(input, task->_centers + jd * dim, dim);
+      if (first < 0.0 || d < first) {
+        second = first;
+        first = d;
+        id = jd;
+      } else if (second < 0.0 || d < second) {
+        second = d;
+      }
+    }
+    worker->_nbDist += K;
+    if (task->_upper != NULL) {
+      task->_upper[iInput] = first;
+      task->_lower[iInput] = (second < 0.0 ? 0.0 : second);
+    }
+    task->_next[iInput] = id;
+  }
+}
+
+// Set the centers of the KMeansClusters of the ImgKMeansClusters 
+// 'that' to the 'K' packed 'centers' of dimension 'dim'
+void IKMCSetCenters(ImgKMeansClusters* const that, 
+  const float* const centers, const int K, const int dim) {
+  KMeansClusters* clusters = (KMeansClusters*)IKMCKMeansClusters(that);
+  KMeansClustersSeed seed = clusters->_seed;
+  KMeansClustersFreeStatic(clusters);
+  *clusters = KMeansClustersCreateStatic(seed);
+  for (int id = 0; id < K; ++id) {
+    VecFloat* center = VecFloatCreate(dim);
+    memcpy(center->_val, centers + id * dim, sizeof(float) * dim);
+    GSetAppend(&(clusters->_centers), center);
+  }
+}
+
+// Set the 'sizeBatch' packed 'inputs' over the cell 'cell' to the 
+// inputs of random pixels of random tiles of the image of the 
+// ImgKMeansClusters 'that', 'keys' is a buffer of 'cell'->_nbPixel 
+// values
+void IKMCSampleBatch(const ImgKMeansClusters* const that, 
+  const IKMCCell* const cell, uint32_t* const keys, float* const inputs, 
+  const int sizeBatch) {
+  // Get the dimension of the image and of the tiles
+  VecShort2D dim = GBGetDim(IKMCImg(that));
+  VecShort2D dimTile = VecShortCreateStatic2D();
+  for (int i = 2; i--;) {
+    VecSet(&dimTile, i, IKMC_MINIBATCHTILE);
+    if (VecGet(&dimTile, i) > VecGet(&dim, i))
+      VecSet(&dimTile, i, VecGet(&dim, i));
+  }
+  // Loop until the batch is full
+  int iInput = 0;
+  while (iInput < sizeBatch) {
+    // Get a random tile
+    VecShort2D origin = VecShortCreateStatic2D();
+    for (int i = 2; i--;)
+      VecSet(&origin, i, 
+        random() % (VecGet(&dim, i) - VecGet(&dimTile, i) + 1));
+    // Loop on a few random pixels of the tile, the tile giving the 
+    // locality of the accesses to the image and the several tiles
+    // per batch its diversity
+    for (int iPix = 0; 
+      iPix < IKMC_MINIBATCHPIXPERTILE && iInput < sizeBatch; ++iPix) {
+      VecShort2D pos = origin;
+      for (int i = 2; i--;)
+        VecSet(&pos, i, 
+          VecGet(&pos, i) + random() % VecGet(&dimTile, i));
+      IKMCGetInputOverCellInto(that, cell, &pos, keys, 
+        inputs + 4 * cell->_nbPixel * iInput);
+      ++iInput;
+    }
+  }
+}
+
+// Search the 'K' clusters of the ImgKMeansClusters 'that' with the 
+// mini-batch k-means over random tiles of its image and set the 
+// centers of its KMeansClusters to the result
+// At each iteration the centers move toward the inputs of a new batch
+// nearest to them, with a rate decreasing with the number of inputs 
+// they already got. The search stops when the net move of the centers
+// over an iteration is small enough. The memory used is bounded by 
+// the size of batch.
+void IKMCSearchMiniBatch(ImgKMeansClusters* const that, 
+  const IKMCCell* const cell, const int K) {
+  // Allocate memory
+  int dim = 4 * cell->_nbPixel;
+  int sizeBatch = IKMCGetSizeBatch(that);
+  float* inputs = PBErrMalloc(PBImgAnalysisErr, 
+    sizeof(float) * dim * sizeBatch);
+  uint32_t* keys = PBErrMalloc(PBImgAnalysisErr, 
+    sizeof(uint32_t) * cell->_nbPixel);
+  float* centers = PBErrMalloc(PBImgAnalysisErr, sizeof(float) * K * dim);
+  float* prevCenters = 
+    PBErrMalloc(PBImgAnalysisErr, sizeof(float) * K * dim);
+  long* count = PBErrMalloc(PBImgAnalysisErr, sizeof(long) * K);
+  int* assign = PBErrMalloc(PBImgAnalysisErr, sizeof(int) * sizeBatch);
+  memset(count, 0, sizeof(long) * K);
+  // Get the initial centers from a first batch
+  IKMCSampleBatch(that, cell, keys, inputs, sizeBatch);
+  IKMCSeedCenters(that, inputs, sizeBatch, dim, K, centers);
+  // Declare the task of the assignment
+  IKMCAssignTask task = {._inputs = inputs, ._dim = dim, ._K = K, 
+    ._centers = centers, ._assign = NULL, ._next = assign, 
+    ._upper = NULL, ._lower = NULL, ._halfDist = NULL, 
+    ._flagFirst = true};
+  // Loop until the centers don't move anymore
+  long nbDist = 0;
+  float maxMoved = IKMC_MINIBATCHEPSILON + 1.0;
+  for (int iter = 0; 
+    iter < IKMC_MINIBATCHMAXITER && maxMoved > IKMC_MINIBATCHEPSILON; 
+    ++iter) {
+    // Get a new batch
+    IKMCSampleBatch(that, cell, keys, inputs, sizeBatch);
+    // Assign the inputs of the batch to their nearest center with the 
+    // centers at the beginning of the iteration
+    memcpy(prevCenters, centers, sizeof(float) * K * dim);
+    nbDist += IKMCRunWorkers(that, sizeBatch, IKMCAssignTaskRun, &task);
+    // Move the centers toward their inputs
+    for (int iInput = 0; iInput < sizeBatch; ++iInput) {
+      const float* input = inputs + dim * iInput;
+      int id = assign[iInput];
+      float* center = centers + id * dim;
+      ++(count[id]);
+      float rate = 1.0 / (float)(count[id]);
+      for (int i = 0; i < dim; ++i)
+        center[i] += rate * (input[i] - center[i]);
+    }
+    // Get the largest net move of the centers over the iteration
+    maxMoved = 0.0;
+    for (int id = 0; id < K; ++id) {
+      float d = IKMCDist(centers + id * dim, prevCenters + id * dim, dim);
+      if (d > maxMoved)
+        maxMoved = d;
+    }
+  }
+  that->_nbDist = nbDist;
+  // Replace the centers of the KMeansClusters with the result
+  IKMCSetCenters(that, centers, K, dim);
+  // Free memory
+  free(inputs);
+  free(keys);
+  free(centers);
+  free(prevCenters);
+  free(count);
+  free(assign);
+}
+
+// Update the average pixel of each cluster and the packed centers of
+// the ImgKMeansClusters 'that' from the current centers of its 
+// KMeansClusters
+void IKMCUpdateClusters(ImgKMeansClusters* const that) {
+  // Free the eventual previous average pixels and centers
+  free(that->_lut);
+  free(that->_centers);
+  // Allocate memory for the average pixels and centers
+  int K = IKMCGetK(that);
+  that->_lut = PBErrMalloc(PBImgAnalysisErr, sizeof(GBPixel) * K);
+  that->_dimCenter = (K > 0 ? 
+    VecGetDim(KMeansClustersCenter(IKMCKMeansClusters(that), 0)) : 0);
+  that->_centers = PBErrMalloc(PBImgAnalysisErr, 
+    sizeof(float) * K * that->_dimCenter);
+  // Loop on clusters
+  for (int id = 0; id < K; ++id) {
+    // Get the 'id'-th cluster's center
+    const VecFloat* center = 
+      KMeansClustersCenter(IKMCKMeansClusters(that), id);
+    // Pack the center
+    memcpy(that->_centers + id * that->_dimCenter, center->_val,
+      sizeof(float) * that->_dimCenter);
+    // Calculate the average pixel over the pixels in the cell
+    float avgPix[4] = {0.0, 0.0, 0.0, 0.0};
+    for (int i = 0; i < VecGetDim(center); i += 4) {
+      for (int j = 4; j--;) {
+        avgPix[j] += VecGet(center, i + j);
+      }
+    }
+    float nbPixel = round((float)VecGetDim(center) / 4.0);
+    // Update the average pixel values and ensure the converted value 
+    // from float to char is valid
+    for (int j = 4; j--;) {
+      float v = avgPix[j] / nbPixel;
+      if (v < 0.0) 
+        v = 0.0;
+      else if (v > 255.0)
+        v = 255.0;
+      that->_lut[id]._rgba[j] = (unsigned char)v;
+    }
+  }
+}
+
+// Return the index of the center of the ImgKMeansClusters 'that' 
+// nearest to the input over cell 'input'
+// The distances are computed on the packed centers with a loop the 
+// compiler can vectorize
+int IKMCNearestCenter(const ImgKMeansClusters* const that, 
+  const float* const input) {
+  int dim = that->_dimCenter;
+  int id = 0;
+  float best = 0.0;
+  for (int iCenter = 0; iCenter < IKMCGetK(that); ++iCenter) {
+    const float* center = that->_centers + iCenter * dim;
+    // Squared distance, enough to compare the centers
+    float dist = 0.0;
+    for (int i = 0; i < dim; ++i) {
+      float d = input[i] - center[i];
+      dist += d * d;
+    }
+    if (iCenter == 0 || dist < best) {
+      best = dist;
+      id = iCenter;
+    }
+  }
+  return id;
+}
+
+// Main function of the threads of IKMCRunWorkers
+void* IKMCWorkerMain(void* arg) {
+  IKMCWorker* worker = arg;
+  worker->_task(worker);
+  return NULL;
+}
+
+// Task computing the inputs over cells and the ids of the pixels in 
+// the rows of the image processed by the worker 'worker'
+void IKMCPixelTaskRun(IKMCWorker* const worker) {
+  const ImgKMeansClusters* that = worker->_ikmc;
+  IKMCPixelTask* task = worker->_arg;
+  int nbPixel = that->_cell._nbPixel;
+  // Allocate the buffers of the worker
+  uint32_t* keys = PBErrMalloc(PBImgAnalysisErr, 
+    sizeof(uint32_t) * nbPixel);
+  float* input = PBErrMalloc(PBImgAnalysisErr, 
+    sizeof(float) * 4 * nbPixel);
+  // Get the dimension of the image
+  VecShort2D dim = GBGetDim(IKMCImg(that));
+  // Loop on the pixels of the worker's rows
+  VecShort2D pos = VecShortCreateStatic2D();
+  for (long y = worker->_first; y < worker->_end; ++y) {
+    VecSet(&pos, 1, y);
+    for (int x = 0; x < VecGet(&dim, 0); ++x) {
+      VecSet(&pos, 0, x);
+      long iPix = y * (long)VecGet(&dim, 0) + (long)x;
+      // Get the input over cell, directly in the inputs if any
+      float* inputOverCell = input;
+      if (task->_inputs != NULL)
+        inputOverCell = task->_inputs + 4 * nbPixel * iPix;
+      else if (task->_vecInputs != NULL)
+        inputOverCell = task->_vecInputs[iPix]->_val;
+      IKMCGetInputOverCellInto(that, &(that->_cell), &pos, keys, 
+        inputOverCell);
+      // Get the id of the pixel if needed
+      if (task->_labels != NULL) {
+        task->_labels[iPix] = IKMCNearestCenter(that, inputOverCell);
+        worker->_nbDist += IKMCGetK(that);
+      }
+    }
+  }
+  // Free memory
+  free(keys);
+  free(input);
+}
+
+// Apply the task 'task' with the argument 'arg' to the 'nbItem' 
+// items of the ImgKMeansClusters 'that', splitting the items over its
+// threads
+// Return the number of distances to centers computed by the task
+long IKMCRunWorkers(const ImgKMeansClusters* const that, 
+  const long nbItem, void (*task)(IKMCWorker* const), void* const arg) {
+  // Get the number of threads, no need for more threads than items
+  long nb = IKMCGetNbThread(that);
+  if (nb > nbItem)
+    nb = nbItem;
+  if (nb < 1)
+    nb = 1;
+  // Create the workers
+  IKMCWorker* workers = PBErrMalloc(PBImgAnalysisErr, 
+    sizeof(IKMCWorker) * nb);
+  for (long iThread = 0; iThread < nb; ++iThread) {
+    workers[iThread]._ikmc = that;
+    workers[iThread]._task = task;
+    workers[iThread]._first = nbItem * iThread / nb;
+    workers[iThread]._end = nbItem * (iThread + 1) / nb;
+    workers[iThread]._arg = arg;
+    workers[iThread]._nbDist = 0;
+    workers[iThread]._flagThread = false;
+  }
+  // Run the workers, the last one in the current thread, and wait for
+  // them to end
+  // If a thread can't be created its worker runs in the current thread
+  for (long iThread = nb - 1; iThread--;) {
+    workers[iThread]._flagThread = (pthread_create(
+      &(workers[iThread]._thread), NULL, IKMCWorkerMain, 
+      workers + iThread) == 0);
+    if (!workers[iThread]._flagThread)
+      task(workers + iThread);
+  }
+  task(workers + nb - 1);
+  long nbDist = 0;
+  for (long iThread = nb; iThread--;) {
+    if (workers[iThread]._flagThread)
+      pthread_join(workers[iThread]._thread, NULL);
+    nbDist += workers[iThread]._nbDist;
   }
+  // Free memory
+  free(workers);
+  // Return the number of distances
+  return nbDist;
 }
 
 // Print the ImgKMeansClusters 'that' on the stream 'stream'
@@ -144,7 +864,7 @@ int IKMCGetId(const ImgKMeansClusters* const that,
   // Get the KMeansClusters input over the cell
   VecFloat* inputOverCell = IKMCGetInputOverCell(that, pos);
   // Get the index of the cluster for this pixel
-  int id = KMeansClustersGetId(IKMCKMeansClusters(that), inputOverCell);
+  int id = IKMCNearestCenter(that, inputOverCell->_val);
   // Free memory
   VecFree(&inputOverCell);
   // Return the id
@@ -168,36 +888,10 @@ GBPixel IKMCGetPixel(const ImgKMeansClusters* const that,
     PBErrCatch(PBImgAnalysisErr);
   }
 #endif  
-  // Declare the result pixel
-  GBPixel pix;
   // Get the id of the cluster for the input pixel
   int id = IKMCGetId(that, pos);
-  // Get the 'id'-th cluster's center
-  const VecFloat* center = 
-    KMeansClustersCenter(IKMCKMeansClusters(that), id);
-  // Declare a variable to calculate the average pixel
-  VecFloat* avgPix = VecFloatCreate(4);
-  // Calculate the average pixel
-  for (int i = 0; i < VecGetDim(center); i += 4) {
-    for (int j = 4; j--;) {
-      VecSet(avgPix, j, VecGet(avgPix, j) + VecGet(center, i + j));
-    }
-  }
-  VecScale(avgPix, 1.0 / round((float)VecGetDim(center) / 4.0));
-  // Update the returned pixel values and ensure the converted value 
-  // from float to char is valid
-  for (int i = 4; i--;) {
-    float v = VecGet(avgPix, i);
-    if (v < 0.0) 
-      v = 0.0;
-    else if (v > 255.0)
-      v = 255.0;
-    pix._rgba[i] = (unsigned char)v;
-  }
-  // Free memory
-  VecFree(&avgPix);
-  // Return the result pixel
-  return pix;
+  // Return the average pixel of this cluster
+  return *IKMCGetPixelCluster(that, id);
 }
 
 // Convert the image of the ImageKMeansClusters 'that' to its clustered
@@ -211,22 +905,100 @@ void IKMCCluster(const ImgKMeansClusters* const that) {
     PBErrCatch(PBImgAnalysisErr);
   }
 #endif
+  // Get the id of the cluster of each pixel
+  unsigned short* labels = IKMCGetLabelMap(that);
   // Get the dimension of the image
   VecShort2D dim = GBGetDim(IKMCImg(that));
   // Loop on pixels
   VecShort2D pos = VecShortCreateStatic2D();
   do {
     // Get the clustered pixel for this pixel
-    GBPixel clustered = IKMCGetPixel(that, &pos);
+    const GBPixel* clustered = IKMCGetPixelCluster(that, 
+      labels[VecGet(&pos, 1) * VecGet(&dim, 0) + VecGet(&pos, 0)]);
     // Replace the original pixel
-    GBSetFinalPixel((GenBrush*)IKMCImg(that), &pos, &clustered);
+    GBSetFinalPixel((GenBrush*)IKMCImg(that), &pos, clustered);
   } while (VecStep(&pos, &dim));
+  // Free memory
+  free(labels);
+}
+
+// Return the map of the cluster's id for each pixel of the image of 
+// the ImgKMeansClusters 'that'
+// The map is an array of width*height values, the id for the pixel at
+// position (x, y) being at index (y * width + x)
+// IKMCSearch must have been called previously 
+// The returned array must be freed by the user
+unsigned short* IKMCGetLabelMap(const ImgKMeansClusters* const that) {
+#if BUILDMODE == 0
+  if (that == NULL) {
+    PBImgAnalysisErr->_type = PBErrTypeNullPointer;
+    sprintf(PBImgAnalysisErr->_msg, "'that' is null");
+    PBErrCatch(PBImgAnalysisErr);
+  }
+  if (IKMCGetK(that) > USHRT_MAX + 1) {
+    PBImgAnalysisErr->_type = PBErrTypeInvalidArg;
+    sprintf(PBImgAnalysisErr->_msg, "'that' has too many clusters "
+      "(%d<=%d)", IKMCGetK(that), USHRT_MAX + 1);
+    PBErrCatch(PBImgAnalysisErr);
+  }
+#endif
+  // Get the dimension of the image
+  VecShort2D dim = GBGetDim(IKMCImg(that));
+  // Allocate memory for the result
+  unsigned short* labels = PBErrMalloc(PBImgAnalysisErr, 
+    sizeof(unsigned short) * VecGet(&dim, 0) * VecGet(&dim, 1));
+  // Compute the ids of the pixels
+  IKMCPixelTask task = {._inputs = NULL, ._vecInputs = NULL, 
+    ._labels = labels};
+  IKMCRunWorkers(that, VecGet(&dim, 1), IKMCPixelTaskRun, &task);
+  // Return the result
+  return labels;
+}
+
+// Set the 4*'cell'->_nbPixel values of 'input' to the input values 
+// for the pixel at position 'pos' over the cell 'cell' of the 
+// ImgKMeansClusters 'that', 'keys' is a buffer of 'cell'->_nbPixel 
+// values
+void IKMCGetInputOverCellInto(const ImgKMeansClusters* const that,
+  const IKMCCell* const cell, const VecShort2D* const pos,
+  uint32_t* const keys, float* const input) {
+  // Get the dimension of the image
+  VecShort2D dim = GBGetDim(IKMCImg(that));
+  // Get the pixel at the center of the cell, will be used as default
+  // if the cell goes over the border of the image
+  const GBPixel* defaultPixel = GBFinalPixel(IKMCImg(that), pos);
+  // Loop over the pixels of the cell and pack them into their sort 
+  // key, the alpha channel being the most significant
+  VecShort2D posImg = VecShortCreateStatic2D();
+  for (int iPix = 0; iPix < cell->_nbPixel; ++iPix) {
+    VecSet(&posImg, 0, VecGet(pos, 0) + cell->_offsets[2 * iPix]);
+    VecSet(&posImg, 1, VecGet(pos, 1) + cell->_offsets[2 * iPix + 1]);
+    const GBPixel* pix = defaultPixel;
+    if (VecGet(&posImg, 0) >= 0 && VecGet(&posImg, 0) < VecGet(&dim, 0) &&
+      VecGet(&posImg, 1) >= 0 && VecGet(&posImg, 1) < VecGet(&dim, 1))
+      pix = GBFinalPixel(IKMCImg(that), &posImg);
+    uint32_t key = 0;
+    for (int iRgba = 4; iRgba--;)
+      key = (key << 8) | pix->_rgba[iRgba];
+    // Insert the key in the sorted keys, from greatest to lowest
+    int iKey = iPix;
+    while (iKey > 0 && keys[iKey - 1] < key) {
+      keys[iKey] = keys[iKey - 1];
+      --iKey;
+    }
+    keys[iKey] = key;
+  }
+  // Unpack the sorted keys into the input values
+  for (int iPix = 0; iPix < cell->_nbPixel; ++iPix)
+    for (int iRgba = 0; iRgba < 4; ++iRgba)
+      input[iPix * 4 + iRgba] = 
+        (float)((keys[iPix] >> (8 * iRgba)) & 0xFF);
 }
 
 // Get the input values for the pixel at position 'pos' according to
 // the cell size of the ImgKMeansClusters 'that'
 // The return is a VecFloat made of the sizeCell^2 pixels' value 
-// around pos ordered by (((r*256+g)*256+b)*256+a) 
+// around pos ordered by (((a*256+b)*256+g)*256+r) descending
 VecFloat* IKMCGetInputOverCell(const ImgKMeansClusters* const that, 
   const VecShort2D* const pos) {
 #if BUILDMODE == 0
@@ -241,50 +1013,16 @@ VecFloat* IKMCGetInputOverCell(const ImgKMeansClusters* const that,
     PBErrCatch(PBImgAnalysisErr);
   }
 #endif
-  // Create two vectors to loop on the cell
-  VecShort2D from = VecShortCreateStatic2D();
-  VecSet(&from, 0, -that->_size);
-  VecSet(&from, 1, -that->_size);
-  VecShort2D to = VecShortCreateStatic2D();
-  VecSet(&to, 0, that->_size + 1);
-  VecSet(&to, 1, that->_size + 1);
-  // Get the pixel at the center of the cell, will be used as default
-  // if the cell goes over the border of the image
-  const GBPixel* defaultPixel = GBFinalPixel(IKMCImg(that), pos);
-  // Declare a set to memorize the pixels in the cell
-  GSet pixels = GSetCreateStatic();
-  // Loop over the pixels of the cell
-  VecShort2D posCell = from;
-  VecShort2D posImg = VecShortCreateStatic2D();
-  do {
-    // If the position in the cell is inside the radius of the cell
-    VecFloat2D posCellFloat = VecShortToFloat2D(&posCell);
-    if ((int)round(VecNorm(&posCellFloat)) <= that->_size) {
-      // Get the position in the image
-      posImg = VecGetOp(pos, 1, &posCell, 1);
-      // Get the pixel at this position
-      const GBPixel* pix = GBFinalPixelSafe(IKMCImg(that), &posImg);
-      if (pix == NULL)
-        pix = defaultPixel;
-      // Get the value to sort this pixel
-      float valPix = 0.0;
-      for (int iRgba = 4; iRgba--;)
-        valPix += 256.0 * valPix + (float)(pix->_rgba[iRgba]);
-      // Add the pixel to the set of pixels in the cell
-      GSetAddSort(&pixels, pix, valPix);
-    }
-  } while (VecShiftStep(&posCell, &from, &to));
+  // Allocate the buffer of keys for the pixels of the cell
+  const IKMCCell* cell = &(that->_cell);
+  uint32_t* keys = PBErrMalloc(PBImgAnalysisErr, 
+    sizeof(uint32_t) * cell->_nbPixel);
   // Declare the result vector
-  VecFloat* res = VecFloatCreate(GSetNbElem(&pixels) * 4);
-  // Loop over the sorted pixels of the cell
-  int iPix = 0;
-  while (GSetNbElem(&pixels)) {
-    const GBPixel* pix = GSetDrop(&pixels);
-    // Set the result value
-    for (int i = 0; i < 4; ++i)
-      VecSet(res, iPix * 4 + i, (float)(pix->_rgba[i]));
-    ++iPix;
-  }
+  VecFloat* res = VecFloatCreate(cell->_nbPixel * 4);
+  // Get the input values
+  IKMCGetInputOverCellInto(that, cell, pos, keys, res->_val);
+  // Free memory
+  free(keys);
   // Return the result
   return res;
 }
@@ -340,16 +1078,43 @@ bool IKMCSave(const ImgKMeansClusters* const that,
     PBErrCatch(PBImgAnalysisErr);
   }
 #endif
-  // Get the JSON encoding
-  JSONNode* json = IKMCEncodeAsJSON(that);
-  // Save the JSON
-  if (!JSONSave(json, stream, compact)) {
-    return false;
-  }
-  // Free memory
-  JSONFree(&json);
+  // Write the JSON encoding in a single pass
+  JSONStreamWriter writer = JSONStreamWriterCreateStatic(stream, compact);
+  IKMCEncodeAsJSONStream(that, &writer);
   // Return success code
-  return true;
+  return JSWIsOk(&writer);
+}
+
+// Write the JSON encoding of 'that' with the JSONStreamWriter 'writer'
+// It's the same encoding as IKMCEncodeAsJSON
+void IKMCEncodeAsJSONStream(const ImgKMeansClusters* const that, 
+  JSONStreamWriter* const writer) {
+#if BUILDMODE == 0
+  if (that == NULL) {
+    PBImgAnalysisErr->_type = PBErrTypeNullPointer;
+    sprintf(PBImgAnalysisErr->_msg, "'that' is null");
+    PBErrCatch(PBImgAnalysisErr);
+  }
+  if (writer == NULL) {
+    PBImgAnalysisErr->_type = PBErrTypeNullPointer;
+    sprintf(PBImgAnalysisErr->_msg, "'writer' is null");
+    PBErrCatch(PBImgAnalysisErr);
+  }
+#endif
+  JSWOpenObject(writer, NULL);
+  // Encode the size
+  JSWAddPropInt(writer, "_size", that->_size);
+  // Encode the KMeansClusters
+  const KMeansClusters* clusters = IKMCKMeansClusters(that);
+  JSWOpenObject(writer, "_clusters");
+  JSWAddPropInt(writer, "_seed", clusters->_seed);
+  JSWOpenArray(writer, "_centers");
+  for (int iCenter = 0; iCenter < KMeansClustersGetK(clusters); 
+    ++iCenter)
+    JSWAddVecFloat(writer, NULL, KMeansClustersCenter(clusters, iCenter));
+  JSWCloseArray(writer);
+  JSWCloseObject(writer);
+  JSWCloseObject(writer);
 }
 
 // Function which return the JSON encoding of 'that' 
@@ -401,12 +1166,15 @@ bool IKMCDecodeAsJSON(ImgKMeansClusters* that,
   if (that->_size < 0) {
     return false;
   }
+  that->_cell = IKMCCellCreateStatic(that->_size);
   // Decode the KMeansClusters
   prop = JSONProperty(json, "_clusters");
   if (!KMeansClustersDecodeAsJSON(
     (KMeansClusters*)IKMCKMeansClusters(that), prop)) {
     return false;
   }
+  // Update the average pixels of the clusters
+  IKMCUpdateClusters(that);
   // Return the success code
   return true;
 }
@@ -474,338 +1242,2682 @@ void ISCTexEncodeAsJSON(const ImgSegmentorCriterionTex* const that,
 // ImgSegmentorCriterionTex 
 bool ISCTexDecodeAsJSON(
   ImgSegmentorCriterionTex** const that, const JSONNode* const json);
+
+// Return a new generation for the criteria of an ImgSegmentor
+unsigned long ISNextGeneration(void);
   
 // ================ Functions implementation ====================
 
-// Create a new static ImgSegmentor with 'nbClass' output
-ImgSegmentor ImgSegmentorCreateStatic(int nbClass) {
+// Create a new ImgSegmentorPlane of dimensions 'dim' with 'nbChannel'
+// values per pixel, all values are initialised to 0.0
+ImgSegmentorPlane* ImgSegmentorPlaneCreate(const VecShort2D* const dim,
+  const int nbChannel) {
 #if BUILDMODE == 0
-  if (nbClass <= 0) {
+  if (dim == NULL) {
+    PBImgAnalysisErr->_type = PBErrTypeNullPointer;
+    sprintf(PBImgAnalysisErr->_msg, "'dim' is null");
+    PBErrCatch(PBImgAnalysisErr);
+  }
+  if (nbChannel <= 0) {
     PBImgAnalysisErr->_type = PBErrTypeInvalidArg;
-    sprintf(PBImgAnalysisErr->_msg, "'nbClass' is invalid (%d>0)",
-      nbClass);
+    sprintf(PBImgAnalysisErr->_msg, "'nbChannel' is invalid (%d>0)",
+      nbChannel);
     PBErrCatch(PBImgAnalysisErr);
   }
 #endif
-  // Declare the new ImgSegmentor
-  ImgSegmentor that;
-  // Init properties
-  that._nbClass = nbClass;
-  that._criteria = GenTreeCreateStatic();
-  that._flagBinaryResult = false;
-  that._thresholdBinaryResult = 0.5;
-  that._nbEpoch = 1;
-  that._sizePool = GENALG_NBENTITIES;
-  that._sizeMinPool = that._sizePool;
-  that._sizeMaxPool = that._sizePool;
-  that._nbElite = GENALG_NBELITES;
-  that._targetBestValue = 0.9999;
-  that._flagTextOMeter = false;
-  that._textOMeter = NULL;
-  sprintf(that._line1, IS_TRAINTXTOMETER_LINE1);
-  sprintf(that._line3, IS_TRAINTXTOMETER_LINE2);
-  sprintf(that._line2, IS_EVALTXTOMETER_LINE1);
-  that._flagTraining = false;
-  that._reusedInput = GSetVecFloatCreateStatic();
-  that._emailNotification = NULL;
-  that._emailSubject = NULL;
-  // Return the new ImgSegmentor
+  // Allocate memory for the new ImgSegmentorPlane
+  ImgSegmentorPlane* that = PBErrMalloc(PBImgAnalysisErr,
+    sizeof(ImgSegmentorPlane));
+  // Set the properties
+  that->_dim = *dim;
+  that->_nbChannel = nbChannel;
+  // Allocate the values, the size must be a multiple of the alignment
+  size_t size = sizeof(float) * (size_t)ISPGetArea(that) * 
+    (size_t)nbChannel;
+  size = ((size + IS_PLANEALIGN - 1) / IS_PLANEALIGN) * IS_PLANEALIGN;
+  if (size == 0)
+    size = IS_PLANEALIGN;
+  that->_val = aligned_alloc(IS_PLANEALIGN, size);
+  if (that->_val == NULL) {
+    PBImgAnalysisErr->_type = PBErrTypeMallocFailed;
+    sprintf(PBImgAnalysisErr->_msg, "aligned_alloc failed (%zu)", size);
+    PBErrCatch(PBImgAnalysisErr);
+  }
+  memset(that->_val, 0, size);
+  // Return the new ImgSegmentorPlane
   return that;
 }
 
-// Create a new ImgSegmentor with 'nbClass' output
-ImgSegmentor* ImgSegmentorCreate(int nbClass) {
+// Create a new ImgSegmentorPlane from the final pixels of the GenBrush
+// 'img', with 3 values per pixel (r, g, b) in [0.0, 1.0]
+ImgSegmentorPlane* ImgSegmentorPlaneCreateFromGenBrush(
+  const GenBrush* const img) {
 #if BUILDMODE == 0
-  if (nbClass <= 0) {
-    PBImgAnalysisErr->_type = PBErrTypeInvalidArg;
-    sprintf(PBImgAnalysisErr->_msg, "'nbClass' is invalid (%d>0)",
-      nbClass);
+  if (img == NULL) {
+    PBImgAnalysisErr->_type = PBErrTypeNullPointer;
+    sprintf(PBImgAnalysisErr->_msg, "'img' is null");
     PBErrCatch(PBImgAnalysisErr);
   }
 #endif
-  // Declare the new ImgSegmentor
-  ImgSegmentor* that = PBErrMalloc(PBImgAnalysisErr, 
-    sizeof(ImgSegmentor));
-  // Init properties
-  *that = ImgSegmentorCreateStatic(nbClass);
-  // Return the new ImgSegmentor
+  // Create the plane
+  VecShort2D dim = GBGetDim(img);
+  ImgSegmentorPlane* that = ImgSegmentorPlaneCreate(&dim, 3);
+  // Convert the final pixels in one pass, they are stored in the 
+  // same row-major order as the values of the plane
+  const GBPixel* pixels = GBSurfaceFinalPixels(GBSurf(img));
+  float* val = ISPVal(that);
+  const float scale = 1.0 / 255.0;
+  for (long iPos = ISPGetArea(that); iPos--;) {
+    const unsigned char* rgba = pixels[iPos]._rgba;
+    float* v = val + iPos * 3L;
+    v[0] = (float)(rgba[0]) * scale;
+    v[1] = (float)(rgba[1]) * scale;
+    v[2] = (float)(rgba[2]) * scale;
+  }
+  // Return the new ImgSegmentorPlane
   return that;
 }
 
-// Free the memory used by the static ImgSegmentor 'that'
-void ImgSegmentorFreeStatic(ImgSegmentor* that) {
-  if (that == NULL)
+// Return a clone of the ImgSegmentorPlane 'that'
+ImgSegmentorPlane* ImgSegmentorPlaneClone(
+  const ImgSegmentorPlane* const that) {
+#if BUILDMODE == 0
+  if (that == NULL) {
+    PBImgAnalysisErr->_type = PBErrTypeNullPointer;
+    sprintf(PBImgAnalysisErr->_msg, "'that' is null");
+    PBErrCatch(PBImgAnalysisErr);
+  }
+#endif
+  ImgSegmentorPlane* clone = 
+    ImgSegmentorPlaneCreate(ISPDim(that), ISPGetNbChannel(that));
+  memcpy(ISPVal(clone), ISPVal(that), 
+    sizeof(float) * ISPGetArea(that) * ISPGetNbChannel(that));
+  return clone;
+}
+
+// Free the memory used by the ImgSegmentorPlane 'that'
+void ImgSegmentorPlaneFree(ImgSegmentorPlane** that) {
+  if (that == NULL || *that == NULL)
     return;
-  if (that->_textOMeter != NULL)
-    TextOMeterFree(&(that->_textOMeter));
-  if (that->_emailNotification != NULL)
-    free(that->_emailNotification);
-  if (that->_emailSubject != NULL)
-    free(that->_emailSubject);
-  if (!GenTreeIsLeaf(ISCriteria(that))) {
+  free((*that)->_val);
+  free(*that);
+  *that = NULL;
+}
+
+// Release the ImgSegmentorPlane 'that': free it if it is owned, i.e. 
+// it is not 'borrowed', else only forget it
+void ImgSegmentorPlaneRelease(ImgSegmentorPlane** that, 
+  const ImgSegmentorPlane* const borrowed) {
+  if (that == NULL || *that == NULL)
+    return;
+  if (*that != borrowed)
+    ImgSegmentorPlaneFree(that);
+  *that = NULL;
+}
+
+// Create a new ImgBitMask of dimensions 'dim' with all bits set to 0
+ImgBitMask* ImgBitMaskCreate(const VecShort2D* const dim) {
+#if BUILDMODE == 0
+  if (dim == NULL) {
+    PBImgAnalysisErr->_type = PBErrTypeNullPointer;
+    sprintf(PBImgAnalysisErr->_msg, "'dim' is null");
+    PBErrCatch(PBImgAnalysisErr);
+  }
+#endif
+  // Allocate memory for the new ImgBitMask
+  ImgBitMask* that = PBErrMalloc(PBImgAnalysisErr, sizeof(ImgBitMask));
+  // Set the properties
+  that->_dim = *dim;
+  that->_nbWordPerRow = 
+    (VecGet(dim, 0) + IBM_WORDSIZE - 1) / IBM_WORDSIZE;
+  // Allocate the words, all set to 0
+  long nbWord = that->_nbWordPerRow * VecGet(dim, 1);
+  that->_words = PBErrMalloc(PBImgAnalysisErr, 
+    sizeof(uint64_t) * (nbWord > 0 ? nbWord : 1));
+  memset(that->_words, 0, sizeof(uint64_t) * (nbWord > 0 ? nbWord : 1));
+  // Return the new ImgBitMask
+  return that;
+}
+
+// Create a new ImgBitMask from the final pixels of the GenBrush 'img'
+// The bits are set to 1 for the pixels of color 'rgba', 0 else
+ImgBitMask* ImgBitMaskCreateFromGenBrush(const GenBrush* const img, 
+  const GBPixel* const rgba) {
+#if BUILDMODE == 0
+  if (img == NULL) {
+    PBImgAnalysisErr->_type = PBErrTypeNullPointer;
+    sprintf(PBImgAnalysisErr->_msg, "'img' is null");
+    PBErrCatch(PBImgAnalysisErr);
+  }
+  if (rgba == NULL) {
+    PBImgAnalysisErr->_type = PBErrTypeNullPointer;
+    sprintf(PBImgAnalysisErr->_msg, "'rgba' is null");
+    PBErrCatch(PBImgAnalysisErr);
+  }
+#endif
+  // Create the ImgBitMask
+  VecShort2D dim = GBGetDim(img);
+  ImgBitMask* that = ImgBitMaskCreate(&dim);
+  // Pack the final pixels into bits, one word at a time
+  const GBPixel* pixels = GBSurfaceFinalPixels(GBSurf(img));
+  long width = VecGet(&dim, 0);
+  for (long y = VecGet(&dim, 1); y--;) {
+    const GBPixel* row = pixels + y * width;
+    uint64_t* words = that->_words + y * that->_nbWordPerRow;
+    for (long x = 0; x < width; ++x)
+      if (GBPixelIsSame(row + x, rgba))
+        words[x / IBM_WORDSIZE] |= (uint64_t)1 << (x % IBM_WORDSIZE);
+  }
+  // Return the new ImgBitMask
+  return that;
+}
+
+// Free the memory used by the ImgBitMask 'that'
+void ImgBitMaskFree(ImgBitMask** that) {
+  if (that == NULL || *that == NULL)
+    return;
+  free((*that)->_words);
+  free(*that);
+  *that = NULL;
+}
+
+// Return the number of bits set to 1 in the ImgBitMask 'that'
+long IBMGetNbSet(const ImgBitMask* const that) {
+#if BUILDMODE == 0
+  if (that == NULL) {
+    PBImgAnalysisErr->_type = PBErrTypeNullPointer;
+    sprintf(PBImgAnalysisErr->_msg, "'that' is null");
+    PBErrCatch(PBImgAnalysisErr);
+  }
+#endif
+  long nb = 0;
+  for (long iWord = that->_nbWordPerRow * VecGet(IBMDim(that), 1); 
+    iWord--;)
+    nb += __builtin_popcountll(that->_words[iWord]);
+  return nb;
+}
+
+// Set to 0 all the bits of the ImgBitMask 'that'
+void IBMReset(ImgBitMask* const that) {
+#if BUILDMODE == 0
+  if (that == NULL) {
+    PBImgAnalysisErr->_type = PBErrTypeNullPointer;
+    sprintf(PBImgAnalysisErr->_msg, "'that' is null");
+    PBErrCatch(PBImgAnalysisErr);
+  }
+#endif
+  long nbWord = that->_nbWordPerRow * VecGet(IBMDim(that), 1);
+  memset(that->_words, 0, sizeof(uint64_t) * (nbWord > 0 ? nbWord : 1));
+}
+
+// Free the memory used by the checkpoint 'that', without deleting its 
+// file
+void ISCheckpointFree(ISCheckpoint** that) {
+  if (that == NULL || *that == NULL)
+    return;
+  free((*that)->_path);
+  free((*that)->_data);
+  free(*that);
+  *that = NULL;
+}
+
+// Write the checkpoint 'that' in a temporary file renamed to its path
+// once complete, so a checkpoint file is never partially written
+// Return true upon success else false
+bool ISCheckpointWrite(const ISCheckpoint* const that) {
+  size_t len = strlen(that->_path) + 5;
+  char* tmpPath = PBErrMalloc(PBImgAnalysisErr, len);
+  snprintf(tmpPath, len, "%s.tmp", that->_path);
+  bool ret = false;
+  FILE* fp = fopen(tmpPath, "w");
+  if (fp != NULL) {
+    ret = (fwrite(that->_data, 1, that->_size, fp) == that->_size);
+    ret = (fclose(fp) == 0 && ret);
+    if (ret)
+      ret = (rename(tmpPath, that->_path) == 0);
+    if (!ret)
+      remove(tmpPath);
+  }
+  free(tmpPath);
+  return ret;
+}
+
+// Delete the checkpoints of the ISCheckpointWriter 'that' which are 
+// neither among the _keepBest best ones nor the _keepLast last ones
+// The mutex of 'that' must be locked
+void ISCWApplyRetention(ISCheckpointWriter* const that) {
+  if (that->_keepBest == 0 && that->_keepLast == 0)
+    return;
+  long nb = GSetNbElem(&(that->_written));
+  ISCheckpoint** cps = PBErrMalloc(PBImgAnalysisErr, 
+    sizeof(ISCheckpoint*) * nb);
+  for (long i = 0; i < nb; ++i)
+    cps[i] = GSetPop(&(that->_written));
+  for (long i = 0; i < nb; ++i) {
+    // Keep the last checkpoints
+    bool keep = (i >= nb - that->_keepLast);
+    // Keep the best checkpoints, the most recent first for equal 
+    // values
+    if (!keep) {
+      long rank = 0;
+      for (long j = 0; j < nb; ++j)
+        if (cps[j]->_value > cps[i]->_value || 
+          (cps[j]->_value == cps[i]->_value && j > i))
+          ++rank;
+      keep = (rank < that->_keepBest);
+    }
+    if (keep) {
+      GSetAppend(&(that->_written), cps[i]);
+    } else {
+      remove(cps[i]->_path);
+      ISCheckpointFree(cps + i);
+    }
+  }
+  free(cps);
+}
+
+// Main function of the thread of the ISCheckpointWriter 'arg'
+// Write the checkpoints in the order of addition until it is stopped
+// and the queue is empty
+void* ISCWMain(void* arg) {
+  ISCheckpointWriter* that = arg;
+  pthread_mutex_lock(&(that->_mutex));
+  while (true) {
+    while (GSetNbElem(&(that->_queue)) == 0 && !(that->_flagStop))
+      pthread_cond_wait(&(that->_cond), &(that->_mutex));
+    if (GSetNbElem(&(that->_queue)) == 0)
+      break;
+    ISCheckpoint* cp = GSetPop(&(that->_queue));
+    // Write the checkpoint without blocking the training
+    pthread_mutex_unlock(&(that->_mutex));
+    bool ret = ISCheckpointWrite(cp);
+    if (!ret)
+      fprintf(stderr, "Couldn't save the checkpoint %s\n", cp->_path);
+    free(cp->_data);
+    cp->_data = NULL;
+    pthread_mutex_lock(&(that->_mutex));
+    if (ret) {
+      GSetAppend(&(that->_written), cp);
+      ISCWApplyRetention(that);
+    } else {
+      ISCheckpointFree(&cp);
+    }
+  }
+  pthread_mutex_unlock(&(that->_mutex));
+  return NULL;
+}
+
+// Create a new ISCheckpointWriter keeping on disk the 'keepBest' best
+// and the 'keepLast' last checkpoints, 0 for both keeps all of them,
+// and start its thread
+ISCheckpointWriter* ISCheckpointWriterCreate(const int keepBest, 
+  const int keepLast) {
+#if BUILDMODE == 0
+  if (keepBest < 0) {
+    PBImgAnalysisErr->_type = PBErrTypeInvalidArg;
+    sprintf(PBImgAnalysisErr->_msg, "'keepBest' is invalid (%d>=0)", keepBest);
+    PBErrCatch(PBImgAnalysisErr);
+  }
+  if (keepLast < 0) {
+    PBImgAnalysisErr->_type = PBErrTypeInvalidArg;
+    sprintf(PBImgAnalysisErr->_msg, "'keepLast' is invalid (%d>=0)", keepLast);
+    PBErrCatch(PBImgAnalysisErr);
+  }
+#endif
+  // Allocate memory for the new ISCheckpointWriter
+  ISCheckpointWriter* that = PBErrMalloc(PBImgAnalysisErr, 
+    sizeof(ISCheckpointWriter));
+  // Set the properties
+  that->_queue = GSetCreateStatic();
+  that->_written = GSetCreateStatic();
+  that->_keepBest = keepBest;
+  that->_keepLast = keepLast;
+  that->_flagStop = false;
+  pthread_mutex_init(&(that->_mutex), NULL);
+  pthread_cond_init(&(that->_cond), NULL);
+  // Start the thread, if it can't be created the checkpoints are 
+  // written synchronously
+  that->_flagThread = 
+    (pthread_create(&(that->_thread), NULL, ISCWMain, that) == 0);
+  if (!(that->_flagThread))
+    fprintf(stderr, "Couldn't start the thread of the checkpoint "
+      "writer, checkpoints will be written synchronously\n");
+  // Return the new ISCheckpointWriter
+  return that;
+}
+
+// Write the remaining checkpoints of the ISCheckpointWriter 'that', 
+// stop its thread and free its memory
+void ISCheckpointWriterFree(ISCheckpointWriter** that) {
+  if (that == NULL || *that == NULL)
+    return;
+  // Stop the thread once the queue is empty
+  pthread_mutex_lock(&((*that)->_mutex));
+  (*that)->_flagStop = true;
+  pthread_cond_signal(&((*that)->_cond));
+  pthread_mutex_unlock(&((*that)->_mutex));
+  if ((*that)->_flagThread)
+    pthread_join((*that)->_thread, NULL);
+  // Free memory, the written checkpoints stay on disk
+  while (GSetNbElem(&((*that)->_written)) > 0) {
+    ISCheckpoint* cp = GSetPop(&((*that)->_written));
+    ISCheckpointFree(&cp);
+  }
+  pthread_mutex_destroy(&((*that)->_mutex));
+  pthread_cond_destroy(&((*that)->_cond));
+  free(*that);
+  *that = NULL;
+}
+
+// Add to the ISCheckpointWriter 'that' the checkpoint of value 'value'
+// made of the 'size' bytes of 'data' to be written in the file 'path'
+// 'data' is then owned by 'that'
+void ISCWAdd(ISCheckpointWriter* const that, const char* const path,
+  const float value, char* const data, const size_t size) {
+#if BUILDMODE == 0
+  if (that == NULL) {
+    PBImgAnalysisErr->_type = PBErrTypeNullPointer;
+    sprintf(PBImgAnalysisErr->_msg, "'that' is null");
+    PBErrCatch(PBImgAnalysisErr);
+  }
+  if (path == NULL) {
+    PBImgAnalysisErr->_type = PBErrTypeNullPointer;
+    sprintf(PBImgAnalysisErr->_msg, "'path' is null");
+    PBErrCatch(PBImgAnalysisErr);
+  }
+  if (data == NULL) {
+    PBImgAnalysisErr->_type = PBErrTypeNullPointer;
+    sprintf(PBImgAnalysisErr->_msg, "'data' is null");
+    PBErrCatch(PBImgAnalysisErr);
+  }
+#endif
+  ISCheckpoint* cp = PBErrMalloc(PBImgAnalysisErr, sizeof(ISCheckpoint));
+  cp->_path = strdup(path);
+  cp->_value = value;
+  cp->_data = data;
+  cp->_size = size;
+  pthread_mutex_lock(&(that->_mutex));
+  GSetAppend(&(that->_queue), cp);
+  pthread_cond_signal(&(that->_cond));
+  // Without thread, write the queue now
+  if (!(that->_flagThread))
+    that->_flagStop = true;
+  pthread_mutex_unlock(&(that->_mutex));
+  if (!(that->_flagThread))
+    ISCWMain(that);
+}
+
+// Create a new ImgSegmentorReuseCache with a memory budget of 
+// 'budget' bytes, 0 for no limit
+ImgSegmentorReuseCache* ImgSegmentorReuseCacheCreate(
+  const size_t budget) {
+  // Allocate memory for the new ImgSegmentorReuseCache
+  ImgSegmentorReuseCache* that = PBErrMalloc(PBImgAnalysisErr, 
+    sizeof(ImgSegmentorReuseCache));
+  // Set the properties
+  that->_budget = budget;
+  that->_stats._nbHit = 0;
+  that->_stats._nbMiss = 0;
+  that->_stats._nbEviction = 0;
+  that->_stats._size = 0;
+  that->_mostRecent = NULL;
+  that->_leastRecent = NULL;
+  that->_flagReadOnly = false;
+  pthread_mutex_init(&(that->_mutex), NULL);
+  // Return the new ImgSegmentorReuseCache
+  return that;
+}
+
+// Free the memory used by the ImgSegmentorReuseCache 'that'
+// The entries must have been freed before with ISRCEntryFree
+void ImgSegmentorReuseCacheFree(ImgSegmentorReuseCache** that) {
+  if (that == NULL || *that == NULL)
+    return;
+  pthread_mutex_destroy(&((*that)->_mutex));
+  free(*that);
+  *that = NULL;
+}
+
+// Remove the entry 'entry' from the list of use of the 
+// ImgSegmentorReuseCache 'that'
+void ISRCUnlinkUse(ImgSegmentorReuseCache* const that, 
+  ImgSegmentorReuseEntry* const entry) {
+  if (entry->_prevUse != NULL)
+    entry->_prevUse->_nextUse = entry->_nextUse;
+  else
+    that->_mostRecent = entry->_nextUse;
+  if (entry->_nextUse != NULL)
+    entry->_nextUse->_prevUse = entry->_prevUse;
+  else
+    that->_leastRecent = entry->_prevUse;
+  entry->_prevUse = NULL;
+  entry->_nextUse = NULL;
+}
+
+// Insert the entry 'entry' at the head of the list of use of the 
+// ImgSegmentorReuseCache 'that'
+void ISRCLinkUse(ImgSegmentorReuseCache* const that, 
+  ImgSegmentorReuseEntry* const entry) {
+  entry->_prevUse = NULL;
+  entry->_nextUse = that->_mostRecent;
+  if (that->_mostRecent != NULL)
+    that->_mostRecent->_prevUse = entry;
+  that->_mostRecent = entry;
+  if (that->_leastRecent == NULL)
+    that->_leastRecent = entry;
+}
+
+// Free the data of the entry 'entry' according to its type
+void ISRCEntryFreeData(ImgSegmentorReuseEntry* const entry) {
+  switch (entry->_type) {
+    case ISReuseType_Plane:
+      ImgSegmentorPlaneFree((ImgSegmentorPlane**)&(entry->_data));
+      break;
+    case ISReuseType_Tex:
+      ImgSegmentorCriterionTexReuseFree(
+        (ImgSegmentorCriterionTexReuse**)&(entry->_data));
+      break;
+    default:
+      PBImgAnalysisErr->_type = PBErrTypeNotYetImplemented;
+      sprintf(PBImgAnalysisErr->_msg, 
+        "Not yet implemented type of reused data");
+      PBErrCatch(PBImgAnalysisErr);
+      break;
+  }
+  entry->_data = NULL;
+}
+
+// Return the entry for the sample 'iSample' in the GSet of 
+// ImgSegmentorReuseEntry 'set' managed by the ImgSegmentorReuseCache
+// 'that', which may be NULL
+// The missing entries are created, unless 'that' is read only in 
+// which case NULL is returned
+ImgSegmentorReuseEntry* ISRCGetEntry(ImgSegmentorReuseCache* const that,
+  GSet* const set, const long iSample) {
+#if BUILDMODE == 0
+  if (set == NULL) {
+    PBImgAnalysisErr->_type = PBErrTypeNullPointer;
+    sprintf(PBImgAnalysisErr->_msg, "'set' is null");
+    PBErrCatch(PBImgAnalysisErr);
+  }
+  if (iSample < 0) {
+    PBImgAnalysisErr->_type = PBErrTypeInvalidArg;
+    sprintf(PBImgAnalysisErr->_msg, "'iSample' is invalid (%ld>=0)",
+      iSample);
+    PBErrCatch(PBImgAnalysisErr);
+  }
+#endif
+  if (iSample >= GSetNbElem(set)) {
+    // The GSets of the reused data are shared by the threads during 
+    // the parallel evaluation and can't be modified
+    if (that != NULL && that->_flagReadOnly)
+      return NULL;
+    while (iSample >= GSetNbElem(set)) {
+      ImgSegmentorReuseEntry* entry = PBErrMalloc(PBImgAnalysisErr, 
+        sizeof(ImgSegmentorReuseEntry));
+      entry->_data = NULL;
+      entry->_type = ISReuseType_Plane;
+      entry->_size = 0;
+      entry->_nbPin = 0;
+      entry->_prevUse = NULL;
+      entry->_nextUse = NULL;
+      GSetAppend(set, entry);
+    }
+  }
+  return GSetGet(set, iSample);
+}
+
+// Return the data of the entry 'entry' of the ImgSegmentorReuseCache 
+// 'that', which may be NULL, or NULL if the data is not resident
+// Update the statistics and the order of use
+void* ISRCGetData(ImgSegmentorReuseCache* const that, 
+  ImgSegmentorReuseEntry* const entry) {
+#if BUILDMODE == 0
+  if (entry == NULL) {
+    PBImgAnalysisErr->_type = PBErrTypeNullPointer;
+    sprintf(PBImgAnalysisErr->_msg, "'entry' is null");
+    PBErrCatch(PBImgAnalysisErr);
+  }
+#endif
+  if (that == NULL)
+    return entry->_data;
+  pthread_mutex_lock(&(that->_mutex));
+  void* data = entry->_data;
+  if (data != NULL) {
+    ++(that->_stats._nbHit);
+    ISRCUnlinkUse(that, entry);
+    ISRCLinkUse(that, entry);
+  } else {
+    ++(that->_stats._nbMiss);
+  }
+  pthread_mutex_unlock(&(that->_mutex));
+  return data;
+}
+
+// Give the data 'data' of type 'type' using 'size' bytes to the 
+// entry 'entry' of the ImgSegmentorReuseCache 'that', which may be 
+// NULL. The least recently used and not pinned data are evicted to 
+// respect the budget
+// Return true if the data has been added, else false and the data 
+// is still owned by the caller
+bool ISRCAdd(ImgSegmentorReuseCache* const that, 
+  ImgSegmentorReuseEntry* const entry, void* const data, 
+  const ISReuseType type, const size_t size) {
+#if BUILDMODE == 0
+  if (entry == NULL) {
+    PBImgAnalysisErr->_type = PBErrTypeNullPointer;
+    sprintf(PBImgAnalysisErr->_msg, "'entry' is null");
+    PBErrCatch(PBImgAnalysisErr);
+  }
+  if (data == NULL) {
+    PBImgAnalysisErr->_type = PBErrTypeNullPointer;
+    sprintf(PBImgAnalysisErr->_msg, "'data' is null");
+    PBErrCatch(PBImgAnalysisErr);
+  }
+  if (entry->_data != NULL) {
+    PBImgAnalysisErr->_type = PBErrTypeInvalidArg;
+    sprintf(PBImgAnalysisErr->_msg, "'entry' already has data");
+    PBErrCatch(PBImgAnalysisErr);
+  }
+#endif
+  entry->_type = type;
+  entry->_size = size;
+  if (that == NULL) {
+    entry->_data = data;
+    return true;
+  }
+  pthread_mutex_lock(&(that->_mutex));
+  if (that->_flagReadOnly || 
+    (that->_budget > 0 && size > that->_budget)) {
+    pthread_mutex_unlock(&(that->_mutex));
+    return false;
+  }
+  // Evict the least recently used data which are not pinned until the
+  // new data fits in the budget
+  ImgSegmentorReuseEntry* lru = that->_leastRecent;
+  while (that->_budget > 0 && that->_stats._size + size > that->_budget &&
+    lru != NULL) {
+    ImgSegmentorReuseEntry* prev = lru->_prevUse;
+    if (lru->_nbPin == 0) {
+      ISRCUnlinkUse(that, lru);
+      that->_stats._size -= lru->_size;
+      ++(that->_stats._nbEviction);
+      ISRCEntryFreeData(lru);
+    }
+    lru = prev;
+  }
+  // If the data still doesn't fit, give up
+  if (that->_budget > 0 && that->_stats._size + size > that->_budget) {
+    pthread_mutex_unlock(&(that->_mutex));
+    return false;
+  }
+  // Add the data
+  entry->_data = data;
+  ISRCLinkUse(that, entry);
+  that->_stats._size += size;
+  pthread_mutex_unlock(&(that->_mutex));
+  return true;
+}
+
+// Pin the entry 'entry' of the ImgSegmentorReuseCache 'that' to 
+// prevent the eviction of its data while it is used
+void ISRCPin(ImgSegmentorReuseCache* const that, 
+  ImgSegmentorReuseEntry* const entry) {
+  if (that == NULL || entry == NULL)
+    return;
+  pthread_mutex_lock(&(that->_mutex));
+  ++(entry->_nbPin);
+  pthread_mutex_unlock(&(that->_mutex));
+}
+
+// Unpin the entry 'entry' of the ImgSegmentorReuseCache 'that'
+void ISRCUnpin(ImgSegmentorReuseCache* const that, 
+  ImgSegmentorReuseEntry* const entry) {
+  if (that == NULL || entry == NULL)
+    return;
+  pthread_mutex_lock(&(that->_mutex));
+  --(entry->_nbPin);
+  pthread_mutex_unlock(&(that->_mutex));
+}
+
+// Update to 'size' bytes the memory used by the data of the entry 
+// 'entry' of the ImgSegmentorReuseCache 'that', which may be NULL, 
+// after the data has shrunk
+void ISRCSetSize(ImgSegmentorReuseCache* const that, 
+  ImgSegmentorReuseEntry* const entry, const size_t size) {
+#if BUILDMODE == 0
+  if (entry == NULL) {
+    PBImgAnalysisErr->_type = PBErrTypeNullPointer;
+    sprintf(PBImgAnalysisErr->_msg, "'entry' is null");
+    PBErrCatch(PBImgAnalysisErr);
+  }
+  if (size > entry->_size) {
+    PBImgAnalysisErr->_type = PBErrTypeInvalidArg;
+    sprintf(PBImgAnalysisErr->_msg, "'size' is invalid (%zu<=%zu)",
+      size, entry->_size);
+    PBErrCatch(PBImgAnalysisErr);
+  }
+#endif
+  if (that == NULL) {
+    entry->_size = size;
+    return;
+  }
+  pthread_mutex_lock(&(that->_mutex));
+  if (entry->_data != NULL)
+    that->_stats._size -= entry->_size - size;
+  entry->_size = size;
+  pthread_mutex_unlock(&(that->_mutex));
+}
+
+// Free the entry 'entry' and its data, managed by the 
+// ImgSegmentorReuseCache 'that', which may be NULL
+void ISRCEntryFree(ImgSegmentorReuseCache* const that, 
+  ImgSegmentorReuseEntry** const entry) {
+  if (entry == NULL || *entry == NULL)
+    return;
+  if ((*entry)->_data != NULL) {
+    if (that != NULL) {
+      pthread_mutex_lock(&(that->_mutex));
+      ISRCUnlinkUse(that, *entry);
+      that->_stats._size -= (*entry)->_size;
+      pthread_mutex_unlock(&(that->_mutex));
+    }
+    ISRCEntryFreeData(*entry);
+  }
+  free(*entry);
+  *entry = NULL;
+}
+
+// Set the flag forbidding the addition of data to the 
+// ImgSegmentorReuseCache 'that' to 'flag'
+void ISRCSetReadOnly(ImgSegmentorReuseCache* const that, 
+  const bool flag) {
+#if BUILDMODE == 0
+  if (that == NULL) {
+    PBImgAnalysisErr->_type = PBErrTypeNullPointer;
+    sprintf(PBImgAnalysisErr->_msg, "'that' is null");
+    PBErrCatch(PBImgAnalysisErr);
+  }
+#endif
+  pthread_mutex_lock(&(that->_mutex));
+  that->_flagReadOnly = flag;
+  pthread_mutex_unlock(&(that->_mutex));
+}
+
+// Return the flag forbidding the addition of data to the 
+// ImgSegmentorReuseCache 'that', which may be NULL
+bool ISRCIsReadOnly(ImgSegmentorReuseCache* const that) {
+  if (that == NULL)
+    return false;
+  pthread_mutex_lock(&(that->_mutex));
+  bool flag = that->_flagReadOnly;
+  pthread_mutex_unlock(&(that->_mutex));
+  return flag;
+}
+
+// Return the statistics of the ImgSegmentorReuseCache 'that'
+ImgSegmentorReuseStats ISRCGetStats(ImgSegmentorReuseCache* const that) {
+#if BUILDMODE == 0
+  if (that == NULL) {
+    PBImgAnalysisErr->_type = PBErrTypeNullPointer;
+    sprintf(PBImgAnalysisErr->_msg, "'that' is null");
+    PBErrCatch(PBImgAnalysisErr);
+  }
+#endif
+  pthread_mutex_lock(&(that->_mutex));
+  ImgSegmentorReuseStats stats = that->_stats;
+  pthread_mutex_unlock(&(that->_mutex));
+  return stats;
+}
+
+// Create a new ImgSegmentorPredCache with a memory budget of 'budget'
+// bytes
+ImgSegmentorPredCache* ImgSegmentorPredCacheCreate(const size_t budget) {
+  // Allocate memory for the new ImgSegmentorPredCache
+  ImgSegmentorPredCache* that = PBErrMalloc(PBImgAnalysisErr, 
+    sizeof(ImgSegmentorPredCache));
+  // Set the properties
+  that->_budget = budget;
+  that->_size = 0;
+  that->_buckets = PBErrMalloc(PBImgAnalysisErr, 
+    sizeof(ImgSegmentorPredCacheEntry*) * IS_PREDCACHENBBUCKET);
+  memset(that->_buckets, 0, 
+    sizeof(ImgSegmentorPredCacheEntry*) * IS_PREDCACHENBBUCKET);
+  that->_mostRecent = NULL;
+  that->_leastRecent = NULL;
+  pthread_mutex_init(&(that->_mutex), NULL);
+  // Return the new ImgSegmentorPredCache
+  return that;
+}
+
+// Free the memory used by the ImgSegmentorPredCache 'that'
+void ImgSegmentorPredCacheFree(ImgSegmentorPredCache** that) {
+  if (that == NULL || *that == NULL)
+    return;
+  ImgSegmentorPredCacheEntry* entry = (*that)->_mostRecent;
+  while (entry != NULL) {
+    ImgSegmentorPredCacheEntry* next = entry->_nextUse;
+    ImgSegmentorPlaneFree(&(entry->_pred));
+    // The parameters of the key are in the same allocation
+    free(entry);
+    entry = next;
+  }
+  free((*that)->_buckets);
+  pthread_mutex_destroy(&((*that)->_mutex));
+  free(*that);
+  *that = NULL;
+}
+
+// Return the index of the bucket of the entry with key 'key'
+long ISPCGetIBucket(const ImgSegmentorPredCacheKey* const key) {
+  uint64_t hash = key->_paramHash ^ 
+    ((uint64_t)(key->_iSample) * 0x9E3779B97F4A7C15ULL) ^ 
+    (uint64_t)(key->_iCrit);
+  return (long)((hash ^ (hash >> 32)) % IS_PREDCACHENBBUCKET);
+}
+
+// Return true if the keys 'a' and 'b' are equal, else false
+bool ISPCKeyIsEqual(const ImgSegmentorPredCacheKey* const a, 
+  const ImgSegmentorPredCacheKey* const b) {
+  return a->_paramHash == b->_paramHash && a->_iCrit == b->_iCrit && 
+    a->_iSample == b->_iSample && 
+    VecGet(&(a->_dim), 0) == VecGet(&(b->_dim), 0) &&
+    VecGet(&(a->_dim), 1) == VecGet(&(b->_dim), 1) &&
+    a->_sizeParams == b->_sizeParams && (a->_sizeParams == 0 || 
+    memcmp(a->_params, b->_params, a->_sizeParams) == 0);
+}
+
+// Remove the entry 'entry' from the list of use of the 
+// ImgSegmentorPredCache 'that'
+void ISPCUnlinkUse(ImgSegmentorPredCache* const that, 
+  ImgSegmentorPredCacheEntry* const entry) {
+  if (entry->_prevUse != NULL)
+    entry->_prevUse->_nextUse = entry->_nextUse;
+  else
+    that->_mostRecent = entry->_nextUse;
+  if (entry->_nextUse != NULL)
+    entry->_nextUse->_prevUse = entry->_prevUse;
+  else
+    that->_leastRecent = entry->_prevUse;
+  entry->_prevUse = NULL;
+  entry->_nextUse = NULL;
+}
+
+// Insert the entry 'entry' at the head of the list of use of the 
+// ImgSegmentorPredCache 'that'
+void ISPCLinkUse(ImgSegmentorPredCache* const that, 
+  ImgSegmentorPredCacheEntry* const entry) {
+  entry->_prevUse = NULL;
+  entry->_nextUse = that->_mostRecent;
+  if (that->_mostRecent != NULL)
+    that->_mostRecent->_prevUse = entry;
+  that->_mostRecent = entry;
+  if (that->_leastRecent == NULL)
+    that->_leastRecent = entry;
+}
+
+// Return the entry of the ImgSegmentorPredCache 'that' for the key 
+// 'key', or NULL if there is no such entry
+// The mutex of 'that' must be locked
+ImgSegmentorPredCacheEntry* ISPCFind(
+  const ImgSegmentorPredCache* const that, 
+  const ImgSegmentorPredCacheKey* const key) {
+  ImgSegmentorPredCacheEntry* entry = 
+    that->_buckets[ISPCGetIBucket(key)];
+  while (entry != NULL && !ISPCKeyIsEqual(&(entry->_key), key))
+    entry = entry->_nextInBucket;
+  return entry;
+}
+
+// Return the entry of the ImgSegmentorPredCache 'that' for the key 
+// 'key', or NULL if it is not in the cache
+// The whole key is compared, not only the hash of the parameters
+// The returned entry is pinned, its prediction _pred can be read 
+// until the entry is unpinned with ISPCUnpin
+ImgSegmentorPredCacheEntry* ISPCGet(ImgSegmentorPredCache* const that, 
+  const ImgSegmentorPredCacheKey* const key) {
+#if BUILDMODE == 0
+  if (that == NULL) {
+    PBImgAnalysisErr->_type = PBErrTypeNullPointer;
+    sprintf(PBImgAnalysisErr->_msg, "'that' is null");
+    PBErrCatch(PBImgAnalysisErr);
+  }
+  if (key == NULL) {
+    PBImgAnalysisErr->_type = PBErrTypeNullPointer;
+    sprintf(PBImgAnalysisErr->_msg, "'key' is null");
+    PBErrCatch(PBImgAnalysisErr);
+  }
+#endif
+  pthread_mutex_lock(&(that->_mutex));
+  ImgSegmentorPredCacheEntry* entry = ISPCFind(that, key);
+  if (entry != NULL) {
+    // Move the entry to the head of the list of use
+    ISPCUnlinkUse(that, entry);
+    ISPCLinkUse(that, entry);
+    ++(entry->_nbPin);
+  }
+  pthread_mutex_unlock(&(that->_mutex));
+  return entry;
+}
+
+// Add the prediction 'pred' for the key 'key' to the 
+// ImgSegmentorPredCache 'that'
+// The least recently used predictions which are not pinned are 
+// removed to respect the memory budget of 'that'
+// Return the new entry, pinned, which owns 'pred', or NULL if the 
+// prediction couldn't be added, in which case 'pred' is still owned 
+// by the caller
+ImgSegmentorPredCacheEntry* ISPCAdd(ImgSegmentorPredCache* const that, 
+  const ImgSegmentorPredCacheKey* const key, 
+  ImgSegmentorPlane* const pred) {
+#if BUILDMODE == 0
+  if (that == NULL) {
+    PBImgAnalysisErr->_type = PBErrTypeNullPointer;
+    sprintf(PBImgAnalysisErr->_msg, "'that' is null");
+    PBErrCatch(PBImgAnalysisErr);
+  }
+  if (key == NULL) {
+    PBImgAnalysisErr->_type = PBErrTypeNullPointer;
+    sprintf(PBImgAnalysisErr->_msg, "'key' is null");
+    PBErrCatch(PBImgAnalysisErr);
+  }
+  if (pred == NULL) {
+    PBImgAnalysisErr->_type = PBErrTypeNullPointer;
+    sprintf(PBImgAnalysisErr->_msg, "'pred' is null");
+    PBErrCatch(PBImgAnalysisErr);
+  }
+#endif
+  // Get the memory used by the new entry, give up if it doesn't fit
+  // in the budget
+  size_t size = sizeof(ImgSegmentorPredCacheEntry) + key->_sizeParams +
+    sizeof(ImgSegmentorPlane) + sizeof(float) * 
+    (size_t)ISPGetArea(pred) * (size_t)ISPGetNbChannel(pred);
+  if (size > that->_budget)
+    return NULL;
+  pthread_mutex_lock(&(that->_mutex));
+  // If another thread has already added this prediction, nothing to do
+  if (ISPCFind(that, key) != NULL) {
+    pthread_mutex_unlock(&(that->_mutex));
+    return NULL;
+  }
+  // Remove the least recently used entries which are not pinned 
+  // until the new one fits, give up if there is not enough of them
+  while (that->_size + size > that->_budget) {
+    ImgSegmentorPredCacheEntry* lru = that->_leastRecent;
+    while (lru != NULL && lru->_nbPin > 0)
+      lru = lru->_prevUse;
+    if (lru == NULL) {
+      pthread_mutex_unlock(&(that->_mutex));
+      return NULL;
+    }
+    ISPCUnlinkUse(that, lru);
+    ImgSegmentorPredCacheEntry** ptr = 
+      &(that->_buckets[ISPCGetIBucket(&(lru->_key))]);
+    while (*ptr != lru)
+      ptr = &((*ptr)->_nextInBucket);
+    *ptr = lru->_nextInBucket;
+    that->_size -= lru->_size;
+    ImgSegmentorPlaneFree(&(lru->_pred));
+    free(lru);
+  }
+  // Add the new entry, with a copy of the parameters of the key in 
+  // the same allocation
+  ImgSegmentorPredCacheEntry* entry = PBErrMalloc(PBImgAnalysisErr, 
+    sizeof(ImgSegmentorPredCacheEntry) + key->_sizeParams);
+  entry->_key = *key;
+  if (key->_sizeParams > 0) {
+    memcpy(entry + 1, key->_params, key->_sizeParams);
+    entry->_key._params = (const unsigned char*)(entry + 1);
+  }
+  entry->_pred = pred;
+  entry->_size = size;
+  entry->_nbPin = 1;
+  long iBucket = ISPCGetIBucket(key);
+  entry->_nextInBucket = that->_buckets[iBucket];
+  that->_buckets[iBucket] = entry;
+  ISPCLinkUse(that, entry);
+  that->_size += size;
+  pthread_mutex_unlock(&(that->_mutex));
+  return entry;
+}
+
+// Unpin the entry 'entry' of the ImgSegmentorPredCache 'that'
+void ISPCUnpin(ImgSegmentorPredCache* const that, 
+  ImgSegmentorPredCacheEntry* const entry) {
+#if BUILDMODE == 0
+  if (that == NULL) {
+    PBImgAnalysisErr->_type = PBErrTypeNullPointer;
+    sprintf(PBImgAnalysisErr->_msg, "'that' is null");
+    PBErrCatch(PBImgAnalysisErr);
+  }
+  if (entry == NULL) {
+    PBImgAnalysisErr->_type = PBErrTypeNullPointer;
+    sprintf(PBImgAnalysisErr->_msg, "'entry' is null");
+    PBErrCatch(PBImgAnalysisErr);
+  }
+#endif
+  pthread_mutex_lock(&(that->_mutex));
+  --(entry->_nbPin);
+  pthread_mutex_unlock(&(that->_mutex));
+}
+
+// Return the memory used by the ImgSegmentorPredCache 'that', in bytes
+size_t ISPCGetSize(ImgSegmentorPredCache* const that) {
+#if BUILDMODE == 0
+  if (that == NULL) {
+    PBImgAnalysisErr->_type = PBErrTypeNullPointer;
+    sprintf(PBImgAnalysisErr->_msg, "'that' is null");
+    PBErrCatch(PBImgAnalysisErr);
+  }
+#endif
+  pthread_mutex_lock(&(that->_mutex));
+  size_t size = that->_size;
+  pthread_mutex_unlock(&(that->_mutex));
+  return size;
+}
+
+// Create a new static ImgSegmentor with 'nbClass' output
+ImgSegmentor ImgSegmentorCreateStatic(int nbClass) {
+#if BUILDMODE == 0
+  if (nbClass <= 0) {
+    PBImgAnalysisErr->_type = PBErrTypeInvalidArg;
+    sprintf(PBImgAnalysisErr->_msg, "'nbClass' is invalid (%d>0)",
+      nbClass);
+    PBErrCatch(PBImgAnalysisErr);
+  }
+#endif
+  // Declare the new ImgSegmentor
+  ImgSegmentor that;
+  // Init properties
+  that._nbClass = nbClass;
+  that._criteria = GenTreeCreateStatic();
+  that._flagBinaryResult = false;
+  that._thresholdBinaryResult = 0.5;
+  that._nbEpoch = 1;
+  that._sizePool = GENALG_NBENTITIES;
+  that._sizeMinPool = that._sizePool;
+  that._sizeMaxPool = that._sizePool;
+  that._nbElite = GENALG_NBELITES;
+  that._targetBestValue = 0.9999;
+  that._flagTextOMeter = false;
+  that._flagWarmStart = false;
+  that._textOMeter = NULL;
+  sprintf(that._line1, IS_TRAINTXTOMETER_LINE1);
+  sprintf(that._line3, IS_TRAINTXTOMETER_LINE2);
+  sprintf(that._line2, IS_EVALTXTOMETER_LINE1);
+  that._flagTraining = false;
+  that._reusedInput = GSetCreateStatic();
+  that._reusedMask = GSetCreateStatic();
+  that._detect = NULL;
+  that._emailNotification = NULL;
+  that._emailSubject = NULL;
+  that._nbThread = 1;
+  that._predCacheBudget = IS_PREDCACHEBUDGETDEFAULT;
+  that._predCache = NULL;
+  that._checkpointKeepBest = 0;
+  that._checkpointKeepLast = 0;
+  that._reuseBudget = 0;
+  that._reuseCache = NULL;
+  that._featureCachePath = NULL;
+  that._trainStatePath = NULL;
+  that._binMap = NULL;
+  that._binMapSize = 0;
+  that._generation = ISNextGeneration();
+  // Return the new ImgSegmentor
+  return that;
+}
+
+// Create a new ImgSegmentor with 'nbClass' output
+ImgSegmentor* ImgSegmentorCreate(int nbClass) {
+#if BUILDMODE == 0
+  if (nbClass <= 0) {
+    PBImgAnalysisErr->_type = PBErrTypeInvalidArg;
+    sprintf(PBImgAnalysisErr->_msg, "'nbClass' is invalid (%d>0)",
+      nbClass);
+    PBErrCatch(PBImgAnalysisErr);
+  }
+#endif
+  // Declare the new ImgSegmentor
+  ImgSegmentor* that = PBErrMalloc(PBImgAnalysisErr, 
+    sizeof(ImgSegmentor));
+  // Init properties
+  *that = ImgSegmentorCreateStatic(nbClass);
+  // Return the new ImgSegmentor
+  return that;
+}
+
+// Free the memory used by the static ImgSegmentor 'that'
+void ImgSegmentorFreeStatic(ImgSegmentor* that) {
+  if (that == NULL)
+    return;
+  if (that->_textOMeter != NULL)
+    TextOMeterFree(&(that->_textOMeter));
+  if (that->_emailNotification != NULL)
+    free(that->_emailNotification);
+  if (that->_emailSubject != NULL)
+    free(that->_emailSubject);
+  if (that->_featureCachePath != NULL)
+    free(that->_featureCachePath);
+  if (that->_trainStatePath != NULL)
+    free(that->_trainStatePath);
+  ISFlushReusedData(that);
+  ISFreeBitMasks(that, &(that->_detect));
+  if (!GenTreeIsLeaf(ISCriteria(that))) {
+    GenTreeIterDepth iter = GenTreeIterDepthCreateStatic(ISCriteria(that));
+    do {
+      ImgSegmentorCriterion* criterion = GenTreeIterGetData(&iter);
+      // Skip the nodes left without criterion by a failed decoding
+      if (criterion == NULL)
+        continue;
+      switch (criterion->_type) {
+        case ISCType_RGB:
+          ImgSegmentorCriterionRGBFree(
+            (ImgSegmentorCriterionRGB**)&criterion);
+          break;
+        case ISCType_RGB2HSV:
+          ImgSegmentorCriterionRGB2HSVFree(
+            (ImgSegmentorCriterionRGB2HSV**)&criterion);
+          break;
+        case ISCType_Dust:
+          ImgSegmentorCriterionDustFree(
+            (ImgSegmentorCriterionDust**)&criterion);
+          break;
+        case ISCType_Tex:
+          ImgSegmentorCriterionTexFree(
+            (ImgSegmentorCriterionTex**)&criterion);
+          break;
+        default:
+          PBImgAnalysisErr->_type = PBErrTypeNotYetImplemented;
+          sprintf(PBImgAnalysisErr->_msg, 
+            "Not yet implemented type of criterion");
+          PBErrCatch(PBImgAnalysisErr);
+          break;
+      }
+    } while (GenTreeIterStep(&iter));
+    GenTreeIterFreeStatic(&iter);
+  }
+  GenTreeFreeStatic((GenTree*)ISCriteria(that));
+  // Unmap the binary file once the criteria borrowing its arrays are 
+  // freed
+  if (that->_binMap != NULL) {
+    munmap(that->_binMap, that->_binMapSize);
+    that->_binMap = NULL;
+    that->_binMapSize = 0;
+  }
+}
+
+// Free the data of the ImgSegmentor 'that' and its criteria reused 
+// during training
+void ISFlushReusedData(ImgSegmentor* const that) {
+  if (!GenTreeIsLeaf(ISCriteria(that))) {
     GenTreeIterDepth iter = GenTreeIterDepthCreateStatic(ISCriteria(that));
     do {
-      ImgSegmentorCriterion* criterion = GenTreeIterGetData(&iter);
-      switch (criterion->_type) {
-        case ISCType_RGB:
-          ImgSegmentorCriterionRGBFree(
-            (ImgSegmentorCriterionRGB**)&criterion);
-          break;
-        case ISCType_RGB2HSV:
-          ImgSegmentorCriterionRGB2HSVFree(
-            (ImgSegmentorCriterionRGB2HSV**)&criterion);
-          break;
-        case ISCType_Dust:
-          ImgSegmentorCriterionDustFree(
-            (ImgSegmentorCriterionDust**)&criterion);
-          break;
-        case ISCType_Tex:
-          ImgSegmentorCriterionTexFree(
-            (ImgSegmentorCriterionTex**)&criterion);
-          break;
-        default:
-          PBImgAnalysisErr->_type = PBErrTypeNotYetImplemented;
-          sprintf(PBImgAnalysisErr->_msg, 
-            "Not yet implemented type of criterion");
-          PBErrCatch(PBImgAnalysisErr);
-          break;
+      ImgSegmentorCriterion* criterion = GenTreeIterGetData(&iter);
+      if (criterion == NULL)
+        continue;
+      ImgSegmentorCriterionFlushReusedData(criterion);
+      criterion->_reuseCache = NULL;
+      criterion->_featureCachePath = NULL;
+    } while (GenTreeIterStep(&iter));
+    GenTreeIterFreeStatic(&iter);
+  }
+  while (GSetNbElem(&(that->_reusedInput)) > 0) {
+    ImgSegmentorReuseEntry* entry = GSetPop(&(that->_reusedInput));
+    ISRCEntryFree(that->_reuseCache, &entry);
+  }
+  while (GSetNbElem(&(that->_reusedMask)) > 0) {
+    ImgBitMask** masks = GSetPop(&(that->_reusedMask));
+    ISFreeBitMasks(that, &masks);
+  }
+  ImgSegmentorPredCacheFree(&(that->_predCache));
+  ImgSegmentorReuseCacheFree(&(that->_reuseCache));
+}
+
+// Return the statistics of the data reused during the last training 
+// of the ImgSegmentor 'that'
+ImgSegmentorReuseStats ISGetReuseStats(const ImgSegmentor* const that) {
+#if BUILDMODE == 0
+  if (that == NULL) {
+    PBImgAnalysisErr->_type = PBErrTypeNullPointer;
+    sprintf(PBImgAnalysisErr->_msg, "'that' is null");
+    PBErrCatch(PBImgAnalysisErr);
+  }
+#endif
+  if (that->_reuseCache == NULL) {
+    ImgSegmentorReuseStats stats = {0, 0, 0, 0};
+    return stats;
+  }
+  return ISRCGetStats(that->_reuseCache);
+}
+
+// Free the memory used by the ImgSegmentor 'that'
+void ImgSegmentorFree(ImgSegmentor** that) {
+  if (that == NULL || *that == NULL)
+    return;
+  ImgSegmentorFreeStatic(*that);
+  free(*that);
+  *that = NULL;
+}
+
+// Make a prediction on the GenBrush 'img' with the ImgSegmentor 'that'
+// Return an array of pointer to GenBrush, one per output class, in 
+// greyscale, where the color of each pixel indicates the detection of 
+// the corresponding class at the given pixel, white equals no 
+// detection, black equals detection, 50% grey equals "don't know"
+GenBrush** ISPredictWithReuse(const ImgSegmentor* const that, 
+  const GenBrush* const img, const int iSample) {
+  return _ISPredict(that, img, iSample, NULL);
+}
+
+// Make a prediction on the GenBrush 'img' with the ImgSegmentor 'that'
+// using the context 'ctx' created for 'that'
+// 'that' is not modified, the NeuraNets of the context are used, so 
+// several threads can predict with the same ImgSegmentor, each one 
+// with its own context
+// Return the same result as ISPredict, or NULL if the prediction 
+// failed or was interrupted, in which case the error is in 'ctx'
+GenBrush** ISPredictWithContext(const ImgSegmentor* const that, 
+  const GenBrush* const img, ImgSegmentorContext* const ctx) {
+#if BUILDMODE == 0
+  if (ctx == NULL) {
+    PBImgAnalysisErr->_type = PBErrTypeNullPointer;
+    sprintf(PBImgAnalysisErr->_msg, "'ctx' is null");
+    PBErrCatch(PBImgAnalysisErr);
+  }
+#endif
+  return _ISPredict(that, img, -1, ctx);
+}
+
+// Main function of the threads of ISPredictBatch
+// Pull the next image to predict from the pool until there is no more
+// image
+void* ISPredictBatchWorkerMain(void* arg) {
+  ImgSegmentorPredictPool* pool = arg;
+  ImgSegmentorContext* ctx = 
+    ImgSegmentorContextCreate(pool->_segmentor);
+  while (true) {
+    int iImg = atomic_fetch_add(&(pool->_next), 1);
+    if (iImg >= pool->_nbImg)
+      break;
+    pool->_res[iImg] = 
+      ISPredictWithContext(pool->_segmentor, pool->_imgs[iImg], ctx);
+  }
+  ImgSegmentorContextFree(&ctx);
+  return NULL;
+}
+
+// Make a prediction on each of the 'nbImg' GenBrush 'imgs' with the 
+// ImgSegmentor 'that', using 'nbThread' threads each with its own 
+// ImgSegmentorContext. If 'nbThread' is lower than 1 the number of 
+// online processors is used
+// Return an array of 'nbImg' results in the same order as 'imgs', 
+// each result being the one of ISPredict, or NULL if the prediction 
+// failed
+GenBrush*** ISPredictBatch(const ImgSegmentor* const that, 
+  const GenBrush* const* const imgs, const int nbImg, 
+  const int nbThread) {
+#if BUILDMODE == 0
+  if (that == NULL) {
+    PBImgAnalysisErr->_type = PBErrTypeNullPointer;
+    sprintf(PBImgAnalysisErr->_msg, "'that' is null");
+    PBErrCatch(PBImgAnalysisErr);
+  }
+  if (imgs == NULL) {
+    PBImgAnalysisErr->_type = PBErrTypeNullPointer;
+    sprintf(PBImgAnalysisErr->_msg, "'imgs' is null");
+    PBErrCatch(PBImgAnalysisErr);
+  }
+  if (nbImg < 1) {
+    PBImgAnalysisErr->_type = PBErrTypeInvalidArg;
+    sprintf(PBImgAnalysisErr->_msg, "'nbImg' is invalid (%d>0)", nbImg);
+    PBErrCatch(PBImgAnalysisErr);
+  }
+#endif
+  // Allocate memory for the results
+  GenBrush*** res = PBErrMalloc(PBImgAnalysisErr, 
+    sizeof(GenBrush**) * nbImg);
+  memset(res, 0, sizeof(GenBrush**) * nbImg);
+  // Create the pool of images
+  ImgSegmentorPredictPool pool;
+  pool._segmentor = that;
+  pool._imgs = imgs;
+  pool._nbImg = nbImg;
+  pool._res = res;
+  atomic_store(&(pool._next), 0);
+  // Get the number of threads, no need for more threads than images
+  int nb = nbThread;
+  if (nb < 1)
+    nb = (int)sysconf(_SC_NPROCESSORS_ONLN);
+  if (nb < 1)
+    nb = 1;
+  if (nb > nbImg)
+    nb = nbImg;
+  // Run the threads and wait for them to end
+  pthread_t* threads = PBErrMalloc(PBImgAnalysisErr, 
+    sizeof(pthread_t) * nb);
+  bool* flagThreads = PBErrMalloc(PBImgAnalysisErr, sizeof(bool) * nb);
+  bool flagFailed = false;
+  for (int iThread = nb; iThread--;) {
+    flagThreads[iThread] = (pthread_create(threads + iThread, NULL, 
+      ISPredictBatchWorkerMain, &pool) == 0);
+    flagFailed |= !flagThreads[iThread];
+  }
+  // If a thread couldn't be created, pull the remaining images from 
+  // the calling thread
+  if (flagFailed)
+    (void)ISPredictBatchWorkerMain(&pool);
+  for (int iThread = nb; iThread--;)
+    if (flagThreads[iThread])
+      pthread_join(threads[iThread], NULL);
+  // Free memory
+  free(threads);
+  free(flagThreads);
+  // Return the results
+  return res;
+}
+
+// Convert the prediction score 'p' of the ImgSegmentor 'that' into 
+// the grey level used in the result of ISPredict
+unsigned char ISScoreToGrey(const ImgSegmentor* const that, float p) {
+#if BUILDMODE == 0
+  if (that == NULL) {
+    PBImgAnalysisErr->_type = PBErrTypeNullPointer;
+    sprintf(PBImgAnalysisErr->_msg, "'that' is null");
+    PBErrCatch(PBImgAnalysisErr);
+  }
+#endif
+  if (ISGetFlagBinaryResult(that)) {
+    if (p > ISGetThresholdBinaryResult(that))
+      p = 1.0;
+    else
+      p = -1.0;
+  }
+  return 255 - (unsigned char)round(255.0 * (p * 0.5 + 0.5));
+}
+
+// Return true if the prediction score 'p' of the ImgSegmentor 'that'
+// is rendered as a detection (black pixel) in the result of ISPredict
+bool ISScoreIsDetection(const ImgSegmentor* const that, const float p) {
+  return ISScoreToGrey(that, p) == 0;
+}
+
+// Return true if the criterion of the node 'node' and all its 
+// ancestors are frozen, i.e. its prediction during training is the 
+// same for all the entities
+bool ISIsFrozenPred(const GenTree* const node) {
+#if BUILDMODE == 0
+  if (node == NULL) {
+    PBImgAnalysisErr->_type = PBErrTypeNullPointer;
+    sprintf(PBImgAnalysisErr->_msg, "'node' is null");
+    PBErrCatch(PBImgAnalysisErr);
+  }
+#endif
+  const GenTree* cur = node;
+  while (cur != NULL && GenTreeData(cur) != NULL) {
+    if (!ISCIsFrozen((const ImgSegmentorCriterion*)GenTreeData(cur)))
+      return false;
+    cur = GenTreeParent(cur);
+  }
+  return true;
+}
+
+// Release the plane 'plane' used during the prediction of an 
+// ImgSegmentor: forget it if it is the borrowed input 'borrowed' or
+// the prediction of one of the entries of the cache of predictions in
+// 'pinned', else free it
+void ISReleasePlane(ImgSegmentorPlane** plane, 
+  const ImgSegmentorPlane* const borrowed, const GSet* const pinned) {
+  if (plane == NULL || *plane == NULL)
+    return;
+  if (GSetNbElem(pinned) > 0) {
+    GSetIterForward iter = GSetIterForwardCreateStatic((GSet*)pinned);
+    do {
+      const ImgSegmentorPredCacheEntry* entry = GSetIterGet(&iter);
+      if (entry->_pred == *plane) {
+        *plane = NULL;
+        return;
       }
-    } while (GenTreeIterStep(&iter));
-    GenTreeIterFreeStatic(&iter);
+    } while (GSetIterStep(&iter));
   }
-  GenTreeFreeStatic((GenTree*)ISCriteria(that));
-  while (GSetNbElem(&(that->_reusedInput)) > 0) {
-    VecFloat* v = GSetPop(&(that->_reusedInput));
-    VecFree(&v);
+  ImgSegmentorPlaneRelease(plane, borrowed);
+}
+
+// Function used by _ISPredict, ISPredictScoresInto, 
+// ISPredictScoresUInt8Into and ISEvaluateSample
+// 'ctx' may be NULL
+// The scores are written either as floats in 'scores' or quantized 
+// to grey levels in 'scoresUInt8', the other one being NULL
+// If 'masks' is not NULL, it's the masks of 'img' as created by 
+// ISCreateBitMasks and the intersection over union of the detections 
+// with 'masks' is calculated for each class into 'iou', the detections
+// being packed in the same pass as the scores into 'detect', bit masks
+// of the dimensions of 'img' with all bits set to 0, one per class
+// In that case 'scores' and 'scoresUInt8' can both be NULL
+bool _ISPredictScores(const ImgSegmentor* const that, 
+  const GenBrush* const img, const int iSample, 
+  ImgSegmentorContext* const ctx, float* const scores,
+  unsigned char* const scoresUInt8, ImgBitMask* const* const masks, 
+  ImgBitMask* const* const detect, float* const iou) {
+#if BUILDMODE == 0
+  if (that == NULL) {
+    PBImgAnalysisErr->_type = PBErrTypeNullPointer;
+    sprintf(PBImgAnalysisErr->_msg, "'that' is null");
+    PBErrCatch(PBImgAnalysisErr);
+  }
+  if (img == NULL) {
+    PBImgAnalysisErr->_type = PBErrTypeNullPointer;
+    sprintf(PBImgAnalysisErr->_msg, "'img' is null");
+    PBErrCatch(PBImgAnalysisErr);
+  }
+  if ((scores != NULL && scoresUInt8 != NULL) || 
+    (scores == NULL && scoresUInt8 == NULL && masks == NULL)) {
+    PBImgAnalysisErr->_type = PBErrTypeInvalidArg;
+    sprintf(PBImgAnalysisErr->_msg, 
+      "one and only one of 'scores' and 'scoresUInt8' must be null");
+    PBErrCatch(PBImgAnalysisErr);
+  }
+  if (masks != NULL && iou == NULL) {
+    PBImgAnalysisErr->_type = PBErrTypeNullPointer;
+    sprintf(PBImgAnalysisErr->_msg, "'iou' is null");
+    PBErrCatch(PBImgAnalysisErr);
+  }
+  if (masks != NULL && detect == NULL) {
+    PBImgAnalysisErr->_type = PBErrTypeNullPointer;
+    sprintf(PBImgAnalysisErr->_msg, "'detect' is null");
+    PBErrCatch(PBImgAnalysisErr);
+  }
+#endif
+  // If there is a context, check it matches 'that' and reset its error
+  if (ctx != NULL) {
+    ctx->_flagError = false;
+    ctx->_errMsg[0] = '\0';
+    if (ctx->_flagInvalid) {
+      ctx->_flagError = true;
+      sprintf(ctx->_errMsg, "the context couldn't be created");
+      return false;
+    }
+    if (ctx->_segmentor != that || 
+      ctx->_nbCriterion != ISGetNbCriterion(that)) {
+      ctx->_flagError = true;
+      sprintf(ctx->_errMsg, "the context doesn't match the segmentor");
+      return false;
+    }
+    if (ctx->_generation != that->_generation) {
+      ctx->_flagError = true;
+      sprintf(ctx->_errMsg, 
+        "the criteria have been modified, recreate the context");
+      return false;
+    }
+  }
+  // Get the dimension of the input image
+  VecShort2D dim = GBGetDim(img);
+  // Calculate the area of the image
+  long area = VecGet(&dim, 0) * VecGet(&dim, 1);
+  // Get the number of class
+  long nbClass = ISGetNbClass(that);
+  // Declare the plane holding the input of the criteria
+  ImgSegmentorPlane* input = NULL;
+  // Declare a pointer to the input when it is borrowed from the reused
+  // data, it is owned by the reused data and must not be freed
+  const ImgSegmentorPlane* borrowedInput = NULL;
+  // Get the entry of the reused data for this sample
+  // The data are never reused with a context to keep 'that' unmodified
+  ImgSegmentorReuseEntry* entry = NULL;
+  if (that->_flagTraining && iSample >= 0 && ctx == NULL)
+    entry = ISRCGetEntry(that->_reuseCache, 
+      (GSet*)&(that->_reusedInput), iSample);
+  // If we reuse data and this input is resident, borrow it, the 
+  // criteria only read their input
+  if (entry != NULL)
+    input = ISRCGetData(that->_reuseCache, entry);
+  if (input != NULL) {
+    borrowedInput = input;
+  // Else, convert the image's pixels into the input plane
+  } else {
+    input = ImgSegmentorPlaneCreateFromGenBrush(img);
+    // Give the converted input to the reusable data and borrow it
+    if (entry != NULL && ISRCAdd(that->_reuseCache, entry, input, 
+      ISReuseType_Plane, sizeof(ImgSegmentorPlane) + sizeof(float) * 
+      (size_t)ISPGetArea(input) * (size_t)ISPGetNbChannel(input)))
+      borrowedInput = input;
+  }
+  // Pin the borrowed input to prevent its eviction by the criteria
+  if (borrowedInput != NULL)
+    ISRCPin(that->_reuseCache, entry);
+  // Declare a set to memorize the temporary inputs while moving
+  // through the tree of criteria
+  GSet inputs = GSetCreateStatic();
+  // Add the initial input to the set
+  GSetAppend(&inputs, input);
+  // Create a set to memorize the prediction of each leaf criterion
+  GSet leafPred = GSetCreateStatic();
+  // Create a set to memorize the entries of the cache of predictions
+  // pinned while their prediction is used
+  GSet pinnedPred = GSetCreateStatic();
+  // Loop on criteria
+  int iCrit = 0;
+  GenTreeIterDepth iter = GenTreeIterDepthCreateStatic(ISCriteria(that));
+  do {
+    // Get the criteria
+    ImgSegmentorCriterion* criterion = GenTreeIterGetData(&iter);
+    // Get the input on which to apply the criteria, this is the last
+    // pushed input
+    ImgSegmentorPlane* curInput = GSetTail(&inputs);
+    // Do the prediction
+    ImgSegmentorPlane* pred = NULL;
+    if (ctx != NULL) {
+      pred = ISCPredictWithContext(criterion, curInput, -1, 
+        ctx->_criteria + iCrit);
+    } else if (that->_flagTraining) {
+      // The prediction of a frozen criterion whose ancestors are 
+      // frozen is the same for all the entities, reuse it
+      ImgSegmentorReuseEntry* frozenEntry = NULL;
+      if (iSample >= 0 && 
+        ISIsFrozenPred(GenTreeIterGetGenTree(&iter))) {
+        frozenEntry = ISRCGetEntry(that->_reuseCache, 
+          &(criterion->_frozenPred), iSample);
+        if (frozenEntry != NULL) {
+          const ImgSegmentorPlane* frozenPred = 
+            ISRCGetData(that->_reuseCache, frozenEntry);
+          if (frozenPred != NULL)
+            pred = ImgSegmentorPlaneClone(frozenPred);
+        }
+      }
+      // Use the cache of predictions if the parameters of the 
+      // criterion are known
+      bool flagCache = (pred == NULL && frozenEntry == NULL && 
+        that->_predCache != NULL && iSample >= 0 && 
+        criterion->_paramHash != 0);
+      ImgSegmentorPredCacheKey key = {
+        ._paramHash = criterion->_paramHash, 
+        ._params = criterion->_paramKey, 
+        ._sizeParams = criterion->_sizeParamKey, 
+        ._iCrit = iCrit, ._iSample = iSample, ._dim = dim};
+      if (flagCache) {
+        ImgSegmentorPredCacheEntry* cached = 
+          ISPCGet(that->_predCache, &key);
+        if (cached != NULL) {
+          pred = cached->_pred;
+          GSetAppend(&pinnedPred, cached);
+        }
+      }
+      if (pred == NULL) {
+        pred = ISCPredictWithReuse(criterion, curInput, iSample);
+        // A prediction interrupted by Ctrl-C is incomplete, don't 
+        // cache it
+        if (flagCache && !PBIA_CtrlC) {
+          ImgSegmentorPredCacheEntry* cached = 
+            ISPCAdd(that->_predCache, &key, pred);
+          if (cached != NULL)
+            GSetAppend(&pinnedPred, cached);
+        }
+        // Give a clone of the prediction of the frozen criterion to 
+        // the reused data
+        if (frozenEntry != NULL) {
+          ImgSegmentorPlane* clone = ImgSegmentorPlaneClone(pred);
+          if (!ISRCAdd(that->_reuseCache, frozenEntry, clone, 
+            ISReuseType_Plane, sizeof(ImgSegmentorPlane) + 
+            sizeof(float) * (size_t)ISPGetArea(clone) * 
+            (size_t)ISPGetNbChannel(clone)))
+            ImgSegmentorPlaneFree(&clone);
+        }
+      }
+    } else {
+      pred = ISCPredict(criterion, curInput);
+    }
+    ++iCrit;
+    // If this criterion is a leaf in the tree of crieria
+    if (GenTreeIsLeaf(GenTreeIterGetGenTree(&iter))) {
+      // Add the result of the prediction to the set of final prediction
+      GSetAppend(&leafPred, pred);
+      // If the criterion is a last brother
+      if (GenTreeIsLastBrother(GenTreeIterGetGenTree(&iter))) {
+        // Drop and free the intermediate input
+        (void)GSetDrop(&inputs);
+        ISReleasePlane(&curInput, borrowedInput, &pinnedPred);
+        // In case the parent was the last brother it will be skipped
+        // back by the GenTreeIterDepth and we need to drop its input
+        // right away
+        GenTree* parent = GenTreeParent(GenTreeIterGetGenTree(&iter));
+        while (parent != NULL && GenTreeIsLastBrother(parent)) {
+          curInput = GSetDrop(&inputs);
+          ISReleasePlane(&curInput, borrowedInput, &pinnedPred);
+          parent = GenTreeParent(parent);
+        }
+      }
+    // Else the criterion is a node in the tree
+    } else {
+      // Append the result of prediction to the intermediate input
+      GSetAppend(&inputs, pred);
+    }
+  } while(GenTreeIterStep(&iter));
+  GenTreeIterFreeStatic(&iter);
+  // If the prediction has been interrupted
+  if (ctx != NULL && ctx->_flagStop != NULL && *(ctx->_flagStop)) {
+    ctx->_flagError = true;
+    sprintf(ctx->_errMsg, "the prediction has been interrupted");
+    while (GSetNbElem(&leafPred) > 0) {
+      ImgSegmentorPlane* pred = GSetPop(&leafPred);
+      ISReleasePlane(&pred, NULL, &pinnedPred);
+    }
+    while (GSetNbElem(&inputs) > 0) {
+      ImgSegmentorPlane* curInput = GSetDrop(&inputs);
+      ISReleasePlane(&curInput, borrowedInput, &pinnedPred);
+    }
+    if (borrowedInput != NULL)
+      ISRCUnpin(that->_reuseCache, entry);
+    while (GSetNbElem(&pinnedPred) > 0)
+      ISPCUnpin(that->_predCache, GSetPop(&pinnedPred));
+    return false;
+  }
+  // Get the values of the predictions of the leaf criteria
+  long nbLeaf = GSetNbElem(&leafPred);
+  const float** leafVal = 
+    PBErrMalloc(PBImgAnalysisErr, sizeof(float*) * nbLeaf);
+  GSetIterForward iterPred = GSetIterForwardCreateStatic(&leafPred);
+  long iLeaf = 0;
+  do {
+    leafVal[iLeaf++] = 
+      ISPVal((ImgSegmentorPlane*)GSetIterGet(&iterPred));
+  } while (GSetIterStep(&iterPred));
+  // Declare a buffer for the combined predictions of one pixel
+  float* c = PBErrMalloc(PBImgAnalysisErr, sizeof(float) * nbClass);
+  // Combine the predictions one pixel at a time, streaming through the
+  // predictions of the leaf criteria together, hence without 
+  // intermediate plane and writing directly the scores in the 
+  // requested type
+  // The combination over criteria is the weighted average of 
+  // prediction over criteria where the weight is the absolute value of 
+  // the prediction
+  // The combination over classes is calculated as follow:
+  // finalPred(i) = (pred(i)*abs(combPred(i) - sum_{j!=i} 
+  //   combPred(j)*abs(combPred(j)) / (sum_i abs(combPred(i))
+  // The result is written in planar layout, one plane per class
+  long width = VecGet(&dim, 0);
+  for (long y = VecGet(&dim, 1); y--;) {
+    for (long x = width; x--;) {
+      long iPos = y * width + x;
+      long iVal = iPos * nbClass;
+      for (long iClass = nbClass; iClass--;) {
+        float comb = 0.0;
+        float sumWeight = 0.0;
+        for (iLeaf = 0; iLeaf < nbLeaf; ++iLeaf) {
+          float v = leafVal[iLeaf][iVal + iClass];
+          comb += v * fabs(v);
+          sumWeight += fabs(v);
+        }
+        if (sumWeight > PBMATH_EPSILON)
+          c[iClass] = comb / sumWeight;
+        else
+          c[iClass] = 0.0;
+      }
+      float sumSigned = 0.0;
+      float sumAbs = 0.0;
+      for (long jClass = nbClass; jClass--;) {
+        sumSigned += c[jClass] * fabs(c[jClass]);
+        sumAbs += fabs(c[jClass]);
+      }
+      for (long iClass = nbClass; iClass--;) {
+        float f = 0.0;
+        if (sumAbs > PBMATH_EPSILON)
+          f = (2.0 * c[iClass] * fabs(c[iClass]) - sumSigned) / sumAbs;
+        if (scores != NULL)
+          scores[iClass * area + iPos] = f;
+        else if (scoresUInt8 != NULL)
+          scoresUInt8[iClass * area + iPos] = ISScoreToGrey(that, f);
+        // Pack the detection in the bit mask
+        if (masks != NULL && ISScoreIsDetection(that, f))
+          IBMSet(detect[iClass], x, y);
+      }
+    }
+  }
+  // Calculate the intersection over union per class
+  if (masks != NULL)
+    for (long iClass = nbClass; iClass--;)
+      iou[iClass] = 
+        IntersectionOverUnionBitMask(masks[iClass], detect[iClass]);
+  // Free memory
+  while (GSetNbElem(&leafPred) > 0) {
+    ImgSegmentorPlane* pred = GSetPop(&leafPred);
+    ISReleasePlane(&pred, NULL, &pinnedPred);
+  }
+  do {
+    ImgSegmentorPlane* curInput = GSetDrop(&inputs);
+    ISReleasePlane(&curInput, borrowedInput, &pinnedPred);
+  } while (GSetNbElem(&inputs) > 0);
+  free(leafVal);
+  free(c);
+  if (borrowedInput != NULL)
+    ISRCUnpin(that->_reuseCache, entry);
+  while (GSetNbElem(&pinnedPred) > 0)
+    ISPCUnpin(that->_predCache, GSetPop(&pinnedPred));
+  // Return the success flag
+  return true;
+}
+
+// Function used by ISPredictWithReuse and ISPredictWithContext
+// 'ctx' may be NULL
+GenBrush** _ISPredict(const ImgSegmentor* const that, 
+  const GenBrush* const img, const int iSample, 
+  ImgSegmentorContext* const ctx) {
+#if BUILDMODE == 0
+  if (that == NULL) {
+    PBImgAnalysisErr->_type = PBErrTypeNullPointer;
+    sprintf(PBImgAnalysisErr->_msg, "'that' is null");
+    PBErrCatch(PBImgAnalysisErr);
+  }
+  if (img == NULL) {
+    PBImgAnalysisErr->_type = PBErrTypeNullPointer;
+    sprintf(PBImgAnalysisErr->_msg, "'img' is null");
+    PBErrCatch(PBImgAnalysisErr);
+  }
+#endif
+  // Get the dimension of the input image
+  VecShort2D dim = GBGetDim(img);
+  // Calculate the area of the image
+  long area = VecGet(&dim, 0) * VecGet(&dim, 1);
+  // Allocate memory for the scores and calculate them
+  float* scores = PBErrMalloc(PBImgAnalysisErr, 
+    sizeof(float) * area * ISGetNbClass(that));
+  if (!_ISPredictScores(that, img, iSample, ctx, scores, NULL, NULL, 
+    NULL, NULL)) {
+    free(scores);
+    return NULL;
+  }
+  // Allocate memory for the results
+  GenBrush** res = PBErrMalloc(PBImgAnalysisErr, 
+    sizeof(GenBrush*) * ISGetNbClass(that));
+  // Declare a variable to convert the prediction into pixel
+  GBPixel pix = GBColorWhite;
+  // Declare a vector to loop on position in the image
+  VecShort2D pos = VecShortCreateStatic2D();
+  // Loop on classes
+  for (int iClass = ISGetNbClass(that); iClass--;) {
+    // Create the result GenBrush
+    res[iClass] = GBCreateImage(&dim);
+    // Add a layer to the result GenBrush
+    GBLayer* layer = GBAddLayer(res[iClass], &dim);
+    // Get the plane of scores for this class
+    const float* plane = scores + iClass * area;
+    // Loop on position in the image
+    VecSetNull(&pos);
+    do {
+      // Get the prediction value for this class and this position
+      // and convert it to rgb value
+      unsigned char pChar = 
+        ISScoreToGrey(that, plane[GBPosIndex(&pos, &dim)]);
+      // Convert the prediction to a pixel
+      pix._rgba[GBPixelRed] = pix._rgba[GBPixelGreen] = 
+        pix._rgba[GBPixelBlue] = pChar;
+      // Set the pixel in the layer
+      GBLayerAddPixel(
+        layer, 
+        &pos, 
+        &pix, 
+        0.0);
+    } while (VecStep(&pos, &dim));
+    // Render the final pixels in the result image
+    GBSurfaceUpdate(GBSurf(res[iClass]));
+    GBUpdate(res[iClass]);
+  }
+  // Free memory
+  free(scores);
+  // Return the result
+  return res;
+}
+
+// Calculate the prediction scores on the GenBrush 'img' with the 
+// ImgSegmentor 'that' into 'scores' without rendering any GenBrush
+// 'scores' must be allocated by the user to the area of 'img' times 
+// the number of class of 'that'. It is filled in planar layout, the 
+// score of class 'iClass' at pixel (x, y) is 
+// scores[iClass * area + y * width + x], in [-1.0, 1.0], -1.0 equals 
+// no detection, 1.0 equals detection, 0.0 equals "don't know"
+// The binarization flag of 'that' is not applied
+// 'ctx' may be NULL, else it is used as in ISPredictWithContext
+// Return true if the prediction succeeded, false else in which case 
+// the error is in 'ctx'
+bool ISPredictScoresInto(const ImgSegmentor* const that, 
+  const GenBrush* const img, ImgSegmentorContext* const ctx, 
+  float* const scores) {
+#if BUILDMODE == 0
+  if (that == NULL) {
+    PBImgAnalysisErr->_type = PBErrTypeNullPointer;
+    sprintf(PBImgAnalysisErr->_msg, "'that' is null");
+    PBErrCatch(PBImgAnalysisErr);
+  }
+  if (img == NULL) {
+    PBImgAnalysisErr->_type = PBErrTypeNullPointer;
+    sprintf(PBImgAnalysisErr->_msg, "'img' is null");
+    PBErrCatch(PBImgAnalysisErr);
+  }
+  if (scores == NULL) {
+    PBImgAnalysisErr->_type = PBErrTypeNullPointer;
+    sprintf(PBImgAnalysisErr->_msg, "'scores' is null");
+    PBErrCatch(PBImgAnalysisErr);
+  }
+#endif
+  return _ISPredictScores(that, img, -1, ctx, scores, NULL, NULL, NULL, 
+    NULL);
+}
+
+// Calculate the prediction scores on the GenBrush 'img' with the 
+// ImgSegmentor 'that', see ISPredictScoresInto
+// Return the scores in a new array, or NULL if the prediction failed
+float* ISPredictScores(const ImgSegmentor* const that, 
+  const GenBrush* const img, ImgSegmentorContext* const ctx) {
+#if BUILDMODE == 0
+  if (that == NULL) {
+    PBImgAnalysisErr->_type = PBErrTypeNullPointer;
+    sprintf(PBImgAnalysisErr->_msg, "'that' is null");
+    PBErrCatch(PBImgAnalysisErr);
+  }
+  if (img == NULL) {
+    PBImgAnalysisErr->_type = PBErrTypeNullPointer;
+    sprintf(PBImgAnalysisErr->_msg, "'img' is null");
+    PBErrCatch(PBImgAnalysisErr);
+  }
+#endif
+  // Allocate memory for the scores
+  VecShort2D dim = GBGetDim(img);
+  float* scores = PBErrMalloc(PBImgAnalysisErr, sizeof(float) * 
+    VecGet(&dim, 0) * VecGet(&dim, 1) * ISGetNbClass(that));
+  // Calculate the scores
+  if (!_ISPredictScores(that, img, -1, ctx, scores, NULL, NULL, NULL, 
+    NULL)) {
+    free(scores);
+    return NULL;
+  }
+  // Return the scores
+  return scores;
+}
+
+// Calculate the prediction scores on the GenBrush 'img' with the 
+// ImgSegmentor 'that' into 'scores', quantized to the grey levels of 
+// the result of ISPredict (255 equals no detection, 0 equals 
+// detection), the binarization flag of 'that' being applied
+// The layout and arguments are the same as for ISPredictScoresInto
+// Return true if the prediction succeeded, false else in which case 
+// the error is in 'ctx'
+bool ISPredictScoresUInt8Into(const ImgSegmentor* const that, 
+  const GenBrush* const img, ImgSegmentorContext* const ctx, 
+  unsigned char* const scores) {
+#if BUILDMODE == 0
+  if (that == NULL) {
+    PBImgAnalysisErr->_type = PBErrTypeNullPointer;
+    sprintf(PBImgAnalysisErr->_msg, "'that' is null");
+    PBErrCatch(PBImgAnalysisErr);
+  }
+  if (img == NULL) {
+    PBImgAnalysisErr->_type = PBErrTypeNullPointer;
+    sprintf(PBImgAnalysisErr->_msg, "'img' is null");
+    PBErrCatch(PBImgAnalysisErr);
+  }
+  if (scores == NULL) {
+    PBImgAnalysisErr->_type = PBErrTypeNullPointer;
+    sprintf(PBImgAnalysisErr->_msg, "'scores' is null");
+    PBErrCatch(PBImgAnalysisErr);
+  }
+#endif
+  // Calculate the scores, they are quantized as they are combined
+  return _ISPredictScores(that, img, -1, ctx, NULL, scores, NULL, NULL, 
+    NULL);
+}
+
+// Calculate the prediction scores on the GenBrush 'img' with the 
+// ImgSegmentor 'that', see ISPredictScoresUInt8Into
+// Return the scores in a new array, or NULL if the prediction failed
+unsigned char* ISPredictScoresUInt8(const ImgSegmentor* const that, 
+  const GenBrush* const img, ImgSegmentorContext* const ctx) {
+#if BUILDMODE == 0
+  if (that == NULL) {
+    PBImgAnalysisErr->_type = PBErrTypeNullPointer;
+    sprintf(PBImgAnalysisErr->_msg, "'that' is null");
+    PBErrCatch(PBImgAnalysisErr);
+  }
+  if (img == NULL) {
+    PBImgAnalysisErr->_type = PBErrTypeNullPointer;
+    sprintf(PBImgAnalysisErr->_msg, "'img' is null");
+    PBErrCatch(PBImgAnalysisErr);
+  }
+#endif
+  // Allocate memory for the scores
+  VecShort2D dim = GBGetDim(img);
+  unsigned char* scores = PBErrMalloc(PBImgAnalysisErr, 
+    sizeof(unsigned char) * VecGet(&dim, 0) * VecGet(&dim, 1) * 
+    ISGetNbClass(that));
+  // Calculate the scores
+  if (!ISPredictScoresUInt8Into(that, img, ctx, scores)) {
+    free(scores);
+    return NULL;
+  }
+  // Return the scores
+  return scores;
+}
+
+// Create a new ImgSegmentorContext for the ImgSegmentor 'that'
+// The context must be recreated if the criteria of 'that' are modified
+// (added, trained, loaded, set with ISSetParams or compiled), the 
+// predictions with an outdated context fail
+// The errors are reported in the context, not in PBImgAnalysisErr, 
+// so several threads can create and use their own context
+ImgSegmentorContext* ImgSegmentorContextCreate(
+  const ImgSegmentor* const that) {
+#if BUILDMODE == 0
+  if (that == NULL) {
+    PBImgAnalysisErr->_type = PBErrTypeNullPointer;
+    sprintf(PBImgAnalysisErr->_msg, "'that' is null");
+    PBErrCatch(PBImgAnalysisErr);
   }
+#endif
+  // Allocate memory for the new ImgSegmentorContext
+  ImgSegmentorContext* ctx = PBErrMalloc(PBImgAnalysisErr, 
+    sizeof(ImgSegmentorContext));
+  // Set the properties
+  ctx->_segmentor = that;
+  ctx->_generation = that->_generation;
+  ctx->_nbCriterion = ISGetNbCriterion(that);
+  ctx->_flagStop = NULL;
+  ctx->_flagError = false;
+  ctx->_errMsg[0] = '\0';
+  ctx->_flagInvalid = false;
+  ctx->_criteria = NULL;
+  if (ctx->_nbCriterion == 0)
+    return ctx;
+  ctx->_criteria = PBErrMalloc(PBImgAnalysisErr, 
+    sizeof(ImgSegmentorCriterionContext) * ctx->_nbCriterion);
+  // Loop on the criteria
+  int iCrit = 0;
+  GenTreeIterDepth iter = GenTreeIterDepthCreateStatic(ISCriteria(that));
+  do {
+    const ImgSegmentorCriterion* criterion = GenTreeIterGetData(&iter);
+    ImgSegmentorCriterionContext* critCtx = ctx->_criteria + iCrit;
+    critCtx->_flagStop = NULL;
+    critCtx->_nn = NULL;
+    // Get the NeuraNet of the criterion if any
+    const NeuraNet* nn = NULL;
+    if (criterion->_type == ISCType_RGB) {
+      nn = ISCRGBNeuraNet((const ImgSegmentorCriterionRGB*)criterion);
+    } else if (criterion->_type == ISCType_Tex) {
+      nn = ISCTexNeuraNet((const ImgSegmentorCriterionTex*)criterion);
+    }
+    // Clone the NeuraNet through its JSON encoding, the NeuraNet 
+    // memorizes its hidden values during evaluation hence it can't be 
+    // shared by several threads
+    // A failure is reported in the context, the predictions with it 
+    // will fail
+    if (nn != NULL) {
+      JSONNode* json = NNEncodeAsJSON(nn);
+      if (!NNDecodeAsJSON(&(critCtx->_nn), json)) {
+        NeuraNetFree(&(critCtx->_nn));
+        ctx->_flagInvalid = true;
+        ctx->_flagError = true;
+        sprintf(ctx->_errMsg, "couldn't clone the NeuraNet");
+      }
+      JSONFree(&json);
+    }
+    ++iCrit;
+  } while (GenTreeIterStep(&iter));
+  GenTreeIterFreeStatic(&iter);
+  // Return the new ImgSegmentorContext
+  return ctx;
 }
 
-// Free the memory used by the ImgSegmentor 'that'
-void ImgSegmentorFree(ImgSegmentor** that) {
+// Free the memory used by the ImgSegmentorContext 'that'
+void ImgSegmentorContextFree(ImgSegmentorContext** that) {
   if (that == NULL || *that == NULL)
     return;
-  ImgSegmentorFreeStatic(*that);
+  // Free memory
+  for (int iCrit = (*that)->_nbCriterion; iCrit--;)
+    NeuraNetFree(&((*that)->_criteria[iCrit]._nn));
+  free((*that)->_criteria);
   free(*that);
   *that = NULL;
 }
 
-// Make a prediction on the GenBrush 'img' with the ImgSegmentor 'that'
-// Return an array of pointer to GenBrush, one per output class, in 
-// greyscale, where the color of each pixel indicates the detection of 
-// the corresponding class at the given pixel, white equals no 
-// detection, black equals detection, 50% grey equals "don't know"
-GenBrush** ISPredictWithReuse(const ImgSegmentor* const that, 
-  const GenBrush* const img, const int iSample) {
+// Set the flag interrupting the predictions with the context 'that'
+// to 'flag', which may be NULL
+void ISCtxSetFlagStop(ImgSegmentorContext* const that, 
+  const volatile bool* const flag) {
 #if BUILDMODE == 0
   if (that == NULL) {
     PBImgAnalysisErr->_type = PBErrTypeNullPointer;
     sprintf(PBImgAnalysisErr->_msg, "'that' is null");
     PBErrCatch(PBImgAnalysisErr);
   }
-  if (img == NULL) {
+#endif
+  that->_flagStop = flag;
+  for (int iCrit = that->_nbCriterion; iCrit--;)
+    that->_criteria[iCrit]._flagStop = flag;
+}
+
+// Handler for the signal Ctrl-C
+void ISTrainHandlerCtrlC(int sig) {
+  (void)sig;
+  PBIA_CtrlC = true;
+  time_t intTime = time(NULL);
+  char* strIntTime = ctime(&intTime);
+  printf("\n%s!!! ISTrain Interrupted by Ctrl-C !!!\n", strIntTime);
+  fflush(stdout);
+}
+ 
+// Return the FNV-1a hash of the 'nbInt' int parameters from 
+// 'shiftInt' in 'adnI' and the 'nbFloat' float parameters from 
+// 'shiftFloat' in 'adnF', starting from the hash 'hash'
+uint64_t ISHashAdnSlice(const VecLong* const adnI, 
+  const VecFloat* const adnF, uint64_t hash,
+  const long shiftInt, const long nbInt, 
+  const long shiftFloat, const long nbFloat) {
+  const unsigned char* bytes = NULL;
+  for (long i = 0; i < nbInt; ++i) {
+    long val = VecGet(adnI, shiftInt + i);
+    bytes = (const unsigned char*)&val;
+    for (size_t iByte = 0; iByte < sizeof(long); ++iByte)
+      hash = (hash ^ bytes[iByte]) * 0x100000001B3ULL;
+  }
+  for (long i = 0; i < nbFloat; ++i) {
+    float val = VecGet(adnF, shiftFloat + i);
+    bytes = (const unsigned char*)&val;
+    for (size_t iByte = 0; iByte < sizeof(float); ++iByte)
+      hash = (hash ^ bytes[iByte]) * 0x100000001B3ULL;
+  }
+  // Avoid 0 which means unknown
+  if (hash == 0)
+    hash = 1;
+  return hash;
+}
+
+// Return a new generation for the criteria of an ImgSegmentor
+unsigned long ISNextGeneration(void) {
+  return atomic_fetch_add(&PBIA_Generation, 1) + 1;
+}
+
+// Set the parameters of the criteria of the ImgSegmentor 'that' with 
+// the adn 'adn'
+// The frozen criteria have no parameters in 'adn'
+void ISSetAdn(ImgSegmentor* const that, const GenAlgAdn* const adn) {
+#if BUILDMODE == 0
+  if (adn == NULL) {
     PBImgAnalysisErr->_type = PBErrTypeNullPointer;
-    sprintf(PBImgAnalysisErr->_msg, "'img' is null");
+    sprintf(PBImgAnalysisErr->_msg, "'adn' is null");
     PBErrCatch(PBImgAnalysisErr);
   }
 #endif
-  // Get the dimension of the input image
-  VecShort2D dim = GBGetDim(img);
-  // Calculate the area of the image
-  long area = VecGet(&dim, 0) * VecGet(&dim, 1);
-  // Create a temporary vector to convert the image into the input
-  // of a criterion
-  VecFloat* input = NULL;
-  // Declare a vector to loop on position in the image
-  VecShort2D pos = VecShortCreateStatic2D();
-  
-  // If don't reuse data or the reused data has not yet been created
-  if (!(that->_flagTraining) || iSample < 0 ||
-    iSample >= GSetNbElem(&that->_reusedInput)) {
-    // Convert the image's pixels into the input VecFloat
-    input = VecFloatCreate(area * 3);
-    do {
-      GBPixel pix = GBGetFinalPixel(img, &pos);
-      long iPos = GBPosIndex(&pos, &dim);
-      for (int iRGB = 3; iRGB--;)
-        VecSet(input, iPos * 3 + iRGB, (float)(pix._rgba[iRGB]) / 255.0);
-    } while (VecStep(&pos, &dim));
-    // Add the converted input to the reusable data
-    if (that->_flagTraining && iSample >= 0) {
-      // Add a clone version because 'input' will be freed later,
-      // should be optimized to avoid the clone
-      GSetAppend((GSetVecFloat*)&(that->_reusedInput), VecClone(input));
-    }
-  // Else, we reuse data and this input has already been computed
-  } else {
-    // Reuse the data
-    // Use a clone because 'input' will be freed later, should be
-    // optimized to avoid the clone
-    input = VecClone(GSetGet(&(that->_reusedInput), iSample));
+  ISSetParams(that, GAAdnAdnI(adn), GAAdnAdnF(adn));
+}
+
+// Set the parameters of the criteria of the ImgSegmentor 'that' with 
+// the int parameters 'adnI' and float parameters 'adnF', in the order
+// of ISGetAdn ('adnI' or 'adnF' can be NULL if there is no such 
+// parameters)
+// The hash of the parameters of each criterion is chained with the one
+// of its parent, as its prediction depends on the parameters of all
+// its ancestors
+// The frozen criteria have no parameters in 'adnI' and 'adnF'
+void ISSetParams(ImgSegmentor* const that, const VecLong* const adnI,
+  const VecFloat* const adnF) {
+#if BUILDMODE == 0
+  if (that == NULL) {
+    PBImgAnalysisErr->_type = PBErrTypeNullPointer;
+    sprintf(PBImgAnalysisErr->_msg, "'that' is null");
+    PBErrCatch(PBImgAnalysisErr);
   }
-  // Declare a set to memorize the temporary inputs while moving
-  // through the tree of criteria
-  GSet inputs = GSetCreateStatic();
-  // Add the initial input to the set
-  GSetAppend(&inputs, input);
-  // Create a set to memorize the prediction of each leaf criterion
-  GSet leafPred = GSetCreateStatic();
-  // Loop on criteria
+#endif
+  // The contexts created before are outdated
+  that->_generation = ISNextGeneration();
+  long shiftParamInt = 0;
+  long shiftParamFloat = 0;
   GenTreeIterDepth iter = GenTreeIterDepthCreateStatic(ISCriteria(that));
   do {
-    // Get the criteria
-    ImgSegmentorCriterion* criterion = GenTreeIterGetData(&iter);
-    // Get the input on which to apply the criteria, this is the last
-    // pushed input
-    VecFloat* curInput = GSetTail(&inputs);
-    // Do the prediction
-    VecFloat* pred = NULL;
-    if (that->_flagTraining) {
-      pred = ISCPredictWithReuse(criterion, curInput, &dim, iSample);
-    } else {
-      pred = ISCPredict(criterion, curInput, &dim);
+    ImgSegmentorCriterion* crit = GenTreeIterGetData(&iter);
+    // The parameters of a frozen criterion are not in the adn
+    if (!ISCIsFrozen(crit)) {
+      ISCSetAdnInt(crit, adnI, shiftParamInt);
+      ISCSetAdnFloat(crit, adnF, shiftParamFloat);
     }
-    // If this criterion is a leaf in the tree of crieria
-    if (GenTreeIsLeaf(GenTreeIterGetGenTree(&iter))) {
-      // Add the result of the prediction to the set of final prediction
-      GSetAppend(&leafPred, pred);
-      // If the criterion is a last brother
-      if (GenTreeIsLastBrother(GenTreeIterGetGenTree(&iter))) {
-        // Drop and free the intermediate input
-        (void)GSetDrop(&inputs);
-        VecFree(&curInput);
-        // In case the parent was the last brother it will be skipped
-        // back by the GenTreeIterDepth and we need to drop its input
-        // right away
-        GenTree* parent = GenTreeParent(GenTreeIterGetGenTree(&iter));
-        while (parent != NULL && GenTreeIsLastBrother(parent)) {
-          curInput = GSetDrop(&inputs);
-          VecFree(&curInput);
-          parent = GenTreeParent(parent);
-        }
+    uint64_t hash = 0xCBF29CE484222325ULL;
+    const ImgSegmentorCriterion* parentCrit = NULL;
+    GenTree* parent = GenTreeParent(GenTreeIterGetGenTree(&iter));
+    if (parent != NULL && GenTreeData(parent) != NULL) {
+      parentCrit = GenTreeData(parent);
+      hash = parentCrit->_paramHash;
+    }
+    long nbInt = ISCGetNbTrainedParamInt(crit);
+    long nbFloat = ISCGetNbTrainedParamFloat(crit);
+    crit->_paramHash = ISHashAdnSlice(adnI, adnF, hash, shiftParamInt, 
+      nbInt, shiftParamFloat, nbFloat);
+    // Pack the parameters after the ones of the ancestors, they are
+    // the full key of the predictions of the criterion in the cache
+    size_t sizeParent = 
+      (parentCrit != NULL ? parentCrit->_sizeParamKey : 0);
+    size_t sizeKey = 
+      sizeParent + sizeof(long) * nbInt + sizeof(float) * nbFloat;
+    free(crit->_paramKey);
+    crit->_paramKey = NULL;
+    if (sizeKey > 0) {
+      crit->_paramKey = PBErrMalloc(PBImgAnalysisErr, sizeKey);
+      if (sizeParent > 0)
+        memcpy(crit->_paramKey, parentCrit->_paramKey, sizeParent);
+      unsigned char* ptr = crit->_paramKey + sizeParent;
+      for (long i = 0; i < nbInt; ++i, ptr += sizeof(long)) {
+        long val = VecGet(adnI, shiftParamInt + i);
+        memcpy(ptr, &val, sizeof(long));
+      }
+      for (long i = 0; i < nbFloat; ++i, ptr += sizeof(float)) {
+        float val = VecGet(adnF, shiftParamFloat + i);
+        memcpy(ptr, &val, sizeof(float));
       }
-    // Else the criterion is a node in the tree
-    } else {
-      // Append the result of prediction to the intermediate input
-      GSetAppend(&inputs, pred);
     }
-  } while(GenTreeIterStep(&iter));
+    crit->_sizeParamKey = sizeKey;
+    shiftParamInt += nbInt;
+    shiftParamFloat += nbFloat;
+  } while (GenTreeIterStep(&iter));
   GenTreeIterFreeStatic(&iter);
-  // Create temporary vectors to memorize the combined predictions
-  VecFloat* combPred = VecFloatCreate(area * ISGetNbClass(that));
-  VecFloat* finalPred = VecFloatCreate(area * ISGetNbClass(that));
-  // Combine the predictions over criteria
-  // The combination is the weighted average of prediction over criteria
-  // where the weight is the absolute value of the prediction
-  for (long i = area * (long)ISGetNbClass(that); i--;) {
-    float sumWeight = 0.0;
-    GSetIterForward iter = GSetIterForwardCreateStatic(&leafPred);
-    do {
-      VecFloat* pred = GSetIterGet(&iter);
-      float v = VecGet(pred, i);
-      VecSetAdd(combPred, i, v * fabs(v));
-      sumWeight += fabs(v);
-    } while (GSetIterStep(&iter));
-    if (sumWeight > PBMATH_EPSILON)
-      VecSet(combPred, i, VecGet(combPred, i) / sumWeight);
-    else
-      VecSet(combPred, i, 0.0);
+}
+
+// Copy the current parameters of the criteria of the ImgSegmentor 
+// 'that' in 'adnI' and 'adnF', in the order of ISSetAdn
+void ISGetAdn(const ImgSegmentor* const that, VecLong* const adnI, 
+  VecFloat* const adnF) {
+#if BUILDMODE == 0
+  if (that == NULL) {
+    PBImgAnalysisErr->_type = PBErrTypeNullPointer;
+    sprintf(PBImgAnalysisErr->_msg, "'that' is null");
+    PBErrCatch(PBImgAnalysisErr);
   }
-  // Combine the predictions over classes
-  // The combination is calculated as follow:
-  // finalPred(i) = (pred(i)*abs(combPred(i) - sum_{j!=i} 
-  //   combPred(j)*abs(combPred(j)) / (sum_i abs(combPred(i))
-  VecSetNull(&pos);
+  if (adnI == NULL) {
+    PBImgAnalysisErr->_type = PBErrTypeNullPointer;
+    sprintf(PBImgAnalysisErr->_msg, "'adnI' is null");
+    PBErrCatch(PBImgAnalysisErr);
+  }
+  if (adnF == NULL) {
+    PBImgAnalysisErr->_type = PBErrTypeNullPointer;
+    sprintf(PBImgAnalysisErr->_msg, "'adnF' is null");
+    PBErrCatch(PBImgAnalysisErr);
+  }
+#endif
+  if (ISGetNbCriterion(that) == 0)
+    return;
+  long shiftParamInt = 0;
+  long shiftParamFloat = 0;
+  GenTreeIterDepth iter = GenTreeIterDepthCreateStatic(ISCriteria(that));
   do {
-    for (long iClass = ISGetNbClass(that); iClass--;) {
-      float sumWeight = 0.0;
-      long iPos = GBPosIndex(&pos, &dim) * ISGetNbClass(that) + iClass;
-      for (long jClass = ISGetNbClass(that); jClass--;) {
-        long jPos = GBPosIndex(&pos, &dim) * ISGetNbClass(that) + jClass;
-        float v = VecGet(combPred, jPos);
-        if (iClass == jClass) {
-          VecSetAdd(finalPred, iPos, v * fabs(v));
-        } else {
-          VecSetAdd(finalPred, iPos, -1.0 * v * fabs(v));
-        }
-        sumWeight += fabs(v);
+    const ImgSegmentorCriterion* crit = GenTreeIterGetData(&iter);
+    if (!ISCIsFrozen(crit)) {
+      ISCGetAdnInt(crit, adnI, shiftParamInt);
+      ISCGetAdnFloat(crit, adnF, shiftParamFloat);
+    }
+    shiftParamInt += ISCGetNbTrainedParamInt(crit);
+    shiftParamFloat += ISCGetNbTrainedParamFloat(crit);
+  } while (GenTreeIterStep(&iter));
+  GenTreeIterFreeStatic(&iter);
+}
+
+// Seed the initialised population of the GenAlg 'ga' with the current
+// parameters of the criteria of the ImgSegmentor 'that', among 
+// 'nbParamInt' int and 'nbParamFloat' float parameters
+// The elites get the current parameters and the other entities get 
+// them mutated by up to IS_WARMSTARTMUTATION of the range of their
+// bounds
+void ISTrainWarmStart(const ImgSegmentor* const that, GenAlg* const ga,
+  const long nbParamInt, const long nbParamFloat) {
+  // Get the current parameters
+  VecLong* curAdnI = VecLongCreate(nbParamInt > 0 ? nbParamInt : 1);
+  VecFloat* curAdnF = VecFloatCreate(nbParamFloat > 0 ? nbParamFloat : 1);
+  ISGetAdn(that, curAdnI, curAdnF);
+  // Loop on the entities
+  for (int iEnt = 0; iEnt < GAGetNbAdns(ga); ++iEnt) {
+    GenAlgAdn* adn = GAAdn(ga, iEnt);
+    bool flagElite = (iEnt < GAGetNbElites(ga));
+    for (long iParam = 0; iParam < nbParamInt; ++iParam) {
+      long val = VecGet(curAdnI, iParam);
+      if (!flagElite) {
+        const VecLong2D* bounds = GABoundsAdnInt(ga, iParam);
+        long range = VecGet(bounds, 1) - VecGet(bounds, 0);
+        val += (long)round((rnd() * 2.0 - 1.0) * 
+          IS_WARMSTARTMUTATION * (float)range);
+        if (val < VecGet(bounds, 0))
+          val = VecGet(bounds, 0);
+        if (val > VecGet(bounds, 1))
+          val = VecGet(bounds, 1);
       }
-      if (sumWeight > PBMATH_EPSILON)
-        VecSet(finalPred, iPos, VecGet(finalPred, iPos) / sumWeight);
-      else
-        VecSet(finalPred, iPos, 0.0);
+      VecSet(adn->_adnI, iParam, val);
     }
-  } while(VecStep(&pos, &dim));
-  // Allocate memory for the results
-  GenBrush** res = PBErrMalloc(PBImgAnalysisErr, 
-    sizeof(GenBrush*) * ISGetNbClass(that));
-  // Declare a variable to convert the prediction into pixel
-  GBPixel pix = GBColorWhite;
+    for (long iParam = 0; iParam < nbParamFloat; ++iParam) {
+      float val = VecGet(curAdnF, iParam);
+      if (!flagElite) {
+        const VecFloat2D* bounds = GABoundsAdnFloat(ga, iParam);
+        float range = VecGet(bounds, 1) - VecGet(bounds, 0);
+        val += (rnd() * 2.0 - 1.0) * IS_WARMSTARTMUTATION * range;
+        if (val < VecGet(bounds, 0))
+          val = VecGet(bounds, 0);
+        if (val > VecGet(bounds, 1))
+          val = VecGet(bounds, 1);
+      }
+      VecSet(adn->_adnF, iParam, val);
+    }
+  }
+  // Free memory
+  VecFree(&curAdnI);
+  VecFree(&curAdnF);
+}
+
+// Report the new best value 'bestValue' of the training of the 
+// ImgSegmentor 'that' on the dataset 'dataset' with the GenAlg 'ga',
+// the criteria of 'that' must be set with the best adn
+// Evaluate 'that' on the validation category if any, send the email
+// notification if any and give the checkpoint to the writer 'writer'
+// The checkpoint is ranked by its value on the validation category if
+// any, else by 'bestValue'
+void ISTrainReportNewBest(ImgSegmentor* const that, 
+  const GDataSetGenBrushPair* const dataset, const GenAlg* const ga,
+  const float bestValue, PBMailer* const mailer, 
+  ISCheckpointWriter* const writer) {
+  char str[100];
+  int iStr = 0;
+  sprintf(str, "Epoch %05ld/%05u ", 
+    GAGetCurEpoch(ga), ISGetNbEpoch(that) - 1);
+  iStr = strlen(str);
+  sprintf(str + iStr, "TrainAcc[0,1] %f/%f ", bestValue, 
+    ISGetTargetBestValue(that));
+  iStr = strlen(str);
+  // If the dataset has an evaluation category
+  float evalValue = 0.0;
+  if (GDSGetNbCat(dataset) > 1) {
+    // Evaluate the new best entity on the validation category
+    const int iCatValid = 1;
+    evalValue = ISEvaluate(that, dataset, iCatValid);
+    sprintf(str + iStr, "EvalAcc[0,1] %f ", evalValue);
+    iStr = strlen(str);
+  }
+  time_t improvTime = time(NULL);
+  char* strImprovTime = ctime(&improvTime);
+  sprintf(str + iStr, "on %s", strImprovTime);
+  printf("%s", str);
+  fflush(stdout);
+  // Send an email if necessary
+  if (ISGetEmailNotification(that) != NULL) {
+    PBMailerAddStr(mailer, str);
+    PBMailerSend(mailer, ISGetEmailSubject(that));
+  }
+  // Snapshot the ImgSegmentor in memory, the checkpoint is written by
+  // the thread of the writer
+  char cpFilename[200];
+  if (GDSGetNbCat(dataset) > 1) {
+    sprintf(cpFilename, "%05ld_%f_%f_" IS_CHECKPOINTFILENAME, GAGetCurEpoch(ga) + 1L, bestValue, evalValue);
+  } else {
+    sprintf(cpFilename, "%05ld_%f_" IS_CHECKPOINTFILENAME, 
+      GAGetCurEpoch(ga) + 1L, bestValue);
+  }
+  char* data = NULL;
+  size_t size = 0;
+  FILE* stream = open_memstream(&data, &size);
+  bool ret = (stream != NULL && ISSave(that, stream, false));
+  if (stream != NULL)
+    ret = (fclose(stream) == 0 && ret);
+  if (ret) {
+    float cpValue = (GDSGetNbCat(dataset) > 1 ? evalValue : bestValue);
+    ISCWAdd(writer, cpFilename, cpValue, data, size);
+  } else {
+    fprintf(stderr, "Couldn't save the checkpoint %s\n",  
+      cpFilename);
+    free(data);
+  }
+}
+
+// Copy the parameters of the adn 'adn' in 'adnF' and 'adnI', 
+// replacing their previous values
+void ISTrainSnapshotAdn(const GenAlgAdn* const adn, VecFloat** adnF, 
+  VecLong** adnI) {
+  VecFree(adnF);
+  VecFree(adnI);
+  if (GAAdnAdnF(adn) != NULL)
+    *adnF = VecClone(GAAdnAdnF(adn));
+  if (GAAdnAdnI(adn) != NULL)
+    *adnI = VecClone(GAAdnAdnI(adn));
+}
+
+// Return the next seed of the random generator drawn from the 
+// generator of the seeds 'rng' (splitmix64)
+// The random generator is reseeded at the beginning of each epoch of
+// the training, so that its state can be saved in the training state
+// without depending on the internals of random()
+unsigned int ISTrainNextSeed(uint64_t* const rng) {
+  *rng += 0x9E3779B97F4A7C15ULL;
+  uint64_t z = *rng;
+  z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+  z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+  return (unsigned int)((z ^ (z >> 31)) >> 32);
+}
+
+// Save in the file of the training state of the ImgSegmentor 'that' 
+// the GenAlg 'ga', the best value 'bestValue' and parameters 
+// 'bestAdnF' and 'bestAdnI' (can be NULL) among the 'nbParamInt' int 
+// and 'nbParamFloat' float parameters, and the state 'rngSeed' of the
+// generator of the seeds of the epochs, see ISTrainNextSeed
+// Return true upon success else false
+bool ISTrainSaveState(const ImgSegmentor* const that, 
+  const GenAlg* const ga, const float bestValue, 
+  const VecFloat* const bestAdnF, const VecLong* const bestAdnI, 
+  const long nbParamInt, const long nbParamFloat, 
+  const uint64_t rngSeed) {
+#if BUILDMODE == 0
+  if (that == NULL) {
+    PBImgAnalysisErr->_type = PBErrTypeNullPointer;
+    sprintf(PBImgAnalysisErr->_msg, "'that' is null");
+    PBErrCatch(PBImgAnalysisErr);
+  }
+  if (ga == NULL) {
+    PBImgAnalysisErr->_type = PBErrTypeNullPointer;
+    sprintf(PBImgAnalysisErr->_msg, "'ga' is null");
+    PBErrCatch(PBImgAnalysisErr);
+  }
+  if (ISGetTrainStatePath(that) == NULL) {
+    PBImgAnalysisErr->_type = PBErrTypeInvalidArg;
+    sprintf(PBImgAnalysisErr->_msg, "'that' has no training state path");
+    PBErrCatch(PBImgAnalysisErr);
+  }
+#endif
+  // Set the header
+  ISTrainStateHeader header;
+  memset(&header, 0, sizeof(ISTrainStateHeader));
+  memcpy(header._magic, IS_TRAINSTATEMAGIC, sizeof(header._magic));
+  header._version = IS_TRAINSTATEVERSION;
+  header._nbParamInt = nbParamInt;
+  header._nbParamFloat = nbParamFloat;
+  header._bestValue = bestValue;
+  header._flagBestAdnI = (bestAdnI != NULL);
+  header._flagBestAdnF = (bestAdnF != NULL);
+  header._rngSeed = rngSeed;
+  // Encode the training state in memory
+  char* data = NULL;
+  size_t size = 0;
+  FILE* stream = open_memstream(&data, &size);
+  if (stream == NULL)
+    return false;
+  bool ret = 
+    (fwrite(&header, sizeof(ISTrainStateHeader), 1, stream) == 1);
+  if (bestAdnF != NULL) {
+    for (long i = 0; ret && i < VecGetDim(bestAdnF); ++i) {
+      float val = VecGet(bestAdnF, i);
+      ret = (fwrite(&val, sizeof(float), 1, stream) == 1);
+    }
+  }
+  if (bestAdnI != NULL) {
+    for (long i = 0; ret && i < VecGetDim(bestAdnI); ++i) {
+      int64_t val = VecGet(bestAdnI, i);
+      ret = (fwrite(&val, sizeof(int64_t), 1, stream) == 1);
+    }
+  }
+  ret = (ret && GASave(ga, stream, true));
+  ret = (fclose(stream) == 0 && ret);
+  // Write the training state with an atomic rename, so that a previous
+  // training state stays valid if the training is interrupted while 
+  // writing
+  if (ret) {
+    ISCheckpoint state = {._path = that->_trainStatePath, 
+      ._value = bestValue, ._data = data, ._size = size};
+    ret = ISCheckpointWrite(&state);
+  }
+  free(data);
+  return ret;
+}
+
+// Load the training state 'that' from the stream 'stream' if it 
+// matches 'nbParamInt' int and 'nbParamFloat' float parameters
+// Return true upon success else false
+bool ISTrainLoadState(ISTrainState* const that, FILE* const stream,
+  const long nbParamInt, const long nbParamFloat) {
+#if BUILDMODE == 0
+  if (that == NULL) {
+    PBImgAnalysisErr->_type = PBErrTypeNullPointer;
+    sprintf(PBImgAnalysisErr->_msg, "'that' is null");
+    PBErrCatch(PBImgAnalysisErr);
+  }
+  if (stream == NULL) {
+    PBImgAnalysisErr->_type = PBErrTypeNullPointer;
+    sprintf(PBImgAnalysisErr->_msg, "'stream' is null");
+    PBErrCatch(PBImgAnalysisErr);
+  }
+#endif
+  that->_ga = NULL;
+  that->_bestValue = 0.0;
+  that->_bestAdnF = NULL;
+  that->_bestAdnI = NULL;
+  // Read and check the header
+  ISTrainStateHeader header;
+  if (fread(&header, sizeof(ISTrainStateHeader), 1, stream) != 1 ||
+    memcmp(header._magic, IS_TRAINSTATEMAGIC, sizeof(header._magic)) 
+      != 0 ||
+    header._version != IS_TRAINSTATEVERSION ||
+    header._nbParamInt != nbParamInt || 
+    header._nbParamFloat != nbParamFloat)
+    return false;
+  that->_bestValue = header._bestValue;
+  that->_rngSeed = header._rngSeed;
+  // Read the parameters of the best entity
+  bool ret = true;
+  if (header._flagBestAdnF) {
+    that->_bestAdnF = VecFloatCreate(nbParamFloat);
+    for (long i = 0; ret && i < nbParamFloat; ++i) {
+      float val = 0.0;
+      ret = (fread(&val, sizeof(float), 1, stream) == 1);
+      VecSet(that->_bestAdnF, i, val);
+    }
+  }
+  if (header._flagBestAdnI) {
+    that->_bestAdnI = VecLongCreate(nbParamInt);
+    for (long i = 0; ret && i < nbParamInt; ++i) {
+      int64_t val = 0;
+      ret = (fread(&val, sizeof(int64_t), 1, stream) == 1);
+      VecSet(that->_bestAdnI, i, val);
+    }
+  }
+  // Read the GenAlg
+  ret = (ret && GALoad(&(that->_ga), stream));
+  if (!ret)
+    ISTrainStateFreeStatic(that);
+  return ret;
+}
+
+// Free the memory used by the training state 'that'
+void ISTrainStateFreeStatic(ISTrainState* const that) {
+  if (that == NULL)
+    return;
+  if (that->_ga != NULL)
+    GenAlgFree(&(that->_ga));
+  VecFree(&(that->_bestAdnF));
+  VecFree(&(that->_bestAdnI));
+}
+
+// Create the masks of the sample 'sample' for the ImgSegmentor 
+// 'that' as an array of ImgBitMask, one per class, with bits set to 1
+// where the mask is black
+ImgBitMask** ISCreateBitMasks(const ImgSegmentor* const that, 
+  const GDSGenBrushPair* const sample) {
+#if BUILDMODE == 0
+  if (that == NULL) {
+    PBImgAnalysisErr->_type = PBErrTypeNullPointer;
+    sprintf(PBImgAnalysisErr->_msg, "'that' is null");
+    PBErrCatch(PBImgAnalysisErr);
+  }
+#endif
+  // Allocate memory for the masks
+  ImgBitMask** masks = PBErrMalloc(PBImgAnalysisErr, 
+    sizeof(ImgBitMask*) * ISGetNbClass(that));
+  // Declare a variable to memorize the color of the mask
+  const GBPixel rgbaMask = GBColorBlack; 
   // Loop on classes
   for (int iClass = ISGetNbClass(that); iClass--;) {
-    // Create the result GenBrush
-    res[iClass] = GBCreateImage(&dim);
-    // Add a layer to the result GenBrush
-    GBLayer* layer = GBAddLayer(res[iClass], &dim);
-    // Loop on position in the image
-    VecSetNull(&pos);
-    do {
-      // Get the prediction value for this class and this position
-      // and convert it to rgb value
-      long iPos = GBPosIndex(&pos, &dim);
-      float p = VecGet(finalPred, iPos * ISGetNbClass(that) + iClass);
-      if (ISGetFlagBinaryResult(that)) {
-        if (p > ISGetThresholdBinaryResult(that))
-          p = 1.0;
-        else
-          p = -1.0;
-      }
-      unsigned char pChar = 255 - 
-        (unsigned char)round(255.0 * (p * 0.5 + 0.5));
-      // Convert the prediction to a pixel
-      pix._rgba[GBPixelRed] = pix._rgba[GBPixelGreen] = 
-        pix._rgba[GBPixelBlue] = pChar;
-      // Set the pixel in the layer
-      GBLayerAddPixel(
-        layer, 
-        &pos, 
-        &pix, 
-        0.0);
-    } while (VecStep(&pos, &dim));
-    // Render the final pixels in the result image
-    GBSurfaceUpdate(GBSurf(res[iClass]));
-    GBUpdate(res[iClass]);
+#if BUILDMODE == 0
+    if (!VecIsEqual(GBDim(sample->_mask[iClass]), GBDim(sample->_img))) {
+      PBImgAnalysisErr->_type = PBErrTypeInvalidArg;
+      sprintf(PBImgAnalysisErr->_msg, 
+        "the mask and the image have different dimensions");
+      PBErrCatch(PBImgAnalysisErr);
+    }
+#endif
+    // Pack the mask into bits
+    masks[iClass] = 
+      ImgBitMaskCreateFromGenBrush(sample->_mask[iClass], &rgbaMask);
+  }
+  // Return the masks
+  return masks;
+}
+
+// Free the array of ImgBitMask 'masks' created by ISCreateBitMasks 
+// for the ImgSegmentor 'that'
+void ISFreeBitMasks(const ImgSegmentor* const that, 
+  ImgBitMask*** const masks) {
+  if (masks == NULL || *masks == NULL)
+    return;
+  for (int iClass = ISGetNbClass(that); iClass--;)
+    ImgBitMaskFree(*masks + iClass);
+  free(*masks);
+  *masks = NULL;
+}
+
+// Evaluate the ImgSegmentor 'that' on the sample 'sample' with 
+// 'nbMask' masks. Try to reuse the data associated with the sample 
+// 'iSample' (-1 to not reuse the data)
+// The prediction is directly compared to the bit masks, without
+// rendering any GenBrush
+// Return the sum of the intersection over union of each class divided
+// by 'nbMask'
+float ISEvaluateSample(ImgSegmentor* const that, 
+  const GDSGenBrushPair* const sample, const long iSample, 
+  const int nbMask) {
+  // Get the bit masks, reuse them if possible
+  ImgBitMask** masks = NULL;
+  bool flagReuse = that->_flagTraining && iSample >= 0;
+  if (flagReuse && iSample < GSetNbElem(&(that->_reusedMask))) {
+    masks = GSetGet(&(that->_reusedMask), iSample);
+  } else {
+    masks = ISCreateBitMasks(that, sample);
+    // The reused masks can't be added anymore once they are shared by
+    // the workers of a parallel training, the masks are then freed 
+    // after use
+    if (flagReuse && !ISRCIsReadOnly(that->_reuseCache))
+      GSetAppend(&(that->_reusedMask), masks);
+    else
+      flagReuse = false;
   }
+  // Get the bit masks of the detections, reuse the ones of the 
+  // previous evaluation if they have the dimensions of the sample
+  VecShort2D dim = GBGetDim(sample->_img);
+  if (that->_detect != NULL && 
+    VecIsEqual(IBMDim(that->_detect[0]), &dim)) {
+    for (int iClass = ISGetNbClass(that); iClass--;)
+      IBMReset(that->_detect[iClass]);
+  } else {
+    ISFreeBitMasks(that, &(that->_detect));
+    that->_detect = PBErrMalloc(PBImgAnalysisErr, 
+      sizeof(ImgBitMask*) * ISGetNbClass(that));
+    for (int iClass = ISGetNbClass(that); iClass--;)
+      that->_detect[iClass] = ImgBitMaskCreate(&dim);
+  }
+  // Do the prediction and compare it with the masks, the scores 
+  // themselves are not needed
+  float* iou = PBErrMalloc(PBImgAnalysisErr, 
+    sizeof(float) * ISGetNbClass(that));
+  (void)_ISPredictScores(that, sample->_img, (int)iSample, NULL, 
+    NULL, NULL, masks, that->_detect, iou);
+  float valMask = 0.0;
+  for (int iClass = ISGetNbClass(that); iClass--;)
+    valMask += iou[iClass];
   // Free memory
-  while (GSetNbElem(&leafPred) > 0) {
-    VecFloat* pred = GSetPop(&leafPred);
-    VecFree(&pred);
+  free(iou);
+  if (!flagReuse)
+    ISFreeBitMasks(that, &masks);
+  // Return the result
+  return valMask / (float)nbMask;
+}
+
+// Return the sample 'iSample' of the training category of the dataset
+// of the pool 'pool', loaded for the calling worker
+// The iterator of the dataset is shared by the workers, it is moved 
+// and the sample is loaded under the mutex of the pool
+// The returned sample must be freed by the user
+GDSGenBrushPair* ISTrainPoolGetSample(ImgSegmentorTrainPool* const pool,
+  const long iSample) {
+  pthread_mutex_lock(&(pool->_mutex));
+  if (iSample < pool->_iSampleDataset) {
+    GDSReset(pool->_dataset, 0);
+    pool->_iSampleDataset = 0;
+  }
+  while (pool->_iSampleDataset < iSample) {
+    (void)GDSStepSample(pool->_dataset, 0);
+    ++(pool->_iSampleDataset);
+  }
+  GDSGenBrushPair* sample = GDSGetSample(pool->_dataset, 0);
+  pthread_mutex_unlock(&(pool->_mutex));
+  return sample;
+}
+
+// Evaluate the ImgSegmentor 'that' on the samples of the training 
+// category of the pool 'pool', reusing the data of 'that' during 
+// training
+// Give up the evaluation as soon as the result can't be greater than
+// the threshold of the pool, which may be updated by other threads 
+// during the evaluation
+// Return a value in [0.0, 1.0], 0.0 being worst and 1.0 being best
+float ISEvaluateSamples(ImgSegmentor* const that, 
+  ImgSegmentorTrainPool* const pool) {
+  // Declare a variable to memorize the result value
+  float value = 0.0;
+  // Declare a variable to compute the skip condition
+  float minVal = 0.0;
+  // Loop on the samples
+  long iSample = 0;
+  do {
+    // Do the prediction on the sample and check it against the masks
+    GDSGenBrushPair* sample = ISTrainPoolGetSample(pool, iSample);
+    value += ISEvaluateSample(that, sample, iSample, pool->_nbMask);
+    GDSGenBrushPairFree(&sample);
+    ++iSample;
+    // Get the value under which we can skip the remaining samples
+    // with the latest threshold
+    minVal = iSample + 
+      (float)(pool->_nbSample) * (atomic_load(&(pool->_threshold)) - 1.0);
+  } while (iSample < pool->_nbSample && !PBIA_CtrlC && value >= minVal);
+  // Get the average value over all samples
+  value /= (float)(pool->_nbSample);
+  // Return the result of the evaluation
+  return value;
+}
+
+// Evaluate the entities of the current round for the worker 'worker'
+// Pull the next entity to evaluate from the pool until there is no 
+// more entity or the evaluation is stopped
+void ISTrainWorkerEvaluate(ImgSegmentorTrainWorker* const worker) {
+  ImgSegmentorTrainPool* pool = worker->_pool;
+  ImgSegmentor* segmentor = &(worker->_segmentor);
+  while (!atomic_load(&(pool->_flagStop)) && !PBIA_CtrlC) {
+    // Get the next entity, the entities are dispatched one by one to
+    // the first available thread to balance the uneven cost of 
+    // evaluations with early exit
+    long i = atomic_fetch_add(&(pool->_next), 1);
+    if (i >= pool->_nbEnt)
+      break;
+    // Set the criteria with this entity's adn and evaluate them
+    ISSetAdn(segmentor, GAAdn(pool->_ga, pool->_iEnts[i]));
+    float value = ISEvaluateSamples(segmentor, pool);
+    pool->_values[i] = value;
+    pool->_flagEvaluated[i] = true;
+    // Update the threshold with this value
+    pthread_mutex_lock(&(pool->_mutex));
+    GSetAddSort(pool->_setVal, NULL, -1.0 * value);
+    if (GSetNbElem(pool->_setVal) >= GAGetNbElites(pool->_ga)) {
+      float threshold = -1.0 * GSetElemGetSortVal(
+        GSetElement(pool->_setVal, GAGetNbElites(pool->_ga) - 1));
+      atomic_store(&(pool->_threshold), threshold);
+    }
+    pthread_mutex_unlock(&(pool->_mutex));
+    // Stop the evaluation if this entity reaches the target
+    if (value >= ISGetTargetBestValue(segmentor))
+      atomic_store(&(pool->_flagStop), true);
+  }
+}
+
+// Main function of the threads of the workers of the training
+// The threads stay alive during the whole training, they wait for 
+// the start of each round of evaluation and evaluate its entities, 
+// until the end of the threads is requested
+void* ISTrainWorkerMain(void* arg) {
+  ImgSegmentorTrainWorker* worker = arg;
+  ImgSegmentorTrainPool* pool = worker->_pool;
+  long round = 0;
+  pthread_mutex_lock(&(pool->_mutex));
+  while (true) {
+    // Wait for the next round
+    while (pool->_round == round && !(pool->_flagExit))
+      pthread_cond_wait(&(pool->_condStart), &(pool->_mutex));
+    if (pool->_flagExit)
+      break;
+    round = pool->_round;
+    // Evaluate the entities without holding the mutex
+    pthread_mutex_unlock(&(pool->_mutex));
+    ISTrainWorkerEvaluate(worker);
+    pthread_mutex_lock(&(pool->_mutex));
+    // Signal the end of the round if this is the last thread
+    --(pool->_nbRunning);
+    if (pool->_nbRunning == 0)
+      pthread_cond_signal(&(pool->_condEnd));
+  }
+  pthread_mutex_unlock(&(pool->_mutex));
+  return NULL;
+}
+
+// Create the worker 'worker' for the training of the ImgSegmentor 
+// 'that' with the pool 'pool'
+// The worker's ImgSegmentor is a clone of 'that' sharing its reused 
+// data, which must have been computed for all the samples
+void ISTrainWorkerInit(ImgSegmentorTrainWorker* const worker, 
+  const ImgSegmentor* const that, ImgSegmentorTrainPool* const pool) {
+  worker->_pool = pool;
+  // Clone 'that' through its JSON encoding
+  worker->_segmentor = ImgSegmentorCreateStatic(ISGetNbClass(that));
+  JSONNode* json = ISEncodeAsJSON(that);
+  if (!ISDecodeAsJSON(&(worker->_segmentor), json)) {
+    PBImgAnalysisErr->_type = PBErrTypeInvalidData;
+    sprintf(PBImgAnalysisErr->_msg, "Couldn't clone the ImgSegmentor");
+    PBErrCatch(PBImgAnalysisErr);
   }
+  JSONFree(&json);
+  worker->_segmentor._flagTraining = true;
+  // Share the reused data, they are only read once computed
+  worker->_segmentor._reusedInput = that->_reusedInput;
+  worker->_segmentor._reusedMask = that->_reusedMask;
+  worker->_segmentor._predCache = that->_predCache;
+  worker->_segmentor._reuseCache = that->_reuseCache;
+  GenTreeIterDepth iter = GenTreeIterDepthCreateStatic(ISCriteria(that));
+  GenTreeIterDepth iterClone = 
+    GenTreeIterDepthCreateStatic(ISCriteria(&(worker->_segmentor)));
   do {
-    VecFloat* curInput = GSetDrop(&inputs);
-    VecFree(&curInput);
-  } while (GSetNbElem(&inputs) > 0);
-  VecFree(&finalPred);
-  VecFree(&combPred);
-  // Return the result
-  return res;
+    const ImgSegmentorCriterion* crit = GenTreeIterGetData(&iter);
+    ImgSegmentorCriterion* critClone = GenTreeIterGetData(&iterClone);
+    critClone->_reusedInput = crit->_reusedInput;
+    critClone->_frozenPred = crit->_frozenPred;
+    critClone->_reuseCache = crit->_reuseCache;
+    critClone->_featureCachePath = crit->_featureCachePath;
+    (void)GenTreeIterStep(&iterClone);
+  } while (GenTreeIterStep(&iter));
+  GenTreeIterFreeStatic(&iter);
+  GenTreeIterFreeStatic(&iterClone);
 }
 
-// Handler for the signal Ctrl-C
-void ISTrainHandlerCtrlC(int sig) {
-  (void)sig;
-  PBIA_CtrlC = true;
-  time_t intTime = time(NULL);
-  char* strIntTime = ctime(&intTime);
-  printf("\n%s!!! ISTrain Interrupted by Ctrl-C !!!\n", strIntTime);
-  fflush(stdout);
+// Free the memory used by the worker 'worker', without freeing the 
+// reused data shared with the trained ImgSegmentor
+void ISTrainWorkerFreeStatic(ImgSegmentorTrainWorker* const worker) {
+  worker->_segmentor._reusedInput = GSetCreateStatic();
+  worker->_segmentor._reusedMask = GSetCreateStatic();
+  worker->_segmentor._predCache = NULL;
+  worker->_segmentor._reuseCache = NULL;
+  GenTreeIterDepth iter = 
+    GenTreeIterDepthCreateStatic(ISCriteria(&(worker->_segmentor)));
+  do {
+    ImgSegmentorCriterion* crit = GenTreeIterGetData(&iter);
+    crit->_reusedInput = GSetCreateStatic();
+    crit->_frozenPred = GSetCreateStatic();
+    crit->_reuseCache = NULL;
+    crit->_featureCachePath = NULL;
+  } while (GenTreeIterStep(&iter));
+  GenTreeIterFreeStatic(&iter);
+  ImgSegmentorFreeStatic(&(worker->_segmentor));
 }
- 
+
 // Train the ImageSegmentor 'that' on the data set 'dataSet' using
 // the data of the first category in 'dataSet'. If the data set has a 
 // second category it will be used for validation
-// srandom must have been called before calling ISTrain
-void ISTrain(ImgSegmentor* const that, 
-  const GDataSetGenBrushPair* const dataset) {
+// If 'resume' is not null, the training continues from this training
+// state, whose GenAlg and best parameters are then owned by the 
+// training
+// The random generator uses its own state during the training, 
+// reseeded at each epoch by ISTrainNextSeed, and the one of the 
+// caller is put back untouched at the end
+void ISTrainCore(ImgSegmentor* const that, 
+  const GDataSetGenBrushPair* const dataset, 
+  ISTrainState* const resume) {
 #if BUILDMODE == 0
   if (that == NULL) {
     PBImgAnalysisErr->_type = PBErrTypeNullPointer;
@@ -832,6 +3944,23 @@ void ISTrain(ImgSegmentor* const that,
     return;
   // Set the flag to memorize we are under training
   that->_flagTraining = true;
+  // Flush the reused data of a previous training
+  ISFlushReusedData(that);
+  // Create the accounting of the reused data and share it with the 
+  // criteria
+  that->_reuseCache = ImgSegmentorReuseCacheCreate(ISGetReuseBudget(that));
+  GenTreeIterDepth iterCrit = 
+    GenTreeIterDepthCreateStatic(ISCriteria(that));
+  do {
+    ImgSegmentorCriterion* crit = GenTreeIterGetData(&iterCrit);
+    crit->_reuseCache = that->_reuseCache;
+    crit->_featureCachePath = ISGetFeatureCachePath(that);
+  } while (GenTreeIterStep(&iterCrit));
+  GenTreeIterFreeStatic(&iterCrit);
+  // Create the cache of predictions of the criteria
+  if (ISGetPredCacheBudget(that) > 0)
+    that->_predCache = ImgSegmentorPredCacheCreate(
+      ISGetPredCacheBudget(that));
   // Memorize the current flag for binarization of results
   bool curFlagBinary = ISGetFlagBinaryResult(that);
   // Turn on the binarization
@@ -844,27 +3973,46 @@ void ISTrain(ImgSegmentor* const that,
   // float parameters
   long nbTotalParamInt = 0;
   long nbTotalParamFloat = 0;
-  // Get the number of int and float parameters for each criterion
-  // and flush the reused data
+  // Get the number of int and float parameters for each criterion,
+  // none for the frozen ones, and flush the reused data
   int iCrit = 0;
   GenTreeIterDepth iter = GenTreeIterDepthCreateStatic(ISCriteria(that));
   do {
     ImgSegmentorCriterion* crit = GenTreeIterGetData(&iter);
-    long nb = ISCGetNbParamInt(crit);
+    long nb = ISCGetNbTrainedParamInt(crit);
     VecSet(nbParamInt, iCrit, nb);
     nbTotalParamInt += nb;
-    nb = ISCGetNbParamFloat(crit);
+    nb = ISCGetNbTrainedParamFloat(crit);
     VecSet(nbParamFloat, iCrit, nb);
     nbTotalParamFloat += nb;
     ImgSegmentorCriterionFlushReusedData(crit);
     ++iCrit;
   } while (GenTreeIterStep(&iter));
-  char cpFilename[200] = {'\0'};
   // If there are parameters
   if (nbTotalParamInt > 0 || nbTotalParamFloat > 0) {
-    // Create the GenAlg to search parameters' value
-    GenAlg* ga = GenAlgCreate(ISGetSizePool(that), ISGetNbElite(that), 
-      nbTotalParamFloat, nbTotalParamInt);
+    // Use a private state for the random generator. It is reseeded 
+    // from the generator of the seeds 'rngSeed', itself seeded with 
+    // one draw of the caller's generator, or restored from the resumed
+    // training
+    uint64_t rngSeed = 0;
+    if (resume != NULL)
+      rngSeed = resume->_rngSeed;
+    else
+      rngSeed = (uint64_t)random();
+    char rngState[IS_RNGSTATESIZE];
+    char* prevRngState = initstate(0, rngState, IS_RNGSTATESIZE);
+    if (resume == NULL)
+      srandom(ISTrainNextSeed(&rngSeed));
+    // Create the GenAlg to search parameters' value, or get the one
+    // of the resumed training
+    GenAlg* ga = NULL;
+    if (resume != NULL) {
+      ga = resume->_ga;
+      resume->_ga = NULL;
+    } else {
+      ga = GenAlgCreate(ISGetSizePool(that), ISGetNbElite(that), 
+        nbTotalParamFloat, nbTotalParamInt);
+    }
     
     GASetDiversityThreshold(ga, 0.001);  
     
@@ -877,18 +4025,40 @@ void ISTrain(ImgSegmentor* const that,
     long shiftParamFloat = 0;
     do {
       ImgSegmentorCriterion* crit = GenTreeIterGetData(&iter);
-      ISCSetBoundsAdnInt(crit, ga, shiftParamInt);
-      shiftParamInt += ISCGetNbParamInt(crit);
-      ISCSetBoundsAdnFloat(crit, ga, shiftParamFloat);
-      shiftParamFloat += ISCGetNbParamFloat(crit);
+      if (!ISCIsFrozen(crit)) {
+        ISCSetBoundsAdnInt(crit, ga, shiftParamInt);
+        ISCSetBoundsAdnFloat(crit, ga, shiftParamFloat);
+      }
+      shiftParamInt += ISCGetNbTrainedParamInt(crit);
+      shiftParamFloat += ISCGetNbTrainedParamFloat(crit);
     } while (GenTreeIterStep(&iter));
-    // Initialise the GenAlg
-    GAInit(ga);
+    // Initialise the GenAlg, the population of a resumed training is
+    // kept
+    if (resume == NULL)
+      GAInit(ga);
+    // Seed the population with the current parameters if requested
+    if (resume == NULL && ISGetFlagWarmStart(that))
+      ISTrainWarmStart(that, ga, nbTotalParamInt, nbTotalParamFloat);
     // Set the TextOMeter flag of the GenAlg same as the one of the 
     // ImgSegmentor
     GASetTextOMeterFlag(ga, ISGetFlagTextOMeter(that));
     // Declare a variable to memorize the current best value
     float bestValue = 0.0;
+    // Declare variables to memorize the parameters of the best entity,
+    // restored at the end of the training
+    VecFloat* bestAdnF = NULL;
+    VecLong* bestAdnI = NULL;
+    // Get the best entity of the resumed training
+    if (resume != NULL) {
+      bestValue = resume->_bestValue;
+      bestAdnF = resume->_bestAdnF;
+      bestAdnI = resume->_bestAdnI;
+      resume->_bestAdnF = NULL;
+      resume->_bestAdnI = NULL;
+    }
+    // Create the writer of checkpoints
+    ISCheckpointWriter* writer = ISCheckpointWriterCreate(
+      ISGetCheckpointKeepBest(that), ISGetCheckpointKeepLast(that));
     // Create a time estimator
     EstimTimeToComp etc = EstimTimeToCompCreateStatic();
     // Create a PBMailer for email notifications
@@ -897,25 +4067,49 @@ void ISTrain(ImgSegmentor* const that,
       mailer = PBMailerCreateStatic(ISGetEmailNotification(that));
     // Create a GSet to compute the threshold of ISEvaluateFast
     GSet setVal = GSetCreateStatic();
+    // Declare the variables for the evaluation in parallel of the
+    // entities. The workers are created once the reused data have 
+    // been computed by the first evaluation
+    int nbThread = ISGetNbThread(that);
+    ImgSegmentorTrainPool pool;
+    ImgSegmentorTrainWorker* workers = NULL;
+    if (nbThread > 1) {
+      // The samples of the training category are loaded by the 
+      // workers when they need them
+      pool._dataset = dataset;
+      pool._iSampleDataset = 0;
+      pool._nbSample = GDSGetSizeCat(dataset, 0);
+      pool._nbMask = GDSGetNbMask(dataset);
+      pool._ga = ga;
+      pool._setVal = &setVal;
+      pool._round = 0;
+      pool._nbRunning = 0;
+      pool._flagExit = false;
+      pthread_cond_init(&(pool._condStart), NULL);
+      pthread_cond_init(&(pool._condEnd), NULL);
+      pthread_mutex_init(&(pool._mutex), NULL);
+      pool._iEnts = NULL;
+      pool._values = NULL;
+      pool._flagEvaluated = NULL;
+    }
     // Loop over epochs
     do {
+      // Reseed the random generator, the seed only depends on the 
+      // epoch, hence a resumed training draws the same values
+      srandom(ISTrainNextSeed(&rngSeed));
+      // Declare a variable to memorize the new entity evaluated by this
+      // thread when the training is parallel
+      int iEntEvaluated = -1;
       // Loop over the GenAlg entities
       for (int iEnt = 0; iEnt < GAGetNbAdns(ga) && 
         bestValue < ISGetTargetBestValue(that) && !PBIA_CtrlC; ++iEnt) {
-        // If this entity is a new one
-        if (GAAdnIsNew(GAAdn(ga, iEnt))) {
-          // Loop on the criterion to set the criteria parameters with 
-          // this entity's adn
-          GenTreeIterReset(&iter);
-          shiftParamInt = 0;
-          shiftParamFloat = 0;
-          do {
-            ImgSegmentorCriterion* crit = GenTreeIterGetData(&iter);
-            ISCSetAdnInt(crit, GAAdn(ga, iEnt), shiftParamInt);
-            shiftParamInt += ISCGetNbParamInt(crit);
-            ISCSetAdnFloat(crit, GAAdn(ga, iEnt), shiftParamFloat);
-            shiftParamFloat += ISCGetNbParamFloat(crit);
-          } while (GenTreeIterStep(&iter));
+        // If this entity is a new one and it is evaluated by this 
+        // thread, i.e. training is sequential or it is the first 
+        // evaluation computing the reused data
+        if (GAAdnIsNew(GAAdn(ga, iEnt)) && 
+          (nbThread == 1 || workers == NULL)) {
+          // Set the criteria parameters with this entity's adn
+          ISSetAdn(that, GAAdn(ga, iEnt));
           // Update the info for the TexOMeter
           if (ISGetFlagTextOMeter(that)) {
             sprintf(that->_line1, IS_TRAINTXTOMETER_FORMAT1, 
@@ -936,8 +4130,11 @@ void ISTrain(ImgSegmentor* const that,
           }
           // Get the threshold value for ISEvaluateFast
           // This is the sort value of the nbElite-th element
+          // The evaluation before the creation of the workers has no 
+          // threshold to compute the reused data of all the samples,
+          // the elites of a resumed training would else give one
           float threshold = 0.0;
-          if (GSetNbElem(&setVal) >= GAGetNbElites(ga))
+          if (nbThread == 1 && GSetNbElem(&setVal) >= GAGetNbElites(ga))
             threshold = -1.0 * GSetElemGetSortVal(
               GSetElement(&setVal, GAGetNbElites(ga) - 1));
           // Evaluate the ImgSegmentor for this entity's adn on the 
@@ -949,84 +4146,165 @@ void ISTrain(ImgSegmentor* const that,
           GASetAdnValue(ga, GAAdn(ga, iEnt), value);
           // If the value is the best value
           if (value - bestValue > PBMATH_EPSILON) {
-            char str[100];
-            int iStr = 0;
             bestValue = value;
-            sprintf(str, "Epoch %05ld/%05u ", 
-              GAGetCurEpoch(ga), ISGetNbEpoch(that) - 1);
-            iStr = strlen(str);
-            sprintf(str + iStr, "TrainAcc[0,1] %f/%f ", bestValue, 
-              ISGetTargetBestValue(that));
-            iStr = strlen(str);
-            // If the dataset has an evaluation category
-            float evalValue = 0.0;
-            if (GDSGetNbCat(dataset) > 1) {
-              // Evaluate the new best entity on the validation category
-              const int iCatValid = 1;
-              evalValue = ISEvaluate(that, dataset, iCatValid);
-              sprintf(str + iStr, "EvalAcc[0,1] %f ", evalValue);
-              iStr = strlen(str);
-            }
-            time_t improvTime = time(NULL);
-            char* strImprovTime = ctime(&improvTime);
-            sprintf(str + iStr, "on %s", strImprovTime);
-            printf("%s", str);
-            fflush(stdout);
-            // Send an email if necessary
-            if (ISGetEmailNotification(that) != NULL) {
-              PBMailerAddStr(&mailer, str);
-              PBMailerSend(&mailer, ISGetEmailSubject(that));
-            }
-            // Save the ImgSegmentor
-            if (GDSGetNbCat(dataset) > 1) {
-              sprintf(cpFilename, "%05ld_%f_%f_" IS_CHECKPOINTFILENAME, GAGetCurEpoch(ga) + 1L, bestValue, evalValue);
-            } else {
-              sprintf(cpFilename, "%05ld_%f_" IS_CHECKPOINTFILENAME, 
-                GAGetCurEpoch(ga) + 1L, bestValue);
-            }
-            FILE* fpCheckpoint = fopen(cpFilename, "w");
-            if (!ISSave(that, fpCheckpoint, false)) {
-              fprintf(stderr, "Couldn't save the checkpoint %s\n",  
-                cpFilename);
-            }
-            fclose(fpCheckpoint);
+            ISTrainSnapshotAdn(GAAdn(ga, iEnt), &bestAdnF, &bestAdnI);
+            ISTrainReportNewBest(that, dataset, ga, bestValue, &mailer,
+              writer);
           }
+          // If the training is parallel, the reused data are now 
+          // computed and the workers can be created
+          if (nbThread > 1 && !PBIA_CtrlC) {
+            iEntEvaluated = iEnt;
+            // The reused data are shared by the workers and can't be 
+            // added anymore
+            ISRCSetReadOnly(that->_reuseCache, true);
+            workers = PBErrMalloc(PBImgAnalysisErr, 
+              sizeof(ImgSegmentorTrainWorker) * nbThread);
+            for (int iThread = nbThread; iThread--;)
+              ISTrainWorkerInit(workers + iThread, that, &pool);
+            // Create the threads of the workers, they wait for the 
+            // rounds of evaluation until the end of the training
+            // If a thread couldn't be created, its worker evaluates
+            // from the calling thread
+            for (int iThread = nbThread; iThread--;)
+              workers[iThread]._flagThread = 
+                (pthread_create(&(workers[iThread]._thread), NULL, 
+                ISTrainWorkerMain, workers + iThread) == 0);
+          }
+        // Else if this entity is a new one, it will be evaluated by the
+        // workers
+        } else if (GAAdnIsNew(GAAdn(ga, iEnt))) {
+          continue;
         }
         // Add the value of this entity to the set of values for the 
         // threshold of ISEvaluateFast, sorted from best to worst
         GSetAddSort(&setVal, NULL, -1.0 * GAAdnGetVal(GAAdn(ga, iEnt)));
       }
+      // If the training is parallel, evaluate the remaining new 
+      // entities with the workers
+      if (workers != NULL && bestValue < ISGetTargetBestValue(that) && 
+        !PBIA_CtrlC) {
+        // Get the new entities not evaluated yet
+        pool._iEnts = PBErrMalloc(PBImgAnalysisErr, 
+          sizeof(int) * GAGetNbAdns(ga));
+        pool._nbEnt = 0;
+        for (int iEnt = 0; iEnt < GAGetNbAdns(ga); ++iEnt)
+          if (GAAdnIsNew(GAAdn(ga, iEnt)) && iEnt != iEntEvaluated)
+            pool._iEnts[pool._nbEnt++] = iEnt;
+        pool._values = PBErrMalloc(PBImgAnalysisErr, 
+          sizeof(float) * (pool._nbEnt + 1));
+        pool._flagEvaluated = PBErrMalloc(PBImgAnalysisErr, 
+          sizeof(bool) * (pool._nbEnt + 1));
+        memset(pool._flagEvaluated, 0, sizeof(bool) * (pool._nbEnt + 1));
+        atomic_store(&(pool._next), 0);
+        atomic_store(&(pool._flagStop), false);
+        float threshold = 0.0;
+        if (GSetNbElem(&setVal) >= GAGetNbElites(ga))
+          threshold = -1.0 * GSetElemGetSortVal(
+            GSetElement(&setVal, GAGetNbElites(ga) - 1));
+        atomic_store(&(pool._threshold), threshold);
+        // Update the info for the TexOMeter
+        if (ISGetFlagTextOMeter(that)) {
+          sprintf(that->_line1, IS_TRAINTXTOMETER_FORMAT1, 
+            GAGetCurEpoch(ga), (long int)ISGetNbEpoch(that) - 1, 
+            (int)pool._nbEnt, GAGetNbAdns(ga) - 1);
+          ISUpdateTextOMeter(that);
+        }
+        // Start a round for the threads of the workers, the iterator 
+        // of the dataset has been moved by the calling thread since the 
+        // previous round
+        pthread_mutex_lock(&(pool._mutex));
+        GDSReset(dataset, 0);
+        pool._iSampleDataset = 0;
+        pool._nbRunning = 0;
+        for (int iThread = nbThread; iThread--;)
+          if (workers[iThread]._flagThread)
+            ++(pool._nbRunning);
+        ++(pool._round);
+        pthread_cond_broadcast(&(pool._condStart));
+        pthread_mutex_unlock(&(pool._mutex));
+        // The workers without thread pull the remaining entities from
+        // the calling thread
+        for (int iThread = nbThread; iThread--;)
+          if (!(workers[iThread]._flagThread))
+            ISTrainWorkerEvaluate(workers + iThread);
+        // Wait for the end of the round
+        pthread_mutex_lock(&(pool._mutex));
+        while (pool._nbRunning > 0)
+          pthread_cond_wait(&(pool._condEnd), &(pool._mutex));
+        pthread_mutex_unlock(&(pool._mutex));
+        // Update the values of the entities in the order of the GenAlg
+        // and report the new best values
+        for (long i = 0; i < pool._nbEnt; ++i) {
+          if (pool._flagEvaluated[i]) {
+            GenAlgAdn* adn = GAAdn(ga, pool._iEnts[i]);
+            GASetAdnValue(ga, adn, pool._values[i]);
+            if (pool._values[i] - bestValue > PBMATH_EPSILON) {
+              bestValue = pool._values[i];
+              ISSetAdn(that, adn);
+              ISTrainSnapshotAdn(adn, &bestAdnF, &bestAdnI);
+              ISTrainReportNewBest(that, dataset, ga, bestValue, 
+                &mailer, writer);
+            }
+          }
+        }
+        free(pool._iEnts);
+        free(pool._values);
+        free(pool._flagEvaluated);
+        pool._iEnts = NULL;
+        pool._values = NULL;
+        pool._flagEvaluated = NULL;
+      }
       // Step the GenAlg
       GAStep(ga);
       // Reset the set of values for the threshold of ISEvaluateFast
       GSetFlush(&setVal);
+      // Save the training state if the epoch has not been interrupted
+      if (ISGetTrainStatePath(that) != NULL && !PBIA_CtrlC &&
+        !ISTrainSaveState(that, ga, bestValue, bestAdnF, bestAdnI, 
+          nbTotalParamInt, nbTotalParamFloat, rngSeed)) {
+        fprintf(stderr, "Couldn't save the training state %s\n",  
+          ISGetTrainStatePath(that));
+      }
     } while (GAGetCurEpoch(ga) < ISGetNbEpoch(that) &&
       bestValue < ISGetTargetBestValue(that) && !PBIA_CtrlC);
-    // Loop on the criterion to set the criteria to the best one
-    GenTreeIterReset(&iter);
-    shiftParamInt = 0;
-    shiftParamFloat = 0;
-    do {
-      ImgSegmentorCriterion* crit = GenTreeIterGetData(&iter);
-      ISCSetAdnInt(crit, GABestAdn(ga), shiftParamInt);
-      shiftParamInt += ISCGetNbParamInt(crit);
-      ISCSetAdnFloat(crit, GABestAdn(ga), shiftParamFloat);
-      shiftParamFloat += ISCGetNbParamFloat(crit);
-    } while (GenTreeIterStep(&iter));
+    // Free the memory used by the parallel evaluation
+    if (nbThread > 1) {
+      if (workers != NULL) {
+        // End the threads of the workers
+        pthread_mutex_lock(&(pool._mutex));
+        pool._flagExit = true;
+        pthread_cond_broadcast(&(pool._condStart));
+        pthread_mutex_unlock(&(pool._mutex));
+        for (int iThread = nbThread; iThread--;)
+          if (workers[iThread]._flagThread)
+            pthread_join(workers[iThread]._thread, NULL);
+        for (int iThread = nbThread; iThread--;)
+          ISTrainWorkerFreeStatic(workers + iThread);
+        free(workers);
+        ISRCSetReadOnly(that->_reuseCache, false);
+      }
+      pthread_cond_destroy(&(pool._condStart));
+      pthread_cond_destroy(&(pool._condEnd));
+      pthread_mutex_destroy(&(pool._mutex));
+    }
+    // Set the criteria to the best one, from the in-memory snapshot of
+    // the last checkpoint
+    if (bestAdnF != NULL || bestAdnI != NULL) {
+      ISSetParams(that, bestAdnI, bestAdnF);
+    } else {
+      ISSetAdn(that, GABestAdn(ga));
+    }
+    // Wait for the remaining checkpoints to be written
+    ISCheckpointWriterFree(&writer);
     // Free memory
+    VecFree(&bestAdnF);
+    VecFree(&bestAdnI);
     GenAlgFree(&ga);
     if (ISGetEmailNotification(that) != NULL)
       PBMailerFreeStatic(&mailer);
-  }
-  // Reload the checkpoint at the end of the training to
-  // return the ImgSegmentor in its best version
-  FILE* fpCheckpoint = fopen(cpFilename, "r");
-  if (!fpCheckpoint) {
-    if (!ISLoad(that, fpCheckpoint)) {
-      fprintf(stderr, "Couldn't reload the checkpoint %s\n",  
-        cpFilename);
-    }
-    fclose(fpCheckpoint);
+    // Put back the state of the random generator of the caller
+    setstate(prevRngState);
   }
   // Free memory
   GenTreeIterFreeStatic(&iter);
@@ -1038,6 +4316,105 @@ void ISTrain(ImgSegmentor* const that,
   signal(SIGINT, SIG_DFL);
   // Set the flag to memorize we are not under training
   that->_flagTraining = false;
+  // Free the cache of predictions of the criteria
+  ImgSegmentorPredCacheFree(&(that->_predCache));
+  // Compile the criteria with their trained parameters
+  ISCompile(that);
+}
+
+// Train the ImageSegmentor 'that' on the data set 'dataSet' using
+// the data of the first category in 'dataSet'. If the data set has a 
+// second category it will be used for validation
+// The training uses its own random generator, seeded with one value 
+// drawn with random(), hence srandom must have been called before 
+// calling ISTrain. Apart from this draw the random generator of the 
+// caller is left untouched
+void ISTrain(ImgSegmentor* const that, 
+  const GDataSetGenBrushPair* const dataset) {
+  ISTrainCore(that, dataset, NULL);
+}
+
+// Resume the training of the ImageSegmentor 'that' on the data set 
+// 'dataSet' from the training state saved in 'stream' by a previous 
+// ISTrain or ISTrainResume, see ISSetTrainStatePath
+// 'that' must have the same criteria as the interrupted training
+// Return true if the training state could be loaded and the training
+// has been resumed, else false
+bool ISTrainResume(ImgSegmentor* const that, 
+  const GDataSetGenBrushPair* const dataset, FILE* const stream) {
+#if BUILDMODE == 0
+  if (that == NULL) {
+    PBImgAnalysisErr->_type = PBErrTypeNullPointer;
+    sprintf(PBImgAnalysisErr->_msg, "'that' is null");
+    PBErrCatch(PBImgAnalysisErr);
+  }
+  if (dataset == NULL) {
+    PBImgAnalysisErr->_type = PBErrTypeNullPointer;
+    sprintf(PBImgAnalysisErr->_msg, "'dataset' is null");
+    PBErrCatch(PBImgAnalysisErr);
+  }
+  if (stream == NULL) {
+    PBImgAnalysisErr->_type = PBErrTypeNullPointer;
+    sprintf(PBImgAnalysisErr->_msg, "'stream' is null");
+    PBErrCatch(PBImgAnalysisErr);
+  }
+#endif
+  // If there is no criterion, there is no training to resume
+  if (ISGetNbCriterion(that) == 0)
+    return false;
+  // Get the total number of int and float parameters
+  long nbParamInt = 0;
+  long nbParamFloat = 0;
+  GenTreeIterDepth iter = GenTreeIterDepthCreateStatic(ISCriteria(that));
+  do {
+    ImgSegmentorCriterion* crit = GenTreeIterGetData(&iter);
+    nbParamInt += ISCGetNbTrainedParamInt(crit);
+    nbParamFloat += ISCGetNbTrainedParamFloat(crit);
+  } while (GenTreeIterStep(&iter));
+  GenTreeIterFreeStatic(&iter);
+  // Load the training state
+  ISTrainState state;
+  if (!ISTrainLoadState(&state, stream, nbParamInt, nbParamFloat))
+    return false;
+  // The interruption of the previous training doesn't stop this one
+  PBIA_CtrlC = false;
+  // Resume the training
+  ISTrainCore(that, dataset, &state);
+  // Free memory
+  ISTrainStateFreeStatic(&state);
+  return true;
+}
+
+// Compile the criteria of the ImgSegmentor 'that' which support it
+// and are not already compiled, to speed up the prediction
+// Only the criteria RGB whose size of lookup table has been set with 
+// ISCRGBSetLUTSize are compiled
+// Automatically called at the end of ISTrain, ISLoad and ISLoadBinary
+void ISCompile(ImgSegmentor* const that) {
+#if BUILDMODE == 0
+  if (that == NULL) {
+    PBImgAnalysisErr->_type = PBErrTypeNullPointer;
+    sprintf(PBImgAnalysisErr->_msg, "'that' is null");
+    PBErrCatch(PBImgAnalysisErr);
+  }
+#endif
+  // The contexts created before are outdated
+  that->_generation = ISNextGeneration();
+  // If there is no criterion, nothing to do
+  if (ISGetNbCriterion(that) == 0)
+    return;
+  // Loop on criteria
+  GenTreeIterDepth iter = GenTreeIterDepthCreateStatic(ISCriteria(that));
+  do {
+    ImgSegmentorCriterion* criterion = GenTreeIterGetData(&iter);
+    if (criterion->_type == ISCType_RGB) {
+      ImgSegmentorCriterionRGB* criterionRGB = 
+        (ImgSegmentorCriterionRGB*)criterion;
+      if (!ISCRGBIsCompiled(criterionRGB))
+        ISCRGBCompile(criterionRGB);
+    }
+  } while (GenTreeIterStep(&iter));
+  GenTreeIterFreeStatic(&iter);
 }
 
 // Evaluate the ImageSegmentor 'that' on the data set 'dataSet' using
@@ -1051,8 +4428,6 @@ float ISEvaluateFast(ImgSegmentor* const that,
   float threshold) {
   // Declare a variable to memorize the result value
   float value = 0.0;
-  // Declare a variable to memorize the color of the mask
-  const GBPixel rgbaMask = GBColorBlack; 
   // Reset the iterator of the GDataSet
   GDSReset(dataset, iCat);
   // Declare a variable to compute the skip condition
@@ -1068,24 +4443,14 @@ float ISEvaluateFast(ImgSegmentor* const that,
     }
     // Get the next sample
     GDSGenBrushPair* sample = GDSGetSample(dataset, iCat);
-    // Do the prediction on the sample
+    // Do the prediction on the sample and check it against the masks
     // Reuse data to speed up training if we are under training
-    GenBrush** pred = NULL;
-    if (that->_flagTraining && iCat == 0) {
-      pred = ISPredictWithReuse(that, sample->_img, iSample);
-    } else {
-      pred = ISPredict(that, sample->_img);
-    }
-    // Check the prediction against the masks
-    float valMask = 0.0;
-    for (int iClass = ISGetNbClass(that); iClass--;)
-      valMask += IntersectionOverUnion(
-        sample->_mask[iClass], pred[iClass], &rgbaMask);
-    value += valMask / (float)GDSGetNbMask(dataset);
+    long iSampleReuse = -1;
+    if (that->_flagTraining && iCat == 0)
+      iSampleReuse = iSample;
+    value += ISEvaluateSample(that, sample, iSampleReuse, 
+      GDSGetNbMask(dataset));
     // Free memory
-    for (int iClass = ISGetNbClass(that); iClass--;)
-      GBFree(pred + iClass);
-    free(pred);
     GDSGenBrushPairFree(&sample);
     ++iSample;
     // Get the value under which we can skip the remaining samples
@@ -1132,35 +4497,307 @@ void ISSetFlagTextOMeter(ImgSegmentor* const that, bool flag) {
   }
 }
 
-// Refresh the content of the TextOMeter attached to the 
-// ImgSegmentor 'that'
-void ISUpdateTextOMeter(const ImgSegmentor* const that) {
+// Refresh the content of the TextOMeter attached to the 
+// ImgSegmentor 'that'
+void ISUpdateTextOMeter(const ImgSegmentor* const that) {
+#if BUILDMODE == 0
+  if (that == NULL) {
+    PBImgAnalysisErr->_type = PBErrTypeNullPointer;
+    sprintf(PBImgAnalysisErr->_msg, "'that' is null");
+    PBErrCatch(PBImgAnalysisErr);
+  }
+  if (that->_textOMeter == NULL) {
+    PBImgAnalysisErr->_type = PBErrTypeNullPointer;
+    sprintf(PBImgAnalysisErr->_msg, "'that->_textOMeter' is null");
+    PBErrCatch(PBImgAnalysisErr);
+  }
+#endif
+  // Clear the TextOMeter
+  TextOMeterClear(that->_textOMeter);
+  // .........................
+  TextOMeterPrint(that->_textOMeter, that->_line1);
+  TextOMeterPrint(that->_textOMeter, that->_line3);
+  TextOMeterPrint(that->_textOMeter, that->_line2);
+  // Flush the content of the TextOMeter
+  TextOMeterFlush(that->_textOMeter);
+}
+
+// Load the ImgSegmentor from the stream
+// If the ImgSegmentor is already allocated, it is freed before loading
+// Return true upon success else false
+bool ISLoad(ImgSegmentor* that, FILE* const stream) {
+#if BUILDMODE == 0
+  if (that == NULL) {
+    PBImgAnalysisErr->_type = PBErrTypeNullPointer;
+    sprintf(PBImgAnalysisErr->_msg, "'that' is null");
+    PBErrCatch(PBImgAnalysisErr);
+  }
+  if (stream == NULL) {
+    PBImgAnalysisErr->_type = PBErrTypeNullPointer;
+    sprintf(PBImgAnalysisErr->_msg, "'stream' is null");
+    PBErrCatch(PBImgAnalysisErr);
+  }
+#endif
+  // Declare a json to load the encoded data
+  JSONNode* json = JSONCreate();
+  // Load the whole encoded data
+  if (!JSONLoad(json, stream)) {
+    return false;
+  }
+  // Decode the data from the JSON
+  if (!ISDecodeAsJSON(that, json)) {
+    return false;
+  }
+  // Free the memory used by the JSON
+  JSONFree(&json);
+  // Compile the criteria
+  ISCompile(that);
+  // Return success code
+  return true;
+}
+
+// Save the ImgSegmentor to the stream
+// If 'compact' equals true it saves in compact form, else it saves in 
+// readable form
+// Return true upon success else false
+bool ISSave(const ImgSegmentor* const that, 
+  FILE* const stream, const bool compact) {
+#if BUILDMODE == 0
+  if (that == NULL) {
+    PBImgAnalysisErr->_type = PBErrTypeNullPointer;
+    sprintf(PBImgAnalysisErr->_msg, "'that' is null");
+    PBErrCatch(PBImgAnalysisErr);
+  }
+  if (stream == NULL) {
+    PBImgAnalysisErr->_type = PBErrTypeNullPointer;
+    sprintf(PBImgAnalysisErr->_msg, "'stream' is null");
+    PBErrCatch(PBImgAnalysisErr);
+  }
+#endif
+  // Write the JSON encoding in a single pass
+  JSONStreamWriter writer = JSONStreamWriterCreateStatic(stream, compact);
+  ISEncodeAsJSONStream(that, &writer);
+  // Return success code
+  return JSWIsOk(&writer);
+}
+
+// Write the JSON encoding of 'that' with the JSONStreamWriter 'writer'
+// It's the same encoding as ISEncodeAsJSON
+void ISEncodeAsJSONStream(const ImgSegmentor* const that, 
+  JSONStreamWriter* const writer) {
+#if BUILDMODE == 0
+  if (that == NULL) {
+    PBImgAnalysisErr->_type = PBErrTypeNullPointer;
+    sprintf(PBImgAnalysisErr->_msg, "'that' is null");
+    PBErrCatch(PBImgAnalysisErr);
+  }
+  if (writer == NULL) {
+    PBImgAnalysisErr->_type = PBErrTypeNullPointer;
+    sprintf(PBImgAnalysisErr->_msg, "'writer' is null");
+    PBErrCatch(PBImgAnalysisErr);
+  }
+#endif
+  JSWOpenObject(writer, NULL);
+  JSWAddPropInt(writer, "_nbClass", that->_nbClass);
+  JSWAddPropInt(writer, "_flagBinaryResult", that->_flagBinaryResult);
+  JSWAddPropFloat(writer, "_thresholdBinaryResult", 
+    that->_thresholdBinaryResult);
+  JSWAddPropInt(writer, "_nbEpoch", that->_nbEpoch);
+  JSWAddPropInt(writer, "_sizePool", that->_sizePool);
+  JSWAddPropInt(writer, "_nbElite", that->_nbElite);
+  JSWAddPropFloat(writer, "_targetBestValue", that->_targetBestValue);
+  ISEncodeNodeAsJSONStream(ISCriteria(that), "_criteria", writer);
+  JSWCloseObject(writer);
+}
+
+// Write the JSON encoding of the node 'that' in the GenTree of 
+// criteria of a ImgSegmentor with the label 'key' with the 
+// JSONStreamWriter 'writer'
+// It's the same encoding as ISEncodeNodeAsJSON
+void ISEncodeNodeAsJSONStream(const GenTree* const that, 
+  const char* const key, JSONStreamWriter* const writer) {
+#if BUILDMODE == 0
+  if (that == NULL) {
+    PBImgAnalysisErr->_type = PBErrTypeNullPointer;
+    sprintf(PBImgAnalysisErr->_msg, "'that' is null");
+    PBErrCatch(PBImgAnalysisErr);
+  }
+  if (writer == NULL) {
+    PBImgAnalysisErr->_type = PBErrTypeNullPointer;
+    sprintf(PBImgAnalysisErr->_msg, "'writer' is null");
+    PBErrCatch(PBImgAnalysisErr);
+  }
+#endif
+  JSWOpenObject(writer, key);
+  // If there is a criterion on the node
+  if (GenTreeData(that) != NULL)
+    ISCEncodeAsJSONStream(
+      (const ImgSegmentorCriterion*)GenTreeData(that), writer);
+  // Add the number of subtrees
+  JSWAddPropInt(writer, "_nbSubtree", GSetNbElem(&(that->_subtrees)));
+  // If there are subtrees
+  if (!GenTreeIsLeaf(that)) {
+    // Loop on the subtrees
+    GSetIterForward iter = 
+      GSetIterForwardCreateStatic(GenTreeSubtrees(that));
+    int iSubtree = 0;
+    do {
+      char lblSubtree[100];
+      sprintf(lblSubtree, "_subtree_%d", iSubtree);
+      ISEncodeNodeAsJSONStream(GSetIterGet(&iter), lblSubtree, writer);
+      ++iSubtree;
+    } while (GSetIterStep(&iter));
+  }
+  JSWCloseObject(writer);
+}
+
+// Write the JSON encoding of the criterion 'that' with the 
+// JSONStreamWriter 'writer'
+// It's the same encoding as ISCEncodeAsJSON
+void ISCEncodeAsJSONStream(const ImgSegmentorCriterion* const that, 
+  JSONStreamWriter* const writer) {
 #if BUILDMODE == 0
   if (that == NULL) {
     PBImgAnalysisErr->_type = PBErrTypeNullPointer;
     sprintf(PBImgAnalysisErr->_msg, "'that' is null");
     PBErrCatch(PBImgAnalysisErr);
   }
-  if (that->_textOMeter == NULL) {
+  if (writer == NULL) {
     PBImgAnalysisErr->_type = PBErrTypeNullPointer;
-    sprintf(PBImgAnalysisErr->_msg, "'that->_textOMeter' is null");
+    sprintf(PBImgAnalysisErr->_msg, "'writer' is null");
     PBErrCatch(PBImgAnalysisErr);
   }
 #endif
-  // Clear the TextOMeter
-  TextOMeterClear(that->_textOMeter);
-  // .........................
-  TextOMeterPrint(that->_textOMeter, that->_line1);
-  TextOMeterPrint(that->_textOMeter, that->_line3);
-  TextOMeterPrint(that->_textOMeter, that->_line2);
-  // Flush the content of the TextOMeter
-  TextOMeterFlush(that->_textOMeter);
+  JSWOpenObject(writer, "_criterion");
+  JSWAddPropInt(writer, "_type", that->_type);
+  JSWAddPropInt(writer, "_nbClass", that->_nbClass);
+  JSWAddPropInt(writer, "_flagReusedInput", that->_flagReusedInput);
+  JSWAddPropInt(writer, "_flagFrozen", that->_flagFrozen);
+  switch(that->_type) {
+    case ISCType_RGB:
+      JSWAddNeuraNet(writer, "_neuranet", 
+        ISCRGBNeuraNet((const ImgSegmentorCriterionRGB*)that));
+      JSWAddPropInt(writer, "_lutSize", 
+        ISCRGBGetLUTSize((const ImgSegmentorCriterionRGB*)that));
+      break;
+    case ISCType_RGB2HSV:
+      break;
+    case ISCType_Dust:
+      JSWAddVecLong(writer, "_size", 
+        ((const ImgSegmentorCriterionDust*)that)->_size);
+      break;
+    case ISCType_Tex:
+      JSWAddPropInt(writer, "_rank", 
+        ISCTexGetRank((const ImgSegmentorCriterionTex*)that));
+      JSWAddPropInt(writer, "_size", 
+        ISCTexGetSize((const ImgSegmentorCriterionTex*)that));
+      JSWAddNeuraNet(writer, "_neuranet", 
+        ISCTexNeuraNet((const ImgSegmentorCriterionTex*)that));
+      break;
+    default:
+      PBImgAnalysisErr->_type = PBErrTypeNotYetImplemented;
+      sprintf(PBImgAnalysisErr->_msg, 
+        "Not yet implemented type of criterion");
+      PBErrCatch(PBImgAnalysisErr);
+      break;
+  }
+  JSWCloseObject(writer);
 }
 
-// Load the ImgSegmentor from the stream
-// If the ImgSegmentor is already allocated, it is freed before loading
+// Return the number of nodes in the tree of criteria 'that', 
+// including 'that'
+long ISBinGetNbNode(const GenTree* const that) {
+  long nb = 1;
+  if (!GenTreeIsLeaf(that)) {
+    GSetIterForward iter = 
+      GSetIterForwardCreateStatic(GenTreeSubtrees(that));
+    do {
+      nb += ISBinGetNbNode(GSetIterGet(&iter));
+    } while (GSetIterStep(&iter));
+  }
+  return nb;
+}
+
+// Return 'offset' rounded up to the alignment of the arrays in the 
+// binary format
+uint64_t ISBinAlign(const uint64_t offset) {
+  return ((offset + IS_BINALIGN - 1) / IS_BINALIGN) * IS_BINALIGN;
+}
+
+// Fill the records 'nodes' and 'trees' from the index 'iNode' with the
+// tree of criteria 'that' in depth first order, the arrays of the 
+// nodes are placed from the offset 'offset' in the file
+// Return the index of the next node
+long ISBinEncodeNode(const GenTree* const that, ISBinNode* const nodes,
+  const GenTree** const trees, long iNode, uint64_t* const offset) {
+  ISBinNode* node = nodes + iNode;
+  memset(node, 0, sizeof(ISBinNode));
+  trees[iNode] = that;
+  node->_nbSubtree = GSetNbElem(GenTreeSubtrees(that));
+  node->_type = -1;
+  const ImgSegmentorCriterion* crit = GenTreeData(that);
+  if (crit != NULL) {
+    node->_type = crit->_type;
+    node->_nbClass = crit->_nbClass;
+    node->_flagReusedInput = crit->_flagReusedInput;
+    node->_flagFrozen = crit->_flagFrozen;
+    const NeuraNet* nn = NULL;
+    if (crit->_type == ISCType_RGB) {
+      const ImgSegmentorCriterionRGB* rgb = 
+        (const ImgSegmentorCriterionRGB*)crit;
+      nn = ISCRGBNeuraNet(rgb);
+      node->_param[0] = ISCRGBGetLUTSize(rgb);
+      if (ISCRGBIsCompiled(rgb))
+        node->_nbLUT = (int64_t)node->_param[0] * node->_param[0] * 
+          node->_param[0] * node->_nbClass;
+    } else if (crit->_type == ISCType_Tex) {
+      const ImgSegmentorCriterionTex* tex = 
+        (const ImgSegmentorCriterionTex*)crit;
+      nn = ISCTexNeuraNet(tex);
+      node->_param[0] = ISCTexGetRank(tex);
+      node->_param[1] = ISCTexGetSize(tex);
+    } else if (crit->_type == ISCType_Dust) {
+      node->_nbInt = node->_nbClass;
+    }
+    if (nn != NULL)
+      node->_nbBase = VecGetDim(NNBases(nn));
+    // Place the arrays
+    node->_offBase = *offset;
+    *offset = ISBinAlign(*offset + sizeof(float) * node->_nbBase);
+    node->_offLUT = *offset;
+    *offset = ISBinAlign(*offset + sizeof(float) * node->_nbLUT);
+    node->_offInt = *offset;
+    *offset = ISBinAlign(*offset + sizeof(int64_t) * node->_nbInt);
+  }
+  ++iNode;
+  if (!GenTreeIsLeaf(that)) {
+    GSetIterForward iter = 
+      GSetIterForwardCreateStatic(GenTreeSubtrees(that));
+    do {
+      iNode = ISBinEncodeNode(GSetIterGet(&iter), nodes, trees, iNode, 
+        offset);
+    } while (GSetIterStep(&iter));
+  }
+  return iNode;
+}
+
+// Write the 'size' bytes of 'data' in the 'stream' at the offset 
+// 'offset', after padding from the current offset 'pos'
 // Return true upon success else false
-bool ISLoad(ImgSegmentor* that, FILE* const stream) {
+bool ISBinWrite(FILE* const stream, uint64_t* const pos, 
+  const uint64_t offset, const void* const data, const size_t size) {
+  for (; *pos < offset; ++(*pos))
+    if (fputc(0, stream) == EOF)
+      return false;
+  if (size > 0 && fwrite(data, size, 1, stream) != 1)
+    return false;
+  *pos += size;
+  return true;
+}
+
+// Save the ImgSegmentor to the stream in binary format
+// Return true upon success else false
+bool ISSaveBinary(const ImgSegmentor* const that, FILE* const stream) {
 #if BUILDMODE == 0
   if (that == NULL) {
     PBImgAnalysisErr->_type = PBErrTypeNullPointer;
@@ -1173,28 +4810,192 @@ bool ISLoad(ImgSegmentor* that, FILE* const stream) {
     PBErrCatch(PBImgAnalysisErr);
   }
 #endif
-  // Declare a json to load the encoded data
-  JSONNode* json = JSONCreate();
-  // Load the whole encoded data
-  if (!JSONLoad(json, stream)) {
-    return false;
+  // Create the header
+  ISBinHeader header;
+  memset(&header, 0, sizeof(ISBinHeader));
+  memcpy(header._magic, IS_BINMAGIC, 4);
+  header._version = IS_BINVERSION;
+  header._nbClass = that->_nbClass;
+  header._flagBinaryResult = that->_flagBinaryResult;
+  header._thresholdBinaryResult = that->_thresholdBinaryResult;
+  header._nbEpoch = that->_nbEpoch;
+  header._sizePool = that->_sizePool;
+  header._nbElite = that->_nbElite;
+  header._targetBestValue = that->_targetBestValue;
+  header._nbNode = ISBinGetNbNode(ISCriteria(that));
+  // Create the records of the nodes and place their arrays
+  ISBinNode* nodes = PBErrMalloc(PBImgAnalysisErr, 
+    sizeof(ISBinNode) * header._nbNode);
+  const GenTree** trees = PBErrMalloc(PBImgAnalysisErr, 
+    sizeof(GenTree*) * header._nbNode);
+  uint64_t offset = ISBinAlign(sizeof(ISBinHeader) + 
+    sizeof(ISBinNode) * header._nbNode);
+  (void)ISBinEncodeNode(ISCriteria(that), nodes, trees, 0, &offset);
+  header._size = offset;
+  // Write the header, the nodes and the arrays
+  uint64_t pos = 0;
+  bool ret = ISBinWrite(stream, &pos, 0, &header, sizeof(ISBinHeader)) &&
+    ISBinWrite(stream, &pos, pos, nodes, 
+    sizeof(ISBinNode) * header._nbNode);
+  for (long iNode = 0; ret && iNode < header._nbNode; ++iNode) {
+    const ISBinNode* node = nodes + iNode;
+    const ImgSegmentorCriterion* crit = GenTreeData(trees[iNode]);
+    if (crit == NULL)
+      continue;
+    if (crit->_type == ISCType_RGB || crit->_type == ISCType_Tex) {
+      const NeuraNet* nn = (crit->_type == ISCType_RGB ? 
+        ISCRGBNeuraNet((const ImgSegmentorCriterionRGB*)crit) :
+        ISCTexNeuraNet((const ImgSegmentorCriterionTex*)crit));
+      ret = ISBinWrite(stream, &pos, node->_offBase, NNBases(nn)->_val,
+        sizeof(float) * node->_nbBase);
+    }
+    if (ret && node->_nbLUT > 0)
+      ret = ISBinWrite(stream, &pos, node->_offLUT, 
+        ((const ImgSegmentorCriterionRGB*)crit)->_lut, 
+        sizeof(float) * node->_nbLUT);
+    for (long i = 0; ret && i < node->_nbInt; ++i) {
+      int64_t val = ISCDustSize((const ImgSegmentorCriterionDust*)crit, i);
+      ret = ISBinWrite(stream, &pos, (i == 0 ? node->_offInt : pos), 
+        &val, sizeof(int64_t));
+    }
   }
-  // Decode the data from the JSON
-  if (!ISDecodeAsJSON(that, json)) {
+  // Pad up to the end of the last array
+  if (ret)
+    ret = ISBinWrite(stream, &pos, header._size, NULL, 0);
+  // Free memory
+  free(nodes);
+  free(trees);
+  // Return success code
+  return ret;
+}
+
+// Return true if the array of 'nb' elements of 'sizeElem' bytes at 
+// the offset 'off' is aligned and inside the binary file of 'size' 
+// bytes, else false
+// The checks are written to not overflow whatever the values read 
+// from the file
+bool ISBinArrayIsValid(const uint64_t off, const int64_t nb, 
+  const size_t sizeElem, const size_t size) {
+  if (nb < 0 || off > size || off % IS_BINALIGN != 0)
+    return false;
+  return (uint64_t)nb <= (size - off) / sizeElem;
+}
+
+// Decode the tree of criteria 'that' from the node 'iNode' of the 
+// records 'nodes' of the binary file mapped at 'map', of 'size' bytes
+// The criteria must have 'nbClass' classes, the one of the 
+// ImgSegmentor
+// The lookup tables are borrowed from the mapping and '*flagBorrowed' 
+// is set to true if any
+// Return true upon success else false
+bool ISBinDecodeNode(GenTree* const that, const char* const map, 
+  const size_t size, const ISBinNode* const nodes, const long nbNode, 
+  const int nbClass, long* const iNode, bool* const flagBorrowed) {
+  if (*iNode >= nbNode)
+    return false;
+  const ISBinNode* node = nodes + *iNode;
+  ++(*iNode);
+  // Check the arrays are aligned and in the file before using their 
+  // offsets
+  if (node->_nbSubtree < 0 ||
+    !ISBinArrayIsValid(node->_offBase, node->_nbBase, sizeof(float), 
+      size) ||
+    !ISBinArrayIsValid(node->_offLUT, node->_nbLUT, sizeof(float), 
+      size) ||
+    !ISBinArrayIsValid(node->_offInt, node->_nbInt, sizeof(int64_t), 
+      size))
     return false;
+  // If there is a criterion
+  if (node->_type != -1) {
+    if (node->_nbClass != nbClass)
+      return false;
+    ImgSegmentorCriterion* crit = NULL;
+    NeuraNet* nn = NULL;
+    switch (node->_type) {
+      case ISCType_RGB: {
+        if (node->_param[0] != 0 && 
+          (node->_param[0] < 2 || node->_param[0] > 256))
+          return false;
+        ImgSegmentorCriterionRGB* rgb = 
+          ImgSegmentorCriterionRGBCreate(node->_nbClass);
+        rgb->_lutSize = node->_param[0];
+        // Use the lookup table in place
+        if (node->_nbLUT > 0) {
+          if (node->_nbLUT != (int64_t)rgb->_lutSize * rgb->_lutSize * 
+            rgb->_lutSize * node->_nbClass) {
+            ImgSegmentorCriterionRGBFree(&rgb);
+            return false;
+          }
+          rgb->_lut = (float*)(map + node->_offLUT);
+          rgb->_flagLUTBorrowed = true;
+          *flagBorrowed = true;
+        }
+        nn = rgb->_nn;
+        crit = (ImgSegmentorCriterion*)rgb;
+        break;
+      }
+      case ISCType_RGB2HSV:
+        crit = (ImgSegmentorCriterion*)
+          ImgSegmentorCriterionRGB2HSVCreate(node->_nbClass);
+        break;
+      case ISCType_Dust: {
+        if (node->_nbInt != node->_nbClass)
+          return false;
+        ImgSegmentorCriterionDust* dust = 
+          ImgSegmentorCriterionDustCreate(node->_nbClass);
+        const int64_t* val = (const int64_t*)(map + node->_offInt);
+        for (long i = node->_nbInt; i--;)
+          VecSet(dust->_size, i, val[i]);
+        crit = (ImgSegmentorCriterion*)dust;
+        break;
+      }
+      case ISCType_Tex: {
+        if (node->_param[0] < 1 || node->_param[0] > ISCTEX_RANKMAX ||
+          node->_param[1] < 1 || node->_param[1] > ISCTEX_SIZEMAX)
+          return false;
+        ImgSegmentorCriterionTex* tex = ImgSegmentorCriterionTexCreate(
+          node->_nbClass, node->_param[0], node->_param[1]);
+        nn = tex->_nn;
+        crit = (ImgSegmentorCriterion*)tex;
+        break;
+      }
+      default:
+        return false;
+    }
+    that->_data = crit;
+    crit->_flagReusedInput = (node->_flagReusedInput != 0);
+    crit->_flagFrozen = (node->_flagFrozen != 0);
+    // Copy the bases of the NeuraNet, it owns its memory
+    if (nn != NULL) {
+      if (node->_nbBase != VecGetDim(NNBases(nn)))
+        return false;
+      VecFloat* bases = VecFloatCreate(node->_nbBase);
+      memcpy(bases->_val, map + node->_offBase, 
+        sizeof(float) * node->_nbBase);
+      NNSetBases(nn, bases);
+      VecFree(&bases);
+    }
   }
-  // Free the memory used by the JSON
-  JSONFree(&json);
-  // Return success code
+  // Decode the subtrees
+  for (int iSubtree = 0; iSubtree < node->_nbSubtree; ++iSubtree) {
+    GenTree* subtree = GenTreeCreate();
+    GenTreeAppendSubtree(that, subtree);
+    if (!ISBinDecodeNode(subtree, map, size, nodes, nbNode, nbClass, 
+      iNode, flagBorrowed))
+      return false;
+  }
+  // Return the success code
   return true;
 }
 
-// Save the ImgSegmentor to the stream
-// If 'compact' equals true it saves in compact form, else it saves in 
-// readable form
+// Load the ImgSegmentor from the stream in binary format
+// The stream must be a regular file positioned at the beginning of 
+// the data. The file is mapped in memory and its lookup tables are 
+// used in place without parsing
+// The file is decoded into a temporary ImgSegmentor, 'that' is 
+// replaced only upon success and left untouched upon failure
 // Return true upon success else false
-bool ISSave(const ImgSegmentor* const that, 
-  FILE* const stream, const bool compact) {
+bool ISLoadBinary(ImgSegmentor* that, FILE* const stream) {
 #if BUILDMODE == 0
   if (that == NULL) {
     PBImgAnalysisErr->_type = PBErrTypeNullPointer;
@@ -1207,14 +5008,71 @@ bool ISSave(const ImgSegmentor* const that,
     PBErrCatch(PBImgAnalysisErr);
   }
 #endif
-  // Get the JSON encoding
-  JSONNode* json = ISEncodeAsJSON(that);
-  // Save the JSON
-  if (!JSONSave(json, stream, compact)) {
+  // Map the file in memory
+  int fd = fileno(stream);
+  long start = ftell(stream);
+  struct stat st;
+  if (fd < 0 || start != 0 || fstat(fd, &st) != 0 || 
+    (size_t)st.st_size < sizeof(ISBinHeader))
+    return false;
+  size_t size = (size_t)st.st_size;
+  char* map = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+  if (map == MAP_FAILED)
+    return false;
+  // Check the header
+  const ISBinHeader* header = (const ISBinHeader*)map;
+  if (memcmp(header->_magic, IS_BINMAGIC, 4) != 0 ||
+    header->_version != IS_BINVERSION || header->_size != size ||
+    header->_nbClass <= 0 || header->_nbNode < 1 ||
+    (uint64_t)header->_nbNode > 
+      (size - sizeof(ISBinHeader)) / sizeof(ISBinNode) ||
+    header->_nbEpoch < 1 || header->_sizePool < 3 ||
+    header->_nbElite < 2 || header->_nbElite > header->_sizePool - 1 ||
+    header->_targetBestValue < 0.0 || header->_targetBestValue > 1.0) {
+    munmap(map, size);
     return false;
   }
-  // Free memory
-  JSONFree(&json);
+  // Create the temporary ImgSegmentor and set the properties
+  ImgSegmentor loaded = ImgSegmentorCreateStatic(header->_nbClass);
+  loaded._flagBinaryResult = (header->_flagBinaryResult != 0);
+  loaded._thresholdBinaryResult = header->_thresholdBinaryResult;
+  loaded._nbEpoch = header->_nbEpoch;
+  loaded._sizePool = header->_sizePool;
+  loaded._nbElite = header->_nbElite;
+  loaded._targetBestValue = header->_targetBestValue;
+  // Decode the tree of criteria, the ImgSegmentor keeps the mapping 
+  // while the criteria borrow arrays from it
+  loaded._binMap = map;
+  loaded._binMapSize = size;
+  const ISBinNode* nodes = (const ISBinNode*)(map + sizeof(ISBinHeader));
+  long iNode = 0;
+  bool flagBorrowed = false;
+  bool ret = ISBinDecodeNode(&(loaded._criteria), map, size, nodes, 
+    header->_nbNode, header->_nbClass, &iNode, &flagBorrowed) && 
+    iNode == header->_nbNode;
+  // Upon failure, free the temporary ImgSegmentor and the mapping
+  if (!ret) {
+    ImgSegmentorFreeStatic(&loaded);
+    return false;
+  }
+  if (!flagBorrowed) {
+    munmap(map, size);
+    loaded._binMap = NULL;
+    loaded._binMapSize = 0;
+  }
+  // Replace the current ImgSegmentor with the decoded one, the 
+  // subtrees of the root must point to its new address
+  ImgSegmentorFreeStatic(that);
+  *that = loaded;
+  if (!GenTreeIsLeaf(&(that->_criteria))) {
+    GSetIterForward iter = 
+      GSetIterForwardCreateStatic(GenTreeSubtrees(&(that->_criteria)));
+    do {
+      ((GenTree*)GSetIterGet(&iter))->_parent = &(that->_criteria);
+    } while (GSetIterStep(&iter));
+  }
+  // Compile the criteria which are not yet compiled
+  ISCompile(that);
   // Return success code
   return true;
 }
@@ -1470,6 +5328,13 @@ ImgSegmentorCriterion ImgSegmentorCriterionCreateStatic(int nbClass,
   that._type = type;
   that._flagReusedInput = false;
   that._reusedInput = GSetCreateStatic();
+  that._reuseCache = NULL;
+  that._featureCachePath = NULL;
+  that._paramHash = 0;
+  that._paramKey = NULL;
+  that._sizeParamKey = 0;
+  that._flagFrozen = false;
+  that._frozenPred = GSetCreateStatic();
   // Return the new ImgSegmentorCriterion
   return that;
 }
@@ -1480,6 +5345,9 @@ void ImgSegmentorCriterionFreeStatic(ImgSegmentorCriterion* that) {
     return;
   // Free memory
   ImgSegmentorCriterionFlushReusedData(that);
+  free(that->_paramKey);
+  that->_paramKey = NULL;
+  that->_sizeParamKey = 0;
 }
 
 // Flush the reused data of the ImgSegmentorCriterion 'that'
@@ -1492,12 +5360,12 @@ void ImgSegmentorCriterionFlushReusedData(ImgSegmentorCriterion* that) {
   }
 #endif
   while (GSetNbElem(&(that->_reusedInput)) > 0) {
-    GSetVecFloat* set = GSetPop(&(that->_reusedInput));
-    while (GSetNbElem(set) > 0) {
-      VecFloat* v = GSetPop(set);
-      VecFree(&v);
-    }
-    GSetFree(&set);
+    ImgSegmentorReuseEntry* entry = GSetPop(&(that->_reusedInput));
+    ISRCEntryFree(that->_reuseCache, &entry);
+  }
+  while (GSetNbElem(&(that->_frozenPred)) > 0) {
+    ImgSegmentorReuseEntry* entry = GSetPop(&(that->_frozenPred));
+    ISRCEntryFree(that->_reuseCache, &entry);
   }
 }
 
@@ -1505,10 +5373,14 @@ void ImgSegmentorCriterionFlushReusedData(ImgSegmentorCriterion* that) {
 // function according to the type of criterion
 // Try to reuse the data associated with the sample 'iSample'. If
 // 'iSample' equals -1 it means we don't want to reuse the data
+// If 'ctx' is not null, its NeuraNet and stop flag are used instead of
+// the NeuraNet of 'that' and PBIA_CtrlC
 // 'input' 's format is width*height*3, values in [0.0, 1.0]
 // Return values are width*height*nbClass, values in [-1.0, 1.0]
-VecFloat* ISCPredictWithReuse(const ImgSegmentorCriterion* const that,
-  const VecFloat* input, const VecShort2D* const dim, const int iSample) {
+ImgSegmentorPlane* ISCPredictWithContext(
+  const ImgSegmentorCriterion* const that,
+  const ImgSegmentorPlane* const input, const int iSample,
+  const ImgSegmentorCriterionContext* const ctx) {
 #if BUILDMODE == 0
   if (that == NULL) {
     PBImgAnalysisErr->_type = PBErrTypeNullPointer;
@@ -1522,24 +5394,24 @@ VecFloat* ISCPredictWithReuse(const ImgSegmentorCriterion* const that,
   }
 #endif
   // Declare a variable to memorize the result
-  VecFloat* res = NULL;
+  ImgSegmentorPlane* res = NULL;
   // Call the appropriate function based on the type
   switch(that->_type) {
     case ISCType_RGB:
       res = ISCRGBPredict((const ImgSegmentorCriterionRGB*)that, 
-        input, dim, iSample);
+        input, iSample, ctx);
       break;
     case ISCType_RGB2HSV:
       res = ISCRGB2HSVPredict((const ImgSegmentorCriterionRGB2HSV*)that, 
-        input, dim, iSample);
+        input, iSample, ctx);
       break;
     case ISCType_Dust:
       res = ISCDustPredict((const ImgSegmentorCriterionDust*)that, 
-        input, dim, iSample);
+        input, iSample, ctx);
       break;
     case ISCType_Tex:
       res = ISCTexPredict((const ImgSegmentorCriterionTex*)that, 
-        input, dim, iSample);
+        input, iSample, ctx);
       break;
     default:
       PBImgAnalysisErr->_type = PBErrTypeNotYetImplemented;
@@ -1552,6 +5424,14 @@ VecFloat* ISCPredictWithReuse(const ImgSegmentorCriterion* const that,
   return res;
 }
 
+// Return true if the prediction of a criterion with the context 'ctx'
+// must be interrupted
+bool ISCIsInterrupted(const ImgSegmentorCriterionContext* const ctx) {
+  if (ctx == NULL)
+    return PBIA_CtrlC;
+  return (ctx->_flagStop != NULL && *(ctx->_flagStop));
+}
+
 JSONNode* ISCEncodeAsJSON(
   const ImgSegmentorCriterion* const that) {
 #if BUILDMODE == 0
@@ -1574,6 +5454,9 @@ JSONNode* ISCEncodeAsJSON(
   // Flag to reuse the input
   sprintf(val, "%d", that->_flagReusedInput);
   JSONAddProp(json, "_flagReusedInput", val);
+  // Flag to exclude the parameters from the training
+  sprintf(val, "%d", that->_flagFrozen);
+  JSONAddProp(json, "_flagFrozen", val);
   // Call the appropriate function based on the type
   switch(that->_type) {
     case ISCType_RGB:
@@ -1654,11 +5537,47 @@ bool ISCDecodeAsJSON(
     if (flagReusedInput != 0) {
       (*that)->_flagReusedInput = true;
     }
+    // Get the flag to exclude the parameters from the training, 
+    // optional for the files saved before its introduction
+    prop = JSONProperty(json, "_flagFrozen");
+    if (prop != NULL && atoi(JSONLblVal(prop)) != 0) {
+      (*that)->_flagFrozen = true;
+    }
   }
   // Return the result code
   return ret;
 }
 
+// Return the number of int parameters of the criterion 'that' searched
+// during training, 0 if it is frozen
+long ISCGetNbTrainedParamInt(const ImgSegmentorCriterion* const that) {
+#if BUILDMODE == 0
+  if (that == NULL) {
+    PBImgAnalysisErr->_type = PBErrTypeNullPointer;
+    sprintf(PBImgAnalysisErr->_msg, "'that' is null");
+    PBErrCatch(PBImgAnalysisErr);
+  }
+#endif
+  if (ISCIsFrozen(that))
+    return 0;
+  return ISCGetNbParamInt(that);
+}
+
+// Return the number of float parameters of the criterion 'that' 
+// searched during training, 0 if it is frozen
+long ISCGetNbTrainedParamFloat(const ImgSegmentorCriterion* const that) {
+#if BUILDMODE == 0
+  if (that == NULL) {
+    PBImgAnalysisErr->_type = PBErrTypeNullPointer;
+    sprintf(PBImgAnalysisErr->_msg, "'that' is null");
+    PBErrCatch(PBImgAnalysisErr);
+  }
+#endif
+  if (ISCIsFrozen(that))
+    return 0;
+  return ISCGetNbParamFloat(that);
+}
+
 // Return the number of int parameters for the criterion 'that'
 long _ISCGetNbParamInt(const ImgSegmentorCriterion* const that) {
 #if BUILDMODE == 0
@@ -1821,36 +5740,31 @@ void _ISCSetBoundsAdnFloat(const ImgSegmentorCriterion* const that,
 
 // Set the values of int parameters for training of the criterion 'that'
 void _ISCSetAdnInt(const ImgSegmentorCriterion* const that, 
-  const GenAlgAdn* const adn, const long shift) {
+  const VecLong* const adnI, const long shift) {
 #if BUILDMODE == 0
   if (that == NULL) {
     PBImgAnalysisErr->_type = PBErrTypeNullPointer;
     sprintf(PBImgAnalysisErr->_msg, "'that' is null");
     PBErrCatch(PBImgAnalysisErr);
   }
-  if (adn == NULL) {
-    PBImgAnalysisErr->_type = PBErrTypeNullPointer;
-    sprintf(PBImgAnalysisErr->_msg, "'ga' is null");
-    PBErrCatch(PBImgAnalysisErr);
-  }
 #endif
   // Call the appropriate function based on the type
   switch(that->_type) {
     case ISCType_RGB:
       ISCRGBSetAdnInt((const ImgSegmentorCriterionRGB*)that,
-        adn, shift);
+        adnI, shift);
       break;
     case ISCType_RGB2HSV:
       ISCRGB2HSVSetAdnInt((const ImgSegmentorCriterionRGB2HSV*)that,
-        adn, shift);
+        adnI, shift);
       break;
     case ISCType_Dust:
       ISCDustSetAdnInt((const ImgSegmentorCriterionDust*)that,
-        adn, shift);
+        adnI, shift);
       break;
     case ISCType_Tex:
       ISCTexSetAdnInt((const ImgSegmentorCriterionTex*)that,
-        adn, shift);
+        adnI, shift);
       break;
     default:
       PBImgAnalysisErr->_type = PBErrTypeNotYetImplemented;
@@ -1864,36 +5778,117 @@ void _ISCSetAdnInt(const ImgSegmentorCriterion* const that,
 // Set the values of float parameters for training of the criterion 
 // 'that'
 void _ISCSetAdnFloat(const ImgSegmentorCriterion* const that, 
-  const GenAlgAdn* const adn, const long shift) {
+  const VecFloat* const adnF, const long shift) {
 #if BUILDMODE == 0
   if (that == NULL) {
     PBImgAnalysisErr->_type = PBErrTypeNullPointer;
     sprintf(PBImgAnalysisErr->_msg, "'that' is null");
     PBErrCatch(PBImgAnalysisErr);
   }
-  if (adn == NULL) {
-    PBImgAnalysisErr->_type = PBErrTypeNullPointer;
-    sprintf(PBImgAnalysisErr->_msg, "'ga' is null");
-    PBErrCatch(PBImgAnalysisErr);
-  }
 #endif
   // Call the appropriate function based on the type
   switch(that->_type) {
     case ISCType_RGB:
       ISCRGBSetAdnFloat((const ImgSegmentorCriterionRGB*)that,
-        adn, shift);
+        adnF, shift);
       break;
     case ISCType_RGB2HSV:
       ISCRGB2HSVSetAdnFloat((const ImgSegmentorCriterionRGB2HSV*)that,
-        adn, shift);
+        adnF, shift);
       break;
     case ISCType_Dust:
       ISCDustSetAdnFloat((const ImgSegmentorCriterionDust*)that,
-        adn, shift);
+        adnF, shift);
       break;
     case ISCType_Tex:
       ISCTexSetAdnFloat((const ImgSegmentorCriterionTex*)that,
-        adn, shift);
+        adnF, shift);
+      break;
+    default:
+      PBImgAnalysisErr->_type = PBErrTypeNotYetImplemented;
+      sprintf(PBImgAnalysisErr->_msg, 
+        "Not yet implemented type of criterion");
+      PBErrCatch(PBImgAnalysisErr);
+      break;
+  }
+}
+
+// Copy the values of int parameters of the criterion 'that' in 
+// 'adnI' from the index 'shift'
+void _ISCGetAdnInt(const ImgSegmentorCriterion* const that, 
+  VecLong* const adnI, const long shift) {
+#if BUILDMODE == 0
+  if (that == NULL) {
+    PBImgAnalysisErr->_type = PBErrTypeNullPointer;
+    sprintf(PBImgAnalysisErr->_msg, "'that' is null");
+    PBErrCatch(PBImgAnalysisErr);
+  }
+  if (adnI == NULL) {
+    PBImgAnalysisErr->_type = PBErrTypeNullPointer;
+    sprintf(PBImgAnalysisErr->_msg, "'adnI' is null");
+    PBErrCatch(PBImgAnalysisErr);
+  }
+#endif
+  // Call the appropriate function based on the type
+  switch(that->_type) {
+    case ISCType_RGB:
+      ISCRGBGetAdnInt((const ImgSegmentorCriterionRGB*)that,
+        adnI, shift);
+      break;
+    case ISCType_RGB2HSV:
+      ISCRGB2HSVGetAdnInt((const ImgSegmentorCriterionRGB2HSV*)that,
+        adnI, shift);
+      break;
+    case ISCType_Dust:
+      ISCDustGetAdnInt((const ImgSegmentorCriterionDust*)that,
+        adnI, shift);
+      break;
+    case ISCType_Tex:
+      ISCTexGetAdnInt((const ImgSegmentorCriterionTex*)that,
+        adnI, shift);
+      break;
+    default:
+      PBImgAnalysisErr->_type = PBErrTypeNotYetImplemented;
+      sprintf(PBImgAnalysisErr->_msg, 
+        "Not yet implemented type of criterion");
+      PBErrCatch(PBImgAnalysisErr);
+      break;
+  }
+}
+
+// Copy the values of float parameters of the criterion 'that' in 
+// 'adnF' from the index 'shift'
+void _ISCGetAdnFloat(const ImgSegmentorCriterion* const that, 
+  VecFloat* const adnF, const long shift) {
+#if BUILDMODE == 0
+  if (that == NULL) {
+    PBImgAnalysisErr->_type = PBErrTypeNullPointer;
+    sprintf(PBImgAnalysisErr->_msg, "'that' is null");
+    PBErrCatch(PBImgAnalysisErr);
+  }
+  if (adnF == NULL) {
+    PBImgAnalysisErr->_type = PBErrTypeNullPointer;
+    sprintf(PBImgAnalysisErr->_msg, "'adnF' is null");
+    PBErrCatch(PBImgAnalysisErr);
+  }
+#endif
+  // Call the appropriate function based on the type
+  switch(that->_type) {
+    case ISCType_RGB:
+      ISCRGBGetAdnFloat((const ImgSegmentorCriterionRGB*)that,
+        adnF, shift);
+      break;
+    case ISCType_RGB2HSV:
+      ISCRGB2HSVGetAdnFloat((const ImgSegmentorCriterionRGB2HSV*)that,
+        adnF, shift);
+      break;
+    case ISCType_Dust:
+      ISCDustGetAdnFloat((const ImgSegmentorCriterionDust*)that,
+        adnF, shift);
+      break;
+    case ISCType_Tex:
+      ISCTexGetAdnFloat((const ImgSegmentorCriterionTex*)that,
+        adnF, shift);
       break;
     default:
       PBImgAnalysisErr->_type = PBErrTypeNotYetImplemented;
@@ -1932,6 +5927,10 @@ ImgSegmentorCriterionRGB* ImgSegmentorCriterionRGBCreate(
     VecSet(hidden, iLayer, nbHiddenPerLayer);
   that->_nn = NeuraNetCreateFullyConnected(nbInput, nbClass, hidden);
   VecFree(&hidden);
+  // Initialise the lookup table
+  that->_lutSize = ISCRGB_LUTSIZEDEFAULT;
+  that->_lut = NULL;
+  that->_flagLUTBorrowed = false;
   // Return the new ImgSegmentorCriterionRGB
   return that;
 }
@@ -1943,6 +5942,7 @@ void ImgSegmentorCriterionRGBFree(ImgSegmentorCriterionRGB** that) {
   // Free memory
   ImgSegmentorCriterionFreeStatic((ImgSegmentorCriterion*)(*that));
   NeuraNetFree(&((*that)->_nn));
+  ISCRGBInvalidateLUT(*that);
   free(*that);
 }
 
@@ -1958,6 +5958,10 @@ void ISCRGBEncodeAsJSON(
 #endif
   // NeuraNet model
   JSONAddProp(json, "_neuranet", NNEncodeAsJSON(that->_nn));
+  // Size of the lookup table
+  char val[100];
+  sprintf(val, "%d", ISCRGBGetLUTSize(that));
+  JSONAddProp(json, "_lutSize", val);
 }
   
 // Function which decodes the JSON encoding of a 
@@ -2004,17 +6008,120 @@ bool ISCRGBDecodeAsJSON(
   }
   if (!NNDecodeAsJSON(&((*that)->_nn), prop))
     return false;
+  // Decode the size of the lookup table, optional for compatibility
+  // with models saved before its introduction
+  prop = JSONProperty(json, "_lutSize");
+  if (prop != NULL) {
+    int lutSize = atoi(JSONLblVal(prop));
+    if (lutSize != 0 && (lutSize < 2 || lutSize > 256))
+      return false;
+    (*that)->_lutSize = lutSize;
+  }
   // Return the success code
   return true;
 }
 
+// Compile the NeuraNet of the ImgSegmentorCriterionRGB 'that' into a 
+// lookup table of _lutSize^3 colors. If _lutSize is lower than 256
+// the prediction uses a trilinear interpolation of the table, else 
+// a direct lookup. If _lutSize equals 0 it does nothing
+// The lookup table is invalidated when the NeuraNet is modified
+void ISCRGBCompile(ImgSegmentorCriterionRGB* const that) {
+#if BUILDMODE == 0
+  if (that == NULL) {
+    PBImgAnalysisErr->_type = PBErrTypeNullPointer;
+    sprintf(PBImgAnalysisErr->_msg, "'that' is null");
+    PBErrCatch(PBImgAnalysisErr);
+  }
+#endif
+  // Free the current lookup table if any
+  ISCRGBInvalidateLUT(that);
+  // If the lookup table is not used, nothing to do
+  int size = ISCRGBGetLUTSize(that);
+  if (size == 0)
+    return;
+  long nbClass = ISCGetNbClass(that);
+  // Allocate memory for the lookup table
+  float* lut = PBErrMalloc(PBImgAnalysisErr, 
+    sizeof(float) * (size_t)size * (size_t)size * (size_t)size * 
+    (size_t)nbClass);
+  // Declare variables to memorize the input/output of the NeuraNet
+  VecFloat3D in = VecFloatCreateStatic3D();
+  VecFloat* out = VecFloatCreate(nbClass);
+  // Loop on the samples of the color space, the sample 'i' of a 
+  // channel has the value i / (size - 1)
+  float step = 1.0 / (float)(size - 1);
+  float* entry = lut;
+  for (int r = 0; r < size; ++r) {
+    VecSet(&in, 0, (float)r * step);
+    for (int g = 0; g < size; ++g) {
+      VecSet(&in, 1, (float)g * step);
+      for (int b = 0; b < size; ++b) {
+        VecSet(&in, 2, (float)b * step);
+        NNEval(that->_nn, (VecFloat*)&in, out);
+        memcpy(entry, out->_val, sizeof(float) * nbClass);
+        entry += nbClass;
+      }
+    }
+  }
+  // Free memory
+  VecFree(&out);
+  // Memorize the lookup table
+  that->_lut = lut;
+}
+
+// Free the lookup table of the ImgSegmentorCriterionRGB 'that', the 
+// prediction falls back to the NeuraNet until the next compilation
+void ISCRGBInvalidateLUT(const ImgSegmentorCriterionRGB* const that) {
+#if BUILDMODE == 0
+  if (that == NULL) {
+    PBImgAnalysisErr->_type = PBErrTypeNullPointer;
+    sprintf(PBImgAnalysisErr->_msg, "'that' is null");
+    PBErrCatch(PBImgAnalysisErr);
+  }
+#endif
+  // The lookup table is a cache of the NeuraNet, hence it can be 
+  // invalidated on a const criterion, as ISCRGBSetAdnFloat does
+  ImgSegmentorCriterionRGB* criterion = (ImgSegmentorCriterionRGB*)that;
+  if (criterion->_lut != NULL) {
+    if (!(criterion->_flagLUTBorrowed))
+      free(criterion->_lut);
+    criterion->_lut = NULL;
+    criterion->_flagLUTBorrowed = false;
+  }
+}
+
+// Set the number of samples per color channel of the lookup table of 
+// the ImgSegmentorCriterionRGB 'that' to 'size'
+// 'size' must be 0 (no lookup table) or in [2, 256]
+// Invalidate the current lookup table if any
+void ISCRGBSetLUTSize(ImgSegmentorCriterionRGB* const that, 
+  const int size) {
+#if BUILDMODE == 0
+  if (that == NULL) {
+    PBImgAnalysisErr->_type = PBErrTypeNullPointer;
+    sprintf(PBImgAnalysisErr->_msg, "'that' is null");
+    PBErrCatch(PBImgAnalysisErr);
+  }
+  if (size != 0 && (size < 2 || size > 256)) {
+    PBImgAnalysisErr->_type = PBErrTypeInvalidArg;
+    sprintf(PBImgAnalysisErr->_msg, 
+      "'size' is invalid (%d==0 or 2<=%d<=256)", size, size);
+    PBErrCatch(PBImgAnalysisErr);
+  }
+#endif
+  ISCRGBInvalidateLUT(that);
+  that->_lutSize = size;
+}
+
 // Make the prediction on the 'input' values with the 
 // ImgSegmentorCriterionRGB that
 // 'input' 's format is 3*width*height, values in [0.0, 1.0]
 // Return values are nbClass*width*height, values in [-1.0, 1.0]
-VecFloat* ISCRGBPredict(const ImgSegmentorCriterionRGB* const that,
-  const VecFloat* input, const VecShort2D* const dim, 
-  const int iSample) {
+ImgSegmentorPlane* ISCRGBPredict(
+  const ImgSegmentorCriterionRGB* const that,
+  const ImgSegmentorPlane* const input, const int iSample,
+  const ImgSegmentorCriterionContext* const ctx) {
 #if BUILDMODE == 0
   if (that == NULL) {
     PBImgAnalysisErr->_type = PBErrTypeNullPointer;
@@ -2026,16 +6133,11 @@ VecFloat* ISCRGBPredict(const ImgSegmentorCriterionRGB* const that,
     sprintf(PBImgAnalysisErr->_msg, "'input' is null");
     PBErrCatch(PBImgAnalysisErr);
   }
-  if (dim == NULL) {
-    PBImgAnalysisErr->_type = PBErrTypeNullPointer;
-    sprintf(PBImgAnalysisErr->_msg, "'dim' is null");
-    PBErrCatch(PBImgAnalysisErr);
-  }
-  if ((VecGet(dim, 0) * VecGet(dim, 1) * 3) != VecGetDim(input)) {
+  if (ISPGetNbChannel(input) != 3) {
     PBImgAnalysisErr->_type = PBErrTypeInvalidArg;
     sprintf(PBImgAnalysisErr->_msg, 
-      "'input' 's dim is invalid (%ld=%d*%d*3)", VecGetDim(input),
-        VecGet(dim, 0), VecGet(dim, 1));
+      "'input' 's number of channel is invalid (%d=3)", 
+      ISPGetNbChannel(input));
     PBErrCatch(PBImgAnalysisErr);
   }
 #endif
@@ -2046,20 +6148,82 @@ VecFloat* ISCRGBPredict(const ImgSegmentorCriterionRGB* const that,
     VecGet(input, 3), VecGet(input, 4), VecGet(input, 5));
 */
   // Calculate the area of the input image
-  long area = VecGet(dim, 0) * VecGet(dim, 1);
+  long area = ISPGetArea(input);
+  long nbClass = ISCGetNbClass(that);
   // Allocate memory for the result
-  VecFloat* res = VecFloatCreate(area * (long)ISCGetNbClass(that));
+  ImgSegmentorPlane* res = ImgSegmentorPlaneCreate(ISPDim(input), 
+    nbClass);
+  const float* valIn = ISPVal(input);
+  float* valRes = ISPVal(res);
+  // If the lookup table is compiled
+  if (that->_lut != NULL) {
+    const float* lut = that->_lut;
+    int size = ISCRGBGetLUTSize(that);
+    // If the table covers all the 8 bits colors
+    if (size == 256) {
+      // Direct lookup of each pixel
+      for (long iInput = area; iInput--;) {
+        const float* rgb = valIn + iInput * 3L;
+        long iLut = 0;
+        for (int i = 0; i < 3; ++i) {
+          float v = rgb[i] * 255.0;
+          v = (v < 0.0 ? 0.0 : (v > 255.0 ? 255.0 : v));
+          iLut = iLut * 256L + (long)(v + 0.5);
+        }
+        memcpy(valRes + iInput * nbClass, lut + iLut * nbClass, 
+          sizeof(float) * nbClass);
+      }
+    // Else the table is sparser
+    } else {
+      // Trilinear interpolation of the 8 samples surrounding each pixel
+      long stride[3] = {
+        (long)size * (long)size * nbClass, (long)size * nbClass, 
+        nbClass};
+      for (long iInput = area; iInput--;) {
+        const float* rgb = valIn + iInput * 3L;
+        float* pred = valRes + iInput * nbClass;
+        long iLut = 0;
+        float frac[3];
+        for (int i = 0; i < 3; ++i) {
+          float v = rgb[i] * (float)(size - 1);
+          v = (v < 0.0 ? 0.0 : (v > size - 1 ? size - 1 : v));
+          int iLow = (int)v;
+          if (iLow == size - 1)
+            --iLow;
+          frac[i] = v - (float)iLow;
+          iLut += (long)iLow * stride[i];
+        }
+        const long* shift = stride;
+        const float* c000 = lut + iLut;
+        for (long iClass = nbClass; iClass--;) {
+          const float* c = c000 + iClass;
+          float c00 = c[0] + (c[shift[2]] - c[0]) * frac[2];
+          float c01 = c[shift[1]] + 
+            (c[shift[1] + shift[2]] - c[shift[1]]) * frac[2];
+          float c10 = c[shift[0]] + 
+            (c[shift[0] + shift[2]] - c[shift[0]]) * frac[2];
+          float c11 = c[shift[0] + shift[1]] + 
+            (c[shift[0] + shift[1] + shift[2]] - 
+            c[shift[0] + shift[1]]) * frac[2];
+          float c0 = c00 + (c01 - c00) * frac[1];
+          float c1 = c10 + (c11 - c10) * frac[1];
+          pred[iClass] = c0 + (c1 - c0) * frac[0];
+        }
+      }
+    }
+    return res;
+  }
+  // Get the NeuraNet, the one of the context if any
+  const NeuraNet* nn = (ctx != NULL ? ctx->_nn : that->_nn);
   // Declare variables to memorize the input/output of the NeuraNet
   VecFloat3D in = VecFloatCreateStatic3D();
-  VecFloat* out = VecFloatCreate(ISCGetNbClass(that));
+  VecFloat* out = VecFloatCreate(nbClass);
   // Apply the NeuraNet on inputs
-  for (long iInput = area; iInput-- && !PBIA_CtrlC;) {
-    for (long i = 3; i--;)
-      VecSet(&in, i, VecGet(input, iInput * 3L + i));
-    NNEval(that->_nn, (VecFloat*)&in, out);
-    for (long i = ISCGetNbClass(that); i--;)
-      VecSet(res, iInput * (long)ISCGetNbClass(that) + i,
-        VecGet(out, i));
+  for (long iInput = area; iInput-- && !ISCIsInterrupted(ctx);) {
+    memcpy(in._val, valIn + iInput * 3L, sizeof(float) * 3);
+    NNEval(nn, (VecFloat*)&in, out);
+    memcpy(valRes + iInput * nbClass, out->_val, 
+      sizeof(float) * nbClass);
   }
   // Free memory
   VecFree(&out);
@@ -2137,45 +6301,82 @@ void ISCRGBSetBoundsAdnFloat(const ImgSegmentorCriterionRGB* const that,
 
 // Set the values of int parameters for training of the criterion 'that'
 void ISCRGBSetAdnInt(const ImgSegmentorCriterionRGB* const that,
-  const GenAlgAdn* const adn, const long shift) {
+  const VecLong* const adnI, const long shift) {
 #if BUILDMODE == 0
   if (that == NULL) {
     PBImgAnalysisErr->_type = PBErrTypeNullPointer;
     sprintf(PBImgAnalysisErr->_msg, "'that' is null");
     PBErrCatch(PBImgAnalysisErr);
   }
-  if (adn == NULL) {
-    PBImgAnalysisErr->_type = PBErrTypeNullPointer;
-    sprintf(PBImgAnalysisErr->_msg, "'ga' is null");
-    PBErrCatch(PBImgAnalysisErr);
-  }
 #endif
   // Nothing to do
-  (void)that;(void)adn;(void)shift;
+  (void)that;(void)adnI;(void)shift;
 }
 
 // Set the values of float parameters for training of the criterion 
 // 'that'
 void ISCRGBSetAdnFloat(const ImgSegmentorCriterionRGB* const that,
-  const GenAlgAdn* const adn, const long shift) {
+  const VecFloat* const adnF, const long shift) {
 #if BUILDMODE == 0
   if (that == NULL) {
     PBImgAnalysisErr->_type = PBErrTypeNullPointer;
     sprintf(PBImgAnalysisErr->_msg, "'that' is null");
     PBErrCatch(PBImgAnalysisErr);
   }
-  if (adn == NULL) {
+  if (adnF == NULL) {
     PBImgAnalysisErr->_type = PBErrTypeNullPointer;
-    sprintf(PBImgAnalysisErr->_msg, "'ga' is null");
+    sprintf(PBImgAnalysisErr->_msg, "'adnF' is null");
     PBErrCatch(PBImgAnalysisErr);
   }
 #endif
-  const VecFloat* adnF = GAAdnAdnF(adn);
   VecFloat* bases = VecFloatCreate(ISCRGBGetNbParamFloat(that));
   for (int i = ISCRGBGetNbParamFloat(that); i--;)
     VecSet(bases, i, VecGet(adnF, shift + i));
   NNSetBases((NeuraNet*)ISCRGBNeuraNet(that), bases);
   VecFree(&bases);
+  // The lookup table doesn't match the NeuraNet anymore
+  ISCRGBInvalidateLUT(that);
+}
+
+// Copy the values of int parameters of the criterion 'that' in 
+// 'adnI' from the index 'shift'
+void ISCRGBGetAdnInt(const ImgSegmentorCriterionRGB* const that,
+  VecLong* const adnI, const long shift) {
+#if BUILDMODE == 0
+  if (that == NULL) {
+    PBImgAnalysisErr->_type = PBErrTypeNullPointer;
+    sprintf(PBImgAnalysisErr->_msg, "'that' is null");
+    PBErrCatch(PBImgAnalysisErr);
+  }
+  if (adnI == NULL) {
+    PBImgAnalysisErr->_type = PBErrTypeNullPointer;
+    sprintf(PBImgAnalysisErr->_msg, "'adnI' is null");
+    PBErrCatch(PBImgAnalysisErr);
+  }
+#endif
+  // Nothing to do
+  (void)that;(void)adnI;(void)shift;
+}
+
+// Copy the values of float parameters of the criterion 'that' in 
+// 'adnF' from the index 'shift'
+void ISCRGBGetAdnFloat(const ImgSegmentorCriterionRGB* const that,
+  VecFloat* const adnF, const long shift) {
+#if BUILDMODE == 0
+  if (that == NULL) {
+    PBImgAnalysisErr->_type = PBErrTypeNullPointer;
+    sprintf(PBImgAnalysisErr->_msg, "'that' is null");
+    PBErrCatch(PBImgAnalysisErr);
+  }
+  if (adnF == NULL) {
+    PBImgAnalysisErr->_type = PBErrTypeNullPointer;
+    sprintf(PBImgAnalysisErr->_msg, "'adnF' is null");
+    PBErrCatch(PBImgAnalysisErr);
+  }
+#endif
+  const VecFloat* bases = NNBases(ISCRGBNeuraNet(that));
+  for (long i = ISCRGBGetNbParamFloat(that); i--;)
+    VecSet(adnF, shift + i, VecGet(bases, i));
 }
 
 // ---- ImgSegmentorCriterionRGB2HSV
@@ -2272,10 +6473,10 @@ bool ISCRGB2HSVDecodeAsJSON(
 // ImgSegmentorCriterionRGB2HSV that
 // 'input' 's format is 3*width*height, values in [0.0, 1.0]
 // Return values are nbClass*width*height, values in [-1.0, 1.0]
-VecFloat* ISCRGB2HSVPredict(
+ImgSegmentorPlane* ISCRGB2HSVPredict(
   const ImgSegmentorCriterionRGB2HSV* const that,
-  const VecFloat* input, const VecShort2D* const dim, 
-  const int iSample) {
+  const ImgSegmentorPlane* const input, const int iSample,
+  const ImgSegmentorCriterionContext* const ctx) {
 #if BUILDMODE == 0
   if (that == NULL) {
     PBImgAnalysisErr->_type = PBErrTypeNullPointer;
@@ -2287,16 +6488,11 @@ VecFloat* ISCRGB2HSVPredict(
     sprintf(PBImgAnalysisErr->_msg, "'input' is null");
     PBErrCatch(PBImgAnalysisErr);
   }
-  if (dim == NULL) {
-    PBImgAnalysisErr->_type = PBErrTypeNullPointer;
-    sprintf(PBImgAnalysisErr->_msg, "'dim' is null");
-    PBErrCatch(PBImgAnalysisErr);
-  }
-  if ((VecGet(dim, 0) * VecGet(dim, 1) * 3) != VecGetDim(input)) {
+  if (ISPGetNbChannel(input) != 3) {
     PBImgAnalysisErr->_type = PBErrTypeInvalidArg;
     sprintf(PBImgAnalysisErr->_msg, 
-      "'input' 's dim is invalid (%ld=%d*%d*3)", VecGetDim(input),
-        VecGet(dim, 0), VecGet(dim, 1));
+      "'input' 's number of channel is invalid (%d=3)", 
+      ISPGetNbChannel(input));
     PBErrCatch(PBImgAnalysisErr);
   }
 #endif
@@ -2307,21 +6503,23 @@ VecFloat* ISCRGB2HSVPredict(
 */
   (void)that; (void)iSample;
   // Calculate the area of the input image
-  long area = VecGet(dim, 0) * VecGet(dim, 1);
+  long area = ISPGetArea(input);
   // Allocate memory for the result
-  VecFloat* res = VecFloatCreate(area * 3L);
+  ImgSegmentorPlane* res = ImgSegmentorPlaneCreate(ISPDim(input), 3);
+  const float* valIn = ISPVal(input);
+  float* valRes = ISPVal(res);
   // Loop over the image
-  for (long iPos = 0; iPos < area && !PBIA_CtrlC; ++iPos) {
+  for (long iPos = 0; iPos < area && !ISCIsInterrupted(ctx); ++iPos) {
     // Get the pixel
     GBPixel pix = GBColorWhite;
     for (int iRGB = 3; iRGB--;)
       pix._rgba[iRGB] = (unsigned char)round(
-        255.0 * VecGet(input, iPos * 3 + iRGB));
+        255.0 * valIn[iPos * 3 + iRGB]);
     // Convert to HSV
     pix = GBPixelRGB2HSV(&pix);
     // Update the result
     for (int iHSV = 3; iHSV--;)
-      VecSet(res, iPos * 3 + iHSV, (float)(pix._hsva[iHSV]) / 255.0);
+      valRes[iPos * 3 + iHSV] = (float)(pix._hsva[iHSV]) / 255.0;
   }
   // Return the result
   return res;
@@ -2398,42 +6596,72 @@ void ISCRGB2HSVSetBoundsAdnFloat(
 
 // Set the values of int parameters for training of the criterion 'that'
 void ISCRGB2HSVSetAdnInt(const ImgSegmentorCriterionRGB2HSV* const that,
-  const GenAlgAdn* const adn, const long shift) {
+  const VecLong* const adnI, const long shift) {
 #if BUILDMODE == 0
   if (that == NULL) {
     PBImgAnalysisErr->_type = PBErrTypeNullPointer;
     sprintf(PBImgAnalysisErr->_msg, "'that' is null");
     PBErrCatch(PBImgAnalysisErr);
   }
-  if (adn == NULL) {
-    PBImgAnalysisErr->_type = PBErrTypeNullPointer;
-    sprintf(PBImgAnalysisErr->_msg, "'ga' is null");
-    PBErrCatch(PBImgAnalysisErr);
-  }
 #endif
   // Nothing to do
-  (void)that;(void)adn;(void)shift;
+  (void)that;(void)adnI;(void)shift;
 }
 
 // Set the values of float parameters for training of the criterion 
 // 'that'
 void ISCRGB2HSVSetAdnFloat(
   const ImgSegmentorCriterionRGB2HSV* const that,
-  const GenAlgAdn* const adn, const long shift) {
+  const VecFloat* const adnF, const long shift) {
 #if BUILDMODE == 0
   if (that == NULL) {
     PBImgAnalysisErr->_type = PBErrTypeNullPointer;
     sprintf(PBImgAnalysisErr->_msg, "'that' is null");
     PBErrCatch(PBImgAnalysisErr);
   }
-  if (adn == NULL) {
+#endif
+  // Nothing to do
+  (void)that;(void)adnF;(void)shift;
+}
+
+// Copy the values of int parameters of the criterion 'that' in 
+// 'adnI' from the index 'shift'
+void ISCRGB2HSVGetAdnInt(const ImgSegmentorCriterionRGB2HSV* const that,
+  VecLong* const adnI, const long shift) {
+#if BUILDMODE == 0
+  if (that == NULL) {
     PBImgAnalysisErr->_type = PBErrTypeNullPointer;
-    sprintf(PBImgAnalysisErr->_msg, "'ga' is null");
+    sprintf(PBImgAnalysisErr->_msg, "'that' is null");
+    PBErrCatch(PBImgAnalysisErr);
+  }
+  if (adnI == NULL) {
+    PBImgAnalysisErr->_type = PBErrTypeNullPointer;
+    sprintf(PBImgAnalysisErr->_msg, "'adnI' is null");
+    PBErrCatch(PBImgAnalysisErr);
+  }
+#endif
+  // Nothing to do
+  (void)that;(void)adnI;(void)shift;
+}
+
+// Copy the values of float parameters of the criterion 'that' in 
+// 'adnF' from the index 'shift'
+void ISCRGB2HSVGetAdnFloat(const ImgSegmentorCriterionRGB2HSV* const that,
+  VecFloat* const adnF, const long shift) {
+#if BUILDMODE == 0
+  if (that == NULL) {
+    PBImgAnalysisErr->_type = PBErrTypeNullPointer;
+    sprintf(PBImgAnalysisErr->_msg, "'that' is null");
+    PBErrCatch(PBImgAnalysisErr);
+  }
+  if (adnF == NULL) {
+    PBImgAnalysisErr->_type = PBErrTypeNullPointer;
+    sprintf(PBImgAnalysisErr->_msg, "'adnF' is null");
     PBErrCatch(PBImgAnalysisErr);
   }
 #endif
   // Nothing to do
-  (void)that;(void)adn;(void)shift;
+  (void)that;(void)adnF;(void)shift;
 }
 
 // ---- ImgSegmentorCriterionDust
@@ -2541,10 +6769,10 @@ bool ISCDustDecodeAsJSON(
 // ImgSegmentorCriterionDust that
 // 'input' 's format is 3*width*height, values in [0.0, 1.0]
 // Return values are nbClass*width*height, values in [-1.0, 1.0]
-VecFloat* ISCDustPredict(
+ImgSegmentorPlane* ISCDustPredict(
   const ImgSegmentorCriterionDust* const that,
-  const VecFloat* input, const VecShort2D* const dim, 
-  const int iSample) {
+  const ImgSegmentorPlane* const input, const int iSample,
+  const ImgSegmentorCriterionContext* const ctx) {
 #if BUILDMODE == 0
   if (that == NULL) {
     PBImgAnalysisErr->_type = PBErrTypeNullPointer;
@@ -2556,16 +6784,11 @@ VecFloat* ISCDustPredict(
     sprintf(PBImgAnalysisErr->_msg, "'input' is null");
     PBErrCatch(PBImgAnalysisErr);
   }
-  if (dim == NULL) {
-    PBImgAnalysisErr->_type = PBErrTypeNullPointer;
-    sprintf(PBImgAnalysisErr->_msg, "'dim' is null");
-    PBErrCatch(PBImgAnalysisErr);
-  }
-  if ((VecGet(dim, 0) * VecGet(dim, 1)) != VecGetDim(input)) {
+  if (ISPGetNbChannel(input) != 1) {
     PBImgAnalysisErr->_type = PBErrTypeInvalidArg;
     sprintf(PBImgAnalysisErr->_msg, 
-      "'input' 's dim is invalid (%ld=%d*%d)", VecGetDim(input),
-        VecGet(dim, 0), VecGet(dim, 1));
+      "'input' 's number of channel is invalid (%d=1)", 
+      ISPGetNbChannel(input));
     PBErrCatch(PBImgAnalysisErr);
   }
 #endif
@@ -2574,11 +6797,11 @@ VecFloat* ISCDustPredict(
     VecGet(input, 0), VecGet(input, 1), VecGet(input, 2), 
     VecGet(input, 3), VecGet(input, 4), VecGet(input, 5));
 */
-  (void)that;(void)input;(void)iSample;
+  (void)that;(void)input;(void)iSample;(void)ctx;
   // Calculate the area of the input image
-  long area = VecGet(dim, 0) * VecGet(dim, 1);
+  long area = ISPGetArea(input);
   // Allocate memory for the result
-  VecFloat* res = VecFloatCreate(area * 3L);
+  ImgSegmentorPlane* res = ImgSegmentorPlaneCreate(ISPDim(input), 3);
   // Loop over the image
   for (long iPos = 0; iPos < area; ++iPos) {
 
@@ -2674,20 +6897,19 @@ void ISCDustSetBoundsAdnFloat(
 
 // Set the values of int parameters for training of the criterion 'that'
 void ISCDustSetAdnInt(const ImgSegmentorCriterionDust* const that,
-  const GenAlgAdn* const adn, const long shift) {
+  const VecLong* const adnI, const long shift) {
 #if BUILDMODE == 0
   if (that == NULL) {
     PBImgAnalysisErr->_type = PBErrTypeNullPointer;
     sprintf(PBImgAnalysisErr->_msg, "'that' is null");
     PBErrCatch(PBImgAnalysisErr);
   }
-  if (adn == NULL) {
+  if (adnI == NULL) {
     PBImgAnalysisErr->_type = PBErrTypeNullPointer;
-    sprintf(PBImgAnalysisErr->_msg, "'ga' is null");
+    sprintf(PBImgAnalysisErr->_msg, "'adnI' is null");
     PBErrCatch(PBImgAnalysisErr);
   }
 #endif
-  const VecLong* adnI = GAAdnAdnI(adn);
   for (int i = ISCDustGetNbParamInt(that); i--;)
     ISCDustSetSize(that, i, VecGet(adnI, shift + i));
 }
@@ -2696,21 +6918,56 @@ void ISCDustSetAdnInt(const ImgSegmentorCriterionDust* const that,
 // 'that'
 void ISCDustSetAdnFloat(
   const ImgSegmentorCriterionDust* const that,
-  const GenAlgAdn* const adn, const long shift) {
+  const VecFloat* const adnF, const long shift) {
 #if BUILDMODE == 0
   if (that == NULL) {
     PBImgAnalysisErr->_type = PBErrTypeNullPointer;
     sprintf(PBImgAnalysisErr->_msg, "'that' is null");
     PBErrCatch(PBImgAnalysisErr);
   }
-  if (adn == NULL) {
+#endif
+  // Nothing to do
+  (void)that;(void)adnF;(void)shift;
+}
+
+// Copy the values of int parameters of the criterion 'that' in 
+// 'adnI' from the index 'shift'
+void ISCDustGetAdnInt(const ImgSegmentorCriterionDust* const that,
+  VecLong* const adnI, const long shift) {
+#if BUILDMODE == 0
+  if (that == NULL) {
     PBImgAnalysisErr->_type = PBErrTypeNullPointer;
-    sprintf(PBImgAnalysisErr->_msg, "'ga' is null");
+    sprintf(PBImgAnalysisErr->_msg, "'that' is null");
+    PBErrCatch(PBImgAnalysisErr);
+  }
+  if (adnI == NULL) {
+    PBImgAnalysisErr->_type = PBErrTypeNullPointer;
+    sprintf(PBImgAnalysisErr->_msg, "'adnI' is null");
+    PBErrCatch(PBImgAnalysisErr);
+  }
+#endif
+  for (int i = ISCDustGetNbParamInt(that); i--;)
+    VecSet(adnI, shift + i, ISCDustSize(that, i));
+}
+
+// Copy the values of float parameters of the criterion 'that' in 
+// 'adnF' from the index 'shift'
+void ISCDustGetAdnFloat(const ImgSegmentorCriterionDust* const that,
+  VecFloat* const adnF, const long shift) {
+#if BUILDMODE == 0
+  if (that == NULL) {
+    PBImgAnalysisErr->_type = PBErrTypeNullPointer;
+    sprintf(PBImgAnalysisErr->_msg, "'that' is null");
+    PBErrCatch(PBImgAnalysisErr);
+  }
+  if (adnF == NULL) {
+    PBImgAnalysisErr->_type = PBErrTypeNullPointer;
+    sprintf(PBImgAnalysisErr->_msg, "'adnF' is null");
     PBErrCatch(PBImgAnalysisErr);
   }
 #endif
   // Nothing to do
-  (void)that;(void)adn;(void)shift;
+  (void)that;(void)adnF;(void)shift;
 }
 
 // ---- ImgSegmentorCriterionTex
@@ -2718,6 +6975,7 @@ void ISCDustSetAdnFloat(
 // Create a new ImgSegmentorCriterionTex with 'nbClass' output,
 // 'rank' hidden layers and 3^'size' x 3^'size' down to 1x1 square 
 // fragments of the image as input
+// 'rank' is in [1, ISCTEX_RANKMAX] and 'size' in [1, ISCTEX_SIZEMAX]
 ImgSegmentorCriterionTex* ImgSegmentorCriterionTexCreate(
   const int nbClass, const int rank, const int size) {
 #if BUILDMODE == 0
@@ -2727,16 +6985,16 @@ ImgSegmentorCriterionTex* ImgSegmentorCriterionTexCreate(
       nbClass);
     PBErrCatch(PBImgAnalysisErr);
   }
-  if (rank <= 0) {
+  if (rank <= 0 || rank > ISCTEX_RANKMAX) {
     PBImgAnalysisErr->_type = PBErrTypeInvalidArg;
-    sprintf(PBImgAnalysisErr->_msg, "'rank' is invalid (%d>0)",
-      rank);
+    sprintf(PBImgAnalysisErr->_msg, "'rank' is invalid (0<%d<=%d)",
+      rank, ISCTEX_RANKMAX);
     PBErrCatch(PBImgAnalysisErr);
   }
-  if (size <= 0) {
+  if (size <= 0 || size > ISCTEX_SIZEMAX) {
     PBImgAnalysisErr->_type = PBErrTypeInvalidArg;
-    sprintf(PBImgAnalysisErr->_msg, "'size' is invalid (%d>0)",
-      size);
+    sprintf(PBImgAnalysisErr->_msg, "'size' is invalid (0<%d<=%d)",
+      size, ISCTEX_SIZEMAX);
     PBErrCatch(PBImgAnalysisErr);
   }
 #endif
@@ -2805,87 +7063,421 @@ bool ISCTexDecodeAsJSON(
   }
   if (json == NULL) {
     PBImgAnalysisErr->_type = PBErrTypeNullPointer;
-    sprintf(PBImgAnalysisErr->_msg, "'json' is null");
+    sprintf(PBImgAnalysisErr->_msg, "'json' is null");
+    PBErrCatch(PBImgAnalysisErr);
+  }
+#endif
+  // If the criterion exists
+  if (*that != NULL) {
+    // Free the memory
+    ImgSegmentorCriterionTexFree(that);
+  }
+  // Get the number of class
+  JSONNode* prop = JSONProperty(json, "_nbClass");
+  if (prop == NULL) {
+    return false;
+  }
+  int nbClass = atoi(JSONLblVal(prop));
+  // If the number of class is invalid
+  if (nbClass < 1)
+    // Return the error code
+    return false;
+  // Get the size
+  prop = JSONProperty(json, "_size");
+  if (prop == NULL) {
+    return false;
+  }
+  int size = atoi(JSONLblVal(prop));
+  // If the size is invalid
+  if (size < 1 || size > ISCTEX_SIZEMAX)
+    // Return the error code
+    return false;
+  // Get the rank
+  prop = JSONProperty(json, "_rank");
+  if (prop == NULL) {
+    return false;
+  }
+  int rank = atoi(JSONLblVal(prop));
+  // If the rank is invalid
+  if (rank < 1 || rank > ISCTEX_RANKMAX)
+    // Return the error code
+    return false;
+  // Create the criterion
+  *that = ImgSegmentorCriterionTexCreate(nbClass, rank, size);
+  // If we couldn't create the criterion
+  if (*that == NULL)
+    // Return the failure code
+    return false;
+  // Decode the NeuraNet
+  prop = JSONProperty(json, "_neuranet");
+  if (prop == NULL) {
+    return false;
+  }
+  if (!NNDecodeAsJSON(&((*that)->_nn), prop))
+    return false;
+  // Return the success code
+  return true;
+}
+
+// Create the reused data of the ImgSegmentorCriterionTex 'that' for 
+// a sample of dimensions 'dim'
+ImgSegmentorCriterionTexReuse* ImgSegmentorCriterionTexReuseCreate(
+  const ImgSegmentorCriterionTex* const that, 
+  const VecShort2D* const dim) {
+#if BUILDMODE == 0
+  if (that == NULL) {
+    PBImgAnalysisErr->_type = PBErrTypeNullPointer;
+    sprintf(PBImgAnalysisErr->_msg, "'that' is null");
+    PBErrCatch(PBImgAnalysisErr);
+  }
+  if (dim == NULL) {
+    PBImgAnalysisErr->_type = PBErrTypeNullPointer;
+    sprintf(PBImgAnalysisErr->_msg, "'dim' is null");
+    PBErrCatch(PBImgAnalysisErr);
+  }
+#endif
+  // Allocate memory for the reused data
+  ImgSegmentorCriterionTexReuse* reuse = PBErrMalloc(PBImgAnalysisErr, 
+    sizeof(ImgSegmentorCriterionTexReuse));
+  // Set the properties
+  reuse->_sat = NULL;
+  reuse->_nbIn = ISCTexGetNbInput(that);
+  long area = (long)VecGet(dim, 0) * (long)VecGet(dim, 1);
+  reuse->_inputs = PBErrMalloc(PBImgAnalysisErr, 
+    sizeof(float) * reuse->_nbIn * (size_t)(area > 0 ? area : 1));
+  reuse->_valid = ImgBitMaskCreate(dim);
+  reuse->_flagComplete = false;
+  reuse->_map = NULL;
+  reuse->_mapSize = 0;
+  // Return the reused data
+  return reuse;
+}
+
+// Return the key in the persistent feature cache of the inputs of the 
+// ImgSegmentorCriterionTex 'that' for the sample 'iSample' whose input
+// is 'input'
+// The key is a FNV-1a like hash, on 64 bits words instead of bytes, of
+// the configuration of the criterion, the index of the sample and the
+// values of the input, then the features are recomputed if the 
+// dataset changes
+uint64_t ISCTexGetFeatureCacheKey(
+  const ImgSegmentorCriterionTex* const that,
+  const ImgSegmentorPlane* const input, const long iSample) {
+#if BUILDMODE == 0
+  if (that == NULL) {
+    PBImgAnalysisErr->_type = PBErrTypeNullPointer;
+    sprintf(PBImgAnalysisErr->_msg, "'that' is null");
+    PBErrCatch(PBImgAnalysisErr);
+  }
+  if (input == NULL) {
+    PBImgAnalysisErr->_type = PBErrTypeNullPointer;
+    sprintf(PBImgAnalysisErr->_msg, "'input' is null");
+    PBErrCatch(PBImgAnalysisErr);
+  }
+#endif
+  int64_t config[6] = {ISCTexGetRank(that), ISCTexGetSize(that), 
+    ISCTexGetNbInput(that), iSample, VecGet(ISPDim(input), 0), 
+    VecGet(ISPDim(input), 1)};
+  uint64_t hash = 0xCBF29CE484222325ULL;
+  for (size_t iWord = 0; iWord < 6; ++iWord)
+    hash = (hash ^ (uint64_t)config[iWord]) * 0x100000001B3ULL;
+  // Hash the values of the input by words of 64 bits, the words are 
+  // copied as the values may not be aligned on 8 bytes, then the last 
+  // bytes if any
+  const unsigned char* bytes = (const unsigned char*)ISPVal(input);
+  size_t size = sizeof(float) * (size_t)ISPGetArea(input) * 
+    (size_t)ISPGetNbChannel(input);
+  size_t iByte = 0;
+  for (; iByte + sizeof(uint64_t) <= size; iByte += sizeof(uint64_t)) {
+    uint64_t word;
+    memcpy(&word, bytes + iByte, sizeof(uint64_t));
+    hash = (hash ^ word) * 0x100000001B3ULL;
+  }
+  for (; iByte < size; ++iByte)
+    hash = (hash ^ bytes[iByte]) * 0x100000001B3ULL;
+  // Mix the bits of the hash, the multiplication only propagates the 
+  // low bits of each word toward the high bits
+  hash ^= hash >> 33;
+  hash *= 0xFF51AFD7ED558CCDULL;
+  hash ^= hash >> 33;
+  return hash;
+}
+
+// Return the path of the file for the key 'key' in the persistent 
+// feature cache in the directory 'dir'
+// The returned string must be freed by the user
+char* ISFeatureCacheGetFilePath(const char* const dir, 
+  const uint64_t key) {
+#if BUILDMODE == 0
+  if (dir == NULL) {
+    PBImgAnalysisErr->_type = PBErrTypeNullPointer;
+    sprintf(PBImgAnalysisErr->_msg, "'dir' is null");
+    PBErrCatch(PBImgAnalysisErr);
+  }
+#endif
+  size_t len = strlen(dir) + 32;
+  char* path = PBErrMalloc(PBImgAnalysisErr, len);
+  snprintf(path, len, "%s/%016llx.isfc", dir, (unsigned long long)key);
+  return path;
+}
+
+// Save the complete reused data 'that' of an ImgSegmentorCriterionTex
+// in the persistent feature cache in the directory 'dir' with the key
+// 'key'
+// The file is written under a temporary name and then renamed to be 
+// safely shared by several processes
+// Return true if the data could be saved, else false
+bool ISCTexReuseSave(const ImgSegmentorCriterionTexReuse* const that,
+  const char* const dir, const uint64_t key) {
+#if BUILDMODE == 0
+  if (that == NULL) {
+    PBImgAnalysisErr->_type = PBErrTypeNullPointer;
+    sprintf(PBImgAnalysisErr->_msg, "'that' is null");
+    PBErrCatch(PBImgAnalysisErr);
+  }
+  if (dir == NULL) {
+    PBImgAnalysisErr->_type = PBErrTypeNullPointer;
+    sprintf(PBImgAnalysisErr->_msg, "'dir' is null");
+    PBErrCatch(PBImgAnalysisErr);
+  }
+  if (!(that->_flagComplete)) {
+    PBImgAnalysisErr->_type = PBErrTypeInvalidArg;
+    sprintf(PBImgAnalysisErr->_msg, "'that' is not complete");
+    PBErrCatch(PBImgAnalysisErr);
+  }
+#endif
+  // Create the header
+  const VecShort2D* dim = IBMDim(that->_valid);
+  ISFeatureCacheHeader header;
+  memset(&header, 0, sizeof(ISFeatureCacheHeader));
+  memcpy(header._magic, IS_FEATURECACHEMAGIC, 4);
+  header._version = IS_FEATURECACHEVERSION;
+  header._key = key;
+  header._width = VecGet(dim, 0);
+  header._height = VecGet(dim, 1);
+  header._nbIn = that->_nbIn;
+  header._nbWordPerRow = that->_valid->_nbWordPerRow;
+  // Write the file under a temporary name
+  char* path = ISFeatureCacheGetFilePath(dir, key);
+  size_t len = strlen(path) + 32;
+  char* tmpPath = PBErrMalloc(PBImgAnalysisErr, len);
+  snprintf(tmpPath, len, "%s.%ld.tmp", path, (long)getpid());
+  bool ret = false;
+  FILE* fp = fopen(tmpPath, "wb");
+  if (fp != NULL) {
+    size_t nbInput = (size_t)(header._width * header._height * 
+      header._nbIn);
+    size_t nbWord = (size_t)(header._nbWordPerRow * header._height);
+    ret = (fwrite(&header, sizeof(ISFeatureCacheHeader), 1, fp) == 1 &&
+      fwrite(that->_inputs, sizeof(float), nbInput, fp) == nbInput &&
+      fwrite(that->_valid->_words, sizeof(uint64_t), nbWord, fp) == 
+      nbWord);
+    ret = (fclose(fp) == 0 && ret);
+    // Publish the file atomically
+    if (ret)
+      ret = (rename(tmpPath, path) == 0);
+    if (!ret)
+      remove(tmpPath);
+  }
+  free(tmpPath);
+  free(path);
+  return ret;
+}
+
+// Create the reused data of the ImgSegmentorCriterionTex 'that' for 
+// a sample of dimensions 'dim' by mapping in memory, read only, the 
+// file for the key 'key' in the persistent feature cache in the 
+// directory 'dir'
+// Return NULL if the file doesn't exist or doesn't match
+ImgSegmentorCriterionTexReuse* ImgSegmentorCriterionTexReuseCreateFromFile(
+  const ImgSegmentorCriterionTex* const that, 
+  const VecShort2D* const dim, const char* const dir, 
+  const uint64_t key) {
+#if BUILDMODE == 0
+  if (that == NULL) {
+    PBImgAnalysisErr->_type = PBErrTypeNullPointer;
+    sprintf(PBImgAnalysisErr->_msg, "'that' is null");
+    PBErrCatch(PBImgAnalysisErr);
+  }
+  if (dim == NULL) {
+    PBImgAnalysisErr->_type = PBErrTypeNullPointer;
+    sprintf(PBImgAnalysisErr->_msg, "'dim' is null");
+    PBErrCatch(PBImgAnalysisErr);
+  }
+  if (dir == NULL) {
+    PBImgAnalysisErr->_type = PBErrTypeNullPointer;
+    sprintf(PBImgAnalysisErr->_msg, "'dir' is null");
+    PBErrCatch(PBImgAnalysisErr);
+  }
+#endif
+  // Open the file
+  char* path = ISFeatureCacheGetFilePath(dir, key);
+  int fd = open(path, O_RDONLY);
+  free(path);
+  if (fd < 0)
+    return NULL;
+  // Map the file in memory, the mapping stays valid after closing 
+  // the file
+  struct stat st;
+  void* map = MAP_FAILED;
+  if (fstat(fd, &st) == 0 && 
+    (size_t)st.st_size >= sizeof(ISFeatureCacheHeader))
+    map = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+  close(fd);
+  if (map == MAP_FAILED)
+    return NULL;
+  // Allocate memory for the reused data, its inputs are used in place
+  ImgSegmentorCriterionTexReuse* reuse = PBErrMalloc(PBImgAnalysisErr, 
+    sizeof(ImgSegmentorCriterionTexReuse));
+  reuse->_sat = NULL;
+  reuse->_nbIn = ISCTexGetNbInput(that);
+  reuse->_inputs = NULL;
+  reuse->_valid = ImgBitMaskCreate(dim);
+  reuse->_flagComplete = true;
+  reuse->_map = map;
+  reuse->_mapSize = (size_t)st.st_size;
+  // Check the file against the expected layout
+  const ISFeatureCacheHeader* header = map;
+  long area = (long)VecGet(dim, 0) * (long)VecGet(dim, 1);
+  size_t nbWord = (size_t)(reuse->_valid->_nbWordPerRow * VecGet(dim, 1));
+  size_t nbInput = (size_t)(area * reuse->_nbIn);
+  if (memcmp(header->_magic, IS_FEATURECACHEMAGIC, 4) != 0 ||
+    header->_version != IS_FEATURECACHEVERSION || 
+    header->_key != key ||
+    header->_width != VecGet(dim, 0) || 
+    header->_height != VecGet(dim, 1) ||
+    header->_nbIn != reuse->_nbIn || 
+    header->_nbWordPerRow != reuse->_valid->_nbWordPerRow ||
+    (size_t)st.st_size != sizeof(ISFeatureCacheHeader) + 
+    sizeof(float) * nbInput + sizeof(uint64_t) * nbWord) {
+    ImgSegmentorCriterionTexReuseFree(&reuse);
+    return NULL;
+  }
+  // Use the inputs in place, they are only read as the reused data is
+  // complete, and copy the small mask of validity
+  reuse->_inputs = (float*)((char*)map + sizeof(ISFeatureCacheHeader));
+  memcpy(reuse->_valid->_words, reuse->_inputs + nbInput,
+    sizeof(uint64_t) * nbWord);
+  // Return the reused data
+  return reuse;
+}
+
+// Free the memory used by the reused data 'that' of an 
+// ImgSegmentorCriterionTex
+void ImgSegmentorCriterionTexReuseFree(
+  ImgSegmentorCriterionTexReuse** that) {
+  if (that == NULL || *that == NULL)
+    return;
+  free((*that)->_sat);
+  if ((*that)->_map != NULL)
+    munmap((*that)->_map, (*that)->_mapSize);
+  else
+    free((*that)->_inputs);
+  ImgBitMaskFree(&((*that)->_valid));
+  free(*that);
+  *that = NULL;
+}
+
+// Return the memory used by the reused data 'that' of an 
+// ImgSegmentorCriterionTex, in bytes
+// The summed area table is counted until all the inputs are computed,
+// even if it is not yet computed
+size_t ISCTexReuseGetSize(const ImgSegmentorCriterionTexReuse* const that) {
+#if BUILDMODE == 0
+  if (that == NULL) {
+    PBImgAnalysisErr->_type = PBErrTypeNullPointer;
+    sprintf(PBImgAnalysisErr->_msg, "'that' is null");
+    PBErrCatch(PBImgAnalysisErr);
+  }
+#endif
+  const VecShort2D* dim = IBMDim(that->_valid);
+  size_t width = VecGet(dim, 0);
+  size_t height = VecGet(dim, 1);
+  size_t size = sizeof(ImgSegmentorCriterionTexReuse) + 
+    sizeof(float) * that->_nbIn * width * height + 
+    sizeof(uint64_t) * that->_valid->_nbWordPerRow * height;
+  if (!(that->_flagComplete))
+    size += sizeof(double) * (width + 1) * (height + 1) * 3;
+  return size;
+}
+
+// Return the number of inputs of the NeuraNet of the 
+// ImgSegmentorCriterionTex 'that' for one pixel
+long ISCTexGetNbInput(const ImgSegmentorCriterionTex* const that) {
+#if BUILDMODE == 0
+  if (that == NULL) {
+    PBImgAnalysisErr->_type = PBErrTypeNullPointer;
+    sprintf(PBImgAnalysisErr->_msg, "'that' is null");
     PBErrCatch(PBImgAnalysisErr);
   }
 #endif
-  // If the criterion exists
-  if (*that != NULL) {
-    // Free the memory
-    ImgSegmentorCriterionTexFree(that);
-  }
-  // Get the number of class
-  JSONNode* prop = JSONProperty(json, "_nbClass");
-  if (prop == NULL) {
-    return false;
-  }
-  int nbClass = atoi(JSONLblVal(prop));
-  // If the number of class is invalid
-  if (nbClass < 1)
-    // Return the error code
-    return false;
-  // Get the size
-  prop = JSONProperty(json, "_size");
-  if (prop == NULL) {
-    return false;
-  }
-  int size = atoi(JSONLblVal(prop));
-  // If the size is invalid
-  if (size < 1)
-    // Return the error code
-    return false;
-  // Get the rank
-  prop = JSONProperty(json, "_rank");
-  if (prop == NULL) {
-    return false;
-  }
-  int rank = atoi(JSONLblVal(prop));
-  // If the rank is invalid
-  if (rank < 1)
-    // Return the error code
-    return false;
-  // Create the criterion
-  *that = ImgSegmentorCriterionTexCreate(nbClass, rank, size);
-  // If we couldn't create the criterion
-  if (*that == NULL)
-    // Return the failure code
-    return false;
-  // Decode the NeuraNet
-  prop = JSONProperty(json, "_neuranet");
-  if (prop == NULL) {
-    return false;
+  return 3 * (1 + (ISCTexGetSize(that) == 1 ? 0 : 
+    (ISCTexGetSize(that) - 1) * 9));
+}
+
+// Helper function to create the summed area table of the 'input' 
+// for ISCTexPredict, see ImgSegmentorCriterionTexReuse for its layout
+// The sums are accumulated in double to keep the averages accurate on 
+// big images
+double* ISCTexCreateSAT(const ImgSegmentorPlane* const input) {
+  // Get the dimensions of the input
+  long width = VecGet(ISPDim(input), 0);
+  long height = VecGet(ISPDim(input), 1);
+  long widthSAT = width + 1;
+  const float* valIn = ISPVal(input);
+  // Allocate memory for the table, the first row and column are null
+  double* sat = PBErrMalloc(PBImgAnalysisErr, 
+    sizeof(double) * (size_t)(widthSAT * (height + 1) * 3));
+  memset(sat, 0, sizeof(double) * widthSAT * 3);
+  // Loop on the rows of the input
+  for (long y = 0; y < height; ++y) {
+    double* row = sat + (y + 1) * widthSAT * 3;
+    const double* prevRow = sat + y * widthSAT * 3;
+    const float* rowIn = valIn + y * width * 3;
+    double sumRow[3] = {0.0, 0.0, 0.0};
+    row[0] = row[1] = row[2] = 0.0;
+    // Accumulate the sum over the current row and add it to the 
+    // sum over the previous rows
+    for (long x = 0; x < width; ++x) {
+      for (int i = 0; i < 3; ++i) {
+        sumRow[i] += rowIn[x * 3 + i];
+        row[(x + 1) * 3 + i] = prevRow[(x + 1) * 3 + i] + sumRow[i];
+      }
+    }
   }
-  if (!NNDecodeAsJSON(&((*that)->_nn), prop))
-    return false;
-  // Return the success code
-  return true;
+  // Return the table
+  return sat;
 }
 
 // Helper function to create the input of the NeuraNet in ISCTexPredict
 // and manage reuse of data to speed up the training
-VecFloat* ISCTexGetNNInput(const ImgSegmentorCriterionTex* const that,
-  const VecFloat* input, const VecShort2D* const dim,
-  const int iSample, const int iInput, 
-  GSetVecFloat* const setReusedInput, const VecShort2D* const pos) {
-  int nbIn = 3 * (1 + (ISCTexGetSize(that) == 1 ? 0 :
-    (ISCTexGetSize(that) - 1) * 9));
-  VecFloat* in = NULL;
-  if (!(ISCIsReusedInput(that)) || iSample < 0 || 
-    setReusedInput == NULL || iInput >= GSetNbElem(setReusedInput)) {
-    in = VecFloatCreate(nbIn);
-    // Declare a variable to memorize the dimension of the fragment
-    VecShort2D dimFrag = VecShortCreateStatic2D();
+// The averages over the fragments are computed in constant time with 
+// the summed area table 'sat' of the input
+// If 'reuse' is null the input is computed in 'buffer', else it is 
+// computed once in the block of inputs of 'reuse' and copied in 
+// 'buffer'
+void ISCTexGetNNInput(
+  const ImgSegmentorCriterionTex* const that,
+  const ImgSegmentorPlane* const input, const double* const sat, 
+  const int iInput, ImgSegmentorCriterionTexReuse* const reuse, 
+  const VecShort2D* const pos, VecFloat* const buffer) {
+  float* in = buffer->_val;
+  if (reuse != NULL)
+    in = reuse->_inputs + (size_t)iInput * reuse->_nbIn;
+  if (reuse == NULL || 
+    !IBMGet(reuse->_valid, VecGet(pos, 0), VecGet(pos, 1))) {
+    // Get the values and dimensions of the input
+    const float* valIn = ISPVal(input);
+    long widthSAT = VecGet(ISPDim(input), 0) + 1;
     // Current pixel (fragment of size 1x1)
     for (long i = 3; i--;)
-      VecSet(in, i, VecGet(input, iInput * 3L + i));
+      in[i] = valIn[iInput * 3L + i];
     // Loop on fragment sizes bigger than 1x1
     for (int iSize = 1; iSize < ISCTexGetSize(that); ++iSize) {
       // Get the size of the current fragment
       int sizeFrag = powi(3, iSize);
-      VecSet(&dimFrag, 0, sizeFrag);
-      VecSet(&dimFrag, 1, sizeFrag);
       // Get the area of the frag
-      long areaFrag = sizeFrag * sizeFrag;
+      double areaFrag = sizeFrag * sizeFrag;
       // Get the half size of the current fragment
       int halfSizeFrag = (sizeFrag - 1) / 2;
       // Create the matrix of fragments' start position relative to 
@@ -2903,53 +7495,39 @@ VecFloat* ISCTexGetNNInput(const ImgSegmentorCriterionTex* const that,
       };
       // Loop on the 9 fragments for the current size
       for (int iFrag = 9; iFrag--;) {
-        // Declare a variable to memorize the average value
-        float avg[3] = {0.0, 0.0, 0.0};
         // Get the starting and ending pos for this fragment
-        VecShort2D startPosFrag = VecShortCreateStatic2D();
-        VecSet(&startPosFrag, 0, 
-          VecGet(pos, 0) - relPos[iFrag * 2]);
-        VecSet(&startPosFrag, 1, 
-          VecGet(pos, 1) - relPos[iFrag * 2 + 1]);
-        VecShort2D endPosFrag = VecShortCreateStatic2D();
-        VecSet(&endPosFrag, 0, VecGet(&startPosFrag, 0) + sizeFrag);
-        VecSet(&endPosFrag, 1, VecGet(&startPosFrag, 1) + sizeFrag);
-        // Loop on the fragment to calculate the average rgb value
-        VecShort2D posFrag = startPosFrag;
-        do {
-          long iPosFrag = GBPosIndex(&posFrag, dim) * 3;
-          for (long i = 3; i--;)
-            avg[i] += VecGet(input, iPosFrag + i);
-        } while (VecShiftStep(&posFrag, &startPosFrag, &endPosFrag));
-        for (long i = 3; i--;)
-          avg[i] /= (float)areaFrag;
+        long x0 = VecGet(pos, 0) - relPos[iFrag * 2];
+        long y0 = VecGet(pos, 1) - relPos[iFrag * 2 + 1];
+        long x1 = x0 + sizeFrag;
+        long y1 = y0 + sizeFrag;
+        // Get the corners of the fragment in the summed area table
+        const double* s00 = sat + (y0 * widthSAT + x0) * 3;
+        const double* s01 = sat + (y0 * widthSAT + x1) * 3;
+        const double* s10 = sat + (y1 * widthSAT + x0) * 3;
+        const double* s11 = sat + (y1 * widthSAT + x1) * 3;
         // Set the average value in the input vector
         for (long i = 3; i--;)
-          VecSet(in, 3 * (1 + (iSize - 1) * 9 + iFrag) + i, avg[i]);
+          in[3 * (1 + (iSize - 1) * 9 + iFrag) + i] = 
+            (float)((s11[i] - s01[i] - s10[i] + s00[i]) / areaFrag);
       }
     }
-    // Append the input to the set of reused input for later use
-    if (setReusedInput != NULL) {
-      // Clone the vector because it will be freed later
-      // Should be optimized to avoid cloning
-      GSetAppend(setReusedInput, VecClone(in));
-    }
-  // Else, reuse the previously computed input
-  } else {
-    // Clone the vector because it will be freed later
-    // Should be optimized to avoid cloning
-    in = VecClone(GSetGetJump(setReusedInput, iInput));
+    // Flag the input as computed in the reused data for later use
+    if (reuse != NULL)
+      IBMSet(reuse->_valid, VecGet(pos, 0), VecGet(pos, 1));
   }
-  return in;
+  // Copy the reused input in the buffer for the NeuraNet
+  if (reuse != NULL)
+    memcpy(buffer->_val, in, sizeof(float) * reuse->_nbIn);
 }
 
 // Make the prediction on the 'input' values with the 
 // ImgSegmentorCriterionTex that
 // 'input' 's format is 3*width*height, values in [0.0, 1.0]
 // Return values are nbClass*width*height, values in [-1.0, 1.0]
-VecFloat* ISCTexPredict(const ImgSegmentorCriterionTex* const that,
-  const VecFloat* input, const VecShort2D* const dim,
-  const int iSample) {
+ImgSegmentorPlane* ISCTexPredict(
+  const ImgSegmentorCriterionTex* const that,
+  const ImgSegmentorPlane* const input, const int iSample,
+  const ImgSegmentorCriterionContext* const ctx) {
 #if BUILDMODE == 0
   if (that == NULL) {
     PBImgAnalysisErr->_type = PBErrTypeNullPointer;
@@ -2961,41 +7539,80 @@ VecFloat* ISCTexPredict(const ImgSegmentorCriterionTex* const that,
     sprintf(PBImgAnalysisErr->_msg, "'input' is null");
     PBErrCatch(PBImgAnalysisErr);
   }
-  if (dim == NULL) {
-    PBImgAnalysisErr->_type = PBErrTypeNullPointer;
-    sprintf(PBImgAnalysisErr->_msg, "'dim' is null");
-    PBErrCatch(PBImgAnalysisErr);
-  }
-  if ((VecGet(dim, 0) * VecGet(dim, 1) * 3) != VecGetDim(input)) {
+  if (ISPGetNbChannel(input) != 3) {
     PBImgAnalysisErr->_type = PBErrTypeInvalidArg;
     sprintf(PBImgAnalysisErr->_msg, 
-      "'input' 's dim is invalid (%ld=%d*%d*3)", VecGetDim(input),
-        VecGet(dim, 0), VecGet(dim, 1));
+      "'input' 's number of channel is invalid (%d=3)", 
+      ISPGetNbChannel(input));
     PBErrCatch(PBImgAnalysisErr);
   }
 #endif
-  // Calculate the area of the input image
-  long area = VecGet(dim, 0) * VecGet(dim, 1);
+  // Get the dimensions of the input image
+  const VecShort2D* dim = ISPDim(input);
+  long nbClass = ISCGetNbClass(that);
   // Allocate memory for the result
-  VecFloat* res = VecFloatCreate(area * (long)ISCGetNbClass(that));
-  // Declare variables to memorize the output of the NeuraNet
-  VecFloat* out = VecFloatCreate(ISCGetNbClass(that));
+  ImgSegmentorPlane* res = ImgSegmentorPlaneCreate(dim, nbClass);
+  float* valRes = ISPVal(res);
+  // Declare variables to memorize the input and output of the NeuraNet
+  VecFloat* in = VecFloatCreate(ISCTexGetNbInput(that));
+  VecFloat* out = VecFloatCreate(nbClass);
   // Declare a variable to memorize the index of current pixel in the 
   // input
   long iInput = 0;
   // Calculate the size of the biggest fragment
   int sizeFragMax = powi(3, ISCTexGetSize(that) - 1);
-  // Declare a pointer to the set of reused data for this sample
-  GSetVecFloat* setReusedInput = NULL;
-  // If we reuse data and the data for this sample doesn't exist yet
+  // Declare a pointer to the reused data for this sample
+  ImgSegmentorCriterionTexReuse* reuse = NULL;
+  // Declare a flag to memorize if the reused data is owned by this 
+  // call because it couldn't be added to the reused data
+  bool flagOwnReuse = false;
+  // Get the path of the persistent feature cache
+  const char* cachePath = that->_criterion._featureCachePath;
+  uint64_t key = 0;
+  // Declare pointers to the reuse cache and the entry holding the 
+  // reused data
+  ImgSegmentorReuseCache* cache = that->_criterion._reuseCache;
+  ImgSegmentorReuseEntry* entry = NULL;
+  // If we reuse data, get the reused data for this sample. If it's not
+  // resident, map it from the persistent feature cache or create it 
+  // if the budget allows it
   if (ISCIsReusedInput(that) && iSample >= 0) {
-    if (iSample >= GSetNbElem(ISCReusedInput(that))) {
-      // Create the GSetVecFloat for this sample
-      GSetAppend((GSet*)ISCReusedInput(that), GSetVecFloatCreate());
+    entry = ISRCGetEntry(cache, 
+      (GSet*)ISCReusedInput(that), iSample);
+    if (entry != NULL)
+      reuse = ISRCGetData(cache, entry);
+    if (reuse == NULL) {
+      if (cachePath != NULL) {
+        key = ISCTexGetFeatureCacheKey(that, input, iSample);
+        reuse = ImgSegmentorCriterionTexReuseCreateFromFile(
+          that, dim, cachePath, key);
+      }
+      if (reuse == NULL && entry != NULL)
+        reuse = ImgSegmentorCriterionTexReuseCreate(that, dim);
+      if (reuse != NULL && (entry == NULL || !ISRCAdd(cache, entry, 
+        reuse, ISReuseType_Tex, ISCTexReuseGetSize(reuse)))) {
+        // The mapped data can still be used for this prediction
+        if (reuse->_map != NULL)
+          flagOwnReuse = true;
+        else
+          ImgSegmentorCriterionTexReuseFree(&reuse);
+      }
     }
-    // Get the set of reused inputs for this sample
-    setReusedInput = GSetGet(ISCReusedInput(that), iSample);
   }
+  bool flagWasComplete = (reuse != NULL && reuse->_flagComplete);
+  // Get the summed area table of the input, shared with the reused
+  // data if any. It's not needed if all the inputs of the NeuraNet 
+  // are already in the reused data
+  double* sat = NULL;
+  if (reuse != NULL) {
+    if (reuse->_sat == NULL && !(reuse->_flagComplete))
+      reuse->_sat = ISCTexCreateSAT(input);
+    sat = reuse->_sat;
+  } else {
+    sat = ISCTexCreateSAT(input);
+  }
+  // Get the NeuraNet, the one of the context if any
+  const NeuraNet* nn = (ctx != NULL ? ctx->_nn : that->_nn);
   // Loop on the image 
   VecShort2D pos = VecShortCreateStatic2D();
   do {
@@ -3006,29 +7623,43 @@ VecFloat* ISCTexPredict(const ImgSegmentorCriterionTex* const that,
       VecGet(&pos, 1) >= sizeFragMax - 1 && 
       VecGet(&pos, 1) <= (VecGet(dim, 1) - sizeFragMax)) {
       // Get the input
-      VecFloat* in = ISCTexGetNNInput(
-        that, input, dim, iSample, iInput, setReusedInput, &pos);
+      ISCTexGetNNInput(that, input, sat, iInput, reuse, &pos, in);
       // Apply the NeuraNet on inputs
-      NNEval(that->_nn, in, out);
-      // Free memory
-      VecFree(&in);
+      NNEval(nn, in, out);
       // Store the result
-      for (long i = ISCGetNbClass(that); i--;)
-        VecSet(res, iInput * (long)ISCGetNbClass(that) + i,
-          VecGet(out, i));
-    // Else, we need to create null element for the skipped pixel to 
-    // to keep the index in the GSet matching the iInput
-    } else {
-      if (setReusedInput != NULL &&
-        iInput >= GSetNbElem(setReusedInput)) {
-        GSetAppend((GSet*)setReusedInput, NULL);
-      }
+      memcpy(valRes + iInput * nbClass, out->_val, 
+        sizeof(float) * nbClass);
     }
     // Increment the index of the current pixel in input
     ++iInput;
-  } while (VecStep(&pos, dim) && !PBIA_CtrlC);
+  } while (VecStep(&pos, dim) && !ISCIsInterrupted(ctx));
+  // If the loop on the image has not been interrupted, all the inputs
+  // are in the reused data
+  if (reuse != NULL && !ISCIsInterrupted(ctx))
+    reuse->_flagComplete = true;
+  // If the reused data has just been completed, its summed area table 
+  // is not needed anymore, release it and its share of the budget
+  if (reuse != NULL && !flagWasComplete && reuse->_flagComplete) {
+    free(reuse->_sat);
+    reuse->_sat = NULL;
+    if (!flagOwnReuse)
+      ISRCSetSize(cache, entry, ISCTexReuseGetSize(reuse));
+  }
+  // If the reused data has just been completed, save it in the 
+  // persistent feature cache for the later trainings
+  if (cachePath != NULL && reuse != NULL && !flagWasComplete &&
+    reuse->_flagComplete) {
+    if (key == 0)
+      key = ISCTexGetFeatureCacheKey(that, input, iSample);
+    (void)ISCTexReuseSave(reuse, cachePath, key);
+  }
   // Free memory
+  VecFree(&in);
   VecFree(&out);
+  if (reuse == NULL)
+    free(sat);
+  if (flagOwnReuse)
+    ImgSegmentorCriterionTexReuseFree(&reuse);
   // Return the result
   return res;
 }
@@ -3103,40 +7734,34 @@ void ISCTexSetBoundsAdnFloat(const ImgSegmentorCriterionTex* const that,
 
 // Set the values of int parameters for training of the criterion 'that'
 void ISCTexSetAdnInt(const ImgSegmentorCriterionTex* const that,
-  const GenAlgAdn* const adn, const long shift) {
+  const VecLong* const adnI, const long shift) {
 #if BUILDMODE == 0
   if (that == NULL) {
     PBImgAnalysisErr->_type = PBErrTypeNullPointer;
     sprintf(PBImgAnalysisErr->_msg, "'that' is null");
     PBErrCatch(PBImgAnalysisErr);
   }
-  if (adn == NULL) {
-    PBImgAnalysisErr->_type = PBErrTypeNullPointer;
-    sprintf(PBImgAnalysisErr->_msg, "'ga' is null");
-    PBErrCatch(PBImgAnalysisErr);
-  }
 #endif
   // Nothing to do
-  (void)that;(void)adn;(void)shift;
+  (void)that;(void)adnI;(void)shift;
 }
 
 // Set the values of float parameters for training of the criterion 
 // 'that'
 void ISCTexSetAdnFloat(const ImgSegmentorCriterionTex* const that,
-  const GenAlgAdn* const adn, const long shift) {
+  const VecFloat* const adnF, const long shift) {
 #if BUILDMODE == 0
   if (that == NULL) {
     PBImgAnalysisErr->_type = PBErrTypeNullPointer;
     sprintf(PBImgAnalysisErr->_msg, "'that' is null");
     PBErrCatch(PBImgAnalysisErr);
   }
-  if (adn == NULL) {
+  if (adnF == NULL) {
     PBImgAnalysisErr->_type = PBErrTypeNullPointer;
-    sprintf(PBImgAnalysisErr->_msg, "'ga' is null");
+    sprintf(PBImgAnalysisErr->_msg, "'adnF' is null");
     PBErrCatch(PBImgAnalysisErr);
   }
 #endif
-  const VecFloat* adnF = GAAdnAdnF(adn);
   VecFloat* bases = VecFloatCreate(ISCTexGetNbParamFloat(that));
   for (int i = ISCTexGetNbParamFloat(that); i--;)
     VecSet(bases, i, VecGet(adnF, shift + i));
@@ -3144,6 +7769,310 @@ void ISCTexSetAdnFloat(const ImgSegmentorCriterionTex* const that,
   VecFree(&bases);
 }
 
+// Copy the values of int parameters of the criterion 'that' in 
+// 'adnI' from the index 'shift'
+void ISCTexGetAdnInt(const ImgSegmentorCriterionTex* const that,
+  VecLong* const adnI, const long shift) {
+#if BUILDMODE == 0
+  if (that == NULL) {
+    PBImgAnalysisErr->_type = PBErrTypeNullPointer;
+    sprintf(PBImgAnalysisErr->_msg, "'that' is null");
+    PBErrCatch(PBImgAnalysisErr);
+  }
+  if (adnI == NULL) {
+    PBImgAnalysisErr->_type = PBErrTypeNullPointer;
+    sprintf(PBImgAnalysisErr->_msg, "'adnI' is null");
+    PBErrCatch(PBImgAnalysisErr);
+  }
+#endif
+  // Nothing to do
+  (void)that;(void)adnI;(void)shift;
+}
+
+// Copy the values of float parameters of the criterion 'that' in 
+// 'adnF' from the index 'shift'
+void ISCTexGetAdnFloat(const ImgSegmentorCriterionTex* const that,
+  VecFloat* const adnF, const long shift) {
+#if BUILDMODE == 0
+  if (that == NULL) {
+    PBImgAnalysisErr->_type = PBErrTypeNullPointer;
+    sprintf(PBImgAnalysisErr->_msg, "'that' is null");
+    PBErrCatch(PBImgAnalysisErr);
+  }
+  if (adnF == NULL) {
+    PBImgAnalysisErr->_type = PBErrTypeNullPointer;
+    sprintf(PBImgAnalysisErr->_msg, "'adnF' is null");
+    PBErrCatch(PBImgAnalysisErr);
+  }
+#endif
+  const VecFloat* bases = NNBases(ISCTexNeuraNet(that));
+  for (long i = ISCTexGetNbParamFloat(that); i--;)
+    VecSet(adnF, shift + i, VecGet(bases, i));
+}
+
+
+// ------------------ JSONStreamWriter ----------------------
+
+// ================ Functions implementation ====================
+
+// Create a new static JSONStreamWriter writing on the stream 'stream'
+// in compact form if 'compact' equals true, else in readable form
+// The JSON is written in a single pass with the same layout as 
+// JSONSave, without building the JSONNode tree
+JSONStreamWriter JSONStreamWriterCreateStatic(FILE* const stream, 
+  const bool compact) {
+#if BUILDMODE == 0
+  if (stream == NULL) {
+    PBImgAnalysisErr->_type = PBErrTypeNullPointer;
+    sprintf(PBImgAnalysisErr->_msg, "'stream' is null");
+    PBErrCatch(PBImgAnalysisErr);
+  }
+#endif
+  JSONStreamWriter that;
+  that._stream = stream;
+  that._compact = compact;
+  that._depth = 0;
+  that._nbElem[0] = 0;
+  that._flagError = false;
+  return that;
+}
+
+// Write the string 'str' with the JSONStreamWriter 'that'
+void JSWPuts(JSONStreamWriter* const that, const char* const str) {
+  if (fputs(str, that->_stream) == EOF)
+    that->_flagError = true;
+}
+
+// Start a new element with the label 'key' in the current object or 
+// array of the JSONStreamWriter 'that'
+void JSWStartElem(JSONStreamWriter* const that, const char* const key) {
+  if (that->_nbElem[that->_depth] > 0)
+    JSWPuts(that, ",");
+  // The root element starts on the first line
+  if (!(that->_compact) && that->_depth > 0) {
+    JSWPuts(that, "\n");
+    for (int i = that->_depth; i--;)
+      JSWPuts(that, "  ");
+  }
+  if (key != NULL && fprintf(that->_stream, "\"%s\":", key) < 0)
+    that->_flagError = true;
+  ++(that->_nbElem[that->_depth]);
+}
+
+// Enter a new level of nesting with the opening character 'open' for
+// the element with the label 'key' of the JSONStreamWriter 'that'
+void JSWOpen(JSONStreamWriter* const that, const char* const key,
+  const char* const open) {
+#if BUILDMODE == 0
+  if (that == NULL) {
+    PBImgAnalysisErr->_type = PBErrTypeNullPointer;
+    sprintf(PBImgAnalysisErr->_msg, "'that' is null");
+    PBErrCatch(PBImgAnalysisErr);
+  }
+#endif
+  JSWStartElem(that, key);
+  JSWPuts(that, open);
+  if (that->_depth + 1 >= JSW_MAXDEPTH) {
+    that->_flagError = true;
+    return;
+  }
+  ++(that->_depth);
+  that->_nbElem[that->_depth] = 0;
+}
+
+// Leave the current level of nesting with the closing character 
+// 'close' of the JSONStreamWriter 'that'
+void JSWClose(JSONStreamWriter* const that, const char* const close) {
+#if BUILDMODE == 0
+  if (that == NULL) {
+    PBImgAnalysisErr->_type = PBErrTypeNullPointer;
+    sprintf(PBImgAnalysisErr->_msg, "'that' is null");
+    PBErrCatch(PBImgAnalysisErr);
+  }
+#endif
+  if (that->_depth == 0) {
+    that->_flagError = true;
+    return;
+  }
+  --(that->_depth);
+  if (!(that->_compact)) {
+    JSWPuts(that, "\n");
+    for (int i = that->_depth; i--;)
+      JSWPuts(that, "  ");
+  }
+  JSWPuts(that, close);
+  // End the document with a new line
+  if (!(that->_compact) && that->_depth == 0)
+    JSWPuts(that, "\n");
+}
+
+// Open an object with the label 'key' in the JSONStreamWriter 'that'
+// 'key' is NULL for the root object and the elements of arrays
+void JSWOpenObject(JSONStreamWriter* const that, const char* const key) {
+  JSWOpen(that, key, "{");
+}
+
+// Close the current object of the JSONStreamWriter 'that'
+void JSWCloseObject(JSONStreamWriter* const that) {
+  JSWClose(that, "}");
+}
+
+// Open an array of objects with the label 'key' in the 
+// JSONStreamWriter 'that'
+void JSWOpenArray(JSONStreamWriter* const that, const char* const key) {
+  JSWOpen(that, key, "[");
+}
+
+// Close the current array of the JSONStreamWriter 'that'
+void JSWCloseArray(JSONStreamWriter* const that) {
+  JSWClose(that, "]");
+}
+
+// Add the property 'key' with the value 'val' to the current object 
+// of the JSONStreamWriter 'that'
+void JSWAddProp(JSONStreamWriter* const that, const char* const key,
+  const char* const val) {
+#if BUILDMODE == 0
+  if (that == NULL) {
+    PBImgAnalysisErr->_type = PBErrTypeNullPointer;
+    sprintf(PBImgAnalysisErr->_msg, "'that' is null");
+    PBErrCatch(PBImgAnalysisErr);
+  }
+#endif
+  JSWStartElem(that, key);
+  if (fprintf(that->_stream, "\"%s\"", val) < 0)
+    that->_flagError = true;
+}
+
+// Add the property 'key' with the int value 'val' to the current 
+// object of the JSONStreamWriter 'that'
+void JSWAddPropInt(JSONStreamWriter* const that, const char* const key,
+  const long val) {
+#if BUILDMODE == 0
+  if (that == NULL) {
+    PBImgAnalysisErr->_type = PBErrTypeNullPointer;
+    sprintf(PBImgAnalysisErr->_msg, "'that' is null");
+    PBErrCatch(PBImgAnalysisErr);
+  }
+#endif
+  JSWStartElem(that, key);
+  if (fprintf(that->_stream, "\"%ld\"", val) < 0)
+    that->_flagError = true;
+}
+
+// Add the property 'key' with the float value 'val' to the current 
+// object of the JSONStreamWriter 'that'
+void JSWAddPropFloat(JSONStreamWriter* const that, 
+  const char* const key, const float val) {
+#if BUILDMODE == 0
+  if (that == NULL) {
+    PBImgAnalysisErr->_type = PBErrTypeNullPointer;
+    sprintf(PBImgAnalysisErr->_msg, "'that' is null");
+    PBErrCatch(PBImgAnalysisErr);
+  }
+#endif
+  JSWStartElem(that, key);
+  if (fprintf(that->_stream, "\"%f\"", val) < 0)
+    that->_flagError = true;
+}
+
+// Add the VecFloat 'vec' with the label 'key' to the JSONStreamWriter 
+// 'that', with the same encoding as VecEncodeAsJSON
+void JSWAddVecFloat(JSONStreamWriter* const that, 
+  const char* const key, const VecFloat* const vec) {
+#if BUILDMODE == 0
+  if (that == NULL) {
+    PBImgAnalysisErr->_type = PBErrTypeNullPointer;
+    sprintf(PBImgAnalysisErr->_msg, "'that' is null");
+    PBErrCatch(PBImgAnalysisErr);
+  }
+  if (vec == NULL) {
+    PBImgAnalysisErr->_type = PBErrTypeNullPointer;
+    sprintf(PBImgAnalysisErr->_msg, "'vec' is null");
+    PBErrCatch(PBImgAnalysisErr);
+  }
+#endif
+  JSWOpenObject(that, key);
+  JSWAddPropInt(that, "_dim", VecGetDim(vec));
+  // The values are written inline
+  JSWStartElem(that, "_val");
+  JSWPuts(that, "[");
+  for (long i = 0; i < VecGetDim(vec); ++i)
+    if (fprintf(that->_stream, (i > 0 ? ",\"%f\"" : "\"%f\""), 
+      VecGet(vec, i)) < 0)
+      that->_flagError = true;
+  JSWPuts(that, "]");
+  JSWCloseObject(that);
+}
+
+// Add the VecLong 'vec' with the label 'key' to the JSONStreamWriter 
+// 'that', with the same encoding as VecEncodeAsJSON
+void JSWAddVecLong(JSONStreamWriter* const that, 
+  const char* const key, const VecLong* const vec) {
+#if BUILDMODE == 0
+  if (that == NULL) {
+    PBImgAnalysisErr->_type = PBErrTypeNullPointer;
+    sprintf(PBImgAnalysisErr->_msg, "'that' is null");
+    PBErrCatch(PBImgAnalysisErr);
+  }
+  if (vec == NULL) {
+    PBImgAnalysisErr->_type = PBErrTypeNullPointer;
+    sprintf(PBImgAnalysisErr->_msg, "'vec' is null");
+    PBErrCatch(PBImgAnalysisErr);
+  }
+#endif
+  JSWOpenObject(that, key);
+  JSWAddPropInt(that, "_dim", VecGetDim(vec));
+  // The values are written inline
+  JSWStartElem(that, "_val");
+  JSWPuts(that, "[");
+  for (long i = 0; i < VecGetDim(vec); ++i)
+    if (fprintf(that->_stream, (i > 0 ? ",\"%ld\"" : "\"%ld\""), 
+      VecGet(vec, i)) < 0)
+      that->_flagError = true;
+  JSWPuts(that, "]");
+  JSWCloseObject(that);
+}
+
+// Add the NeuraNet 'nn' with the label 'key' to the JSONStreamWriter 
+// 'that', with the same encoding as NNEncodeAsJSON
+void JSWAddNeuraNet(JSONStreamWriter* const that, 
+  const char* const key, const NeuraNet* const nn) {
+#if BUILDMODE == 0
+  if (that == NULL) {
+    PBImgAnalysisErr->_type = PBErrTypeNullPointer;
+    sprintf(PBImgAnalysisErr->_msg, "'that' is null");
+    PBErrCatch(PBImgAnalysisErr);
+  }
+  if (nn == NULL) {
+    PBImgAnalysisErr->_type = PBErrTypeNullPointer;
+    sprintf(PBImgAnalysisErr->_msg, "'nn' is null");
+    PBErrCatch(PBImgAnalysisErr);
+  }
+#endif
+  JSWOpenObject(that, key);
+  JSWAddPropInt(that, "_nbInputVal", nn->_nbInputVal);
+  JSWAddPropInt(that, "_nbOutputVal", nn->_nbOutputVal);
+  JSWAddPropInt(that, "_nbMaxHidVal", nn->_nbMaxHidVal);
+  JSWAddPropInt(that, "_nbMaxBases", nn->_nbMaxBases);
+  JSWAddPropInt(that, "_nbMaxLinks", nn->_nbMaxLinks);
+  JSWAddVecFloat(that, "_bases", nn->_bases);
+  JSWAddVecLong(that, "_links", nn->_links);
+  JSWCloseObject(that);
+}
+
+// Return true if all the writings of the JSONStreamWriter 'that' 
+// succeeded, else false
+bool JSWIsOk(const JSONStreamWriter* const that) {
+#if BUILDMODE == 0
+  if (that == NULL) {
+    PBImgAnalysisErr->_type = PBErrTypeNullPointer;
+    sprintf(PBImgAnalysisErr->_msg, "'that' is null");
+    PBErrCatch(PBImgAnalysisErr);
+  }
+#endif
+  return !(that->_flagError) && that->_depth == 0;
+}
 
 // ------------------ General functions ----------------------
 
@@ -3208,6 +8137,49 @@ float IntersectionOverUnion(const GenBrush* const that,
   return iou;
 }
 
+// Return the Jaccard index (aka intersection over union) of the 
+// ImgBitMask 'that' and 'tho' for the bits set to 1
+// 'that' and 'tho' must have same dimensions
+float IntersectionOverUnionBitMask(const ImgBitMask* const that, 
+  const ImgBitMask* const tho) {
+#if BUILDMODE == 0
+  if (that == NULL) {
+    PBImgAnalysisErr->_type = PBErrTypeNullPointer;
+    sprintf(PBImgAnalysisErr->_msg, "'that' is null");
+    PBErrCatch(PBImgAnalysisErr);
+  }
+  if (tho == NULL) {
+    PBImgAnalysisErr->_type = PBErrTypeNullPointer;
+    sprintf(PBImgAnalysisErr->_msg, "'tho' is null");
+    PBErrCatch(PBImgAnalysisErr);
+  }
+  if (!VecIsEqual(IBMDim(that), IBMDim(tho))) {
+    PBImgAnalysisErr->_type = PBErrTypeInvalidArg;
+    sprintf(PBImgAnalysisErr->_msg, 
+      "'that' and 'tho' have different dimensions");
+    PBErrCatch(PBImgAnalysisErr);
+  }
+#endif
+  // Count the number of pixels in intersection and union, 64 pixels
+  // at a time, the padding bits being 0 they are never counted
+  long nbUnion = 0;
+  long nbInter = 0;
+  for (long iWord = that->_nbWordPerRow * VecGet(IBMDim(that), 1); 
+    iWord--;) {
+    uint64_t a = that->_words[iWord];
+    uint64_t b = tho->_words[iWord];
+    nbInter += __builtin_popcountll(a & b);
+    nbUnion += __builtin_popcountll(a | b);
+  }
+  // Calculate the intersection over union
+  // By definition if nbUnion equals 0 then iou equals 1.0
+  float iou = 1.0;
+  if (nbUnion > 0)
+    iou = (float)nbInter / (float)nbUnion;
+  // Return the result
+  return iou;
+}
+
 // Return the similarity coefficient of the images 'that' and 'tho'
 // (i.e. the sum of the distances of pixels at the same position
 // over the whole image)
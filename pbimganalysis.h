@@ -13,6 +13,14 @@
 #include <string.h>
 #include <time.h>
 #include <signal.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <unistd.h>
+#include <stdint.h>
+#include <limits.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 #include "pberr.h"
 #include "genbrush.h"
 #include "genalg.h"
@@ -21,12 +29,125 @@
 #include "gdataset.h"
 #include "respublish.h"
 
+// ------------------ JSONStreamWriter ----------------------
+
+// ================= Define ==================
+
+// Maximum depth of nesting of the JSONStreamWriter
+#define JSW_MAXDEPTH 256
+
+// ================= Data structure ===================
+
+typedef struct JSONStreamWriter {
+  // Stream where the JSON is written
+  FILE* _stream;
+  // Flag for the compact form, else readable form
+  bool _compact;
+  // Current depth of nesting
+  int _depth;
+  // Number of elements already written at each depth
+  long _nbElem[JSW_MAXDEPTH];
+  // Flag memorizing if an error occured while writing
+  bool _flagError;
+} JSONStreamWriter;
+
+// ================ Functions declaration ====================
+
+// Create a new static JSONStreamWriter writing on the stream 'stream'
+// in compact form if 'compact' equals true, else in readable form
+// The JSON is written in a single pass with the same layout as 
+// JSONSave, without building the JSONNode tree
+JSONStreamWriter JSONStreamWriterCreateStatic(FILE* const stream, 
+  const bool compact);
+
+// Open an object with the label 'key' in the JSONStreamWriter 'that'
+// 'key' is NULL for the root object and the elements of arrays
+void JSWOpenObject(JSONStreamWriter* const that, const char* const key);
+
+// Close the current object of the JSONStreamWriter 'that'
+void JSWCloseObject(JSONStreamWriter* const that);
+
+// Open an array of objects with the label 'key' in the 
+// JSONStreamWriter 'that'
+void JSWOpenArray(JSONStreamWriter* const that, const char* const key);
+
+// Close the current array of the JSONStreamWriter 'that'
+void JSWCloseArray(JSONStreamWriter* const that);
+
+// Add the property 'key' with the value 'val' to the current object 
+// of the JSONStreamWriter 'that'
+void JSWAddProp(JSONStreamWriter* const that, const char* const key,
+  const char* const val);
+
+// Add the property 'key' with the int value 'val' to the current 
+// object of the JSONStreamWriter 'that'
+void JSWAddPropInt(JSONStreamWriter* const that, const char* const key,
+  const long val);
+
+// Add the property 'key' with the float value 'val' to the current 
+// object of the JSONStreamWriter 'that'
+void JSWAddPropFloat(JSONStreamWriter* const that, 
+  const char* const key, const float val);
+
+// Add the VecFloat 'vec' with the label 'key' to the JSONStreamWriter 
+// 'that', with the same encoding as VecEncodeAsJSON
+void JSWAddVecFloat(JSONStreamWriter* const that, 
+  const char* const key, const VecFloat* const vec);
+
+// Add the VecLong 'vec' with the label 'key' to the JSONStreamWriter 
+// 'that', with the same encoding as VecEncodeAsJSON
+void JSWAddVecLong(JSONStreamWriter* const that, 
+  const char* const key, const VecLong* const vec);
+
+// Add the NeuraNet 'nn' with the label 'key' to the JSONStreamWriter 
+// 'that', with the same encoding as NNEncodeAsJSON
+void JSWAddNeuraNet(JSONStreamWriter* const that, 
+  const char* const key, const NeuraNet* const nn);
+
+// Return true if all the writings of the JSONStreamWriter 'that' 
+// succeeded, else false
+bool JSWIsOk(const JSONStreamWriter* const that);
+
 // ------------------ ImgKMeansClusters ----------------------
 
 // ================= Define ==================
 
+// Size of the side of the square tiles of pixels sampled from the 
+// image by the mini-batch search
+#define IKMC_MINIBATCHTILE 16
+// Number of pixels sampled from each tile, so that a batch spreads 
+// over several tiles
+#define IKMC_MINIBATCHPIXPERTILE 8
+// Maximum number of iterations of the mini-batch search
+#define IKMC_MINIBATCHMAXITER 1000
+// The mini-batch search stops when no center has moved by more than 
+// this distance between the beginning and the end of an iteration
+#define IKMC_MINIBATCHEPSILON 0.01
+// Maximum number of iterations of the Lloyd and Hamerly searches
+#define IKMC_MAXITER 1000
+// Relative margin on the distance bounds of the Hamerly search, 
+// covering the rounding errors of the distances so that it gives the
+// same assignments as the Lloyd search
+#define IKMC_BOUNDMARGIN 0.0001
+
 // ================= Data structure ===================
 
+typedef enum IKMCSearchMode {
+  // Search of the KMeansClusters
+  IKMCSearchMode_KMeansClusters,
+  // Lloyd k-means over the packed inputs
+  IKMCSearchMode_Lloyd,
+  // Lloyd k-means accelerated with distance bounds (Hamerly)
+  IKMCSearchMode_Hamerly
+} IKMCSearchMode;
+
+typedef struct IKMCCell {
+  // Number of pixels in the disk-shaped cell
+  int _nbPixel;
+  // Positions (x, y) of the pixels relative to the center of the cell
+  short* _offsets;
+} IKMCCell;
+
 typedef struct ImgKMeansClusters {
   // Image on which the clustering is applied
   // Uses the GBSurfaceFinalPixels
@@ -36,8 +157,79 @@ typedef struct ImgKMeansClusters {
   // Size of the considered cell in the image around a given position 
   // is equal to (_size * 2 + 1)
   int _size;
+  // Pixels of the cell, updated at the same time as _size
+  IKMCCell _cell;
+  // Average pixel of each cluster, indexed by the cluster's id
+  // Updated by IKMCSearch and IKMCDecodeAsJSON
+  GBPixel* _lut;
+  // Centers of the clusters packed in one array of K*_dimCenter 
+  // values, updated at the same time as _lut
+  float* _centers;
+  // Dimension of the centers of the clusters
+  int _dimCenter;
+  // Nb of threads used to compute the inputs over cells and the ids 
+  // of the pixels, 1 by default
+  int _nbThread;
+  // Algorithm used by the search when the size of batch is 0, 
+  // IKMCSearchMode_KMeansClusters by default
+  IKMCSearchMode _searchMode;
+  // Number of distances to centers computed by the last search, 0 for
+  // the search of the KMeansClusters
+  long _nbDist;
+  // Number of pixels per batch of the mini-batch search, if 0 the 
+  // search uses all the pixels of the image at once, 0 by default
+  int _sizeBatch;
 } ImgKMeansClusters;
 
+typedef struct IKMCWorker {
+  // ImgKMeansClusters on which the worker is applied
+  const ImgKMeansClusters* _ikmc;
+  // Task of the worker, applied to the items in [_first, _end[
+  void (*_task)(struct IKMCWorker* const worker);
+  long _first;
+  long _end;
+  // Argument of the task, shared by all the workers
+  void* _arg;
+  // Number of distances to centers computed by the task
+  long _nbDist;
+  // Thread of the worker and flag set if the thread has been created
+  pthread_t _thread;
+  bool _flagThread;
+} IKMCWorker;
+
+typedef struct IKMCAssignTask {
+  // Packed inputs and their dimension
+  const float* _inputs;
+  int _dim;
+  // Number of centers and packed centers
+  int _K;
+  const float* _centers;
+  // Current center of each input, used only with the bounds, and 
+  // next center of each input
+  const int* _assign;
+  int* _next;
+  // Bounds of the Hamerly search, null for the Lloyd search: upper 
+  // bound of the distance of each input to its center, lower bound
+  // of its distance to the other centers and half distance of each 
+  // center to its nearest other center
+  float* _upper;
+  float* _lower;
+  const float* _halfDist;
+  // Flag set during the first assignment, when there is no bound yet
+  bool _flagFirst;
+} IKMCAssignTask;
+
+typedef struct IKMCPixelTask {
+  // Inputs over cells, 4*_cell._nbPixel values per pixel, if null 
+  // the inputs are not memorized
+  float* _inputs;
+  // Inputs over cells, one VecFloat per pixel, if null the inputs are
+  // not memorized
+  VecFloat** _vecInputs;
+  // Map of the ids of the pixels, if null the ids are not computed
+  unsigned short* _labels;
+} IKMCPixelTask;
+
 // ================ Functions declaration ====================
 
 // Create a new ImgKMeansClusters for the image 'img' and with seed 'seed'
@@ -49,6 +241,13 @@ ImgKMeansClusters ImgKMeansClustersCreateStatic(
 // Free the memory used by a ImgKMeansClusters
 void ImgKMeansClustersFreeStatic(ImgKMeansClusters* const that);
 
+// Create the IKMCCell of the pixels at a distance rounded to less or 
+// equal than 'size' from the center of a cell
+IKMCCell IKMCCellCreateStatic(const int size);
+
+// Free the memory used by the IKMCCell 'that'
+void IKMCCellFreeStatic(IKMCCell* const that);
+
 // Get the GenBrush of the ImgKMeansClusters 'that'
 #if BUILDMODE != 0
 static inline
@@ -87,14 +286,76 @@ static inline
 const KMeansClusters* IKMCKMeansClusters(
   const ImgKMeansClusters* const that);
 
+// Return the nb of threads used by the ImgKMeansClusters 'that'
+#if BUILDMODE != 0
+static inline
+#endif 
+int IKMCGetNbThread(const ImgKMeansClusters* const that);
+
+// Set the nb of threads used by the ImgKMeansClusters 'that' to 'nb'
+#if BUILDMODE != 0
+static inline
+#endif 
+void IKMCSetNbThread(ImgKMeansClusters* const that, const int nb);
+
+// Return the algorithm used by the search of the ImgKMeansClusters 
+// 'that'
+#if BUILDMODE != 0
+static inline
+#endif 
+IKMCSearchMode IKMCGetSearchMode(const ImgKMeansClusters* const that);
+
+// Set the algorithm used by the search of the ImgKMeansClusters 
+// 'that' to 'mode'
+#if BUILDMODE != 0
+static inline
+#endif 
+void IKMCSetSearchMode(ImgKMeansClusters* const that, 
+  const IKMCSearchMode mode);
+
+// Return the number of distances to centers computed by the last 
+// search of the ImgKMeansClusters 'that'
+#if BUILDMODE != 0
+static inline
+#endif 
+long IKMCGetNbDist(const ImgKMeansClusters* const that);
+
+// Return the number of pixels per batch of the mini-batch search of 
+// the ImgKMeansClusters 'that'
+#if BUILDMODE != 0
+static inline
+#endif 
+int IKMCGetSizeBatch(const ImgKMeansClusters* const that);
+
+// Set the number of pixels per batch of the mini-batch search of 
+// the ImgKMeansClusters 'that' to 'size'
+// If 'size' is 0 the search uses all the pixels of the image at once
+#if BUILDMODE != 0
+static inline
+#endif 
+void IKMCSetSizeBatch(ImgKMeansClusters* const that, const int size);
+
 // Search for the 'K' clusters in the image of the
 // ImgKMeansClusters 'that'
+// If the size of batch is not 0 the search is a mini-batch k-means 
+// over random tiles of the image, else it depends on the search mode:
+// IKMCSearchMode_KMeansClusters (default) uses the search of 
+// KMeansClusters, IKMCSearchMode_Lloyd the in-tree Lloyd k-means and
+// IKMCSearchMode_Hamerly the Lloyd k-means accelerated with distance
+// bounds
 void IKMCSearch(ImgKMeansClusters* const that, const int K);
 
 // Print the ImgKMeansClusters 'that' on the stream 'stream'
 void IKMCPrintln(const ImgKMeansClusters* const that, 
   FILE* const stream);
 
+// Get the input values for the pixel at position 'pos' according to
+// the cell size of the ImgKMeansClusters 'that'
+// The return is a VecFloat made of the sizeCell^2 pixels' value 
+// around pos ordered by (((a*256+b)*256+g)*256+r) descending
+VecFloat* IKMCGetInputOverCell(const ImgKMeansClusters* const that, 
+  const VecShort2D* const pos);
+
 // Get the index of the cluster at position 'pos' for the 
 // ImgKMeansClusters 'that' 
 int IKMCGetId(const ImgKMeansClusters* const that, 
@@ -105,6 +366,22 @@ int IKMCGetId(const ImgKMeansClusters* const that,
 GBPixel IKMCGetPixel(const ImgKMeansClusters* const that, 
   const VecShort2D* const pos);
 
+// Get the average pixel of the 'id'-th cluster of the 
+// ImgKMeansClusters 'that'
+#if BUILDMODE != 0
+static inline
+#endif 
+const GBPixel* IKMCGetPixelCluster(const ImgKMeansClusters* const that, 
+  const int id);
+
+// Return the map of the cluster's id for each pixel of the image of 
+// the ImgKMeansClusters 'that'
+// The map is an array of width*height values, the id for the pixel at
+// position (x, y) being at index (y * width + x)
+// IKMCSearch must have been called previously 
+// The returned array must be freed by the user
+unsigned short* IKMCGetLabelMap(const ImgKMeansClusters* const that);
+
 // Convert the image of the ImageKMeansClusters 'that' to its clustered
 // version
 // IKMCSearch must have been called previously 
@@ -130,6 +407,11 @@ JSONNode* IKMCEncodeAsJSON(const ImgKMeansClusters* const that);
 bool IKMCDecodeAsJSON(ImgKMeansClusters* that, 
   const JSONNode* const json);
 
+// Write the JSON encoding of 'that' with the JSONStreamWriter 'writer'
+// It's the same encoding as IKMCEncodeAsJSON
+void IKMCEncodeAsJSONStream(const ImgKMeansClusters* const that, 
+  JSONStreamWriter* const writer);
+
 // ================= Polymorphism ==================
 
 // ------------------ General functions ----------------------
@@ -164,8 +446,235 @@ float GBSimilarityCoeff(const GenBrush* const that,
 
 #define IS_CHECKPOINTFILENAME "checkpoint.json"
 
+// Amplitude of the mutation of the parameters of the non elite 
+// entities of a warm started training, relative to the range of their
+// bounds
+#define IS_WARMSTARTMUTATION 0.1
+
+// Alignment in bytes of the values of the ImgSegmentorPlane
+#define IS_PLANEALIGN 32
+
+// Number of bits per word of the ImgBitMask
+#define IBM_WORDSIZE 64
+
+// Default memory budget in bytes of the cache of predictions of the 
+// criteria during training
+#define IS_PREDCACHEBUDGETDEFAULT ((size_t)256 * 1024 * 1024)
+// Number of buckets of the cache of predictions of the criteria
+#define IS_PREDCACHENBBUCKET 4096
+
+// Maximum rank and size of the ImgSegmentorCriterionTex, the size of 
+// the biggest fragment is 3^(size-1) and the NeuraNet grows with both
+#define ISCTEX_RANKMAX 8
+#define ISCTEX_SIZEMAX 6
+
+// Magic number and version of the binary format of the ImgSegmentor
+#define IS_BINMAGIC "ISBN"
+#define IS_BINVERSION 2
+// Alignment in bytes of the arrays in the binary format of the 
+// ImgSegmentor
+#define IS_BINALIGN 32
+
+// Magic number and version of the files of the persistent feature 
+// cache
+#define IS_FEATURECACHEMAGIC "ISFC"
+#define IS_FEATURECACHEVERSION 2
+
+// Magic number and version of the files of the training state
+#define IS_TRAINSTATEMAGIC "ISTS"
+#define IS_TRAINSTATEVERSION 2
+// Size in bytes of the private state of the random generator during 
+// training, given to initstate
+#define IS_RNGSTATESIZE 256
+
+// Default number of samples per color channel of the lookup table 
+// of ImgSegmentorCriterionRGB, the lookup table is opt-in as a table 
+// with less than 256 samples per channel approximates the NeuraNet
+#define ISCRGB_LUTSIZEDEFAULT 0
+
 // ================= Data structure ===================
 
+typedef struct ImgSegmentorPlane {
+  // Dimensions of the image
+  VecShort2D _dim;
+  // Number of values per pixel
+  int _nbChannel;
+  // Values, row-major, contiguous and aligned on IS_PLANEALIGN bytes
+  // The value for the channel 'iChannel' of the pixel at position 
+  // (x, y) is at index (y * width + x) * _nbChannel + iChannel
+  float* _val;
+} ImgSegmentorPlane;
+
+typedef struct ImgBitMask {
+  // Dimensions of the image
+  VecShort2D _dim;
+  // Number of words per row
+  long _nbWordPerRow;
+  // Bits, one per pixel, row-major, each row starting on a new word
+  // The bit of the pixel at position (x, y) is the bit 
+  // (x % IBM_WORDSIZE) of the word (y * _nbWordPerRow + x / IBM_WORDSIZE)
+  // The bits after the last pixel of a row are always 0
+  uint64_t* _words;
+} ImgBitMask;
+
+typedef enum ISReuseType {
+  ISReuseType_Plane, ISReuseType_Tex
+} ISReuseType;
+
+typedef struct ISBinHeader {
+  // Magic number, IS_BINMAGIC
+  char _magic[4];
+  // Version of the format, IS_BINVERSION
+  uint32_t _version;
+  // Properties of the ImgSegmentor
+  int32_t _nbClass;
+  int32_t _flagBinaryResult;
+  float _thresholdBinaryResult;
+  uint32_t _nbEpoch;
+  int32_t _sizePool;
+  int32_t _nbElite;
+  float _targetBestValue;
+  // Number of nodes in the tree of criteria, including the root
+  int32_t _nbNode;
+  // Size in bytes of the file
+  uint64_t _size;
+  // The header is followed by the _nbNode ISBinNode of the tree of 
+  // criteria in depth first order, then by the arrays of the nodes, 
+  // each aligned on IS_BINALIGN bytes
+} ISBinHeader;
+
+typedef struct ISBinNode {
+  // Number of subtrees of the node
+  int32_t _nbSubtree;
+  // Type of the criterion, -1 if the node has no criterion
+  int32_t _type;
+  // Number of class, flag to reuse the input of the criterion and 
+  // flag to freeze its parameters
+  int32_t _nbClass;
+  int32_t _flagReusedInput;
+  int32_t _flagFrozen;
+  // Parameters of the criterion (RGB: size of the lookup table; Tex: 
+  // rank and size)
+  int32_t _param[2];
+  // Padding to align the following values on 8 bytes
+  int32_t _padding;
+  // Number and offset in the file of the bases of the NeuraNet
+  int64_t _nbBase;
+  uint64_t _offBase;
+  // Number and offset in the file of the values of the lookup table, 
+  // 0 if not compiled
+  int64_t _nbLUT;
+  uint64_t _offLUT;
+  // Number and offset in the file of the int64_t values of the 
+  // criterion (Dust: dust size for each class)
+  int64_t _nbInt;
+  uint64_t _offInt;
+} ISBinNode;
+
+typedef struct ISFeatureCacheHeader {
+  // Magic number, IS_FEATURECACHEMAGIC
+  char _magic[4];
+  // Version of the format, IS_FEATURECACHEVERSION
+  uint32_t _version;
+  // Key of the features, see ISCTexGetFeatureCacheKey
+  uint64_t _key;
+  // Dimensions of the sample
+  int64_t _width;
+  int64_t _height;
+  // Number of inputs per pixel and number of words per row of the 
+  // mask of validity
+  int64_t _nbIn;
+  int64_t _nbWordPerRow;
+  // The header is followed by the inputs of the pixels (_nbIn floats 
+  // per pixel, row-major) and the words of the mask of validity
+} ISFeatureCacheHeader;
+
+typedef struct ImgSegmentorReuseEntry {
+  // Reused data for one sample, NULL if not resident
+  void* _data;
+  // Type of the reused data (ImgSegmentorPlane or 
+  // ImgSegmentorCriterionTexReuse)
+  ISReuseType _type;
+  // Memory used by the reused data, in bytes
+  size_t _size;
+  // Number of users preventing the eviction of the reused data
+  int _nbPin;
+  // Previous and next resident entries in the order of use, most 
+  // recent first
+  struct ImgSegmentorReuseEntry* _prevUse;
+  struct ImgSegmentorReuseEntry* _nextUse;
+} ImgSegmentorReuseEntry;
+
+typedef struct ImgSegmentorReuseStats {
+  // Number of reused data found resident
+  long _nbHit;
+  // Number of reused data not resident
+  long _nbMiss;
+  // Number of reused data evicted to respect the memory budget
+  long _nbEviction;
+  // Memory used by the resident reused data, in bytes
+  size_t _size;
+} ImgSegmentorReuseStats;
+
+typedef struct ImgSegmentorReuseCache {
+  // Memory budget in bytes, 0 for no limit
+  size_t _budget;
+  // Statistics of use
+  ImgSegmentorReuseStats _stats;
+  // Resident entries in the order of use
+  ImgSegmentorReuseEntry* _mostRecent;
+  ImgSegmentorReuseEntry* _leastRecent;
+  // Flag to forbid the addition of reused data, set while the entities
+  // are evaluated in parallel
+  bool _flagReadOnly;
+  // Mutex protecting the cache, shared by the threads of the training
+  pthread_mutex_t _mutex;
+} ImgSegmentorReuseCache;
+
+typedef struct ImgSegmentorPredCacheKey {
+  // Hash of the parameters of the criterion and its ancestors
+  uint64_t _paramHash;
+  // Parameters of the criterion and its ancestors, packed in 
+  // _sizeParams bytes
+  const unsigned char* _params;
+  size_t _sizeParams;
+  // Index of the criterion in the depth first order of the tree
+  int _iCrit;
+  // Index of the sample and dimensions of its image
+  long _iSample;
+  VecShort2D _dim;
+} ImgSegmentorPredCacheKey;
+
+typedef struct ImgSegmentorPredCacheEntry {
+  // Key of the entry, its parameters are stored after the entry
+  ImgSegmentorPredCacheKey _key;
+  // Prediction of the criterion on the sample
+  ImgSegmentorPlane* _pred;
+  // Memory used by the entry, in bytes
+  size_t _size;
+  // Number of users of the prediction, a pinned entry is not evicted
+  int _nbPin;
+  // Next entry in the same bucket
+  struct ImgSegmentorPredCacheEntry* _nextInBucket;
+  // Previous and next entries in the order of use, most recent first
+  struct ImgSegmentorPredCacheEntry* _prevUse;
+  struct ImgSegmentorPredCacheEntry* _nextUse;
+} ImgSegmentorPredCacheEntry;
+
+typedef struct ImgSegmentorPredCache {
+  // Memory budget in bytes
+  size_t _budget;
+  // Memory used by the entries in bytes
+  size_t _size;
+  // Buckets of the hash table of entries, IS_PREDCACHENBBUCKET buckets
+  ImgSegmentorPredCacheEntry** _buckets;
+  // Most and least recently used entries
+  ImgSegmentorPredCacheEntry* _mostRecent;
+  ImgSegmentorPredCacheEntry* _leastRecent;
+  // Mutex protecting the cache, shared by the threads of the training
+  pthread_mutex_t _mutex;
+} ImgSegmentorPredCache;
+
 typedef struct ImgSegmentor {
   // Tree of criterion
   GenTree _criteria;
@@ -196,6 +705,10 @@ typedef struct ImgSegmentor {
   float _targetBestValue;
   // Flag to memorize if we display info during training with a TextOMeter
   bool _flagTextOMeter;
+  // Flag to memorize if the initial population of the training is 
+  // seeded from the current parameters of the criteria
+  // By default false
+  bool _flagWarmStart;
   // TextOMeter to display info during training
   TextOMeter* _textOMeter;
   // Strings for the TextOMeter
@@ -204,15 +717,227 @@ typedef struct ImgSegmentor {
   char _line3[50]; 
   // Internal flag used during trainng
   bool _flagTraining;
-  // Saved data to be reused when training
-  GSetVecFloat _reusedInput;
+  // Saved data to be reused when training, GSet of 
+  // ImgSegmentorReuseEntry of ImgSegmentorPlane, one per sample
+  GSet _reusedInput;
+  // Saved masks to be reused when training, GSet of arrays of 
+  // ImgBitMask*, one per class, see ISCreateBitMasks
+  GSet _reusedMask;
+  // Bit masks of the detections, one per class, reused from one 
+  // evaluation to the next, NULL until the first evaluation
+  ImgBitMask** _detect;
   // Email adress to which send motification during training
   // if null no notifications are sent
   char* _emailNotification;
   // Subject of emails notification if any
   char* _emailSubject;
+  // Nb of threads used to evaluate the entities during training
+  // 1 by default
+  int _nbThread;
+  // Memory budget in bytes of the cache of predictions of the criteria
+  // during training, 0 to disable the cache
+  // IS_PREDCACHEBUDGETDEFAULT by default
+  size_t _predCacheBudget;
+  // Cache of predictions of the criteria, only allocated during 
+  // training
+  ImgSegmentorPredCache* _predCache;
+  // Number of best and last checkpoints kept on disk during training,
+  // a checkpoint is deleted when it is neither among the best nor the
+  // last ones, 0 for both (default) keeps all the checkpoints
+  int _checkpointKeepBest;
+  int _checkpointKeepLast;
+  // Memory budget in bytes of the reused data of the ImgSegmentor and
+  // its criteria during training, 0 for no limit (default)
+  size_t _reuseBudget;
+  // Accounting of the reused data, created by ISTrain and shared with
+  // the criteria
+  ImgSegmentorReuseCache* _reuseCache;
+  // Path of the directory of the persistent feature cache, NULL if 
+  // not used (default)
+  char* _featureCachePath;
+  // Path of the file where the training state is saved at the end of
+  // each epoch, NULL if not used (default)
+  char* _trainStatePath;
+  // Mapping of the file in binary format the ImgSegmentor has been 
+  // loaded from, if some arrays are used in place, else NULL
+  void* _binMap;
+  // Size in bytes of the mapping
+  size_t _binMapSize;
+  // Generation of the criteria, unique among all the ImgSegmentor and
+  // renewed each time their parameters are set or they are compiled,
+  // to detect the ImgSegmentorContext created before
+  unsigned long _generation;
 } ImgSegmentor;
 
+typedef struct ImgSegmentorCriterionContext {
+  // Clone of the NeuraNet of the criterion, NULL if the criterion 
+  // has no NeuraNet
+  NeuraNet* _nn;
+  // Pointer to a flag interrupting the prediction when it's true,
+  // may be NULL
+  const volatile bool* _flagStop;
+} ImgSegmentorCriterionContext;
+
+typedef struct ImgSegmentorContext {
+  // ImgSegmentor for which the context has been created
+  const ImgSegmentor* _segmentor;
+  // Generation of the criteria of _segmentor when the context has 
+  // been created
+  unsigned long _generation;
+  // Nb of criteria
+  int _nbCriterion;
+  // Contexts of the criteria, in the depth first order of the tree 
+  // of criteria
+  ImgSegmentorCriterionContext* _criteria;
+  // Pointer to a flag interrupting the prediction when it's true,
+  // may be NULL
+  const volatile bool* _flagStop;
+  // Flag memorizing if the last prediction failed
+  bool _flagError;
+  // Message of the error of the last prediction
+  char _errMsg[100];
+  // Flag memorizing if the creation of the context failed, in which 
+  // case all the predictions fail
+  bool _flagInvalid;
+} ImgSegmentorContext;
+
+typedef struct ImgSegmentorPredictPool {
+  // ImgSegmentor used for the predictions
+  const ImgSegmentor* _segmentor;
+  // Images to predict
+  const GenBrush* const* _imgs;
+  // Nb of images
+  int _nbImg;
+  // Results of the predictions, in the same order as _imgs
+  GenBrush*** _res;
+  // Index in _imgs of the next image to predict
+  atomic_int _next;
+} ImgSegmentorPredictPool;
+
+typedef struct ImgSegmentorTrainPool {
+  // GenAlg of the training
+  GenAlg* _ga;
+  // Indices in the GenAlg of the entities to evaluate
+  int* _iEnts;
+  // Values of the evaluated entities, in the same order as _iEnts
+  float* _values;
+  // Flags memorizing which entities have been evaluated
+  bool* _flagEvaluated;
+  // Nb of entities to evaluate
+  long _nbEnt;
+  // Index in _iEnts of the next entity to evaluate
+  atomic_long _next;
+  // Flag to stop the evaluation of remaining entities
+  atomic_bool _flagStop;
+  // Threshold of ISEvaluateFast, updated each time an entity is 
+  // evaluated
+  _Atomic float _threshold;
+  // Values of the evaluated entities sorted from best to worst, used 
+  // to compute the threshold, protected by _mutex
+  GSet* _setVal;
+  // Dataset of the training, the samples of the training category are
+  // loaded one by one by the workers through its iterator, shared 
+  // under _mutex, hence only one sample per worker is in memory
+  const GDataSetGenBrushPair* _dataset;
+  // Index of the current sample of the iterator of the training 
+  // category, protected by _mutex
+  long _iSampleDataset;
+  // Nb of samples
+  long _nbSample;
+  // Nb of masks per sample
+  int _nbMask;
+  // Index of the current round of evaluation, the threads of the 
+  // workers stay alive between the rounds and wait for the next one,
+  // protected by _mutex
+  long _round;
+  // Nb of threads still evaluating the current round, protected by 
+  // _mutex
+  int _nbRunning;
+  // Flag to end the threads of the workers, protected by _mutex
+  bool _flagExit;
+  // Conditions signaling the start of a round to the threads and the 
+  // end of the round to the training
+  pthread_cond_t _condStart;
+  pthread_cond_t _condEnd;
+  // Mutex protecting _setVal, the iterator of _dataset and the rounds
+  pthread_mutex_t _mutex;
+} ImgSegmentorTrainPool;
+
+typedef struct ISCheckpoint {
+  // Path of the checkpoint file
+  char* _path;
+  // Value of the ImgSegmentor on the training category
+  float _value;
+  // Encoded ImgSegmentor, NULL once written
+  char* _data;
+  // Size in bytes of _data
+  size_t _size;
+} ISCheckpoint;
+
+typedef struct ISCheckpointWriter {
+  // Checkpoints waiting to be written, in the order of addition
+  GSet _queue;
+  // Checkpoints written and still on disk, in the order of writing
+  GSet _written;
+  // Number of best checkpoints to keep, 0 for no limit
+  int _keepBest;
+  // Number of last checkpoints to keep, 0 for no limit
+  int _keepLast;
+  // Flag to stop the thread once the queue is empty
+  bool _flagStop;
+  // Mutex and condition protecting the properties above
+  pthread_mutex_t _mutex;
+  pthread_cond_t _cond;
+  // Thread writing the checkpoints
+  pthread_t _thread;
+  // Flag set if the thread is running, else the checkpoints are 
+  // written by ISCWAdd
+  bool _flagThread;
+} ISCheckpointWriter;
+
+typedef struct ISTrainStateHeader {
+  // Magic number, IS_TRAINSTATEMAGIC
+  char _magic[4];
+  // Version of the format, IS_TRAINSTATEVERSION
+  uint32_t _version;
+  // Number of int and float parameters of the criteria
+  int64_t _nbParamInt;
+  int64_t _nbParamFloat;
+  // Current best value
+  float _bestValue;
+  // Flags for the presence of the int and float parameters of the best
+  // entity
+  int32_t _flagBestAdnI;
+  int32_t _flagBestAdnF;
+  // State of the generator of the seeds of the epochs
+  uint64_t _rngSeed;
+  // The header is followed by the float parameters (float) and int 
+  // parameters (int64_t) of the best entity if any, and the GenAlg 
+  // as saved by GASave
+} ISTrainStateHeader;
+
+typedef struct ISTrainState {
+  // GenAlg with its population and current epoch
+  GenAlg* _ga;
+  // Current best value
+  float _bestValue;
+  // Parameters of the best entity, NULL if none
+  VecFloat* _bestAdnF;
+  VecLong* _bestAdnI;
+  // State of the generator of the seeds of the epochs
+  uint64_t _rngSeed;
+} ISTrainState;
+
+typedef struct ImgSegmentorTrainWorker {
+  // Private clone of the trained ImgSegmentor, sharing its reused data
+  ImgSegmentor _segmentor;
+  // Pool of entities to evaluate
+  ImgSegmentorTrainPool* _pool;
+  // Thread of the worker and flag set if it has been created
+  pthread_t _thread;
+  bool _flagThread;
+} ImgSegmentorTrainWorker;
+
 typedef struct ImgSegmentorPerf {
   // Accuracy
   float _accuracy;
@@ -234,8 +959,30 @@ typedef struct ImgSegmentorCriterion {
   int _nbClass;
   // Flag to memorize if we reuses the data during training
   bool _flagReusedInput;
-  // Saved data to be reused when training, GSet of GSetVecFloat
+  // Saved data to be reused when training, GSet of 
+  // ImgSegmentorReuseEntry, one per sample
+  // (ImgSegmentorCriterionTexReuse for ImgSegmentorCriterionTex)
   GSet _reusedInput;
+  // Accounting of the reused data, shared with the ImgSegmentor 
+  // during training, NULL for no limit
+  ImgSegmentorReuseCache* _reuseCache;
+  // Path of the directory of the persistent feature cache, borrowed 
+  // from the ImgSegmentor during training, NULL if not used
+  const char* _featureCachePath;
+  // Hash of the parameters of this criterion and its ancestors, set
+  // by ISSetAdn during training, 0 if unknown
+  uint64_t _paramHash;
+  // Parameters of this criterion and its ancestors packed in 
+  // _sizeParamKey bytes, set at the same time as _paramHash
+  unsigned char* _paramKey;
+  size_t _sizeParamKey;
+  // Flag to memorize if the parameters of this criterion are excluded
+  // from the training
+  bool _flagFrozen;
+  // Predictions to be reused when training, GSet of 
+  // ImgSegmentorReuseEntry (ImgSegmentorPlane), one per sample, 
+  // only used if this criterion and all its ancestors are frozen
+  GSet _frozenPred;
 } ImgSegmentorCriterion;
 
 typedef struct ImgSegmentorCriterionRGB {
@@ -243,6 +990,15 @@ typedef struct ImgSegmentorCriterionRGB {
   ImgSegmentorCriterion _criterion;
   // NeuraNet model
   NeuraNet* _nn;
+  // Number of samples per color channel of the lookup table, 
+  // 0 if the lookup table is not used
+  int _lutSize;
+  // Lookup table of the NeuraNet output, _lutSize^3*nbClass values, 
+  // NULL if not compiled
+  float* _lut;
+  // Flag to memorize if the lookup table is borrowed from the mapping
+  // of the binary file of the ImgSegmentor and must not be freed
+  bool _flagLUTBorrowed;
 } ImgSegmentorCriterionRGB;
 
 typedef struct ImgSegmentorCriterionRGB2HSV {
@@ -268,8 +1024,233 @@ typedef struct ImgSegmentorCriterionTex {
   int _size;
 } ImgSegmentorCriterionTex;
 
+typedef struct ImgSegmentorCriterionTexReuse {
+  // Summed area table of the input, (width+1)*(height+1)*3 values, 
+  // the value at index ((y * (width + 1)) + x) * 3 + iRGB is the sum of
+  // the channel iRGB over the pixels in [0, x[ x [0, y[
+  // NULL if not computed, and freed once all the inputs are computed
+  double* _sat;
+  // Number of inputs of the NeuraNet per pixel
+  long _nbIn;
+  // Inputs of the NeuraNet, _nbIn values per pixel in a single 
+  // contiguous block, the inputs of the pixel at index iInput
+  // (y * width + x) start at iInput * _nbIn
+  float* _inputs;
+  // Validity of the inputs, the bit of a pixel is set once its inputs
+  // are computed, the bits of the skipped pixels are never set
+  ImgBitMask* _valid;
+  // Flag to memorize if the inputs of all the pixels are computed
+  bool _flagComplete;
+  // Mapping of the file of the persistent feature cache holding 
+  // _inputs, NULL if _inputs is allocated
+  void* _map;
+  // Size in bytes of the mapping
+  size_t _mapSize;
+} ImgSegmentorCriterionTexReuse;
+
 // ================ Functions declaration ====================
 
+// Create a new ImgSegmentorPlane of dimensions 'dim' with 'nbChannel'
+// values per pixel, all values are initialised to 0.0
+ImgSegmentorPlane* ImgSegmentorPlaneCreate(const VecShort2D* const dim,
+  const int nbChannel);
+
+// Create a new ImgSegmentorPlane from the final pixels of the GenBrush
+// 'img', with 3 values per pixel (r, g, b) in [0.0, 1.0]
+ImgSegmentorPlane* ImgSegmentorPlaneCreateFromGenBrush(
+  const GenBrush* const img);
+
+// Return a clone of the ImgSegmentorPlane 'that'
+ImgSegmentorPlane* ImgSegmentorPlaneClone(
+  const ImgSegmentorPlane* const that);
+
+// Free the memory used by the ImgSegmentorPlane 'that'
+void ImgSegmentorPlaneFree(ImgSegmentorPlane** that);
+
+// Release the ImgSegmentorPlane 'that': free it if it is owned, i.e. 
+// it is not 'borrowed', else only forget it
+void ImgSegmentorPlaneRelease(ImgSegmentorPlane** that, 
+  const ImgSegmentorPlane* const borrowed);
+
+// Return the dimensions of the ImgSegmentorPlane 'that'
+#if BUILDMODE != 0
+static inline
+#endif
+const VecShort2D* ISPDim(const ImgSegmentorPlane* const that);
+
+// Return the number of pixels of the ImgSegmentorPlane 'that'
+#if BUILDMODE != 0
+static inline
+#endif
+long ISPGetArea(const ImgSegmentorPlane* const that);
+
+// Return the number of values per pixel of the ImgSegmentorPlane 'that'
+#if BUILDMODE != 0
+static inline
+#endif
+int ISPGetNbChannel(const ImgSegmentorPlane* const that);
+
+// Return the values of the ImgSegmentorPlane 'that'
+#if BUILDMODE != 0
+static inline
+#endif
+float* ISPVal(const ImgSegmentorPlane* const that);
+
+// Create a new ImgBitMask of dimensions 'dim' with all bits set to 0
+ImgBitMask* ImgBitMaskCreate(const VecShort2D* const dim);
+
+// Create a new ImgBitMask from the final pixels of the GenBrush 'img'
+// The bits are set to 1 for the pixels of color 'rgba', 0 else
+ImgBitMask* ImgBitMaskCreateFromGenBrush(const GenBrush* const img, 
+  const GBPixel* const rgba);
+
+// Free the memory used by the ImgBitMask 'that'
+void ImgBitMaskFree(ImgBitMask** that);
+
+// Return the dimensions of the ImgBitMask 'that'
+#if BUILDMODE != 0
+static inline
+#endif
+const VecShort2D* IBMDim(const ImgBitMask* const that);
+
+// Return the bit of the ImgBitMask 'that' at position ('x', 'y')
+#if BUILDMODE != 0
+static inline
+#endif
+bool IBMGet(const ImgBitMask* const that, const long x, const long y);
+
+// Set to 1 the bit of the ImgBitMask 'that' at position ('x', 'y')
+#if BUILDMODE != 0
+static inline
+#endif
+void IBMSet(ImgBitMask* const that, const long x, const long y);
+
+// Return the number of bits set to 1 in the ImgBitMask 'that'
+long IBMGetNbSet(const ImgBitMask* const that);
+
+// Set to 0 all the bits of the ImgBitMask 'that'
+void IBMReset(ImgBitMask* const that);
+
+// Return the Jaccard index (aka intersection over union) of the 
+// ImgBitMask 'that' and 'tho' for the bits set to 1
+// 'that' and 'tho' must have same dimensions
+float IntersectionOverUnionBitMask(const ImgBitMask* const that, 
+  const ImgBitMask* const tho);
+
+// Create a new ISCheckpointWriter keeping on disk the 'keepBest' best
+// and the 'keepLast' last checkpoints, 0 for both keeps all of them,
+// and start its thread
+ISCheckpointWriter* ISCheckpointWriterCreate(const int keepBest, 
+  const int keepLast);
+
+// Write the remaining checkpoints of the ISCheckpointWriter 'that', 
+// stop its thread and free its memory
+void ISCheckpointWriterFree(ISCheckpointWriter** that);
+
+// Add to the ISCheckpointWriter 'that' the checkpoint of value 'value'
+// made of the 'size' bytes of 'data' to be written in the file 'path'
+// 'data' is then owned by 'that'
+void ISCWAdd(ISCheckpointWriter* const that, const char* const path,
+  const float value, char* const data, const size_t size);
+
+// Create a new ImgSegmentorReuseCache with a memory budget of 
+// 'budget' bytes, 0 for no limit
+ImgSegmentorReuseCache* ImgSegmentorReuseCacheCreate(
+  const size_t budget);
+
+// Free the memory used by the ImgSegmentorReuseCache 'that'
+// The entries must have been freed before with ISRCEntryFree
+void ImgSegmentorReuseCacheFree(ImgSegmentorReuseCache** that);
+
+// Return the entry for the sample 'iSample' in the GSet of 
+// ImgSegmentorReuseEntry 'set' managed by the ImgSegmentorReuseCache
+// 'that', which may be NULL
+// The missing entries are created, unless 'that' is read only in 
+// which case NULL is returned
+ImgSegmentorReuseEntry* ISRCGetEntry(ImgSegmentorReuseCache* const that,
+  GSet* const set, const long iSample);
+
+// Return the data of the entry 'entry' of the ImgSegmentorReuseCache 
+// 'that', which may be NULL, or NULL if the data is not resident
+// Update the statistics and the order of use
+void* ISRCGetData(ImgSegmentorReuseCache* const that, 
+  ImgSegmentorReuseEntry* const entry);
+
+// Give the data 'data' of type 'type' using 'size' bytes to the 
+// entry 'entry' of the ImgSegmentorReuseCache 'that', which may be 
+// NULL. The least recently used and not pinned data are evicted to 
+// respect the budget
+// Return true if the data has been added, else false and the data 
+// is still owned by the caller
+bool ISRCAdd(ImgSegmentorReuseCache* const that, 
+  ImgSegmentorReuseEntry* const entry, void* const data, 
+  const ISReuseType type, const size_t size);
+
+// Pin the entry 'entry' of the ImgSegmentorReuseCache 'that' to 
+// prevent the eviction of its data while it is used
+void ISRCPin(ImgSegmentorReuseCache* const that, 
+  ImgSegmentorReuseEntry* const entry);
+
+// Unpin the entry 'entry' of the ImgSegmentorReuseCache 'that'
+void ISRCUnpin(ImgSegmentorReuseCache* const that, 
+  ImgSegmentorReuseEntry* const entry);
+
+// Update to 'size' bytes the memory used by the data of the entry 
+// 'entry' of the ImgSegmentorReuseCache 'that', which may be NULL, 
+// after the data has shrunk
+void ISRCSetSize(ImgSegmentorReuseCache* const that, 
+  ImgSegmentorReuseEntry* const entry, const size_t size);
+
+// Free the entry 'entry' and its data, managed by the 
+// ImgSegmentorReuseCache 'that', which may be NULL
+void ISRCEntryFree(ImgSegmentorReuseCache* const that, 
+  ImgSegmentorReuseEntry** const entry);
+
+// Set the flag forbidding the addition of data to the 
+// ImgSegmentorReuseCache 'that' to 'flag'
+void ISRCSetReadOnly(ImgSegmentorReuseCache* const that, 
+  const bool flag);
+
+// Return the flag forbidding the addition of data to the 
+// ImgSegmentorReuseCache 'that', which may be NULL
+bool ISRCIsReadOnly(ImgSegmentorReuseCache* const that);
+
+// Return the statistics of the ImgSegmentorReuseCache 'that'
+ImgSegmentorReuseStats ISRCGetStats(ImgSegmentorReuseCache* const that);
+
+// Create a new ImgSegmentorPredCache with a memory budget of 'budget'
+// bytes
+ImgSegmentorPredCache* ImgSegmentorPredCacheCreate(const size_t budget);
+
+// Free the memory used by the ImgSegmentorPredCache 'that'
+void ImgSegmentorPredCacheFree(ImgSegmentorPredCache** that);
+
+// Return the entry of the ImgSegmentorPredCache 'that' for the key 
+// 'key', or NULL if it is not in the cache
+// The whole key is compared, not only the hash of the parameters
+// The returned entry is pinned, its prediction _pred can be read 
+// until the entry is unpinned with ISPCUnpin
+ImgSegmentorPredCacheEntry* ISPCGet(ImgSegmentorPredCache* const that, 
+  const ImgSegmentorPredCacheKey* const key);
+
+// Add the prediction 'pred' for the key 'key' to the 
+// ImgSegmentorPredCache 'that'
+// The least recently used predictions which are not pinned are 
+// removed to respect the memory budget of 'that'
+// Return the new entry, pinned, which owns 'pred', or NULL if the 
+// prediction couldn't be added, in which case 'pred' is still owned 
+// by the caller
+ImgSegmentorPredCacheEntry* ISPCAdd(ImgSegmentorPredCache* const that, 
+  const ImgSegmentorPredCacheKey* const key, 
+  ImgSegmentorPlane* const pred);
+
+// Unpin the entry 'entry' of the ImgSegmentorPredCache 'that'
+void ISPCUnpin(ImgSegmentorPredCache* const that, 
+  ImgSegmentorPredCacheEntry* const entry);
+
+// Return the memory used by the ImgSegmentorPredCache 'that', in bytes
+size_t ISPCGetSize(ImgSegmentorPredCache* const that);
+
 // Create a new static ImgSegmentor with 'nbClass' output
 ImgSegmentor ImgSegmentorCreateStatic(int nbClass);
 
@@ -282,6 +1263,14 @@ void ImgSegmentorFreeStatic(ImgSegmentor* that);
 // Free the memory used by the ImgSegmentor 'that'
 void ImgSegmentorFree(ImgSegmentor** that);
 
+// Free the data of the ImgSegmentor 'that' and its criteria reused 
+// during training
+void ISFlushReusedData(ImgSegmentor* const that);
+
+// Return the statistics of the data reused during the last training 
+// of the ImgSegmentor 'that'
+ImgSegmentorReuseStats ISGetReuseStats(const ImgSegmentor* const that);
+
 // Return the nb of criterion of the ImgSegmentor 'that'
 #if BUILDMODE != 0
 static inline
@@ -331,6 +1320,39 @@ bool ISGetFlagTextOMeter(const ImgSegmentor* const that);
 // ImgSegmentor 'that'
 void ISUpdateTextOMeter(const ImgSegmentor* const that);
 
+// Return the flag for the warm start of the training of the 
+// ImgSegmentor 'that'
+#if BUILDMODE != 0
+static inline
+#endif
+bool ISGetFlagWarmStart(const ImgSegmentor* const that);
+
+// Set the flag for the warm start of the training of the 
+// ImgSegmentor 'that' to 'flag'
+// If true, the elites of the initial population of ISTrain are the 
+// current parameters of the criteria and the other entities are 
+// mutations of them, else the initial population is random
+#if BUILDMODE != 0
+static inline
+#endif
+void ISSetFlagWarmStart(ImgSegmentor* const that, const bool flag);
+
+// Set the parameters of the criteria of the ImgSegmentor 'that' with 
+// the adn 'adn', the frozen criteria having no parameters in 'adn'
+void ISSetAdn(ImgSegmentor* const that, const GenAlgAdn* const adn);
+
+// Set the parameters of the criteria of the ImgSegmentor 'that' with 
+// the int parameters 'adnI' and float parameters 'adnF', in the order
+// of ISGetAdn ('adnI' or 'adnF' can be NULL if there is no such 
+// parameters), the frozen criteria having no parameters in them
+void ISSetParams(ImgSegmentor* const that, const VecLong* const adnI,
+  const VecFloat* const adnF);
+
+// Copy the current parameters of the criteria of the ImgSegmentor 
+// 'that' in 'adnI' and 'adnF', in the order of ISSetAdn
+void ISGetAdn(const ImgSegmentor* const that, VecLong* const adnI, 
+  VecFloat* const adnF);
+
 // Add a new ImageSegmentorCriterionRGB to the ImgSegmentor 'that'
 // under the node 'parent'
 // If 'parent' is null it is inserted to the root of the ImgSegmentor
@@ -426,6 +1448,117 @@ static inline
 #endif
 void ISSetSizePool(ImgSegmentor* const that, int nb);
 
+// Return the nb of threads used to evaluate the entities during the 
+// training of the ImgSegmentor 'that'
+#if BUILDMODE != 0
+static inline
+#endif
+int ISGetNbThread(const ImgSegmentor* const that);
+
+// Set the nb of threads used to evaluate the entities during the 
+// training of the ImgSegmentor 'that' to 'nb'
+#if BUILDMODE != 0
+static inline
+#endif
+void ISSetNbThread(ImgSegmentor* const that, const int nb);
+
+// Return the memory budget in bytes of the cache of predictions of 
+// the criteria during the training of the ImgSegmentor 'that'
+#if BUILDMODE != 0
+static inline
+#endif
+size_t ISGetPredCacheBudget(const ImgSegmentor* const that);
+
+// Set the memory budget in bytes of the cache of predictions of the 
+// criteria during the training of the ImgSegmentor 'that' to 'budget'
+// 0 disables the cache
+#if BUILDMODE != 0
+static inline
+#endif
+void ISSetPredCacheBudget(ImgSegmentor* const that, 
+  const size_t budget);
+
+// Return the memory budget in bytes of the data reused during the 
+// training of the ImgSegmentor 'that', 0 means no limit
+#if BUILDMODE != 0
+static inline
+#endif
+size_t ISGetReuseBudget(const ImgSegmentor* const that);
+
+// Return the number of best checkpoints kept on disk during the 
+// training of the ImgSegmentor 'that', 0 means no limit
+#if BUILDMODE != 0
+static inline
+#endif
+int ISGetCheckpointKeepBest(const ImgSegmentor* const that);
+
+// Return the number of last checkpoints kept on disk during the 
+// training of the ImgSegmentor 'that', 0 means no limit
+#if BUILDMODE != 0
+static inline
+#endif
+int ISGetCheckpointKeepLast(const ImgSegmentor* const that);
+
+// Set the number of best checkpoints kept on disk during the 
+// training of the ImgSegmentor 'that' to 'nb', 0 means no limit
+// The checkpoints are ranked by their value on the validation 
+// category of the dataset if any. Else they are ranked by their value 
+// on the training category, which increases at each checkpoint, then 
+// the best checkpoints are the last ones
+#if BUILDMODE != 0
+static inline
+#endif
+void ISSetCheckpointKeepBest(ImgSegmentor* const that, const int nb);
+
+// Set the number of last checkpoints kept on disk during the 
+// training of the ImgSegmentor 'that' to 'nb', 0 means no limit
+#if BUILDMODE != 0
+static inline
+#endif
+void ISSetCheckpointKeepLast(ImgSegmentor* const that, const int nb);
+
+// Return the path of the directory of the persistent feature cache of 
+// the ImgSegmentor 'that', NULL if not used
+#if BUILDMODE != 0
+static inline
+#endif
+const char* ISGetFeatureCachePath(const ImgSegmentor* const that);
+
+// Set the path of the directory of the persistent feature cache of 
+// the ImgSegmentor 'that' to 'path', NULL to not use it
+// The directory must exist. The features computed during training 
+// are saved in it and mapped in memory by the later trainings
+#if BUILDMODE != 0
+static inline
+#endif
+void ISSetFeatureCachePath(ImgSegmentor* const that, 
+  const char* const path);
+
+// Return the path of the file of the training state of the 
+// ImgSegmentor 'that', NULL if not used
+#if BUILDMODE != 0
+static inline
+#endif
+const char* ISGetTrainStatePath(const ImgSegmentor* const that);
+
+// Set the path of the file of the training state of the ImgSegmentor 
+// 'that' to 'path', NULL to not use it
+// The GenAlg population, the current epoch, the best entity and the 
+// state of the random generator are saved in it at the end of each 
+// epoch of ISTrain, see ISTrainResume
+#if BUILDMODE != 0
+static inline
+#endif
+void ISSetTrainStatePath(ImgSegmentor* const that, 
+  const char* const path);
+
+// Set the memory budget in bytes of the data reused during the 
+// training of the ImgSegmentor 'that' to 'budget', 0 means no limit
+#if BUILDMODE != 0
+static inline
+#endif
+void ISSetReuseBudget(ImgSegmentor* const that, const size_t budget);
+
 // Return the nb of elites for training the ImgSegmentor 'that'
 #if BUILDMODE != 0
 static inline
@@ -484,6 +1617,126 @@ GenBrush** ISPredictWithReuse(const ImgSegmentor* const that,
 // when simply predicting
 #define ISPredict(That, Img) ISPredictWithReuse(That, Img, -1)
 
+// Make a prediction on the GenBrush 'img' with the ImgSegmentor 'that'
+// using the context 'ctx' created for 'that'
+// 'that' is not modified, the NeuraNets of the context are used, so 
+// several threads can predict with the same ImgSegmentor, each one 
+// with its own context
+// Return the same result as ISPredict, or NULL if the prediction 
+// failed or was interrupted, in which case the error is in 'ctx'
+GenBrush** ISPredictWithContext(const ImgSegmentor* const that, 
+  const GenBrush* const img, ImgSegmentorContext* const ctx);
+
+// Make a prediction on each of the 'nbImg' GenBrush 'imgs' with the 
+// ImgSegmentor 'that', using 'nbThread' threads each with its own 
+// ImgSegmentorContext. If 'nbThread' is lower than 1 the number of 
+// online processors is used
+// Return an array of 'nbImg' results in the same order as 'imgs', 
+// each result being the one of ISPredict, or NULL if the prediction 
+// failed
+GenBrush*** ISPredictBatch(const ImgSegmentor* const that, 
+  const GenBrush* const* const imgs, const int nbImg, 
+  const int nbThread);
+
+// Calculate the prediction scores on the GenBrush 'img' with the 
+// ImgSegmentor 'that' into 'scores' without rendering any GenBrush
+// 'scores' must be allocated by the user to the area of 'img' times 
+// the number of class of 'that'. It is filled in planar layout, the 
+// score of class 'iClass' at pixel (x, y) is 
+// scores[iClass * area + y * width + x], in [-1.0, 1.0], -1.0 equals 
+// no detection, 1.0 equals detection, 0.0 equals "don't know"
+// The binarization flag of 'that' is not applied
+// 'ctx' may be NULL, else it is used as in ISPredictWithContext
+// Return true if the prediction succeeded, false else in which case 
+// the error is in 'ctx'
+bool ISPredictScoresInto(const ImgSegmentor* const that, 
+  const GenBrush* const img, ImgSegmentorContext* const ctx, 
+  float* const scores);
+
+// Calculate the prediction scores on the GenBrush 'img' with the 
+// ImgSegmentor 'that', see ISPredictScoresInto
+// Return the scores in a new array, or NULL if the prediction failed
+float* ISPredictScores(const ImgSegmentor* const that, 
+  const GenBrush* const img, ImgSegmentorContext* const ctx);
+
+// Calculate the prediction scores on the GenBrush 'img' with the 
+// ImgSegmentor 'that' into 'scores', quantized to the grey levels of 
+// the result of ISPredict (255 equals no detection, 0 equals 
+// detection), the binarization flag of 'that' being applied
+// The layout and arguments are the same as for ISPredictScoresInto
+// Return true if the prediction succeeded, false else in which case 
+// the error is in 'ctx'
+bool ISPredictScoresUInt8Into(const ImgSegmentor* const that, 
+  const GenBrush* const img, ImgSegmentorContext* const ctx, 
+  unsigned char* const scores);
+
+// Calculate the prediction scores on the GenBrush 'img' with the 
+// ImgSegmentor 'that', see ISPredictScoresUInt8Into
+// Return the scores in a new array, or NULL if the prediction failed
+unsigned char* ISPredictScoresUInt8(const ImgSegmentor* const that, 
+  const GenBrush* const img, ImgSegmentorContext* const ctx);
+
+// Function used by _ISPredict, ISPredictScoresInto, 
+// ISPredictScoresUInt8Into and ISEvaluateSample
+// 'ctx' may be NULL
+// The scores are written either as floats in 'scores' or quantized 
+// to grey levels in 'scoresUInt8', the other one being NULL
+// If 'masks' is not NULL, it's the masks of 'img' as created by 
+// ISCreateBitMasks and the intersection over union of the detections 
+// with 'masks' is calculated for each class into 'iou', the detections
+// being packed in the same pass as the scores into 'detect', bit masks
+// of the dimensions of 'img' with all bits set to 0, one per class
+// In that case 'scores' and 'scoresUInt8' can both be NULL
+bool _ISPredictScores(const ImgSegmentor* const that, 
+  const GenBrush* const img, const int iSample, 
+  ImgSegmentorContext* const ctx, float* const scores,
+  unsigned char* const scoresUInt8, ImgBitMask* const* const masks, 
+  ImgBitMask* const* const detect, float* const iou);
+
+// Convert the prediction score 'p' of the ImgSegmentor 'that' into 
+// the grey level used in the result of ISPredict
+unsigned char ISScoreToGrey(const ImgSegmentor* const that, float p);
+
+// Return true if the prediction score 'p' of the ImgSegmentor 'that'
+// is rendered as a detection (black pixel) in the result of ISPredict
+bool ISScoreIsDetection(const ImgSegmentor* const that, const float p);
+
+// Function used by ISPredictWithReuse and ISPredictWithContext
+// 'ctx' may be NULL
+GenBrush** _ISPredict(const ImgSegmentor* const that, 
+  const GenBrush* const img, const int iSample, 
+  ImgSegmentorContext* const ctx);
+
+// Create a new ImgSegmentorContext for the ImgSegmentor 'that'
+// The context must be recreated if the criteria of 'that' are modified
+// (added, trained, loaded, set with ISSetParams or compiled), the 
+// predictions with an outdated context fail
+// The errors are reported in the context, not in PBImgAnalysisErr, 
+// so several threads can create and use their own context
+ImgSegmentorContext* ImgSegmentorContextCreate(
+  const ImgSegmentor* const that);
+
+// Free the memory used by the ImgSegmentorContext 'that'
+void ImgSegmentorContextFree(ImgSegmentorContext** that);
+
+// Set the flag interrupting the predictions with the context 'that'
+// to 'flag', which may be NULL
+void ISCtxSetFlagStop(ImgSegmentorContext* const that, 
+  const volatile bool* const flag);
+
+// Return true if the last prediction with the context 'that' failed
+#if BUILDMODE != 0
+static inline
+#endif
+bool ISCtxIsError(const ImgSegmentorContext* const that);
+
+// Return the message of the error of the last prediction with the 
+// context 'that'
+#if BUILDMODE != 0
+static inline
+#endif
+const char* ISCtxErrMsg(const ImgSegmentorContext* const that);
+
 // Return the nb of criterion of the ImgSegmentor 'that'
 #if BUILDMODE != 0
 static inline
@@ -493,10 +1746,56 @@ const GenTree* ISCriteria(const ImgSegmentor* const that);
 // Train the ImageSegmentor 'that' on the data set 'dataSet' using
 // the data of the first category in 'dataSet'. If the data set has a 
 // second category it will be used for validation
-// srandom must have been called before calling ISTrain
+// If the nb of threads of 'that' is greater than 1, the samples of the
+// first category are loaded in memory and the new entities of each 
+// epoch are evaluated in parallel, each thread using its own clone of
+// 'that'
+// The training uses its own random generator, seeded with one value 
+// drawn with random(), hence srandom must have been called before 
+// calling ISTrain. Apart from this draw the random generator of the 
+// caller is left untouched
 void ISTrain(ImgSegmentor* const that, 
   const GDataSetGenBrushPair* const dataset);
 
+// Resume the training of the ImageSegmentor 'that' on the data set 
+// 'dataSet' from the training state saved in 'stream' by a previous 
+// ISTrain or ISTrainResume, see ISSetTrainStatePath
+// 'that' must have the same criteria as the interrupted training
+// Return true if the training state could be loaded and the training
+// has been resumed, else false
+bool ISTrainResume(ImgSegmentor* const that, 
+  const GDataSetGenBrushPair* const dataset, FILE* const stream);
+
+// Save in the file of the training state of the ImgSegmentor 'that' 
+// the GenAlg 'ga', the best value 'bestValue' and parameters 
+// 'bestAdnF' and 'bestAdnI' (can be NULL) among the 'nbParamInt' int 
+// and 'nbParamFloat' float parameters, and the state 'rngSeed' of the
+// generator of the seeds of the epochs, see ISTrainNextSeed
+// Return true upon success else false
+bool ISTrainSaveState(const ImgSegmentor* const that, 
+  const GenAlg* const ga, const float bestValue, 
+  const VecFloat* const bestAdnF, const VecLong* const bestAdnI, 
+  const long nbParamInt, const long nbParamFloat, 
+  const uint64_t rngSeed);
+
+// Load the training state 'that' from the stream 'stream' if it 
+// matches 'nbParamInt' int and 'nbParamFloat' float parameters
+// Return true upon success else false
+bool ISTrainLoadState(ISTrainState* const that, FILE* const stream,
+  const long nbParamInt, const long nbParamFloat);
+
+// Free the memory used by the training state 'that'
+void ISTrainStateFreeStatic(ISTrainState* const that);
+
+// Seed the initialised population of the GenAlg 'ga' with the current
+// parameters of the criteria of the ImgSegmentor 'that', among 
+// 'nbParamInt' int and 'nbParamFloat' float parameters
+// The elites get the current parameters and the other entities get 
+// them mutated by up to IS_WARMSTARTMUTATION of the range of their
+// bounds
+void ISTrainWarmStart(const ImgSegmentor* const that, GenAlg* const ga,
+  const long nbParamInt, const long nbParamFloat);
+
 // Evaluate the ImageSegmentor 'that' on the data set 'dataSet' using
 // the data of the 'iCat' category in 'dataSet'
 // Give up the evaluation as soon as the result can't be greater than
@@ -511,6 +1810,35 @@ float ISEvaluateFast(ImgSegmentor* const that,
 #define ISEvaluate(That, Dataset, Icat) \
   ISEvaluateFast(That, Dataset, Icat, 0.0)
 
+// Create the masks of the sample 'sample' for the ImgSegmentor 
+// 'that' as an array of ImgBitMask, one per class, with bits set to 1
+// where the mask is black
+ImgBitMask** ISCreateBitMasks(const ImgSegmentor* const that, 
+  const GDSGenBrushPair* const sample);
+
+// Free the array of ImgBitMask 'masks' created by ISCreateBitMasks 
+// for the ImgSegmentor 'that'
+void ISFreeBitMasks(const ImgSegmentor* const that, 
+  ImgBitMask*** const masks);
+
+// Evaluate the ImgSegmentor 'that' on the sample 'sample' with 
+// 'nbMask' masks. Try to reuse the data associated with the sample 
+// 'iSample' (-1 to not reuse the data)
+// The prediction is directly compared to the bit masks, without
+// rendering any GenBrush
+// Return the sum of the intersection over union of each class divided
+// by 'nbMask'
+float ISEvaluateSample(ImgSegmentor* const that, 
+  const GDSGenBrushPair* const sample, const long iSample, 
+  const int nbMask);
+
+// Compile the criteria of the ImgSegmentor 'that' which support it
+// and are not already compiled, to speed up the prediction
+// Only the criteria RGB whose size of lookup table has been set with 
+// ISCRGBSetLUTSize are compiled
+// Automatically called at the end of ISTrain, ISLoad and ISLoadBinary
+void ISCompile(ImgSegmentor* const that);
+
 // Load the ImgSegmentor from the stream
 // If the ImgSegmentor is already allocated, it is freed before loading
 // Return true upon success else false
@@ -523,6 +1851,38 @@ bool ISLoad(ImgSegmentor* that, FILE* const stream);
 bool ISSave(const ImgSegmentor* const that, 
   FILE* const stream, const bool compact);
 
+// Function which return the JSON encoding of 'that' 
+JSONNode* ISEncodeAsJSON(const ImgSegmentor* const that);
+
+// Write the JSON encoding of 'that' with the JSONStreamWriter 'writer'
+// It's the same encoding as ISEncodeAsJSON
+void ISEncodeAsJSONStream(const ImgSegmentor* const that, 
+  JSONStreamWriter* const writer);
+
+// Write the JSON encoding of the node 'that' in the GenTree of 
+// criteria of a ImgSegmentor with the label 'key' with the 
+// JSONStreamWriter 'writer'
+void ISEncodeNodeAsJSONStream(const GenTree* const that, 
+  const char* const key, JSONStreamWriter* const writer);
+
+// Write the JSON encoding of the criterion 'that' with the 
+// JSONStreamWriter 'writer'
+void ISCEncodeAsJSONStream(const ImgSegmentorCriterion* const that, 
+  JSONStreamWriter* const writer);
+
+// Load the ImgSegmentor from the stream in binary format
+// The stream must be a regular file positioned at the beginning of 
+// the data. The file is mapped in memory and its lookup tables are 
+// used in place without parsing
+// The file is decoded into a temporary ImgSegmentor, 'that' is 
+// replaced only upon success and left untouched upon failure
+// Return true upon success else false
+bool ISLoadBinary(ImgSegmentor* that, FILE* const stream);
+
+// Save the ImgSegmentor to the stream in binary format
+// Return true upon success else false
+bool ISSaveBinary(const ImgSegmentor* const that, FILE* const stream);
+
 // Function which return the JSON encoding of 'that' 
 JSONNode* ImgSegmentorEncodeAsJSON(const ImgSegmentor* const that);
 
@@ -545,15 +1905,28 @@ void ImgSegmentorCriterionFlushReusedData(ImgSegmentorCriterion* that);
 // function according to the type of criterion
 // Try to reuse the data associated with the sample 'iSample'. If
 // 'iSample' equals -1 it means we don't want to reuse the data
-// 'input' 's format is width*height*3, values in [0.0, 1.0]
-// Return values are width*height*nbClass, values in [-1.0, 1.0]
-VecFloat* ISCPredictWithReuse(const ImgSegmentorCriterion* const that,
-  const VecFloat* input, const VecShort2D* const dim, const int iSample);
-
-// Helper function to hide the argument 'iSample' in ISPredictWithReuse 
-// when simply predicting
-#define ISCPredict(That, Input, Dim) \
-  ISCPredictWithReuse(That, Input, Dim, -1)
+// If 'ctx' is not null, its NeuraNet and stop flag are used instead of
+// the NeuraNet of 'that' and PBIA_CtrlC
+// 'input' has 3 channels, values in [0.0, 1.0]
+// Return a plane with nbClass channels, values in [-1.0, 1.0]
+ImgSegmentorPlane* ISCPredictWithContext(
+  const ImgSegmentorCriterion* const that,
+  const ImgSegmentorPlane* const input, const int iSample,
+  const ImgSegmentorCriterionContext* const ctx);
+
+// Helper function to hide the argument 'ctx' in ISCPredictWithContext 
+// when predicting with reuse
+#define ISCPredictWithReuse(That, Input, ISample) \
+  ISCPredictWithContext(That, Input, ISample, NULL)
+
+// Helper function to hide the arguments 'iSample' and 'ctx' in 
+// ISCPredictWithContext when simply predicting
+#define ISCPredict(That, Input) \
+  ISCPredictWithContext(That, Input, -1, NULL)
+
+// Return true if the prediction of a criterion with the context 'ctx'
+// must be interrupted
+bool ISCIsInterrupted(const ImgSegmentorCriterionContext* const ctx);
 
 // Return the nb of class of the ImgSegmentorCriterion 'that'
 #if BUILDMODE != 0
@@ -582,6 +1955,32 @@ static inline
 void _ISCSetIsReusedInput(ImgSegmentorCriterion* const that,
   bool flag);
 
+// Return true if the parameters of the ImgSegmentorCriterion 'that' 
+// are excluded from the training, else false
+#if BUILDMODE != 0
+static inline
+#endif
+bool _ISCIsFrozen(const ImgSegmentorCriterion* const that);
+
+// Set the flag memorizing if the parameters of the 
+// ImgSegmentorCriterion 'that' are excluded from the training to 
+// 'flag'
+// A frozen criterion keeps its current parameters during ISTrain and
+// its predictions are reused if its ancestors are frozen too
+#if BUILDMODE != 0
+static inline
+#endif
+void _ISCSetIsFrozen(ImgSegmentorCriterion* const that, 
+  const bool flag);
+
+// Return the number of int parameters of the criterion 'that' searched
+// during training, 0 if it is frozen
+long ISCGetNbTrainedParamInt(const ImgSegmentorCriterion* const that);
+
+// Return the number of float parameters of the criterion 'that' 
+// searched during training, 0 if it is frozen
+long ISCGetNbTrainedParamFloat(const ImgSegmentorCriterion* const that);
+
 // Return the number of int parameters for the criterion 'that'
 long _ISCGetNbParamInt(const ImgSegmentorCriterion* const that);
 
@@ -598,11 +1997,21 @@ void _ISCSetBoundsAdnFloat(const ImgSegmentorCriterion* const that,
 
 // Set the values of int parameters for training of the criterion 'that'
 void _ISCSetAdnInt(const ImgSegmentorCriterion* const that,
-  const GenAlgAdn* const adn, const long shift);
+  const VecLong* const adnI, const long shift);
 
 // Set the values of float parameters for training of the criterion 'that'
 void _ISCSetAdnFloat(const ImgSegmentorCriterion* const that,
-  const GenAlgAdn* const adn, const long shift);
+  const VecFloat* const adnF, const long shift);
+
+// Copy the values of int parameters of the criterion 'that' in 
+// 'adnI' from the index 'shift'
+void _ISCGetAdnInt(const ImgSegmentorCriterion* const that,
+  VecLong* const adnI, const long shift);
+
+// Copy the values of float parameters of the criterion 'that' in 
+// 'adnF' from the index 'shift'
+void _ISCGetAdnFloat(const ImgSegmentorCriterion* const that,
+  VecFloat* const adnF, const long shift);
 
 // ---- ImgSegmentorCriterionRGB
 
@@ -615,10 +2024,13 @@ void ImgSegmentorCriterionRGBFree(ImgSegmentorCriterionRGB** that);
 
 // Make the prediction on the 'input' values with the 
 // ImgSegmentorCriterionRGB that
-// 'input' 's format is 3*width*height, values in [0.0, 1.0]
-// Return values are nbClass*width*height, values in [-1.0, 1.0]
-VecFloat* ISCRGBPredict(const ImgSegmentorCriterionRGB* const that,
-  const VecFloat* input, const VecShort2D* const dim, const int iSample);
+// 'input' has 3 channels, values in [0.0, 1.0]
+// 'ctx' may be NULL, see ISCPredictWithContext
+// Return a plane with nbClass channels, values in [-1.0, 1.0]
+ImgSegmentorPlane* ISCRGBPredict(
+  const ImgSegmentorCriterionRGB* const that,
+  const ImgSegmentorPlane* const input, const int iSample,
+  const ImgSegmentorCriterionContext* const ctx);
 
 // Return the number of int parameters for the criterion 'that'
 long ISCRGBGetNbParamInt(const ImgSegmentorCriterionRGB* const that);
@@ -636,11 +2048,21 @@ void ISCRGBSetBoundsAdnFloat(const ImgSegmentorCriterionRGB* const that,
 
 // Set the values of int parameters for training of the criterion 'that'
 void ISCRGBSetAdnInt(const ImgSegmentorCriterionRGB* const that,
-  const GenAlgAdn* const adn, const long shift);
+  const VecLong* const adnI, const long shift);
 
 // Set the values of float parameters for training of the criterion 'that'
 void ISCRGBSetAdnFloat(const ImgSegmentorCriterionRGB* const that,
-  const GenAlgAdn* const adn, const long shift);
+  const VecFloat* const adnF, const long shift);
+
+// Copy the values of int parameters of the criterion 'that' in 
+// 'adnI' from the index 'shift'
+void ISCRGBGetAdnInt(const ImgSegmentorCriterionRGB* const that,
+  VecLong* const adnI, const long shift);
+
+// Copy the values of float parameters of the criterion 'that' in 
+// 'adnF' from the index 'shift'
+void ISCRGBGetAdnFloat(const ImgSegmentorCriterionRGB* const that,
+  VecFloat* const adnF, const long shift);
 
 // Return the NeuraNet of the ImgSegmentorCriterionRGB 'that'
 #if BUILDMODE != 0
@@ -649,6 +2071,38 @@ static inline
 const NeuraNet* ISCRGBNeuraNet(
   const ImgSegmentorCriterionRGB* const that);
 
+// Compile the NeuraNet of the ImgSegmentorCriterionRGB 'that' into a 
+// lookup table of _lutSize^3 colors. If _lutSize is lower than 256
+// the prediction uses a trilinear interpolation of the table, else 
+// a direct lookup. If _lutSize equals 0 it does nothing
+// The lookup table is invalidated when the NeuraNet is modified
+void ISCRGBCompile(ImgSegmentorCriterionRGB* const that);
+
+// Free the lookup table of the ImgSegmentorCriterionRGB 'that', the 
+// prediction falls back to the NeuraNet until the next compilation
+void ISCRGBInvalidateLUT(const ImgSegmentorCriterionRGB* const that);
+
+// Set the number of samples per color channel of the lookup table of 
+// the ImgSegmentorCriterionRGB 'that' to 'size'
+// 'size' must be 0 (no lookup table) or in [2, 256]
+// Invalidate the current lookup table if any
+void ISCRGBSetLUTSize(ImgSegmentorCriterionRGB* const that, 
+  const int size);
+
+// Return the number of samples per color channel of the lookup table 
+// of the ImgSegmentorCriterionRGB 'that'
+#if BUILDMODE != 0
+static inline
+#endif
+int ISCRGBGetLUTSize(const ImgSegmentorCriterionRGB* const that);
+
+// Return true if the ImgSegmentorCriterionRGB 'that' has a compiled
+// lookup table, else false
+#if BUILDMODE != 0
+static inline
+#endif
+bool ISCRGBIsCompiled(const ImgSegmentorCriterionRGB* const that);
+
 // ---- ImgSegmentorCriterionRGB2HSV
 
 // Create a new ImgSegmentorCriterionRGB2HSV with 'nbClass' output
@@ -661,11 +2115,13 @@ void ImgSegmentorCriterionRGB2HSVFree(
 
 // Make the prediction on the 'input' values with the 
 // ImgSegmentorCriterionRGB2HSV that
-// 'input' 's format is 3*width*height, values in [0.0, 1.0]
-// Return values are nbClass*width*height, values in [-1.0, 1.0]
-VecFloat* ISCRGB2HSVPredict(
+// 'input' has 3 channels, values in [0.0, 1.0]
+// 'ctx' may be NULL, see ISCPredictWithContext
+// Return a plane with 3 channels (h, s, v), values in [0.0, 1.0]
+ImgSegmentorPlane* ISCRGB2HSVPredict(
   const ImgSegmentorCriterionRGB2HSV* const that,
-  const VecFloat* input, const VecShort2D* const dim, const int iSample);
+  const ImgSegmentorPlane* const input, const int iSample,
+  const ImgSegmentorCriterionContext* const ctx);
 
 // Return the number of int parameters for the criterion 'that'
 long ISCRGB2HSVGetNbParamInt(
@@ -687,11 +2143,21 @@ void ISCRGB2HSVSetBoundsAdnFloat(
 
 // Set the values of int parameters for training of the criterion 'that'
 void ISCRGB2HSVSetAdnInt(const ImgSegmentorCriterionRGB2HSV* const that,
-  const GenAlgAdn* const adn, const long shift);
+  const VecLong* const adnI, const long shift);
 
 // Set the values of float parameters for training of the criterion 'that'
 void ISCRGB2HSVSetAdnFloat(const ImgSegmentorCriterionRGB2HSV* const that,
-  const GenAlgAdn* const adn, const long shift);
+  const VecFloat* const adnF, const long shift);
+
+// Copy the values of int parameters of the criterion 'that' in 
+// 'adnI' from the index 'shift'
+void ISCRGB2HSVGetAdnInt(const ImgSegmentorCriterionRGB2HSV* const that,
+  VecLong* const adnI, const long shift);
+
+// Copy the values of float parameters of the criterion 'that' in 
+// 'adnF' from the index 'shift'
+void ISCRGB2HSVGetAdnFloat(const ImgSegmentorCriterionRGB2HSV* const that,
+  VecFloat* const adnF, const long shift);
   
 // ---- ImgSegmentorCriterionDust
 
@@ -705,11 +2171,13 @@ void ImgSegmentorCriterionDustFree(
 
 // Make the prediction on the 'input' values with the 
 // ImgSegmentorCriterionDust that
-// 'input' 's format is 3*width*height, values in [0.0, 1.0]
-// Return values are nbClass*width*height, values in [-1.0, 1.0]
-VecFloat* ISCDustPredict(
+// 'input' has 1 channel, values in [0.0, 1.0]
+// 'ctx' may be NULL, see ISCPredictWithContext
+// Return a plane with 3 channels, values in [-1.0, 1.0]
+ImgSegmentorPlane* ISCDustPredict(
   const ImgSegmentorCriterionDust* const that,
-  const VecFloat* input, const VecShort2D* const dim, const int iSample);
+  const ImgSegmentorPlane* const input, const int iSample,
+  const ImgSegmentorCriterionContext* const ctx);
 
 // Return the number of int parameters for the criterion 'that'
 long ISCDustGetNbParamInt(
@@ -731,11 +2199,21 @@ void ISCDustSetBoundsAdnFloat(
 
 // Set the values of int parameters for training of the criterion 'that'
 void ISCDustSetAdnInt(const ImgSegmentorCriterionDust* const that,
-  const GenAlgAdn* const adn, const long shift);
+  const VecLong* const adnI, const long shift);
 
 // Set the values of float parameters for training of the criterion 'that'
 void ISCDustSetAdnFloat(const ImgSegmentorCriterionDust* const that,
-  const GenAlgAdn* const adn, const long shift);
+  const VecFloat* const adnF, const long shift);
+
+// Copy the values of int parameters of the criterion 'that' in 
+// 'adnI' from the index 'shift'
+void ISCDustGetAdnInt(const ImgSegmentorCriterionDust* const that,
+  VecLong* const adnI, const long shift);
+
+// Copy the values of float parameters of the criterion 'that' in 
+// 'adnF' from the index 'shift'
+void ISCDustGetAdnFloat(const ImgSegmentorCriterionDust* const that,
+  VecFloat* const adnF, const long shift);
 
 // Return the dust size of the ImgSegmentorCriterionDust 'that' for 
 // the class 'iClass'
@@ -759,6 +2237,7 @@ void ISCDustSetSize(
 // Create a new ImgSegmentorCriterionTex with 'nbClass' output,
 // 'rank' hidden layers and 3^'size' x 3^'size' down to 1x1 square 
 // fragments of the image as input
+// 'rank' is in [1, ISCTEX_RANKMAX] and 'size' in [1, ISCTEX_SIZEMAX]
 ImgSegmentorCriterionTex* ImgSegmentorCriterionTexCreate(
   const int nbClass, const int rank, const int size);
 
@@ -767,10 +2246,83 @@ void ImgSegmentorCriterionTexFree(ImgSegmentorCriterionTex** that);
 
 // Make the prediction on the 'input' values with the 
 // ImgSegmentorCriterionTex that
-// 'input' 's format is 3*width*height, values in [0.0, 1.0]
-// Return values are nbClass*width*height, values in [-1.0, 1.0]
-VecFloat* ISCTexPredict(const ImgSegmentorCriterionTex* const that,
-  const VecFloat* input, const VecShort2D* const dim, const int iSample);
+// 'input' has 3 channels, values in [0.0, 1.0]
+// 'ctx' may be NULL, see ISCPredictWithContext
+// Return a plane with nbClass channels, values in [-1.0, 1.0]
+ImgSegmentorPlane* ISCTexPredict(
+  const ImgSegmentorCriterionTex* const that,
+  const ImgSegmentorPlane* const input, const int iSample,
+  const ImgSegmentorCriterionContext* const ctx);
+
+// Create the reused data of the ImgSegmentorCriterionTex 'that' for 
+// a sample of dimensions 'dim'
+ImgSegmentorCriterionTexReuse* ImgSegmentorCriterionTexReuseCreate(
+  const ImgSegmentorCriterionTex* const that, 
+  const VecShort2D* const dim);
+
+// Free the memory used by the reused data 'that' of an 
+// ImgSegmentorCriterionTex
+void ImgSegmentorCriterionTexReuseFree(
+  ImgSegmentorCriterionTexReuse** that);
+
+// Return the memory used by the reused data 'that' of an 
+// ImgSegmentorCriterionTex, in bytes
+// The summed area table is counted until all the inputs are computed,
+// even if it is not yet computed
+size_t ISCTexReuseGetSize(const ImgSegmentorCriterionTexReuse* const that);
+
+// Return the key in the persistent feature cache of the inputs of the 
+// ImgSegmentorCriterionTex 'that' for the sample 'iSample' whose input
+// is 'input'
+uint64_t ISCTexGetFeatureCacheKey(
+  const ImgSegmentorCriterionTex* const that,
+  const ImgSegmentorPlane* const input, const long iSample);
+
+// Return the path of the file for the key 'key' in the persistent 
+// feature cache in the directory 'dir'
+// The returned string must be freed by the user
+char* ISFeatureCacheGetFilePath(const char* const dir, 
+  const uint64_t key);
+
+// Save the complete reused data 'that' of an ImgSegmentorCriterionTex
+// in the persistent feature cache in the directory 'dir' with the key
+// 'key'
+// The file is written under a temporary name and then renamed to be 
+// safely shared by several processes
+// Return true if the data could be saved, else false
+bool ISCTexReuseSave(const ImgSegmentorCriterionTexReuse* const that,
+  const char* const dir, const uint64_t key);
+
+// Create the reused data of the ImgSegmentorCriterionTex 'that' for 
+// a sample of dimensions 'dim' by mapping in memory, read only, the 
+// file for the key 'key' in the persistent feature cache in the 
+// directory 'dir'
+// Return NULL if the file doesn't exist or doesn't match
+ImgSegmentorCriterionTexReuse* ImgSegmentorCriterionTexReuseCreateFromFile(
+  const ImgSegmentorCriterionTex* const that, 
+  const VecShort2D* const dim, const char* const dir, 
+  const uint64_t key);
+
+// Return the number of inputs of the NeuraNet of the 
+// ImgSegmentorCriterionTex 'that' for one pixel
+long ISCTexGetNbInput(const ImgSegmentorCriterionTex* const that);
+
+// Helper function to create the summed area table of the 'input' 
+// for ISCTexPredict, see ImgSegmentorCriterionTexReuse for its layout
+// The returned table must be freed by the user
+double* ISCTexCreateSAT(const ImgSegmentorPlane* const input);
+
+// Helper function to create the input of the NeuraNet in ISCTexPredict
+// for the pixel at position 'pos' and index 'iInput' of the 'input', 
+// whose summed area table is 'sat'
+// If 'reuse' is null the input is computed in 'buffer', else it is 
+// computed once in the block of inputs of 'reuse' and copied in 
+// 'buffer'
+void ISCTexGetNNInput(
+  const ImgSegmentorCriterionTex* const that,
+  const ImgSegmentorPlane* const input, const double* const sat, 
+  const int iInput, ImgSegmentorCriterionTexReuse* const reuse, 
+  const VecShort2D* const pos, VecFloat* const buffer);
 
 // Return the number of int parameters for the criterion 'that'
 long ISCTexGetNbParamInt(const ImgSegmentorCriterionTex* const that);
@@ -788,11 +2340,21 @@ void ISCTexSetBoundsAdnFloat(const ImgSegmentorCriterionTex* const that,
 
 // Set the values of int parameters for training of the criterion 'that'
 void ISCTexSetAdnInt(const ImgSegmentorCriterionTex* const that,
-  const GenAlgAdn* const adn, const long shift);
+  const VecLong* const adnI, const long shift);
 
 // Set the values of float parameters for training of the criterion 'that'
 void ISCTexSetAdnFloat(const ImgSegmentorCriterionTex* const that,
-  const GenAlgAdn* const adn, const long shift);
+  const VecFloat* const adnF, const long shift);
+
+// Copy the values of int parameters of the criterion 'that' in 
+// 'adnI' from the index 'shift'
+void ISCTexGetAdnInt(const ImgSegmentorCriterionTex* const that,
+  VecLong* const adnI, const long shift);
+
+// Copy the values of float parameters of the criterion 'that' in 
+// 'adnF' from the index 'shift'
+void ISCTexGetAdnFloat(const ImgSegmentorCriterionTex* const that,
+  VecFloat* const adnF, const long shift);
 
 // Return the NeuraNet of the ImgSegmentorCriterionTex 'that'
 #if BUILDMODE != 0
@@ -849,6 +2411,27 @@ int ISCTexGetSize(const ImgSegmentorCriterionTex* const that);
   ImgSegmentorCriterionTex*: _ISCSetIsReusedInput, \
   default: PBErrInvalidPolymorphism) ((ImgSegmentorCriterion*)That, Flag)
 
+#define ISCIsFrozen(That) _Generic(That, \
+  ImgSegmentorCriterion*: _ISCIsFrozen, \
+  const ImgSegmentorCriterion*: _ISCIsFrozen, \
+  ImgSegmentorCriterionRGB*: _ISCIsFrozen, \
+  const ImgSegmentorCriterionRGB*: _ISCIsFrozen, \
+  ImgSegmentorCriterionRGB2HSV*: _ISCIsFrozen, \
+  const ImgSegmentorCriterionRGB2HSV*: _ISCIsFrozen, \
+  ImgSegmentorCriterionDust*: _ISCIsFrozen, \
+  const ImgSegmentorCriterionDust*: _ISCIsFrozen, \
+  ImgSegmentorCriterionTex*: _ISCIsFrozen, \
+  const ImgSegmentorCriterionTex*: _ISCIsFrozen, \
+  default: PBErrInvalidPolymorphism) ((const ImgSegmentorCriterion*)That)
+
+#define ISCSetIsFrozen(That, Flag) _Generic(That, \
+  ImgSegmentorCriterion*: _ISCSetIsFrozen, \
+  ImgSegmentorCriterionRGB*: _ISCSetIsFrozen, \
+  ImgSegmentorCriterionRGB2HSV*: _ISCSetIsFrozen, \
+  ImgSegmentorCriterionDust*: _ISCSetIsFrozen, \
+  ImgSegmentorCriterionTex*: _ISCSetIsFrozen, \
+  default: PBErrInvalidPolymorphism) ((ImgSegmentorCriterion*)That, Flag)
+
 #define ISCGetNbClass(That) _Generic(That, \
   ImgSegmentorCriterion*: _ISCGetNbClass, \
   const ImgSegmentorCriterion*: _ISCGetNbClass, \
@@ -916,7 +2499,7 @@ int ISCTexGetSize(const ImgSegmentorCriterionTex* const that);
   default: PBErrInvalidPolymorphism) ( \
     (const ImgSegmentorCriterion*)That, GenAlg, Shift)
   
-#define ISCSetAdnInt(That, Adn, Shift) _Generic(That, \
+#define ISCSetAdnInt(That, AdnI, Shift) _Generic(That, \
   ImgSegmentorCriterion*: _ISCSetAdnInt, \
   const ImgSegmentorCriterion*: _ISCSetAdnInt, \
   ImgSegmentorCriterionRGB*: ISCRGBSetAdnInt, \
@@ -928,9 +2511,9 @@ int ISCTexGetSize(const ImgSegmentorCriterionTex* const that);
   ImgSegmentorCriterionTex*: ISCTexSetAdnInt, \
   const ImgSegmentorCriterionTex*: ISCTexSetAdnInt, \
   default: PBErrInvalidPolymorphism) ( \
-    (const ImgSegmentorCriterion*)That, Adn, Shift)
+    (const ImgSegmentorCriterion*)That, AdnI, Shift)
   
-#define ISCSetAdnFloat(That, Adn, Shift) _Generic(That, \
+#define ISCSetAdnFloat(That, AdnF, Shift) _Generic(That, \
   ImgSegmentorCriterion*: _ISCSetAdnFloat, \
   const ImgSegmentorCriterion*: _ISCSetAdnFloat, \
   ImgSegmentorCriterionRGB*: ISCRGBSetAdnFloat, \
@@ -942,7 +2525,35 @@ int ISCTexGetSize(const ImgSegmentorCriterionTex* const that);
   ImgSegmentorCriterionTex*: ISCTexSetAdnFloat, \
   const ImgSegmentorCriterionTex*: ISCTexSetAdnFloat, \
   default: PBErrInvalidPolymorphism) ( \
-    (const ImgSegmentorCriterion*)That, Adn, Shift)
+    (const ImgSegmentorCriterion*)That, AdnF, Shift)
+
+#define ISCGetAdnInt(That, AdnI, Shift) _Generic(That, \
+  ImgSegmentorCriterion*: _ISCGetAdnInt, \
+  const ImgSegmentorCriterion*: _ISCGetAdnInt, \
+  ImgSegmentorCriterionRGB*: ISCRGBGetAdnInt, \
+  const ImgSegmentorCriterionRGB*: ISCRGBGetAdnInt, \
+  ImgSegmentorCriterionRGB2HSV*: ISCRGB2HSVGetAdnInt, \
+  const ImgSegmentorCriterionRGB2HSV*: ISCRGB2HSVGetAdnInt, \
+  ImgSegmentorCriterionDust*: ISCDustGetAdnInt, \
+  const ImgSegmentorCriterionDust*: ISCDustGetAdnInt, \
+  ImgSegmentorCriterionTex*: ISCTexGetAdnInt, \
+  const ImgSegmentorCriterionTex*: ISCTexGetAdnInt, \
+  default: PBErrInvalidPolymorphism) ( \
+    (const ImgSegmentorCriterion*)That, AdnI, Shift)
+
+#define ISCGetAdnFloat(That, AdnF, Shift) _Generic(That, \
+  ImgSegmentorCriterion*: _ISCGetAdnFloat, \
+  const ImgSegmentorCriterion*: _ISCGetAdnFloat, \
+  ImgSegmentorCriterionRGB*: ISCRGBGetAdnFloat, \
+  const ImgSegmentorCriterionRGB*: ISCRGBGetAdnFloat, \
+  ImgSegmentorCriterionRGB2HSV*: ISCRGB2HSVGetAdnFloat, \
+  const ImgSegmentorCriterionRGB2HSV*: ISCRGB2HSVGetAdnFloat, \
+  ImgSegmentorCriterionDust*: ISCDustGetAdnFloat, \
+  const ImgSegmentorCriterionDust*: ISCDustGetAdnFloat, \
+  ImgSegmentorCriterionTex*: ISCTexGetAdnFloat, \
+  const ImgSegmentorCriterionTex*: ISCTexGetAdnFloat, \
+  default: PBErrInvalidPolymorphism) ( \
+    (const ImgSegmentorCriterion*)That, AdnF, Shift)
   
 // ================ static inliner ====================
 